@@ -9,9 +9,11 @@ source "${BASEDIR}/ci/utils.sh"
 if [[ "$1" == cpu ]]; then
     DMGE_WITH_DISTRIBUTED=OFF
     DMGE_WITH_CUDA=OFF
+    DMGE_WITH_SHM_COMM=ON
 elif [[ "$1" == cuda ]]; then
     DMGE_WITH_DISTRIBUTED=ON
     DMGE_WITH_CUDA=ON
+    DMGE_WITH_SHM_COMM=ON
 else
     log "Argument must cpu or cuda"
     exit 1
@@ -26,6 +28,7 @@ function build() {
         cmake -S "${BASEDIR}" -B "${build_dir}" \
             -DMGE_WITH_DISTRIBUTED=${DMGE_WITH_DISTRIBUTED} \
             -DMGE_WITH_CUDA=${DMGE_WITH_CUDA} \
+            -DMGE_WITH_SHM_COMM=${DMGE_WITH_SHM_COMM} \
             -DMGE_WITH_TEST=ON \
             -DCMAKE_BUILD_TYPE=RelWithDebInfo
         make -j$(($(nproc) * 2)) -I ${build_dir}
@@ -0,0 +1,151 @@
+/**
+ * \file dnn/src/fallback/cond_take/opr_impl.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "src/fallback/cond_take/opr_impl.h"
+#include "src/common/cond_take/predicate.cuh"
+#include "src/common/utils.h"
+#include "src/naive/handle.h"
+
+#include <algorithm>
+
+using namespace megdnn;
+using namespace fallback;
+using namespace cond_take;
+
+using Param = CondTake::Param;
+
+namespace {
+
+//! number of elements in each block
+constexpr size_t BLOCK_SIZE = 16384;
+
+/*!
+ * \brief write indices of matched elements in [begin, end) to dest + begin,
+ *      and the number of them to *count
+ */
+template <uint32_t mode, typename ctype>
+void gen_index(size_t begin, size_t end, dt_int32* dest, dt_int32* count,
+               const ctype* inp, cond_take::Pred<mode, ctype> pred) {
+    dt_int32* ptr = dest + begin;
+    size_t didx = 0;
+    for (size_t i = begin; i < end; ++i) {
+        // didx never exceeds i - begin, so the store is always in range
+        ptr[didx] = i;
+        didx += pred(inp[i]);
+    }
+    *count = didx;
+}
+
+template <typename ctype>
+void copy_data(size_t sz, dt_int32* dest_idx, ctype* dest_data,
+               const dt_int32* src_idx, const ctype* src_data) {
+    for (size_t i = 0; i < sz; ++i) {
+        auto idx = src_idx[i];
+        dest_idx[i] = idx;
+        dest_data[i] = src_data[idx];
+    }
+}
+
+}  // anonymous namespace
+
+size_t CondTakeImpl::get_workspace_in_bytes(const TensorLayout& data) {
+    size_t size = data.total_nr_elems();
+    return (size + div_ceil(size, BLOCK_SIZE) + 1) * sizeof(dt_int32);
+}
+
+CondTakeImpl::Output CondTakeImpl::exec(_megdnn_tensor_in data,
+                                        _megdnn_tensor_in mask,
+                                        _megdnn_workspace workspace,
+                                        DynOutMallocPolicyCall malloc_policy) {
+    auto size = check_exec_get_size(data.layout, mask.layout, workspace.size);
+    size_t nr_blocks = div_ceil(size, BLOCK_SIZE);
+    auto idx_tmp = workspace.ptr<dt_int32>(), block_offset = idx_tmp + size;
+
+    switch (mask.layout.dtype.enumv()) {
+#define cb(_dt)                                                           \
+    case DTypeTrait<_dt>::enumv: {                                        \
+        using ctype = DTypeTrait<_dt>::ctype;                             \
+        dispatch_genidx<ctype>(size, idx_tmp, block_offset,               \
+                               mask.ptr<ctype>());                        \
+        break;                                                            \
+    }
+        MEGDNN_FOREACH_COMPUTING_DTYPE(cb)
+        cb(::megdnn::dtype::Bool)
+#undef cb
+        default:
+            megdnn_throw("bad mask dtype");
+    }
+
+    static_cast<naive::HandleImpl*>(handle())->megcore_dispatcher()->sync();
+    // convert counts of blocks to exclusive prefix sum
+    size_t out_size = 0;
+    for (size_t i = 0; i < nr_blocks; ++i) {
+        size_t cnt = block_offset[i];
+        block_offset[i] = out_size;
+        out_size += cnt;
+    }
+    block_offset[nr_blocks] = out_size;
+
+    auto out_data =
+            malloc_policy.alloc_output(0, data.layout.dtype, {out_size});
+    auto out_idx = malloc_policy.alloc_output(1, dtype::Int32(), {out_size});
+    auto out_idx_ptr = out_idx.ptr<dt_int32>();
+
+    switch (data.layout.dtype.enumv()) {
+#define cb(_dt)                                                               \
+    case DTypeTrait<_dt>::enumv: {                                            \
+        using ctype = DTypeTrait<_dt>::ctype;                                 \
+        auto out_data_ptr = out_data.ptr<ctype>();                            \
+        auto data_ptr = data.ptr<ctype>();                                    \
+        auto kern = [=](size_t block, size_t) {                               \
+            size_t begin = block_offset[block],                               \
+                   end = block_offset[block + 1];                             \
+            copy_data<ctype>(end - begin, out_idx_ptr + begin,                \
+                             out_data_ptr + begin,                            \
+                             idx_tmp + block * BLOCK_SIZE, data_ptr);         \
+        };                                                                    \
+        MEGDNN_DISPATCH_MULTI_THREAD_CPU_KERN_OPR(kern, nr_blocks);           \
+        break;                                                                \
+    }
+        MEGDNN_FOREACH_COMPUTING_DTYPE(cb)
+        cb(::megdnn::dtype::Bool)
+#undef cb
+        default:
+            megdnn_throw("bad data dtype");
+    }
+
+    return {{out_data, out_idx}};
+}
+
+template <typename ctype>
+void CondTakeImpl::dispatch_genidx(size_t size, dt_int32* dest,
+                                   dt_int32* count, const ctype* inp) {
+    KParam kparam(m_param);
+    size_t nr_blocks = div_ceil(size, BLOCK_SIZE);
+    switch (m_param.mode) {
+#define cb(_m)                                                           \
+    case Param::Mode::_m: {                                              \
+        Pred<PEnum::_m, ctype> pred(kparam);                             \
+        auto kern = [=](size_t block, size_t) {                          \
+            size_t begin = block * BLOCK_SIZE,                           \
+                   end = std::min(size, begin + BLOCK_SIZE);             \
+            gen_index(begin, end, dest, count + block, inp, pred);       \
+        };                                                               \
+        MEGDNN_DISPATCH_MULTI_THREAD_CPU_KERN_OPR(kern, nr_blocks);      \
+        return;                                                          \
+    }
+        MEGDNN_FOREACH_COND_TAKE_MODE(cb)
+#undef cb
+    }
+    megdnn_assert_internal(0);
+}
+
+// vim: syntax=cpp.doxygen
@@ -0,0 +1,44 @@
+/**
+ * \file dnn/src/fallback/cond_take/opr_impl.h
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+#include "megdnn/oprs.h"
+
+namespace megdnn {
+namespace fallback {
+
+/*!
+ * \brief CondTake by two-pass parallel compaction
+ *
+ * The input is split into blocks: the first pass writes the indices of
+ * matched elements of each block into the workspace in parallel, and the
+ * second pass gathers them to the outputs after an exclusive prefix sum of
+ * the per-block counts.
+ */
+class CondTakeImpl : public CondTake {
+    template <typename ctype>
+    void dispatch_genidx(size_t size, dt_int32* dest, dt_int32* count,
+                         const ctype* inp);
+
+public:
+    using CondTake::CondTake;
+
+    size_t get_workspace_in_bytes(const TensorLayout& data) override;
+
+    Output exec(_megdnn_tensor_in data, _megdnn_tensor_in mask,
+                _megdnn_workspace workspace,
+                DynOutMallocPolicyCall malloc_policy) override;
+};
+
+}  // namespace fallback
+}  // namespace megdnn
+
+// vim: syntax=cpp.doxygen
@@ -557,4 +557,268 @@ ConvolutionBackwardDataImpl::AlgoMatrixMul::dispatch_kern(
 #undef cb
 }
 
+/* ===================== backward filter ===================== */
+
+namespace {
+
+using BwdFilterSizeParam = ConvolutionBackwardFilterImpl::NCBKernSizeParam;
+using BwdFilterParam = ConvolutionBackwardFilterImpl::NCBKernParam;
+using BwdFilterIndex = ConvolutionBackwardFilterImpl::NCBKernIndex;
+
+bool is_bwd_filter_float32_nchw(const BwdFilterSizeParam& param) {
+    auto&& fm = param.filter_meta;
+    return fm.format == param::Convolution::Format::NCHW &&
+           param.src_type.enumv() == DTypeEnum::Float32 &&
+           param.diff_type.enumv() == DTypeEnum::Float32 &&
+           param.grad_type.enumv() == DTypeEnum::Float32 &&
+           param.compute_mode == param::Convolution::ComputeMode::DEFAULT &&
+           fm.spatial_ndim == 2;
+}
+
+//! offset of filter position (fh, fw) of the cross-correlation kernel in grad
+size_t bwd_filter_spatial_offset(const BwdFilterSizeParam& param, size_t fh,
+                                 size_t fw) {
+    auto FH = param.filter_meta.spatial[0], FW = param.filter_meta.spatial[1];
+    if (param.filter_meta.should_flip) {
+        return (FH - 1 - fh) * FW + (FW - 1 - fw);
+    }
+    return fh * FW + fw;
+}
+
+//! range [begin, end) of output position o with 0 <= o * stride + offset < isz
+void get_valid_output_range(ptrdiff_t offset, size_t stride, size_t isz,
+                            size_t osz, size_t& begin, size_t& end) {
+    ptrdiff_t strd = stride;
+    ptrdiff_t b = offset < 0 ? (-offset + strd - 1) / strd : 0;
+    ptrdiff_t e = static_cast<ptrdiff_t>(isz) - 1 - offset;
+    e = e < 0 ? 0 : e / strd + 1;
+    begin = std::min<ptrdiff_t>(b, osz);
+    end = std::max<ptrdiff_t>(std::min<ptrdiff_t>(e, osz), begin);
+}
+
+void kern_bwd_filter_chanwise(const BwdFilterParam& param,
+                              const BwdFilterIndex& ncb_index) {
+    auto&& fm = param.filter_meta;
+    size_t g = ncb_index.ndrange_id[0], fh = ncb_index.ndrange_id[1],
+           fw = ncb_index.ndrange_id[2];
+    size_t N = param.n, IH = param.isz[0], IW = param.isz[1],
+           OH = param.osz[0], OW = param.osz[1], SH = fm.stride[0],
+           SW = fm.stride[1];
+    ptrdiff_t offh = static_cast<ptrdiff_t>(fh * fm.dilation[0]) -
+                     static_cast<ptrdiff_t>(fm.padding[0]),
+              offw = static_cast<ptrdiff_t>(fw * fm.dilation[1]) -
+                     static_cast<ptrdiff_t>(fm.padding[1]);
+    size_t oh_begin, oh_end, ow_begin, ow_end;
+    get_valid_output_range(offh, SH, IH, OH, oh_begin, oh_end);
+    get_valid_output_range(offw, SW, IW, OW, ow_begin, ow_end);
+
+    float sum = 0;
+    for (size_t n = 0; n < N; ++n) {
+        const float* src = param.src<float>() + n * param.inp_bs + g * IH * IW;
+        const float* diff =
+                param.diff<float>() + n * param.out_bs + g * OH * OW;
+        for (size_t oh = oh_begin; oh < oh_end; ++oh) {
+            const float* sptr =
+                    src + (static_cast<ptrdiff_t>(oh * SH) + offh) * IW + offw;
+            const float* dptr = diff + oh * OW;
+            for (size_t ow = ow_begin; ow < ow_end; ++ow) {
+                sum += dptr[ow] * sptr[ow * SW];
+            }
+        }
+    }
+    param.grad<float>()[g * fm.spatial[0] * fm.spatial[1] +
+                        bwd_filter_spatial_offset(param, fh, fw)] = sum;
+}
+
+MatrixMul* get_bwd_filter_matmul_opr() {
+    static CpuOprDelegationStorage<> storage;
+    return storage.get<MatrixMul>();
+}
+
+size_t get_bwd_filter_nr_chunks(const BwdFilterSizeParam& param) {
+    return std::max<size_t>(
+            std::min<size_t>(param.n, param.nr_threads), 1);
+}
+
+/*!
+ * workspace of each thread: unrolled src, matmul output and matmul
+ * workspace; followed by the accumulators of all the chunks
+ */
+WorkspaceBundle get_bwd_filter_bundle(const BwdFilterSizeParam& param) {
+    auto&& fm = param.filter_meta;
+    size_t M = fm.ocpg, K = fm.icpg * fm.spatial[0] * fm.spatial[1],
+           L = param.osz[0] * param.osz[1];
+    size_t matmul_ws;
+    {
+        TensorLayout A_({M, L}, dtype::Float32()), B_({L, K}, dtype::Float32()),
+                C_({M, K}, dtype::Float32());
+        matmul_ws = get_bwd_filter_matmul_opr()->get_workspace_in_bytes(A_, B_,
+                                                                         C_);
+    }
+    SmallVector<size_t> sizes;
+    for (size_t i = 0; i < param.nr_threads; ++i) {
+        sizes.push_back(L * K * sizeof(float));
+        sizes.push_back(M * K * sizeof(float));
+        sizes.push_back(matmul_ws);
+    }
+    sizes.push_back(get_bwd_filter_nr_chunks(param) * fm.group * M * K *
+                    sizeof(float));
+    return {nullptr, sizes};
+}
+
+//! unroll src of one group into [OH * OW, IC * FH * FW]
+void im2col_transposed(const BwdFilterParam& param, const float* src,
+                       float* col) {
+    auto&& fm = param.filter_meta;
+    size_t IC = fm.icpg, IH = param.isz[0], IW = param.isz[1],
+           OH = param.osz[0], OW = param.osz[1], FH = fm.spatial[0],
+           FW = fm.spatial[1];
+    ptrdiff_t SH = fm.stride[0], SW = fm.stride[1], PH = fm.padding[0],
+              PW = fm.padding[1], DH = fm.dilation[0], DW = fm.dilation[1];
+    for (size_t oh = 0; oh < OH; ++oh) {
+        for (size_t ow = 0; ow < OW; ++ow) {
+            ptrdiff_t ih0 = static_cast<ptrdiff_t>(oh) * SH - PH,
+                      iw0 = static_cast<ptrdiff_t>(ow) * SW - PW;
+            for (size_t ic = 0; ic < IC; ++ic) {
+                const float* sptr = src + ic * IH * IW;
+                for (size_t fh = 0; fh < FH; ++fh) {
+                    ptrdiff_t ih = ih0 + static_cast<ptrdiff_t>(fh) * DH;
+                    bool valid_h = ih >= 0 && ih < static_cast<ptrdiff_t>(IH);
+                    for (size_t fw = 0; fw < FW; ++fw) {
+                        ptrdiff_t iw = iw0 + static_cast<ptrdiff_t>(fw) * DW;
+                        *(col++) = valid_h && iw >= 0 &&
+                                                   iw < static_cast<ptrdiff_t>(
+                                                                IW)
+                                           ? sptr[ih * IW + iw]
+                                           : 0.f;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void kern_bwd_filter_matmul(const BwdFilterParam& param,
+                            const BwdFilterIndex& ncb_index) {
+    auto&& fm = param.filter_meta;
+    size_t N = param.n, G = fm.group, IC = fm.icpg, M = fm.ocpg,
+           K = IC * fm.spatial[0] * fm.spatial[1],
+           L = param.osz[0] * param.osz[1];
+    size_t g = ncb_index.ndrange_id[0], chunk = ncb_index.ndrange_id[1],
+           nr_chunks = get_bwd_filter_nr_chunks(param);
+    auto bundle = get_bwd_filter_bundle(param);
+    bundle.set(param.workspace_ptr);
+    size_t tid = ncb_index.thread_id;
+    float* col = static_cast<float*>(bundle.get(tid * 3));
+    float* tmp = static_cast<float*>(bundle.get(tid * 3 + 1));
+    Workspace matmul_ws(static_cast<dt_byte*>(bundle.get(tid * 3 + 2)),
+                        bundle.get_size(tid * 3 + 2));
+    float* acc = static_cast<float*>(bundle.get(param.nr_threads * 3)) +
+                 (chunk * G + g) * M * K;
+
+    TensorND A_, B_, C_;
+    A_.layout = TensorLayout({M, L}, dtype::Float32());
+    B_.layout = TensorLayout({L, K}, dtype::Float32());
+    B_.raw_ptr = col;
+    C_.layout = TensorLayout({M, K}, dtype::Float32());
+    size_t n_begin = N * chunk / nr_chunks, n_end = N * (chunk + 1) / nr_chunks;
+    for (size_t n = n_begin; n < n_end; ++n) {
+        im2col_transposed(param,
+                          param.src<float>() + n * param.inp_bs +
+                                  g * IC * param.isz[0] * param.isz[1],
+                          col);
+        A_.raw_ptr = const_cast<float*>(param.diff<float>() +
+                                        n * param.out_bs + g * M * L);
+        C_.raw_ptr = n == n_begin ? acc : tmp;
+        get_bwd_filter_matmul_opr()->exec(A_, B_, C_, matmul_ws);
+        if (n != n_begin) {
+            for (size_t i = 0; i < M * K; ++i) {
+                acc[i] += tmp[i];
+            }
+        }
+    }
+}
+
+//! sum the accumulators of all the chunks into one output channel of grad
+void kern_bwd_filter_reduce(const BwdFilterParam& param,
+                            const BwdFilterIndex& ncb_index) {
+    auto&& fm = param.filter_meta;
+    size_t FH = fm.spatial[0], FW = fm.spatial[1], K = fm.icpg * FH * FW,
+           nr_chunks = get_bwd_filter_nr_chunks(param),
+           chunk_size = fm.group * fm.ocpg * K;
+    size_t row = ncb_index.ndrange_id[0];
+    auto bundle = get_bwd_filter_bundle(param);
+    bundle.set(param.workspace_ptr);
+    const float* acc =
+            static_cast<float*>(bundle.get(param.nr_threads * 3)) + row * K;
+    float* grad = param.grad<float>() + row * K;
+    for (size_t ic = 0; ic < fm.icpg; ++ic) {
+        for (size_t fh = 0; fh < FH; ++fh) {
+            for (size_t fw = 0; fw < FW; ++fw) {
+                size_t k = (ic * FH + fh) * FW + fw;
+                float sum = acc[k];
+                for (size_t c = 1; c < nr_chunks; ++c) {
+                    sum += acc[c * chunk_size + k];
+                }
+                grad[ic * FH * FW + bwd_filter_spatial_offset(param, fh, fw)] =
+                        sum;
+            }
+        }
+    }
+}
+
+}  // namespace
+
+/* ===================== backward filter chanwise algo ===================== */
+
+bool ConvolutionBackwardFilterImpl::AlgoChanwise::usable(
+        const NCBKernSizeParam& param) const {
+    auto&& fm = param.filter_meta;
+    return is_bwd_filter_float32_nchw(param) && fm.icpg == 1 && fm.ocpg == 1;
+}
+
+SmallVector<ConvolutionBackwardFilterImpl::NCBKern>
+ConvolutionBackwardFilterImpl::AlgoChanwise::dispatch_kern(
+        const NCBKernSizeParam& param) const {
+    MIDOUT_BEGIN(megdnn_fallback_conv,
+                 midout_iv("AlgoBwdFilterChanwise::dispatch_kern"_hash)) {
+        auto&& fm = param.filter_meta;
+        return {{kern_bwd_filter_chanwise,
+                 {fm.group, fm.spatial[0], fm.spatial[1]}}};
+    }
+    MIDOUT_END();
+    return {};
+}
+
+/* ===================== backward filter matmul algo ===================== */
+
+bool ConvolutionBackwardFilterImpl::AlgoMatrixMul::usable(
+        const NCBKernSizeParam& param) const {
+    return is_bwd_filter_float32_nchw(param);
+}
+
+size_t ConvolutionBackwardFilterImpl::AlgoMatrixMul::get_workspace(
+        const NCBKernSizeParam& param) const {
+    MIDOUT_BEGIN(megdnn_fallback_conv,
+                 midout_iv("AlgoBwdFilterMatrixMul::get_workspace"_hash)) {
+        return get_bwd_filter_bundle(param).total_size_in_bytes();
+    }
+    MIDOUT_END();
+    return 0;
+}
+
+SmallVector<ConvolutionBackwardFilterImpl::NCBKern>
+ConvolutionBackwardFilterImpl::AlgoMatrixMul::dispatch_kern(
+        const NCBKernSizeParam& param) const {
+    MIDOUT_BEGIN(megdnn_fallback_conv,
+                 midout_iv("AlgoBwdFilterMatrixMul::dispatch_kern"_hash)) {
+        auto&& fm = param.filter_meta;
+        return {{kern_bwd_filter_matmul,
+                 {fm.group, get_bwd_filter_nr_chunks(param)}},
+                {kern_bwd_filter_reduce, {fm.group * fm.ocpg}}};
+    }
+    MIDOUT_END();
+    return {};
+}
+
 // vim: syntax=cpp.doxygen
@@ -184,6 +184,30 @@ public:
     void* type() const override { return sm_fallback_deconv_algo_type; }
 };
 
+class ConvolutionBackwardFilterImpl::AlgoChanwise final : public AlgoBase {
+public:
+    bool is_reproducible() const override { return true; }
+    const char* name() const override { return "ConvBwdFilterChanwise"; }
+    bool usable(const NCBKernSizeParam& param) const override;
+    size_t get_workspace(const NCBKernSizeParam&) const override { return 0; }
+    SmallVector<NCBKern> dispatch_kern(
+            const NCBKernSizeParam& param) const override;
+};
+
+/*!
+ * \brief im2col + matmul, with batches split into chunks whose results are
+ *      accumulated in separate buffers and summed in a fixed order
+ */
+class ConvolutionBackwardFilterImpl::AlgoMatrixMul final : public AlgoBase {
+public:
+    bool is_reproducible() const override { return true; }
+    const char* name() const override { return "ConvBwdFilterMatmul"; }
+    bool usable(const NCBKernSizeParam& param) const override;
+    size_t get_workspace(const NCBKernSizeParam& param) const override;
+    SmallVector<NCBKern> dispatch_kern(
+            const NCBKernSizeParam& param) const override;
+};
+
 }  // namespace fallback
 }  // namespace megdnn
 
@@ -39,6 +39,7 @@ class NaiveConvolutionBackwardData final
 NaiveConvolutionBackwardData naive_conv_backward_data;
 uint8_t fallback_deconv_algo_type_storage;
 uint8_t fallback_conv_algo_type_storage;
+uint8_t fallback_conv_bwd_filter_algo_type_storage;
 
 template <typename T>
 void incr_ptr(T*& dst, ptrdiff_t delta) {
@@ -498,6 +499,9 @@ ConvolutionBackwardDataImpl::make_ncb_kern_size_param(
     auto diff_fwd = diff;
 
     std::swap(grad_fwd.dtype, diff_fwd.dtype);
+    size_t nr_threads = static_cast<naive::HandleImpl*>(handle())
+                                ->megcore_dispatcher()
+                                ->nr_threads();
 
     return {
             safe_u32(diff[0]),
@@ -516,6 +520,7 @@ ConvolutionBackwardDataImpl::make_ncb_kern_size_param(
             0,
             0,
             param().compute_mode,
+            nr_threads,
     };
 }
 
@@ -540,6 +545,15 @@ ConvolutionBackwardDataImpl::make_ncb_kern_param(_megdnn_tensor_in filter,
     return ret;
 }
 
+ConvolutionBackwardDataImpl::NCBKernSizeParam
+ConvolutionBackwardDataImpl::slice_ncb_kern_size_param(
+        const NCBKernSizeParam& param) {
+    auto slice = param;
+    slice.n = 1;
+    slice.filter_meta.group = 1;
+    return slice;
+}
+
 void ConvolutionBackwardDataImpl::exec_with_ncb_kern(
         const NCBKernParam& param) {
     auto p1g = param;
@@ -547,59 +561,77 @@ void ConvolutionBackwardDataImpl::exec_with_ncb_kern(
     p1g.filter_meta.group = 1;
     auto algo = get_algorithm(p1g);
     auto kptr = ncb_1g_dispatch_kern(algo, p1g);
-    if (algo == &naive_conv_backward_data || group == 1) {
+    if (algo == &naive_conv_backward_data) {
         auto run = [kptr, param]() { kptr(param); };
         static_cast<naive::HandleImpl*>(handle())->dispatch_kern(run);
+        return;
+    }
+    megdnn_assert(p1g.filter_meta.format == Param::Format::NCHW ||
+                          p1g.filter_meta.format == Param::Format::NHWC,
+                  "invalid conv format");
+
+    // each (group, batch) pair is computed independently; it is the only
+    // source of parallelism since the kernels run single-threaded
+    NCBKernParam slice;
+    static_cast<NCBKernSizeParam&>(slice) = slice_ncb_kern_size_param(param);
+    slice.filter_ptr = param.filter_ptr;
+    slice.diff_ptr = param.diff_ptr;
+    slice.grad_ptr = param.grad_ptr;
+    WorkspaceBundle bundle{
+            param.workspace_ptr,
+            SmallVector<size_t>(param.nr_threads,
+                                ncb_1g_get_workspace(algo, slice))};
+
+    auto&& fm = p1g.filter_meta;
+    ptrdiff_t istrd, fstrd, ostrd;
+    fstrd = fm.icpg * fm.ocpg * fm.spatial[0] * fm.spatial[1] *
+            p1g.filter_type.size();
+    istrd = fm.ocpg * p1g.diff_type.size();
+    ostrd = fm.icpg * p1g.grad_type.size();
+    if (fm.format == Param::Format::NCHW) {
+        istrd *= p1g.isz[0] * p1g.isz[1];
+        ostrd *= p1g.osz[0] * p1g.osz[1];
     } else {
-        megdnn_assert(p1g.filter_meta.format == Param::Format::NCHW ||
-                              p1g.filter_meta.format == Param::Format::NHWC,
-                      "invalid conv format");
-        auto run = [kptr, p1g_orig = p1g, group]() {
-            auto p1g = p1g_orig;
-            ptrdiff_t istrd, fstrd, ostrd;
-            fstrd = p1g.filter_meta.icpg * p1g.filter_meta.ocpg *
-                    p1g.filter_meta.spatial[0] * p1g.filter_meta.spatial[1] *
-                    p1g.filter_type.size();
-            istrd = p1g.filter_meta.ocpg * p1g.diff_type.size();
-            ostrd = p1g.filter_meta.icpg * p1g.grad_type.size();
-            p1g.diff_extra_mem_size =
-                    (group - 1) * p1g.filter_meta.ocpg * p1g.diff_type.size();
-            p1g.filter_extra_mem_size =
-                    (group - 1) * p1g.filter_meta.icpg * p1g.filter_meta.ocpg *
-                    p1g.filter_meta.spatial[0] * p1g.filter_meta.spatial[1] *
-                    p1g.filter_type.size();
-            p1g.grad_extra_mem_size =
-                    (group - 1) * p1g.filter_meta.icpg * p1g.grad_type.size();
-            if (p1g.filter_meta.format == Param::Format::NCHW) {
-                istrd *= p1g.isz[0] * p1g.isz[1];
-                ostrd *= p1g.osz[0] * p1g.osz[1];
-                p1g.diff_extra_mem_size *= p1g.isz[0] * p1g.isz[1];
-                p1g.grad_extra_mem_size *= p1g.osz[0] * p1g.osz[1];
-            } else {
-                // must be NHWC. No action performed.
-            }
-            for (size_t i = 0; i < group; ++i) {
-                kptr(p1g);
-                incr_ptr(p1g.diff_ptr, istrd);
-                incr_ptr(p1g.filter_ptr, fstrd);
-                incr_ptr(p1g.grad_ptr, ostrd);
-                p1g.diff_extra_mem_size -= istrd;
-                p1g.filter_extra_mem_size -= fstrd;
-                p1g.grad_extra_mem_size -= ostrd;
-            }
-        };
-        static_cast<naive::HandleImpl*>(handle())->dispatch_kern(run);
+        // must be NHWC. No action performed.
+    }
+    ptrdiff_t ibatch = p1g.inp_bs * p1g.diff_type.size(),
+              obatch = p1g.out_bs * p1g.grad_type.size();
+    size_t N = p1g.n;
+    auto run = [kptr, slice, bundle, group, N, istrd, fstrd, ostrd, ibatch,
+                obatch](size_t index, size_t thread_id) {
+        auto p = slice;
+        size_t g = index / N, n = index % N;
+        auto sn = static_cast<ptrdiff_t>(n), sg = static_cast<ptrdiff_t>(g);
+        incr_ptr(p.diff_ptr, ibatch * sn + istrd * sg);
+        incr_ptr(p.filter_ptr, fstrd * sg);
+        incr_ptr(p.grad_ptr, obatch * sn + ostrd * sg);
+        p.diff_extra_mem_size = istrd * (group - 1 - g);
+        p.filter_extra_mem_size = fstrd * (group - 1 - g);
+        p.grad_extra_mem_size = ostrd * (group - 1 - g);
+        p.workspace_ptr = bundle.get(thread_id);
+        p.workspace_size = bundle.get_size(thread_id);
+        kptr(p);
+    };
+    static_cast<naive::HandleImpl*>(handle())->dispatch_kern(run, group * N);
+}
+
+size_t ConvolutionBackwardDataImpl::get_workspace_with_algo(
+        Algorithm* algo, const NCBKernSizeParam& param) {
+    if (algo == &naive_conv_backward_data) {
+        return 0;
     }
+    auto per_thread =
+            ncb_1g_get_workspace(algo, slice_ncb_kern_size_param(param));
+    return WorkspaceBundle{nullptr,
+                           SmallVector<size_t>(param.nr_threads, per_thread)}
+            .total_size_in_bytes();
 }
 
 size_t ConvolutionBackwardDataImpl::get_workspace_with_ncb(
         const NCBKernSizeParam& param) {
-    if (param.filter_meta.group != 1) {
-        auto p1g = param;
-        p1g.filter_meta.group = 1;
-        return ncb_1g_get_workspace(get_algorithm(p1g), p1g);
-    }
-    return ncb_1g_get_workspace(get_algorithm(param), param);
+    auto p1g = param;
+    p1g.filter_meta.group = 1;
+    return get_workspace_with_algo(get_algorithm(p1g), p1g);
 }
 
 std::vector<ConvolutionBackwardDataImpl::Algorithm*>
@@ -730,7 +762,7 @@ ConvolutionBackwardDataImpl::ncb_1g_get_algorithm_heuristic(
         const NCBKernSizeParam& param, size_t workspace_limit_in_bytes,
         bool reproducible) {
     for (auto i : ncb_1g_get_all_algorithms(param)) {
-        if (ncb_1g_get_workspace(i, param) <= workspace_limit_in_bytes) {
+        if (get_workspace_with_algo(i, param) <= workspace_limit_in_bytes) {
             if (reproducible) {
                 if (i->is_reproducible()) {
                     return i;
@@ -763,4 +795,168 @@ const char* ConvolutionBackwardDataImpl::get_algorithm_set_name() const {
     return "FALLBACK_CONVOLUTION_BACKWARD_DATA_IMPL0";
 }
 
+/* ===================== ConvolutionBackwardFilter ===================== */
+
+void* const ConvolutionBackwardFilterImpl::sm_fallback_conv_bwd_filter_algo_type =
+        &fallback_conv_bwd_filter_algo_type_storage;
+
+struct ConvolutionBackwardFilterImpl::AlgoPack {
+    AlgoChanwise chanwise;
+    AlgoMatrixMul matmul;
+};
+ConvolutionBackwardFilterImpl::AlgoPack
+        ConvolutionBackwardFilterImpl::sm_algo_pack;
+
+bool ConvolutionBackwardFilterImpl::is_naive_algo(Algorithm* algo) const {
+    return algo->type() != sm_fallback_conv_bwd_filter_algo_type;
+}
+
+void ConvolutionBackwardFilterImpl::exec(_megdnn_tensor_in src,
+                                         _megdnn_tensor_in diff,
+                                         _megdnn_tensor_out grad,
+                                         _megdnn_workspace workspace) {
+    if (param().format == param::Convolution::Format::NCHW) {
+        check_exec(src.layout, diff.layout, grad.layout, workspace.size);
+        auto fparam = make_ncb_kern_param(src, diff, grad, workspace);
+        auto algo = get_algorithm(fparam);
+        if (!is_naive_algo(algo)) {
+            return exec_with_ncb_kern(fparam, algo);
+        }
+    }
+    naive::ConvolutionBackwardFilterImpl::exec(src, diff, grad, workspace);
+}
+
+size_t ConvolutionBackwardFilterImpl::get_workspace_in_bytes(
+        const TensorLayout& src, const TensorLayout& diff,
+        const TensorLayout& grad) {
+    if (param().format == param::Convolution::Format::NCHW) {
+        auto fparam = make_ncb_kern_size_param(src, diff, grad);
+        auto algo = get_algorithm(fparam);
+        if (!is_naive_algo(algo)) {
+            return static_cast<AlgoBase*>(algo)->get_workspace(fparam);
+        }
+    }
+    return naive::ConvolutionBackwardFilterImpl::get_workspace_in_bytes(
+            src, diff, grad);
+}
+
+std::vector<ConvolutionBackwardFilterImpl::Algorithm*>
+ConvolutionBackwardFilterImpl::get_all_algorithms(const TensorLayout& src,
+                                                  const TensorLayout& diff,
+                                                  const TensorLayout& grad) {
+    auto ret = naive::ConvolutionBackwardFilterImpl::get_all_algorithms(
+            src, diff, grad);
+    if (param().format == param::Convolution::Format::NCHW) {
+        auto fparam = make_ncb_kern_size_param(src, diff, grad);
+        auto algos = get_all_algorithms_with_ncb(fparam);
+        ret.insert(ret.begin(), algos.begin(), algos.end());
+    }
+    return ret;
+}
+
+ConvolutionBackwardFilterImpl::Algorithm*
+ConvolutionBackwardFilterImpl::get_algorithm_heuristic(
+        const TensorLayout& src, const TensorLayout& diff,
+        const TensorLayout& grad, size_t workspace_limit_in_bytes,
+        bool reproducible) {
+    if (param().format == param::Convolution::Format::NCHW) {
+        auto fparam = make_ncb_kern_size_param(src, diff, grad);
+        for (auto i : get_all_algorithms_with_ncb(fparam)) {
+            auto algo = static_cast<AlgoBase*>(i);
+            if (algo->usable_reproducible(fparam, reproducible) &&
+                algo->get_workspace(fparam) <= workspace_limit_in_bytes) {
+                return i;
+            }
+        }
+    }
+    return naive::ConvolutionBackwardFilterImpl::get_algorithm_heuristic(
+            src, diff, grad, workspace_limit_in_bytes, reproducible);
+}
+
+ConvolutionBackwardFilterImpl::NCBKernSizeParam
+ConvolutionBackwardFilterImpl::make_ncb_kern_size_param(
+        const TensorLayout& src, const TensorLayout& diff,
+        const TensorLayout& grad) {
+    auto safe_u32 = [](size_t v) -> uint32_t {
+        megdnn_assert(v <= std::numeric_limits<uint32_t>::max(),
+                      "value too large: %zu", v);
+        return v;
+    };
+    megdnn_assert(param().format == Param::Format::NCHW,
+                  "invalid conv format");
+    size_t nr_threads = static_cast<naive::HandleImpl*>(handle())
+                                ->megcore_dispatcher()
+                                ->nr_threads();
+    return {safe_u32(src[0]),
+            {{safe_u32(src[2]), safe_u32(src[3])}},
+            {{safe_u32(diff[2]), safe_u32(diff[3])}},
+            check_layout_fwd(src, grad, diff),
+            src.dtype,
+            diff.dtype,
+            grad.dtype,
+            src.stride[0],
+            diff.stride[0],
+            param().compute_mode,
+            nr_threads};
+}
+
+ConvolutionBackwardFilterImpl::NCBKernParam
+ConvolutionBackwardFilterImpl::make_ncb_kern_param(
+        _megdnn_tensor_in src, _megdnn_tensor_in diff, _megdnn_tensor_out grad,
+        _megdnn_workspace workspace) {
+    NCBKernParam ret;
+    static_cast<NCBKernSizeParam&>(ret) =
+            make_ncb_kern_size_param(src.layout, diff.layout, grad.layout);
+    ret.src_ptr = src.raw_ptr;
+    ret.diff_ptr = diff.raw_ptr;
+    ret.grad_ptr = grad.raw_ptr;
+    ret.workspace_ptr = workspace.raw_ptr;
+    ret.workspace_size = workspace.size;
+    return ret;
+}
+
+void ConvolutionBackwardFilterImpl::exec_with_ncb_kern(
+        const NCBKernParam& param, Algorithm* algo) {
+    auto&& kerns = static_cast<AlgoBase*>(algo)->dispatch_kern(param);
+    for (auto&& kernel : kerns) {
+        auto run = [param, kernel](size_t index, size_t thread_id) {
+            CpuNDRange ndrange_id(kernel.global_size, index);
+            kernel.kern(param, {thread_id, ndrange_id});
+        };
+        static_cast<naive::HandleImpl*>(handle())->dispatch_kern(
+                run, kernel.global_size.total_size());
+    }
+}
+
+std::vector<ConvolutionBackwardFilterImpl::Algorithm*>
+ConvolutionBackwardFilterImpl::get_all_algorithms_with_ncb(
+        const NCBKernSizeParam& param) {
+    std::vector<Algorithm*> ret;
+    for (AlgoBase* i : {static_cast<AlgoBase*>(&sm_algo_pack.chanwise),
+                        static_cast<AlgoBase*>(&sm_algo_pack.matmul)}) {
+        if (i->usable(param)) {
+            ret.push_back(i);
+        }
+    }
+    return ret;
+}
+
+ConvolutionBackwardFilterImpl::Algorithm*
+ConvolutionBackwardFilterImpl::get_algorithm(const NCBKernSizeParam& param) {
+    if (auto set = execution_policy().algorithm) {
+        return set;
+    }
+    auto algos = get_all_algorithms_with_ncb(param);
+    if (!algos.empty()) {
+        return algos[0];
+    }
+    return static_cast<naive::HandleImpl*>(handle())
+            ->default_conv_bwd_filter_algo();
+}
+
+const char* ConvolutionBackwardFilterImpl::get_algorithm_set_name() const {
+    // fallback version 0
+    return "FALLBACK_CONVOLUTION_BACKWARD_FILTER_IMPL0";
+}
+
 // vim: syntax=cpp.doxygen
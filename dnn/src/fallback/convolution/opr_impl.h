@@ -337,6 +337,7 @@ public:
         //! different value is not allowed.
         size_t diff_extra_mem_size, filter_extra_mem_size, grad_extra_mem_size;
         Param::ComputeMode compute_mode;
+        size_t nr_threads;
     };
 
     //! memory param for kernels with non-contiguous batch
@@ -374,7 +375,12 @@ public:
 protected:
     typedef void (*ncb_kern_t)(const NCBKernParam& param);
 
-    //! default impl calls ncb_1g_dispatch_kern()
+    /*!
+     * default impl calls ncb_1g_dispatch_kern(); kernels other than the
+     * naive one are called on single-batch single-group slices in parallel,
+     * each with a per-thread workspace given by ncb_1g_get_workspace() on the
+     * slice
+     */
     virtual void exec_with_ncb_kern(const NCBKernParam& param);
 
     //! default impl calls ncb_1g_get_workspace()
@@ -437,6 +443,14 @@ private:
     //! get algorithm set by user or by heuristic
     Algorithm* get_algorithm(const NCBKernSizeParam& param);
 
+    //! param of the single-batch single-group slices run by each thread
+    static NCBKernSizeParam slice_ncb_kern_size_param(
+            const NCBKernSizeParam& param);
+
+    //! total workspace of \p algo, including all the per-thread slices
+    size_t get_workspace_with_algo(Algorithm* algo,
+                                   const NCBKernSizeParam& param);
+
     NCBKernSizeParam make_ncb_kern_size_param(const TensorLayout& filter,
                                               const TensorLayout& diff,
                                               const TensorLayout& grad);
@@ -453,6 +467,136 @@ private:
     static AlgoPack sm_algo_pack;
 };
 
+/*!
+ * \brief fallback convolution backward filter impl
+ *
+ * The algos dispatch their own multi-threaded kernels like ConvolutionImpl;
+ * the naive impl is used if no fallback algo is usable.
+ */
+class ConvolutionBackwardFilterImpl
+        : public naive::ConvolutionBackwardFilterImpl {
+public:
+    using naive::ConvolutionBackwardFilterImpl::ConvolutionBackwardFilterImpl;
+
+    void exec(_megdnn_tensor_in src, _megdnn_tensor_in diff,
+              _megdnn_tensor_out grad, _megdnn_workspace workspace) override;
+    size_t get_workspace_in_bytes(const TensorLayout& src,
+                                  const TensorLayout& diff,
+                                  const TensorLayout& grad) override;
+    std::vector<Algorithm*> get_all_algorithms(
+            const TensorLayout& src, const TensorLayout& diff,
+            const TensorLayout& grad) override;
+    Algorithm* get_algorithm_heuristic(const TensorLayout& src,
+                                       const TensorLayout& diff,
+                                       const TensorLayout& grad,
+                                       size_t workspace_limit_in_bytes,
+                                       bool reproducible) override;
+    const char* get_algorithm_set_name() const override;
+
+    //! size param for kernels with non-contiguous batch
+    struct NCBKernSizeParam {
+        uint32_t n;
+        std::array<uint32_t, MAX_SPATIAL_DIM> isz, osz;
+        //! filter info; group may be larger than 1
+        CanonizedFilterMeta filter_meta;
+        DType src_type, diff_type, grad_type;
+        //! stride for batch of src, diff
+        ptrdiff_t inp_bs, out_bs;
+        Param::ComputeMode compute_mode;
+        size_t nr_threads;
+    };
+
+    //! memory param for kernels with non-contiguous batch
+    struct NCBKernParam : public NCBKernSizeParam {
+        const void* src_ptr;
+        const void* diff_ptr;
+        void* grad_ptr;
+        void* workspace_ptr;
+        size_t workspace_size;
+
+        template <typename T>
+        const T* src() const {
+            src_type.assert_is_compatible_ctype<T>();
+            return static_cast<const T*>(src_ptr);
+        }
+
+        template <typename T>
+        const T* diff() const {
+            diff_type.assert_is_compatible_ctype<T>();
+            return static_cast<const T*>(diff_ptr);
+        }
+
+        template <typename T>
+        T* grad() const {
+            grad_type.assert_is_compatible_ctype<T>();
+            return static_cast<T*>(grad_ptr);
+        }
+    };
+
+    struct NCBKernIndex {
+        size_t thread_id = 0;  //!< Thread id
+        CpuNDRange ndrange_id;
+    };
+
+    using ncb_kern_t = thin_function<void(const NCBKernParam& param,
+                                          const NCBKernIndex& ncb_index)>;
+    struct NCBKern {
+        ncb_kern_t kern;
+        CpuNDRange global_size;
+    };
+
+    static void* const sm_fallback_conv_bwd_filter_algo_type;
+
+    class AlgoBase : public Algorithm {
+    protected:
+        ~AlgoBase() = default;
+
+    public:
+        virtual bool usable(const NCBKernSizeParam& param) const = 0;
+        virtual size_t get_workspace(const NCBKernSizeParam& param) const = 0;
+        //! kernels which are dispatched one after another
+        virtual SmallVector<NCBKern> dispatch_kern(
+                const NCBKernSizeParam& param) const = 0;
+        bool usable_reproducible(const NCBKernSizeParam& param,
+                                 bool reproducible = true) const {
+            return (!reproducible || is_reproducible()) && usable(param);
+        }
+        void* type() const override {
+            return sm_fallback_conv_bwd_filter_algo_type;
+        }
+    };
+
+protected:
+    virtual void exec_with_ncb_kern(const NCBKernParam& param,
+                                    Algorithm* algo);
+
+    //! usable fallback algos from highest to lowest preference
+    virtual std::vector<Algorithm*> get_all_algorithms_with_ncb(
+            const NCBKernSizeParam& param);
+
+private:
+    //! get algorithm set by user or by heuristic
+    Algorithm* get_algorithm(const NCBKernSizeParam& param);
+
+    //! whether \p algo should be run by the naive impl
+    bool is_naive_algo(Algorithm* algo) const;
+
+    NCBKernSizeParam make_ncb_kern_size_param(const TensorLayout& src,
+                                              const TensorLayout& diff,
+                                              const TensorLayout& grad);
+
+    NCBKernParam make_ncb_kern_param(_megdnn_tensor_in src,
+                                     _megdnn_tensor_in diff,
+                                     _megdnn_tensor_out grad,
+                                     _megdnn_workspace workspace);
+
+    class AlgoChanwise;
+    class AlgoMatrixMul;
+
+    struct AlgoPack;
+    static AlgoPack sm_algo_pack;
+};
+
 }  // namespace fallback
 }  // namespace megdnn
 
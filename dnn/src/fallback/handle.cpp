@@ -36,6 +36,10 @@
 #include "src/fallback/batched_matrix_mul/opr_impl.h"
 #include "src/fallback/conv_bias/opr_impl.h"
 #include "src/fallback/powc/opr_impl.h"
+#include "src/fallback/rng/opr_impl.h"
+#include "src/fallback/indexing_multi_axis_vec/opr_impl.h"
+#include "src/fallback/indexing_one_hot/opr_impl.h"
+#include "src/fallback/cond_take/opr_impl.h"
 
 namespace megdnn {
 namespace fallback {
@@ -47,6 +51,7 @@ std::unique_ptr<Opr> HandleImpl::create_operator() {
 
 MEGDNN_SPECIALIZE_CREATE_OPERATOR(Convolution)
 MEGDNN_SPECIALIZE_CREATE_OPERATOR(ConvolutionBackwardData)
+MEGDNN_SPECIALIZE_CREATE_OPERATOR(ConvolutionBackwardFilter)
 MEGDNN_SPECIALIZE_CREATE_OPERATOR(Elemwise)
 MEGDNN_SPECIALIZE_CREATE_OPERATOR(Pooling)
 MEGDNN_SPECIALIZE_CREATE_OPERATOR(Reduce)
@@ -70,6 +75,14 @@ MEGDNN_SPECIALIZE_CREATE_OPERATOR(Resize)
 MEGDNN_SPECIALIZE_CREATE_OPERATOR(BatchedMatrixMul)
 MEGDNN_SPECIALIZE_CREATE_OPERATOR(ConvBias)
 MEGDNN_SPECIALIZE_CREATE_OPERATOR(PowC)
+MEGDNN_SPECIALIZE_CREATE_OPERATOR(UniformRNG)
+MEGDNN_SPECIALIZE_CREATE_OPERATOR(GaussianRNG)
+MEGDNN_SPECIALIZE_CREATE_OPERATOR(IndexingMultiAxisVec)
+MEGDNN_SPECIALIZE_CREATE_OPERATOR(IndexingSetMultiAxisVec)
+MEGDNN_SPECIALIZE_CREATE_OPERATOR(IndexingIncrMultiAxisVec)
+MEGDNN_SPECIALIZE_CREATE_OPERATOR(IndexingOneHotForward)
+MEGDNN_SPECIALIZE_CREATE_OPERATOR(IndexingSetOneHotForward)
+MEGDNN_SPECIALIZE_CREATE_OPERATOR(CondTake)
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wpragmas"
@@ -0,0 +1,299 @@
+/**
+ * \file dnn/src/fallback/indexing_multi_axis_vec/opr_impl.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "src/fallback/indexing_multi_axis_vec/opr_impl.h"
+
+#include "src/common/indexing_multi_axis_vec_kdef.h"
+#include "src/common/utils.h"
+#include "src/naive/handle.h"
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+using namespace megdnn;
+using namespace fallback;
+using namespace indexing_multi_axis_vec_kdef;
+
+namespace {
+
+//! number of value elements processed by each task
+constexpr size_t TASK_SIZE = 16384;
+//! number of index values processed by each task when computing offsets
+constexpr size_t OFFSET_TASK_SIZE = 4096;
+
+//! offset of the \p idx th element in a layout
+ptrdiff_t elem_offset(const TensorLayout& layout, size_t idx) {
+    ptrdiff_t offset = 0;
+    for (size_t i = layout.ndim; i; --i) {
+        size_t shp = layout.shape[i - 1];
+        offset += static_cast<ptrdiff_t>(idx % shp) * layout.stride[i - 1];
+        idx /= shp;
+    }
+    return offset;
+}
+
+size_t nr_elems(const TensorLayout& layout, size_t begin, size_t end) {
+    size_t ret = 1;
+    for (size_t i = begin; i < end; ++i) {
+        ret *= layout.shape[i];
+    }
+    return ret;
+}
+
+/*!
+ * \brief value is viewed as (outer, idx, tail), and the data offset of an
+ *      element is outer_offset + offsets[idx] + tail_offset
+ */
+struct KernParam {
+    struct IndexRaw {
+        const dt_int32* ptr;
+        ptrdiff_t stride, data_stride;
+        size_t data_shape;
+    };
+    IndexRaw index[TensorLayout::MAX_NDIM];
+    size_t nr_index;
+
+    TensorLayout outer, tail;
+    size_t nr_outer, idx_len, tail_len;
+    ptrdiff_t value_stride;
+    //! whether rows of tail are contiguous in both data and value
+    bool row_contig;
+    //! data offset for each idx, stored in workspace
+    ptrdiff_t* offsets;
+
+    KernParam(const TensorLayout& data, const TensorLayout& value,
+              const IndexingMultiAxisVec::IndexDesc& index_desc,
+              const IndexingMultiAxisVec::ExecInfo& exec_info,
+              const Workspace& workspace) {
+        nr_index = index_desc.size();
+        for (size_t i = 0; i < nr_index; ++i) {
+            auto&& s = index_desc[i];
+            index[i] = {s.vec.ptr<dt_int32>(), s.vec.layout.stride[0],
+                        data.stride[s.axis], data.shape[s.axis]};
+            if (s.vec.layout.shape[0] == 1)
+                index[i].stride = 0;
+        }
+
+        auto iter = IndexingMultiAxisVec::get_value_iter_optimized_layout(
+                data, value, index_desc, exec_info.idx_axis);
+        auto&& layout = iter.first;
+        size_t idx_axis = iter.second;
+        outer.ndim = idx_axis;
+        tail.ndim = layout.ndim - idx_axis - 1;
+        for (size_t i = 0; i < outer.ndim; ++i) {
+            outer.shape[i] = layout.shape[i];
+            outer.stride[i] = layout.stride[i];
+        }
+        for (size_t i = 0; i < tail.ndim; ++i) {
+            tail.shape[i] = layout.shape[i + idx_axis + 1];
+            tail.stride[i] = layout.stride[i + idx_axis + 1];
+        }
+        nr_outer = nr_elems(layout, 0, idx_axis);
+        idx_len = layout.shape[idx_axis];
+        tail_len = nr_elems(layout, idx_axis + 1, layout.ndim);
+        value_stride = exec_info.value_stride;
+        row_contig = tail_len > 1 && tail.ndim == 1 && tail.stride[0] == 1 &&
+                     value_stride == 1;
+        offsets = workspace.ptr<ptrdiff_t>();
+    }
+
+    void compute_offsets(size_t begin, size_t end) const {
+        for (size_t idx = begin; idx < end; ++idx) {
+            ptrdiff_t offset = 0;
+            for (size_t i = 0; i < nr_index; ++i) {
+                auto&& cur = index[i];
+                dt_int32 data_idx = cur.ptr[cur.stride * idx];
+                if (data_idx < 0)
+                    data_idx += cur.data_shape;
+                megdnn_assert(data_idx >= 0 && static_cast<size_t>(data_idx) <
+                                                       cur.data_shape,
+                              "bad index value for index %zu at output %zu", i,
+                              idx);
+                offset += cur.data_stride * data_idx;
+            }
+            offsets[idx] = offset;
+        }
+    }
+};
+
+template <class Opr>
+struct RowOpr;
+
+template <>
+struct RowOpr<OprFwd> {
+    template <typename ctype>
+    static void apply(ctype* data, ctype* value, size_t size) {
+        memcpy(value, data, size * sizeof(ctype));
+    }
+};
+
+template <>
+struct RowOpr<OprSet> {
+    template <typename ctype>
+    static void apply(ctype* data, ctype* value, size_t size) {
+        memcpy(data, value, size * sizeof(ctype));
+    }
+};
+
+template <>
+struct RowOpr<OprIncr> {
+    template <typename ctype>
+    static void apply(ctype* data, ctype* value, size_t size) {
+        for (size_t i = 0; i < size; ++i) {
+            data[i] += value[i];
+        }
+    }
+};
+
+//! apply Opr on tail elements [begin, end) of a row
+template <typename ctype, class Opr>
+void apply_row(const KernParam& param, ctype* data, ctype* value, size_t begin,
+               size_t end) {
+    if (param.row_contig) {
+        RowOpr<Opr>::apply(data + begin, value + begin, end - begin);
+    } else {
+        for (size_t i = begin; i < end; ++i) {
+            Opr::apply(data[elem_offset(param.tail, i)],
+                       value[i * param.value_stride]);
+        }
+    }
+}
+
+template <typename ctype, class Opr>
+void run_kern(naive::HandleImpl* handle, const KernParam& param,
+              ctype* data_ptr, ctype* value_ptr) {
+    size_t tail_block = std::min(param.tail_len, TASK_SIZE),
+           nr_tail_blocks = div_ceil(param.tail_len, tail_block),
+           nr_rows = param.nr_outer * param.idx_len;
+
+    auto row_ptrs = [param, data_ptr, value_ptr](size_t outer, size_t idx) {
+        ptrdiff_t value_offset =
+                (outer * param.idx_len + idx) * param.tail_len *
+                param.value_stride;
+        return std::make_pair(
+                data_ptr + elem_offset(param.outer, outer) +
+                        param.offsets[idx],
+                value_ptr + value_offset);
+    };
+
+    if (std::is_same<Opr, OprFwd>::value) {
+        // rows are independent; each task handles a few rows
+        size_t rows_per_task = std::max<size_t>(1, TASK_SIZE / tail_block),
+               nr_tasks = div_ceil(nr_rows, rows_per_task) * nr_tail_blocks;
+        auto kern = [=](size_t index, size_t) {
+            size_t row_task = index / nr_tail_blocks,
+                   tail_begin = index % nr_tail_blocks * tail_block,
+                   tail_end = std::min(param.tail_len, tail_begin + tail_block),
+                   row_begin = row_task * rows_per_task,
+                   row_end = std::min(nr_rows, row_begin + rows_per_task);
+            for (size_t row = row_begin; row < row_end; ++row) {
+                auto ptrs = row_ptrs(row / param.idx_len, row % param.idx_len);
+                apply_row<ctype, Opr>(param, ptrs.first, ptrs.second,
+                                      tail_begin, tail_end);
+            }
+        };
+        MEGDNN_DISPATCH_MULTI_THREAD_CPU_KERN(handle, nr_tasks, kern);
+        return;
+    }
+
+    // rows with the same outer index may write to the same location if index
+    // values are duplicated; they are partitioned by their data offsets, so
+    // each location is only modified by one task in the order of index
+    size_t nr_groups = param.nr_outer * nr_tail_blocks,
+           nr_threads = handle->megcore_dispatcher()->nr_threads(),
+           nr_parts = 1;
+    if (nr_groups < nr_threads && param.idx_len > 1) {
+        nr_parts = std::min(div_ceil(nr_threads, nr_groups), param.idx_len);
+    }
+    auto kern = [=](size_t index, size_t) {
+        size_t group = index / nr_parts, part = index % nr_parts,
+               outer = group / nr_tail_blocks,
+               tail_begin = group % nr_tail_blocks * tail_block,
+               tail_end = std::min(param.tail_len, tail_begin + tail_block);
+        for (size_t idx = 0; idx < param.idx_len; ++idx) {
+            if (nr_parts > 1) {
+                uint64_t hash = static_cast<uint64_t>(param.offsets[idx]) *
+                                UINT64_C(0x9E3779B97F4A7C15);
+                if ((hash >> 32) % nr_parts != part)
+                    continue;
+            }
+            auto ptrs = row_ptrs(outer, idx);
+            apply_row<ctype, Opr>(param, ptrs.first, ptrs.second, tail_begin,
+                                  tail_end);
+        }
+    };
+    MEGDNN_DISPATCH_MULTI_THREAD_CPU_KERN(handle, nr_groups * nr_parts, kern);
+}
+
+template <class Opr>
+void dispatch_exec(naive::HandleImpl* handle, const TensorND& data,
+                   const TensorND& value,
+                   const IndexingMultiAxisVec::IndexDesc& index,
+                   const IndexingMultiAxisVec::ExecInfo& exec_info,
+                   const Workspace& workspace) {
+    if (!value.layout.total_nr_elems())
+        return;
+    KernParam param{data.layout, value.layout, index, exec_info, workspace};
+    auto kern_offsets = [param](size_t index, size_t) {
+        size_t begin = index * OFFSET_TASK_SIZE,
+               end = std::min(param.idx_len, begin + OFFSET_TASK_SIZE);
+        param.compute_offsets(begin, end);
+    };
+    MEGDNN_DISPATCH_MULTI_THREAD_CPU_KERN(
+            handle, div_ceil(param.idx_len, OFFSET_TASK_SIZE), kern_offsets);
+
+#define cb(_dt)                                                         \
+    case DTypeTrait<_dt>::enumv: {                                      \
+        using ctype = DTypeTrait<_dt>::ctype;                           \
+        run_kern<ctype, Opr>(handle, param, data.ptr<ctype>(),          \
+                             value.ptr<ctype>());                       \
+        return;                                                         \
+    }
+    switch (data.layout.dtype.enumv()) {
+        MEGDNN_FOREACH_COMPUTING_DTYPE(cb)
+        cb(::megdnn::dtype::Bool)
+        default:
+            megdnn_throw(megdnn_mangle("bad dtype"));
+    }
+#undef cb
+}
+
+}  // anonymous namespace
+
+void IndexingMultiAxisVecImpl::exec(_megdnn_tensor_in src,
+                                    const IndexDesc& index,
+                                    _megdnn_tensor_out dst,
+                                    _megdnn_workspace workspace) {
+    auto info = check_exec(src.layout, index, dst.layout, workspace.size);
+    dispatch_exec<OprFwd>(static_cast<naive::HandleImpl*>(handle()), src, dst,
+                          index, info, workspace);
+}
+
+void IndexingSetMultiAxisVecImpl::exec(_megdnn_tensor_inout data,
+                                       _megdnn_tensor_in value,
+                                       const IndexDesc& index,
+                                       _megdnn_workspace workspace) {
+    auto info = check_exec(data.layout, value.layout, index, workspace.size);
+    dispatch_exec<OprSet>(static_cast<naive::HandleImpl*>(handle()), data,
+                          value, index, info, workspace);
+}
+
+void IndexingIncrMultiAxisVecImpl::exec(_megdnn_tensor_inout data,
+                                        _megdnn_tensor_in value,
+                                        const IndexDesc& index,
+                                        _megdnn_workspace workspace) {
+    auto info = check_exec(data.layout, value.layout, index, workspace.size);
+    dispatch_exec<OprIncr>(static_cast<naive::HandleImpl*>(handle()), data,
+                           value, index, info, workspace);
+}
+
+// vim: syntax=cpp.doxygen
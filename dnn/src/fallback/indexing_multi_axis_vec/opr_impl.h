@@ -0,0 +1,70 @@
+/**
+ * \file dnn/src/fallback/indexing_multi_axis_vec/opr_impl.h
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+#include "megdnn/oprs.h"
+
+namespace megdnn {
+namespace fallback {
+
+/*!
+ * The kernels iterate over value as (outer, idx, tail) given by
+ * get_value_iter_optimized_layout(): data offsets of the index vectors are
+ * computed once into the workspace, and rows of the tail are copied by
+ * memcpy when they are contiguous in both data and value.
+ */
+class IndexingMultiAxisVecImpl final : public IndexingMultiAxisVec {
+public:
+    using IndexingMultiAxisVec::IndexingMultiAxisVec;
+
+    size_t get_workspace_in_bytes(size_t dst_idx_size) override {
+        return dst_idx_size * sizeof(ptrdiff_t);
+    }
+
+    void exec(_megdnn_tensor_in src, const IndexDesc& index,
+              _megdnn_tensor_out dst, _megdnn_workspace workspace) override;
+};
+
+/*!
+ * Rows writing to the same data location are always handled by the same
+ * thread in the order of index, so the result is deterministic and
+ * duplicated index values are accumulated correctly.
+ */
+class IndexingSetMultiAxisVecImpl final : public IndexingSetMultiAxisVec {
+public:
+    using IndexingSetMultiAxisVec::IndexingSetMultiAxisVec;
+
+    size_t get_workspace_in_bytes(size_t value_idx_size) override {
+        return value_idx_size * sizeof(ptrdiff_t);
+    }
+
+    void exec(_megdnn_tensor_inout data, _megdnn_tensor_in value,
+              const IndexDesc& index, _megdnn_workspace workspace) override;
+};
+
+//! see IndexingSetMultiAxisVecImpl for how conflicts are handled
+class IndexingIncrMultiAxisVecImpl final : public IndexingIncrMultiAxisVec {
+public:
+    using IndexingIncrMultiAxisVec::IndexingIncrMultiAxisVec;
+
+    size_t get_workspace_in_bytes(size_t value_idx_size) override {
+        return value_idx_size * sizeof(ptrdiff_t);
+    }
+
+    void exec(_megdnn_tensor_inout data, _megdnn_tensor_in value,
+              const IndexDesc& index, _megdnn_workspace workspace) override;
+};
+
+}  // namespace fallback
+}  // namespace megdnn
+
+// vim: syntax=cpp.doxygen
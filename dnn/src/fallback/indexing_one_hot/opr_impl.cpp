@@ -0,0 +1,137 @@
+/**
+ * \file dnn/src/fallback/indexing_one_hot/opr_impl.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "src/fallback/indexing_one_hot/opr_impl.h"
+
+#include "src/common/utils.h"
+#include "src/naive/handle.h"
+
+#include <algorithm>
+
+using namespace megdnn;
+using namespace fallback;
+
+namespace {
+
+//! number of index values processed by each task
+constexpr size_t TASK_SIZE = 8192;
+
+/*!
+ * \brief all the layouts are contiguous, so src is viewed as (A, M, B) and
+ *      index / dst as (A, B), where M is the shape on the indexed axis
+ */
+struct KernParam {
+    size_t A, M, B;
+
+    KernParam(const TensorLayout& src, uint32_t axis) {
+        A = B = 1;
+        for (size_t i = 0; i < axis; ++i)
+            A *= src.shape[i];
+        M = src.shape[axis];
+        for (size_t i = axis + 1; i < src.ndim; ++i)
+            B *= src.shape[i];
+    }
+
+    //! offset in src for the \p i th element of index
+    size_t src_offset(size_t i, dt_int32 idx) const {
+        megdnn_assert(idx >= 0 && static_cast<size_t>(idx) < M,
+                      "bad value in IndexingOneHot index: input shape is %zu, "
+                      "index value is %d",
+                      M, idx);
+        size_t a = i / B, b = i % B;
+        return (a * M + idx) * B + b;
+    }
+};
+
+template <typename ctype>
+void exec_get(const KernParam& param, const ctype* src, const dt_int32* index,
+              ctype* dst, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        dst[i] = src[param.src_offset(i, index[i])];
+    }
+}
+
+template <typename ctype>
+void exec_set(const KernParam& param, ctype* data, const dt_int32* index,
+              const ctype* sub, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        data[param.src_offset(i, index[i])] = sub[i];
+    }
+}
+
+}  // anonymous namespace
+
+void IndexingOneHotForwardImpl::exec(_megdnn_tensor_in src,
+                                     _megdnn_tensor_in index,
+                                     _megdnn_tensor_out dst,
+                                     _megdnn_workspace workspace) {
+    check_exec(src.layout, index.layout, dst.layout, workspace.size);
+    KernParam kparam(src.layout, param().axis);
+    size_t size = index.layout.total_nr_elems();
+    auto idx_ptr = index.ptr<dt_int32>();
+
+#define cb(_dt)                                                        \
+    case DTypeTrait<_dt>::enumv: {                                     \
+        using ctype = DTypeTrait<_dt>::ctype;                          \
+        auto sptr = src.ptr<ctype>();                                  \
+        auto dptr = dst.ptr<ctype>();                                  \
+        auto kern = [=](size_t task, size_t) {                         \
+            size_t begin = task * TASK_SIZE,                           \
+                   end = std::min(size, begin + TASK_SIZE);            \
+            exec_get<ctype>(kparam, sptr, idx_ptr, dptr, begin, end);  \
+        };                                                             \
+        MEGDNN_DISPATCH_MULTI_THREAD_CPU_KERN_OPR(                     \
+                kern, div_ceil(size, TASK_SIZE));                      \
+        return;                                                        \
+    }
+    switch (src.layout.dtype.enumv()) {
+        MEGDNN_FOREACH_COMPUTING_DTYPE(cb)
+        cb(megdnn::dtype::Quantized8Asymm)
+        default:
+            megdnn_throw(megdnn_mangle("bad dtype"));
+    }
+#undef cb
+}
+
+void IndexingSetOneHotForwardImpl::exec(_megdnn_tensor_inout data,
+                                        _megdnn_tensor_in index,
+                                        _megdnn_tensor_in sub,
+                                        _megdnn_workspace workspace) {
+    check_exec(data.layout, index.layout, sub.layout, workspace.size);
+    KernParam kparam(data.layout, param().axis);
+    size_t size = index.layout.total_nr_elems();
+    auto idx_ptr = index.ptr<dt_int32>();
+
+    // each element of index writes to a distinct location of data
+#define cb(_dt)                                                        \
+    case DTypeTrait<_dt>::enumv: {                                     \
+        using ctype = DTypeTrait<_dt>::ctype;                          \
+        auto dptr = data.ptr<ctype>();                                 \
+        auto sptr = sub.ptr<ctype>();                                  \
+        auto kern = [=](size_t task, size_t) {                         \
+            size_t begin = task * TASK_SIZE,                           \
+                   end = std::min(size, begin + TASK_SIZE);            \
+            exec_set<ctype>(kparam, dptr, idx_ptr, sptr, begin, end);  \
+        };                                                             \
+        MEGDNN_DISPATCH_MULTI_THREAD_CPU_KERN_OPR(                     \
+                kern, div_ceil(size, TASK_SIZE));                      \
+        return;                                                        \
+    }
+    switch (data.layout.dtype.enumv()) {
+        MEGDNN_FOREACH_COMPUTING_DTYPE(cb)
+        cb(megdnn::dtype::Quantized8Asymm)
+        default:
+            megdnn_throw(megdnn_mangle("bad dtype"));
+    }
+#undef cb
+}
+
+// vim: syntax=cpp.doxygen
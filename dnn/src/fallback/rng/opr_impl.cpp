@@ -0,0 +1,202 @@
+/**
+ * \file dnn/src/fallback/rng/opr_impl.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "src/fallback/rng/opr_impl.h"
+#include "src/common/utils.h"
+#include "src/naive/handle.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace megdnn;
+using namespace fallback;
+
+namespace {
+
+//! number of elements processed by each task; must be a multiple of 4
+constexpr size_t TASK_SIZE = 8192;
+//! number of words generated by each call of Philox4x32::fill()
+constexpr size_t BATCH_WORDS = Philox4x32::BATCH * 4;
+static_assert(TASK_SIZE % BATCH_WORDS == 0, "bad task size");
+
+template <typename ctype>
+struct UniformBits;
+
+template <>
+struct UniformBits<dt_float32> {
+    static constexpr int value = 24;
+};
+
+#if !MEGDNN_DISABLE_FLOAT16
+template <>
+struct UniformBits<dt_float16> {
+    static constexpr int value = 11;
+};
+
+template <>
+struct UniformBits<dt_bfloat16> {
+    static constexpr int value = 8;
+};
+#endif
+
+//! map the high \p bits bits of x to (0, 1]; exact in all the float dtypes
+template <int bits>
+inline float uniform_word2float(uint32_t x) {
+    return static_cast<float>((x >> (32 - bits)) + 1) *
+           (1.f / static_cast<float>(1u << bits));
+}
+
+/*!
+ * \brief call func(begin, words, nr) for the values [begin, end) of a stream
+ *      starting at block \p offset, where nr <= BATCH_WORDS and words[i] is
+ *      the random word of value begin + i
+ *
+ * \p begin must be a multiple of 4
+ */
+template <typename Func>
+void foreach_word_batch(uint64_t seed, uint64_t offset, size_t begin,
+                        size_t end, Func&& func) {
+    megdnn_assert_internal(begin % 4 == 0);
+    uint32_t words[BATCH_WORDS];
+    for (size_t pos = begin; pos < end; pos += BATCH_WORDS) {
+        Philox4x32::fill(seed, offset + pos / 4, words);
+        func(pos, words, std::min(BATCH_WORDS, end - pos));
+    }
+}
+
+template <typename ctype>
+void fill_uniform(ctype* dst, uint64_t seed, uint64_t offset, size_t begin,
+                  size_t end) {
+    constexpr int bits = UniformBits<ctype>::value;
+    foreach_word_batch(seed, offset, begin, end,
+                       [dst](size_t pos, const uint32_t* words, size_t nr) {
+                           float val[BATCH_WORDS];
+                           for (size_t i = 0; i < BATCH_WORDS; ++i) {
+                               val[i] = uniform_word2float<bits>(words[i]);
+                           }
+                           for (size_t i = 0; i < nr; ++i) {
+                               dst[pos + i] = static_cast<ctype>(val[i]);
+                           }
+                       });
+}
+
+template <typename ctype>
+void fill_gaussian(ctype* dst, uint64_t seed, uint64_t offset, size_t begin,
+                   size_t end, float mean, float stddev) {
+    // gen gaussian by Box-Muller transform; value pairs never cross a block
+    constexpr float TWO_PI = 2 * M_PI;
+    auto cb = [=](size_t pos, const uint32_t* words, size_t nr) {
+        float val[BATCH_WORDS];
+        for (size_t i = 0; i < BATCH_WORDS; i += 2) {
+            float u1 = uniform_word2float<24>(words[i]),
+                  u2 = uniform_word2float<24>(words[i + 1]),
+                  r = stddev * std::sqrt(-2 * std::log(u1)),
+                  theta = TWO_PI * u2;
+            val[i] = r * std::cos(theta) + mean;
+            val[i + 1] = r * std::sin(theta) + mean;
+        }
+        for (size_t i = 0; i < nr; ++i) {
+            dst[pos + i] = static_cast<ctype>(val[i]);
+        }
+    };
+    foreach_word_batch(seed, offset, begin, end, cb);
+}
+
+}  // anonymous namespace
+
+void Philox4x32::fill(uint64_t seed, uint64_t counter, uint32_t* dst) {
+    constexpr uint32_t M0 = 0xD2511F53, M1 = 0xCD9E8D57, W0 = 0x9E3779B9,
+                       W1 = 0xBB67AE85;
+    // keep the state of all the blocks in separate arrays, so the rounds can
+    // be auto-vectorized across blocks
+    uint32_t c0[BATCH], c1[BATCH], c2[BATCH], c3[BATCH];
+    for (size_t i = 0; i < BATCH; ++i) {
+        uint64_t ctr = counter + i;
+        c0[i] = static_cast<uint32_t>(ctr);
+        c1[i] = static_cast<uint32_t>(ctr >> 32);
+        c2[i] = c3[i] = 0;
+    }
+    uint32_t k0 = static_cast<uint32_t>(seed),
+             k1 = static_cast<uint32_t>(seed >> 32);
+    for (int round = 0; round < 10; ++round) {
+        for (size_t i = 0; i < BATCH; ++i) {
+            uint64_t p0 = static_cast<uint64_t>(M0) * c0[i],
+                     p1 = static_cast<uint64_t>(M1) * c2[i];
+            uint32_t hi0 = static_cast<uint32_t>(p0 >> 32),
+                     hi1 = static_cast<uint32_t>(p1 >> 32);
+            c0[i] = hi1 ^ c1[i] ^ k0;
+            c1[i] = static_cast<uint32_t>(p1);
+            c2[i] = hi0 ^ c3[i] ^ k1;
+            c3[i] = static_cast<uint32_t>(p0);
+        }
+        k0 += W0;
+        k1 += W1;
+    }
+    for (size_t i = 0; i < BATCH; ++i) {
+        dst[i * 4] = c0[i];
+        dst[i * 4 + 1] = c1[i];
+        dst[i * 4 + 2] = c2[i];
+        dst[i * 4 + 3] = c3[i];
+    }
+}
+
+void UniformRNGImpl::exec(_megdnn_tensor_inout dst,
+                          _megdnn_workspace workspace) {
+    check_exec(dst.layout, workspace.size);
+    size_t size = dst.layout.total_nr_elems();
+    uint64_t seed = m_param.seed, offset = m_stream.advance(seed, size);
+    size_t nr_tasks = div_ceil(size, TASK_SIZE);
+    switch (dst.layout.dtype.enumv()) {
+#define cb(_dt)                                                          \
+    case DTypeTrait<_dt>::enumv: {                                       \
+        auto ptr = dst.ptr<DTypeTrait<_dt>::ctype>();                    \
+        auto run = [=](size_t index, size_t) {                           \
+            size_t begin = index * TASK_SIZE,                            \
+                   end = std::min(size, begin + TASK_SIZE);              \
+            fill_uniform(ptr, seed, offset, begin, end);                 \
+        };                                                               \
+        MEGDNN_DISPATCH_MULTI_THREAD_CPU_KERN_OPR(run, nr_tasks);        \
+        return;                                                          \
+    }
+        MEGDNN_FOREACH_COMPUTING_DTYPE_FLOAT(cb)
+#undef cb
+        default:
+            megdnn_throw("bad dtype");
+    }
+}
+
+void GaussianRNGImpl::exec(_megdnn_tensor_inout dst,
+                           _megdnn_workspace workspace) {
+    check_exec(dst.layout, workspace.size);
+    size_t size = dst.layout.total_nr_elems();
+    uint64_t seed = m_param.seed, offset = m_stream.advance(seed, size);
+    size_t nr_tasks = div_ceil(size, TASK_SIZE);
+    float mean = m_param.mean, stddev = m_param.std;
+    switch (dst.layout.dtype.enumv()) {
+#define cb(_dt)                                                          \
+    case DTypeTrait<_dt>::enumv: {                                       \
+        auto ptr = dst.ptr<DTypeTrait<_dt>::ctype>();                    \
+        auto run = [=](size_t index, size_t) {                           \
+            size_t begin = index * TASK_SIZE,                            \
+                   end = std::min(size, begin + TASK_SIZE);              \
+            fill_gaussian(ptr, seed, offset, begin, end, mean, stddev);  \
+        };                                                               \
+        MEGDNN_DISPATCH_MULTI_THREAD_CPU_KERN_OPR(run, nr_tasks);        \
+        return;                                                          \
+    }
+        MEGDNN_FOREACH_COMPUTING_DTYPE_FLOAT(cb)
+#undef cb
+        default:
+            megdnn_throw("bad dtype");
+    }
+}
+
+// vim: syntax=cpp.doxygen
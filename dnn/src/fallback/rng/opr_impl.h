@@ -0,0 +1,94 @@
+/**
+ * \file dnn/src/fallback/rng/opr_impl.h
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+#pragma once
+
+#include "megdnn/oprs.h"
+#include <cstdint>
+
+namespace megdnn {
+namespace fallback {
+
+/*!
+ * \brief the Philox4x32-10 counter-based PRNG described in "Parallel random
+ *      numbers: as easy as 1, 2, 3" (Salmon et al., SC 2011)
+ *
+ * Each 64-bit counter is mapped to a block of four 32-bit random words with
+ * the 64-bit seed as key, so any block can be generated independently.
+ */
+class Philox4x32 {
+public:
+    //! number of blocks generated by each call of fill()
+    static constexpr size_t BATCH = 8;
+
+    //! fill dst[4 * i + j] with word j of block (counter + i), i < BATCH
+    static void fill(uint64_t seed, uint64_t counter, uint32_t* dst);
+};
+
+/*!
+ * \brief stream of random words for an RNG opr
+ *
+ * The n-th random word generated by an opr since its seed is set is word
+ * (n % 4) of Philox4x32 block (n / 4); each exec() starts at a new block, so
+ * a call generating \p size values consumes ceil(size / 4) blocks, and
+ * element i of the output only depends on (seed, offset + i / 4, i % 4),
+ * where offset is the number of blocks consumed by previous calls. The
+ * output is therefore identical for any number of threads.
+ */
+class PhiloxStream {
+    uint64_t m_seed = 0, m_offset = 0;
+
+public:
+    //! get block offset for \p size values, and advance the stream
+    uint64_t advance(uint64_t seed, size_t size) {
+        if (seed != m_seed) {
+            m_seed = seed;
+            m_offset = 0;
+        }
+        auto ret = m_offset;
+        m_offset += (size + 3) / 4;
+        return ret;
+    }
+};
+
+/*!
+ * \brief uniform sampling on (0, 1] from Philox4x32; a 32-bit word x is
+ *      mapped to ((x >> (32 - m)) + 1) * 2^-m, where m is the number of
+ *      significand bits of the dtype
+ */
+class UniformRNGImpl : public UniformRNG {
+    PhiloxStream m_stream;
+
+public:
+    using UniformRNG::UniformRNG;
+    void exec(_megdnn_tensor_inout dst, _megdnn_workspace) override;
+
+    size_t get_workspace_in_bytes(const TensorLayout&) override { return 0; }
+};
+
+/*!
+ * \brief gaussian sampling by Box-Muller transform on Philox4x32; words
+ *      (2k, 2k + 1) are mapped to uniform u1, u2 with 24 bits, and give
+ *      values 2k and 2k + 1 by r * cos(theta) and r * sin(theta)
+ */
+class GaussianRNGImpl : public GaussianRNG {
+    PhiloxStream m_stream;
+
+public:
+    using GaussianRNG::GaussianRNG;
+    void exec(_megdnn_tensor_inout dst, _megdnn_workspace) override;
+
+    size_t get_workspace_in_bytes(const TensorLayout&) override { return 0; }
+};
+
+}  // namespace fallback
+}  // namespace megdnn
+
+// vim: syntax=cpp.doxygen
@@ -0,0 +1,204 @@
+/**
+ * \file dnn/src/x86/argsort/opr_impl.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+#include "src/x86/argsort/opr_impl.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include "src/common/utils.h"
+#include "src/naive/handle.h"
+
+using namespace megdnn;
+using namespace x86;
+
+#include "midout.h"
+MIDOUT_DECL(megdnn_x86_argsort)
+
+namespace {
+
+//! rows shorter than this are sorted by std::sort
+constexpr size_t RADIX_MIN_LEN = 64;
+//! number of uint32 in the scratch for each element of a row
+constexpr size_t SCRATCH_PER_ELEM = 4;
+
+//! map values to uint32 keys with the same order
+template <typename ctype>
+struct RadixKey;
+
+template <>
+struct RadixKey<dt_float32> {
+    static uint32_t get(dt_float32 v) {
+        uint32_t u;
+        memcpy(&u, &v, sizeof(u));
+        //! -0 and +0 compare equal
+        if (u == 0x80000000u) {
+            u = 0;
+        }
+        return (u & 0x80000000u) ? ~u : u | 0x80000000u;
+    }
+};
+
+template <>
+struct RadixKey<dt_int32> {
+    static uint32_t get(dt_int32 v) {
+        return static_cast<uint32_t>(v) ^ 0x80000000u;
+    }
+};
+
+/*!
+ * \brief stable LSD radix sort of a row
+ *
+ * Ties are ordered the same as sorting (value, index) pairs by std::less or
+ * std::greater: descending order is done by sorting inverted keys of the
+ * reversed row.
+ */
+template <typename ctype>
+void radix_sort_row(const ctype* sptr, ctype* dptr, dt_int32* iptr, size_t N,
+                    bool ascending, uint32_t* scratch) {
+    uint32_t *key = scratch, *key_tmp = scratch + N, *id = scratch + 2 * N,
+             *id_tmp = scratch + 3 * N;
+    uint32_t hist[4][256];
+    memset(hist, 0, sizeof(hist));
+    uint32_t flip = ascending ? 0 : ~0u;
+    for (size_t i = 0; i < N; ++i) {
+        size_t src_idx = ascending ? i : N - 1 - i;
+        uint32_t k = RadixKey<ctype>::get(sptr[src_idx]) ^ flip;
+        key[i] = k;
+        id[i] = src_idx;
+        ++hist[0][k & 0xff];
+        ++hist[1][(k >> 8) & 0xff];
+        ++hist[2][(k >> 16) & 0xff];
+        ++hist[3][k >> 24];
+    }
+    for (size_t pass = 0; pass < 4; ++pass) {
+        uint32_t* h = hist[pass];
+        size_t shift = pass * 8;
+        if (h[(key[0] >> shift) & 0xff] == N) {
+            //! all keys have the same digit
+            continue;
+        }
+        uint32_t sum = 0;
+        for (size_t i = 0; i < 256; ++i) {
+            uint32_t cnt = h[i];
+            h[i] = sum;
+            sum += cnt;
+        }
+        for (size_t i = 0; i < N; ++i) {
+            uint32_t pos = h[(key[i] >> shift) & 0xff]++;
+            key_tmp[pos] = key[i];
+            id_tmp[pos] = id[i];
+        }
+        std::swap(key, key_tmp);
+        std::swap(id, id_tmp);
+    }
+    for (size_t i = 0; i < N; ++i) {
+        iptr[i] = id[i];
+        dptr[i] = sptr[id[i]];
+    }
+}
+
+template <typename ctype>
+void std_sort_row(const ctype* sptr, ctype* dptr, dt_int32* iptr, size_t N,
+                  bool ascending, uint32_t* scratch) {
+    using KV = std::pair<ctype, int>;
+    static_assert(sizeof(KV) <= sizeof(uint32_t) * SCRATCH_PER_ELEM,
+                  "scratch too small");
+    KV* row = reinterpret_cast<KV*>(scratch);
+    for (size_t i = 0; i < N; ++i) {
+        row[i].first = sptr[i];
+        row[i].second = i;
+    }
+    if (ascending) {
+        std::sort(row, row + N);
+    } else {
+        std::sort(row, row + N, std::greater<KV>{});
+    }
+    for (size_t i = 0; i < N; ++i) {
+        dptr[i] = row[i].first;
+        iptr[i] = row[i].second;
+    }
+}
+
+template <typename ctype>
+struct SortRow {
+    static void run(const ctype* sptr, ctype* dptr, dt_int32* iptr, size_t N,
+                    bool ascending, uint32_t* scratch) {
+        std_sort_row(sptr, dptr, iptr, N, ascending, scratch);
+    }
+};
+
+#define INST(_ctype)                                                        \
+    template <>                                                             \
+    struct SortRow<_ctype> {                                                \
+        static void run(const _ctype* sptr, _ctype* dptr, dt_int32* iptr,   \
+                        size_t N, bool ascending, uint32_t* scratch) {      \
+            if (N < RADIX_MIN_LEN) {                                        \
+                std_sort_row(sptr, dptr, iptr, N, ascending, scratch);      \
+            } else {                                                        \
+                radix_sort_row(sptr, dptr, iptr, N, ascending, scratch);    \
+            }                                                               \
+        }                                                                   \
+    };
+INST(dt_float32)
+INST(dt_int32)
+#undef INST
+
+size_t get_nr_threads(Handle* handle) {
+    return static_cast<naive::HandleImpl*>(handle)
+            ->megcore_dispatcher()
+            ->nr_threads();
+}
+
+}  // anonymous namespace
+
+void ArgsortForwardImpl::exec(_megdnn_tensor_in src, _megdnn_tensor_out dst,
+                              _megdnn_tensor_out indices,
+                              _megdnn_workspace workspace) {
+    check_exec(src.layout, dst.layout, indices.layout, workspace.size);
+    size_t M = src.layout.shape[0], N = src.layout.shape[1];
+    auto iptr = indices.ptr<dt_int32>();
+    auto scratch = workspace.ptr<uint32_t>();
+    bool ascending = param().order == Order::ASCENDING;
+    switch (src.layout.dtype.enumv()) {
+#define cb(dt)                                                               \
+    case DTypeTrait<dt>::enumv: {                                            \
+        MIDOUT_BEGIN(megdnn_x86_argsort, dt) {                               \
+            using ctype = DTypeTrait<dt>::ctype;                             \
+            auto sptr = src.ptr<ctype>();                                    \
+            auto dptr = dst.ptr<ctype>();                                    \
+            auto run = [=](size_t m, size_t thread_id) {                     \
+                SortRow<ctype>::run(sptr + m * N, dptr + m * N, iptr + m * N, \
+                                    N, ascending,                            \
+                                    scratch + thread_id * N *                \
+                                                      SCRATCH_PER_ELEM);     \
+            };                                                               \
+            MEGDNN_DISPATCH_MULTI_THREAD_CPU_KERN_OPR(run, M);               \
+            return;                                                          \
+        }                                                                    \
+        MIDOUT_END();                                                        \
+        break;                                                               \
+    }
+        MEGDNN_FOREACH_COMPUTING_DTYPE(cb)
+#undef cb
+        default:
+            break;
+    }
+    naive::ArgsortForwardImpl::exec(src, dst, indices, workspace);
+}
+
+size_t ArgsortForwardImpl::get_workspace_in_bytes(const TensorLayout& src,
+                                                  const TensorLayout&,
+                                                  const TensorLayout&) {
+    return get_nr_threads(handle()) * src.shape[1] * SCRATCH_PER_ELEM *
+           sizeof(uint32_t);
+}
+
+// vim: syntax=cpp.doxygen
@@ -0,0 +1,344 @@
+/**
+ * \file dnn/src/x86/batched_matrix_mul/opr_impl.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ */
+#include "src/x86/batched_matrix_mul/opr_impl.h"
+
+#include <algorithm>
+#include <cstring>
+#include "src/common/utils.h"
+#include "src/naive/handle.h"
+#include "src/x86/matrix_mul/f32/common.h"
+#include "src/x86/matrix_mul/f32/kernel_avx2_6x16.h"
+#include "src/x86/matrix_mul/f32/kernel_avx512_14x32.h"
+#include "src/x86/utils.h"
+
+#include "midout.h"
+MIDOUT_DECL(megdnn_x86_batched_matmul)
+
+using namespace megdnn;
+using namespace x86;
+
+namespace {
+
+//! matrices with all of M, N and K not larger than this use the direct kernel
+constexpr size_t SMALL_MAX = 128;
+
+struct KernAVX2 {
+    static constexpr size_t H = 6, W = 16;
+    static void kern(const float* packA, const float* packB, size_t K,
+                     float* C, size_t LDC, bool is_first_k) {
+        matmul_avx2_6x16::kern_6x16(packA, packB, K, C, LDC, is_first_k);
+    }
+};
+
+struct KernAVX512 {
+    static constexpr size_t H = 14, W = 32;
+    static void kern(const float* packA, const float* packB, size_t K,
+                     float* C, size_t LDC, bool is_first_k) {
+        matmul_avx512_14x32::kern_14x32(packA, packB, K, C, LDC, is_first_k);
+    }
+};
+
+size_t get_nr_threads(Handle* handle) {
+    return static_cast<naive::HandleImpl*>(handle)
+            ->megcore_dispatcher()
+            ->nr_threads();
+}
+
+/*!
+ * \brief how the batch is split into tasks
+ *
+ * Each task computes rows [mi * mb, (mi + 1) * mb) of one matrix in the
+ * batch. When B is shared, it is packed by a separate dispatch before the
+ * tasks run: once if it is broadcast, or for each matrix when the batch is
+ * too small to give each thread a whole matrix. Otherwise each task packs
+ * its B into the per-thread workspace.
+ */
+struct Plan {
+    size_t batch, M, N, K;
+    size_t H, W;
+    bool small, share_B, broadcast_B;
+    size_t mb, nr_mb;
+    //! sizes in number of floats
+    size_t packA_size, packB_size;
+    size_t nr_threads;
+
+    Plan(const TensorLayout& A, const TensorLayout& B, const TensorLayout& C,
+         const param::MatrixMul& param, size_t nr_threads_) {
+        bool use_avx512 = is_supported(SIMDType::AVX512F);
+        H = use_avx512 ? KernAVX512::H : KernAVX2::H;
+        W = use_avx512 ? KernAVX512::W : KernAVX2::W;
+        nr_threads = nr_threads_;
+        batch = C.shape[0];
+        M = C.shape[1];
+        N = C.shape[2];
+        K = param.transposeA ? A.shape[1] : A.shape[2];
+        broadcast_B = batch > 1 && B.stride[0] == 0;
+        small = !param.transposeB && M <= SMALL_MAX && N <= SMALL_MAX &&
+                K <= SMALL_MAX;
+        if (small) {
+            //! the direct kernel is always 6x16
+            H = KernAVX2::H;
+            W = KernAVX2::W;
+        }
+        //! rows of A packed at a time, so that they stay in L2
+        size_t MB = H * 16;
+        share_B = !small && (broadcast_B || batch < nr_threads);
+        if (small || share_B) {
+            mb = std::min(round_up(M, H), MB);
+            if (batch * div_ceil(M, mb) < nr_threads) {
+                mb = round_up(div_ceil(M, div_ceil(nr_threads, batch)), H);
+            }
+        } else {
+            mb = M;
+        }
+        nr_mb = div_ceil(M, mb);
+        if (small) {
+            packA_size = packB_size = 0;
+        } else {
+            packA_size = round_up(std::min(mb, MB), H) * K;
+            packB_size = round_up(N, W) * K;
+        }
+    }
+
+    size_t nr_shared_B() const {
+        return share_B ? (broadcast_B ? 1 : batch) : 0;
+    }
+
+    size_t per_thread_size() const {
+        return packA_size + (share_B ? 0 : packB_size);
+    }
+
+    WorkspaceBundle bundle(void* ptr) const {
+        return {ptr,
+                {nr_shared_B() * packB_size * sizeof(float),
+                 nr_threads * per_thread_size() * sizeof(float)}};
+    }
+};
+
+struct MatPtrs {
+    const float *A, *B;
+    float* C;
+    ptrdiff_t A_batch, B_batch, C_batch;
+    size_t lda, ldb, ldc;
+    bool trA, trB;
+
+    MatPtrs(const TensorND& A_, const TensorND& B_, const TensorND& C_,
+            const param::MatrixMul& param)
+            : A{A_.ptr<dt_float32>()},
+              B{B_.ptr<dt_float32>()},
+              C{C_.ptr<dt_float32>()},
+              A_batch{A_.layout.stride[0]},
+              B_batch{B_.layout.stride[0]},
+              C_batch{C_.layout.stride[0]},
+              lda{static_cast<size_t>(A_.layout.stride[1])},
+              ldb{static_cast<size_t>(B_.layout.stride[1])},
+              ldc{static_cast<size_t>(C_.layout.stride[1])},
+              trA{param.transposeA},
+              trB{param.transposeB} {}
+};
+
+template <size_t W>
+void pack_B(const MatPtrs& p, float* out, const float* B, size_t n0,
+            size_t n1, size_t K) {
+    if (p.trB) {
+        matmul_f32::pack_strided<W>(out, B, p.ldb, n0, n1, 0, K);
+    } else {
+        matmul_f32::pack_contig<W>(out, B, p.ldb, n0, n1, 0, K);
+    }
+}
+
+//! compute rows [m_begin, m_end) of matrix b with the packed kernel
+template <class Kern>
+void run_packed(const Plan& plan, const MatPtrs& p, size_t b, size_t m_begin,
+                size_t m_end, float* packA, const float* packB) {
+    constexpr size_t H = Kern::H;
+    size_t K = plan.K, MB = H * 16;
+    const float* A = p.A + b * p.A_batch;
+    float* C = p.C + b * p.C_batch;
+    for (size_t m0 = m_begin; m0 < m_end; m0 += MB) {
+        size_t m1 = std::min(m0 + MB, m_end);
+        if (p.trA) {
+            matmul_f32::pack_contig<H>(packA, A, p.lda, m0, m1, 0, K);
+        } else {
+            matmul_f32::pack_strided<H>(packA, A, p.lda, m0, m1, 0, K);
+        }
+        matmul_f32::gemm_kern_driver<H, Kern::W>(Kern::kern, packA, packB,
+                                                 m1 - m0, plan.N, K,
+                                                 C + m0 * p.ldc, p.ldc, true);
+    }
+}
+
+template <class Kern>
+void exec_packed(Handle* handle, const Plan& plan, const MatPtrs& p,
+                 const WorkspaceBundle& bundle) {
+    constexpr size_t W = Kern::W;
+    auto shared_B = static_cast<float*>(bundle.get(0));
+    auto thread_buf = static_cast<float*>(bundle.get(1));
+    if (plan.share_B) {
+        //! split the N panels of each shared B among the threads
+        size_t nr_panels = div_ceil(plan.N, W);
+        size_t nr_chunks = std::min(
+                nr_panels,
+                std::max<size_t>(1, plan.nr_threads / plan.nr_shared_B()));
+        size_t chunk = div_ceil(nr_panels, nr_chunks) * W;
+        nr_chunks = div_ceil(plan.N, chunk);
+        auto pack = [=](size_t index, size_t) {
+            size_t b = index / nr_chunks, n0 = index % nr_chunks * chunk;
+            size_t n1 = std::min(n0 + chunk, plan.N);
+            pack_B<W>(p, shared_B + b * plan.packB_size + n0 * plan.K,
+                      p.B + b * p.B_batch, n0, n1, plan.K);
+        };
+        MEGDNN_DISPATCH_MULTI_THREAD_CPU_KERN(
+                static_cast<naive::HandleImpl*>(handle),
+                plan.nr_shared_B() * nr_chunks, pack);
+    }
+    auto run = [=](size_t index, size_t thread_id) {
+        size_t b = index / plan.nr_mb, mi = index % plan.nr_mb;
+        float* packA = thread_buf + thread_id * plan.per_thread_size();
+        const float* packB;
+        if (plan.share_B) {
+            packB = shared_B + (plan.broadcast_B ? 0 : b) * plan.packB_size;
+        } else {
+            float* buf = packA + plan.packA_size;
+            pack_B<W>(p, buf, p.B + b * p.B_batch, 0, plan.N, plan.K);
+            packB = buf;
+        }
+        size_t m0 = mi * plan.mb, m1 = std::min(m0 + plan.mb, plan.M);
+        run_packed<Kern>(plan, p, b, m0, m1, packA, packB);
+    };
+    MEGDNN_DISPATCH_MULTI_THREAD_CPU_KERN(
+            static_cast<naive::HandleImpl*>(handle), plan.batch * plan.nr_mb,
+            run);
+}
+
+/*!
+ * \brief compute rows [m_begin, m_end) of a small matrix with the direct
+ *      kernel; edge tiles go through buffers on the stack
+ */
+void run_small(const Plan& plan, const MatPtrs& p, size_t b, size_t m_begin,
+               size_t m_end) {
+    constexpr size_t H = KernAVX2::H, W = KernAVX2::W;
+    size_t N = plan.N, K = plan.K;
+    const float* A = p.A + b * p.A_batch;
+    const float* B = p.B + b * p.B_batch;
+    float* C = p.C + b * p.C_batch;
+    size_t a_row_step = p.trA ? 1 : p.lda, a_k_step = p.trA ? p.lda : 1;
+
+    alignas(32) float tmp_a[H * SMALL_MAX];
+    alignas(32) float tmp_b[SMALL_MAX * W];
+    alignas(32) float tmp_c[H * W];
+    size_t m_full = m_begin + (m_end - m_begin) / H * H;
+    size_t m_tail = m_end - m_full;
+    if (m_tail) {
+        memset(tmp_a, 0, sizeof(float) * H * K);
+        for (size_t i = 0; i < m_tail; ++i) {
+            const float* src = A + (m_full + i) * a_row_step;
+            for (size_t k = 0; k < K; ++k) {
+                tmp_a[i * K + k] = src[k * a_k_step];
+            }
+        }
+    }
+    for (size_t n = 0; n < N; n += W) {
+        size_t nr = std::min(W, N - n);
+        const float* bptr = B + n;
+        size_t ldb = p.ldb;
+        if (nr < W) {
+            memset(tmp_b, 0, sizeof(float) * K * W);
+            for (size_t k = 0; k < K; ++k) {
+                memcpy(tmp_b + k * W, B + k * p.ldb + n, sizeof(float) * nr);
+            }
+            bptr = tmp_b;
+            ldb = W;
+        }
+        for (size_t m = m_begin; m < m_full; m += H) {
+            const float* aptr = A + m * a_row_step;
+            float* cptr = C + m * p.ldc + n;
+            if (nr == W) {
+                matmul_avx2_6x16::kern_6x16_direct(aptr, a_row_step, a_k_step,
+                                                   bptr, ldb, K, cptr, p.ldc);
+            } else {
+                matmul_avx2_6x16::kern_6x16_direct(aptr, a_row_step, a_k_step,
+                                                   bptr, ldb, K, tmp_c, W);
+                for (size_t i = 0; i < H; ++i) {
+                    memcpy(cptr + i * p.ldc, tmp_c + i * W,
+                           sizeof(float) * nr);
+                }
+            }
+        }
+        if (m_tail) {
+            matmul_avx2_6x16::kern_6x16_direct(tmp_a, K, 1, bptr, ldb, K,
+                                               tmp_c, W);
+            float* cptr = C + m_full * p.ldc + n;
+            for (size_t i = 0; i < m_tail; ++i) {
+                memcpy(cptr + i * p.ldc, tmp_c + i * W, sizeof(float) * nr);
+            }
+        }
+    }
+}
+
+}  // anonymous namespace
+
+bool BatchedMatrixMulImpl::is_f32_usable(const TensorLayout& A,
+                                         const TensorLayout& B,
+                                         const TensorLayout& C) const {
+    return A.dtype == dtype::Float32() && B.dtype == dtype::Float32() &&
+           C.dtype == dtype::Float32() &&
+           param().format == param::MatrixMul::Format::DEFAULT &&
+           param().compute_mode == param::MatrixMul::ComputeMode::DEFAULT &&
+           is_supported(SIMDType::AVX) && is_supported(SIMDType::FMA);
+}
+
+size_t BatchedMatrixMulImpl::get_workspace_in_bytes(const TensorLayout& A,
+                                                    const TensorLayout& B,
+                                                    const TensorLayout& C) {
+    if (!is_f32_usable(A, B, C)) {
+        return fallback::BatchedMatrixMulImpl::get_workspace_in_bytes(A, B,
+                                                                      C);
+    }
+    return Plan(A, B, C, param(), get_nr_threads(handle()))
+            .bundle(nullptr)
+            .total_size_in_bytes();
+}
+
+void BatchedMatrixMulImpl::exec(_megdnn_tensor_in A, _megdnn_tensor_in B,
+                                _megdnn_tensor_out C,
+                                _megdnn_workspace workspace) {
+    if (!is_f32_usable(A.layout, B.layout, C.layout)) {
+        return fallback::BatchedMatrixMulImpl::exec(A, B, C, workspace);
+    }
+    check_exec(A.layout, B.layout, C.layout, workspace.size);
+    MIDOUT_BEGIN(megdnn_x86_batched_matmul, midout_iv(0)) {
+        Plan plan(A.layout, B.layout, C.layout, param(),
+                  get_nr_threads(handle()));
+        MatPtrs p(A, B, C, param());
+        if (plan.small) {
+            auto run = [plan, p](size_t index, size_t) {
+                size_t b = index / plan.nr_mb, mi = index % plan.nr_mb;
+                size_t m0 = mi * plan.mb,
+                       m1 = std::min(m0 + plan.mb, plan.M);
+                run_small(plan, p, b, m0, m1);
+            };
+            MEGDNN_DISPATCH_MULTI_THREAD_CPU_KERN_OPR(run,
+                                                      plan.batch * plan.nr_mb);
+            return;
+        }
+        auto bundle = plan.bundle(workspace.raw_ptr);
+        if (plan.W == KernAVX512::W) {
+            exec_packed<KernAVX512>(handle(), plan, p, bundle);
+        } else {
+            exec_packed<KernAVX2>(handle(), plan, p, bundle);
+        }
+    }
+    MIDOUT_END();
+}
+
+// vim: syntax=cpp.doxygen
@@ -0,0 +1,46 @@
+/**
+ * \file dnn/src/x86/batched_matrix_mul/opr_impl.h
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ */
+#pragma once
+
+#include "src/fallback/batched_matrix_mul/opr_impl.h"
+
+namespace megdnn {
+namespace x86 {
+
+/*!
+ * \brief fp32 batched matmul on the packed x86 GEMM kernels
+ *
+ * The batch is split into (batch, row block) tasks run by the multi thread
+ * dispatcher. B is packed once when it is broadcast (stride[0] == 0), and
+ * small matrices are computed by a kernel that reads A and B in place.
+ * Other dtypes and formats go to the fallback implementation.
+ */
+class BatchedMatrixMulImpl : public fallback::BatchedMatrixMulImpl {
+public:
+    using fallback::BatchedMatrixMulImpl::BatchedMatrixMulImpl;
+
+    void exec(_megdnn_tensor_in A, _megdnn_tensor_in B, _megdnn_tensor_out C,
+              _megdnn_workspace workspace) override;
+
+    size_t get_workspace_in_bytes(const TensorLayout& A,
+                                  const TensorLayout& B,
+                                  const TensorLayout& C) override;
+
+private:
+    bool is_f32_usable(const TensorLayout& A, const TensorLayout& B,
+                       const TensorLayout& C) const;
+};
+
+}  // namespace x86
+}  // namespace megdnn
+
+// vim: syntax=cpp.doxygen
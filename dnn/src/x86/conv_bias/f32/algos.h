@@ -164,6 +164,66 @@ public:
     }
 };
 
+/* ===================== nchw88 algos ===================== */
+class ConvBiasImpl::AlgoF32DirectNCHW88 final : public AlgoBase {
+public:
+    bool is_reproducible() const override { return true; }
+    const char* name() const override { return "X86_F32_CONV_NCHW88_DIRECT"; }
+    bool usable(const NCBKernSizeParam& param,
+                AlgoSelectionStrategy algo_selection_strategy) const override;
+
+    size_t get_workspace(const NCBKernSizeParam& param) const override;
+
+    SmallVector<NCBKern> dispatch_kerns(
+            const NCBKernSizeParam& param) const override;
+
+    void* type() const override;
+
+    ConvAlgoTypePack get_algo_type() const override {
+        return {AlgoDataType::FLOAT32, AlgoCategory::DIRECT};
+    }
+};
+
+class ConvBiasImpl::AlgoF32DirectNCHWNCHW88 final : public AlgoBase {
+public:
+    bool is_reproducible() const override { return true; }
+    const char* name() const override { return "X86_F32_CONV_NCHW_NCHW88"; }
+    bool usable(const NCBKernSizeParam& param,
+                AlgoSelectionStrategy algo_selection_strategy) const override;
+
+    size_t get_workspace(const NCBKernSizeParam& param) const override;
+
+    SmallVector<NCBKern> dispatch_kerns(
+            const NCBKernSizeParam& param) const override;
+
+    void* type() const override;
+
+    ConvAlgoTypePack get_algo_type() const override {
+        return {AlgoDataType::FLOAT32, AlgoCategory::DIRECT};
+    }
+};
+
+class ConvBiasImpl::AlgoF32ChannelWiseNCHW88 final : public AlgoBase {
+public:
+    bool is_reproducible() const override { return true; }
+    const char* name() const override {
+        return "X86_F32_CHANNEL_WISE_NCHW88";
+    }
+    bool usable(const NCBKernSizeParam& param,
+                AlgoSelectionStrategy algo_selection_strategy) const override;
+
+    size_t get_workspace(const NCBKernSizeParam& param) const override;
+
+    SmallVector<NCBKern> dispatch_kerns(
+            const NCBKernSizeParam& param) const override;
+
+    void* type() const override;
+
+    ConvAlgoTypePack get_algo_type() const override {
+        return {AlgoDataType::FLOAT32, AlgoCategory::DIRECT};
+    }
+};
+
 #if MEGDNN_X86_WITH_MKL_DNN
 class ConvBiasImpl::AlgoMkldnnConv final : public AlgoBase {
     static void kern_mkldnn_fp32(const NCBKernParam& param,
@@ -0,0 +1,395 @@
+/**
+ * \file dnn/src/x86/conv_bias/f32/f32_nchw88_algo.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ */
+
+#include "src/x86/conv_bias/f32/algos.h"
+#include "src/x86/conv_bias/f32/nchw88_kern.h"
+#include "src/x86/conv_bias/opr_impl.h"
+
+#include "midout.h"
+
+using namespace megdnn;
+using namespace x86;
+using namespace nchw88;
+
+MIDOUT_DECL(megdnn_x86_conv_bias_f32_nchw88)
+
+namespace {
+using conv_fun = std::function<void(
+        const WorkspaceBundle& bundle,
+        const ConvBiasImpl::NCBKernParam& kern_param,
+        const ConvBiasImpl::NCBKernIndex& ncb_index)>;
+
+using NoneOpAvx2 = NoneOp<SIMDType::AVX2, dt_float32>;
+using ReluOpAvx2 = ReluOp<SIMDType::AVX2, dt_float32>;
+using HSwishOpAvx2 = HSwishOp<SIMDType::AVX2, dt_float32>;
+using SigmoidOpAvx2 = SigmoidOp<SIMDType::AVX2, dt_float32>;
+
+//! oh block of each task and the shape of its padded src rows
+void get_rectified_size(const ConvBiasImpl::NCBKernSizeParam& param,
+                        int& oh_block, int& ih2, int& iw2) {
+    auto&& fm = param.filter_meta;
+    int ic = fm.icpg;
+    int oh = param.osz[0];
+    int ow = param.osz[1];
+    int filter = fm.spatial[0];
+    int stride = fm.stride[0];
+    iw2 = get_padded_iw(ow, filter, stride);
+    oh_block = get_oh_block(param.nr_threads, oh,
+                            ic * iw2 * sizeof(float) * stride);
+    ih2 = (oh_block - 1) * stride + filter;
+}
+
+//! icpg of nchw88 src already counts the packed channels
+size_t get_perthread_cache_bytes(const ConvBiasImpl::NCBKernSizeParam& param) {
+    int oh_block, ih2, iw2;
+    get_rectified_size(param, oh_block, ih2, iw2);
+    return static_cast<size_t>(param.filter_meta.icpg) * ih2 * iw2 *
+           sizeof(float);
+}
+
+WorkspaceBundle get_bundle(const ConvBiasImpl::NCBKernSizeParam& param) {
+    size_t src_size = get_perthread_cache_bytes(param);
+    return {nullptr, {src_size * param.nr_threads}};
+}
+
+template <BiasMode bias_mode, typename Op, int filter, int stride>
+void do_conv_kern(const WorkspaceBundle& bundle,
+                  const ConvBiasImpl::NCBKernParam& kern_param,
+                  const ConvBiasImpl::NCBKernIndex& ncb_index) {
+    auto&& fm = kern_param.filter_meta;
+    const int ih = kern_param.isz[0];
+    const int iw = kern_param.isz[1];
+    const int oh = kern_param.osz[0];
+    const int ow = kern_param.osz[1];
+    const int ph = fm.padding[0];
+    const int pw = fm.padding[1];
+    const int ic = fm.icpg;
+    const int oc = fm.ocpg;
+    int oh_block, ih2, iw2;
+    get_rectified_size(kern_param, oh_block, ih2, iw2);
+
+    const size_t batch_id = ncb_index.ndrange_id[0];
+    const size_t group_id = ncb_index.ndrange_id[1];
+    const int oh_start = ncb_index.ndrange_id[2] * oh_block;
+    const int oh_block_real = std::min(oh - oh_start, oh_block);
+    const int ih_real = (oh_block_real - 1) * stride + filter;
+
+    float* sptr = reinterpret_cast<float*>(
+            static_cast<int8_t*>(bundle.get(0)) +
+            ncb_index.thread_id * get_perthread_cache_bytes(kern_param));
+    pack_src_padding(sptr, kern_param.src<float>(batch_id, group_id),
+                     ic / PACK_SIZE, static_cast<size_t>(ih) * iw * PACK_SIZE,
+                     ih, iw, oh_start * stride - ph, ih_real, iw2, pw,
+                     PACK_SIZE);
+    conv_direct_nchw88<bias_mode, Op, filter, stride>(
+            sptr, kern_param.filter<float>(group_id),
+            kern_param.bias<float>(batch_id, group_id),
+            kern_param.dst<float>(batch_id, group_id), oc / PACK_SIZE,
+            ic / PACK_SIZE, ih_real, iw2, oh, ow, oh_start, oh_block_real,
+            Op());
+}
+
+template <BiasMode bias_mode, typename Op, int filter, int stride>
+void do_conv_kern_nchw_nchw88(const WorkspaceBundle& bundle,
+                              const ConvBiasImpl::NCBKernParam& kern_param,
+                              const ConvBiasImpl::NCBKernIndex& ncb_index) {
+    auto&& fm = kern_param.filter_meta;
+    const int ih = kern_param.isz[0];
+    const int iw = kern_param.isz[1];
+    const int oh = kern_param.osz[0];
+    const int ow = kern_param.osz[1];
+    const int ph = fm.padding[0];
+    const int pw = fm.padding[1];
+    const int ic = fm.icpg;
+    const int oc = fm.ocpg;
+    int oh_block, ih2, iw2;
+    get_rectified_size(kern_param, oh_block, ih2, iw2);
+
+    const size_t batch_id = ncb_index.ndrange_id[0];
+    const int oh_start = ncb_index.ndrange_id[2] * oh_block;
+    const int oh_block_real = std::min(oh - oh_start, oh_block);
+    const int ih_real = (oh_block_real - 1) * stride + filter;
+
+    float* sptr = reinterpret_cast<float*>(
+            static_cast<int8_t*>(bundle.get(0)) +
+            ncb_index.thread_id * get_perthread_cache_bytes(kern_param));
+    pack_src_padding(sptr, kern_param.src<float>(batch_id, 0), ic,
+                     static_cast<size_t>(ih) * iw, ih, iw,
+                     oh_start * stride - ph, ih_real, iw2, pw, 1);
+    conv_nchw_nchw88<bias_mode, Op, filter, stride>(
+            sptr, kern_param.filter<float>(0),
+            kern_param.bias<float>(batch_id, 0),
+            kern_param.dst<float>(batch_id, 0), oc / PACK_SIZE, ic, ih_real,
+            iw2, oh, ow, oh_start, oh_block_real, Op());
+}
+
+template <BiasMode bias_mode, typename Op, int filter, int stride>
+void do_conv_kern_chanwise(const WorkspaceBundle& bundle,
+                           const ConvBiasImpl::NCBKernParam& kern_param,
+                           const ConvBiasImpl::NCBKernIndex& ncb_index) {
+    auto&& fm = kern_param.filter_meta;
+    const int ih = kern_param.isz[0];
+    const int iw = kern_param.isz[1];
+    const int oh = kern_param.osz[0];
+    const int ow = kern_param.osz[1];
+    const int ph = fm.padding[0];
+    const int pw = fm.padding[1];
+    const int iw2 = get_padded_iw(ow, filter, stride);
+    const int ih2 = (oh - 1) * stride + filter;
+
+    const size_t batch_id = ncb_index.ndrange_id[0];
+    const size_t group_pack_id = ncb_index.ndrange_id[1];
+    float* sptr = reinterpret_cast<float*>(bundle.get(0)) +
+                  ncb_index.thread_id * ih2 * iw2 * PACK_SIZE;
+    pack_src_padding(
+            sptr,
+            kern_param.src<float>(batch_id, group_pack_id, 0, PACK_SIZE), 1,
+            0, ih, iw, -ph, ih2, iw2, pw, PACK_SIZE);
+    conv_chanwise_nchw88<bias_mode, Op, filter, stride>(
+            sptr, kern_param.filter<float>(group_pack_id, PACK_SIZE),
+            kern_param.bias<float>(batch_id, group_pack_id, 0, PACK_SIZE),
+            kern_param.dst<float>(batch_id, group_pack_id, 0, PACK_SIZE), iw2,
+            oh, ow, Op());
+}
+
+WorkspaceBundle get_bundle_chanwise(
+        const ConvBiasImpl::NCBKernSizeParam& param) {
+    auto&& fm = param.filter_meta;
+    size_t filter = fm.spatial[0], stride = fm.stride[0];
+    size_t iw2 = get_padded_iw(param.osz[1], filter, stride);
+    size_t ih2 = (param.osz[0] - 1) * stride + filter;
+    return {nullptr,
+            {ih2 * iw2 * PACK_SIZE * sizeof(float) * param.nr_threads}};
+}
+
+bool is_avx2_fp32(const ConvBiasImpl::NCBKernSizeParam& param) {
+    auto&& fm = param.filter_meta;
+    return is_supported(SIMDType::AVX2) && is_supported(SIMDType::FMA) &&
+           param.src_type.enumv() == DTypeEnum::Float32 &&
+           param.filter_type.enumv() == DTypeEnum::Float32 &&
+           param.dst_type.enumv() == DTypeEnum::Float32 &&
+           fm.format == param::ConvBias::Format::NCHW88 &&
+           fm.spatial_ndim == 2 && fm.spatial[0] == fm.spatial[1] &&
+           fm.dilation[0] == 1 && fm.dilation[1] == 1 &&
+           fm.stride[0] == fm.stride[1] &&
+           (fm.stride[0] == 1 || fm.stride[0] == 2) && !fm.should_flip &&
+           (fm.spatial[0] == 1 || fm.spatial[0] == 2 || fm.spatial[0] == 3 ||
+            fm.spatial[0] == 5 || fm.spatial[0] == 7);
+}
+
+}  // namespace
+
+#define DO_CONV_KERN_FUN(_fun, filter, bias_mode, op, stride)             \
+    MIDOUT_BEGIN(megdnn_x86_conv_bias_f32_nchw88,                         \
+                 midout_iv(#_fun #filter #bias_mode #op #stride##_hash)) { \
+        do_conv_fun = _fun<bias_mode, op, filter, stride>;                \
+    }                                                                     \
+    MIDOUT_END();
+
+#define GET_STRIDE_PARAM(_fun, filter, bias_mode, op)         \
+    switch (fm.stride[0]) {                                   \
+        case 1:                                               \
+            DO_CONV_KERN_FUN(_fun, filter, bias_mode, op, 1); \
+            break;                                            \
+        case 2:                                               \
+            DO_CONV_KERN_FUN(_fun, filter, bias_mode, op, 2); \
+            break;                                            \
+        default:                                              \
+            megdnn_assert(0);                                 \
+    }
+
+#define GET_OP_PARAM(_fun, filter, bias_mode)                        \
+    switch (param.nonlineMode) {                                     \
+        case param::ConvBias::NonlineMode::IDENTITY:                 \
+            GET_STRIDE_PARAM(_fun, filter, bias_mode, NoneOpAvx2)    \
+            break;                                                   \
+        case param::ConvBias::NonlineMode::RELU:                     \
+            GET_STRIDE_PARAM(_fun, filter, bias_mode, ReluOpAvx2)    \
+            break;                                                   \
+        case param::ConvBias::NonlineMode::H_SWISH:                  \
+            GET_STRIDE_PARAM(_fun, filter, bias_mode, HSwishOpAvx2)  \
+            break;                                                   \
+        case param::ConvBias::NonlineMode::SIGMOID:                  \
+            GET_STRIDE_PARAM(_fun, filter, bias_mode, SigmoidOpAvx2) \
+            break;                                                   \
+        default:                                                     \
+            megdnn_assert(0);                                        \
+            break;                                                   \
+    }
+
+#define GET_BIAS_MODE_PARAM(_fun, filter)                                \
+    switch (param.bias_mode) {                                           \
+        case BiasMode::NO_BIAS:                                          \
+            GET_OP_PARAM(_fun, filter, BiasMode::NO_BIAS)                \
+            break;                                                       \
+        case BiasMode::BROADCAST_CHANNEL_BIAS:                           \
+            GET_OP_PARAM(_fun, filter, BiasMode::BROADCAST_CHANNEL_BIAS) \
+            break;                                                       \
+        case BiasMode::BIAS:                                             \
+            GET_OP_PARAM(_fun, filter, BiasMode::BIAS)                   \
+            break;                                                       \
+        default:                                                         \
+            megdnn_assert(0);                                            \
+            break;                                                       \
+    }
+
+#define DISPATCH_CONV_KERN(_fun)            \
+    switch (param.filter_meta.spatial[0]) { \
+        case 1:                             \
+            GET_BIAS_MODE_PARAM(_fun, 1)    \
+            break;                          \
+        case 2:                             \
+            GET_BIAS_MODE_PARAM(_fun, 2)    \
+            break;                          \
+        case 3:                             \
+            GET_BIAS_MODE_PARAM(_fun, 3)    \
+            break;                          \
+        case 5:                             \
+            GET_BIAS_MODE_PARAM(_fun, 5)    \
+            break;                          \
+        case 7:                             \
+            GET_BIAS_MODE_PARAM(_fun, 7)    \
+            break;                          \
+        default:                            \
+            megdnn_assert(0);               \
+            break;                          \
+    }
+
+/* ===================== direct nchw88 algo ===================== */
+bool ConvBiasImpl::AlgoF32DirectNCHW88::usable(const NCBKernSizeParam& param,
+                                               AlgoSelectionStrategy) const {
+    auto&& fm = param.filter_meta;
+    bool ok_src_dst = fm.icpg % PACK_SIZE == 0 && fm.ocpg % PACK_SIZE == 0;
+    return is_avx2_fp32(param) && ok_src_dst;
+}
+
+size_t ConvBiasImpl::AlgoF32DirectNCHW88::get_workspace(
+        const NCBKernSizeParam& param) const {
+    MIDOUT_BEGIN(megdnn_x86_conv_bias_f32_nchw88,
+                 midout_iv("AlgoF32DirectNCHW88::get_workspace"_hash)) {
+        return get_bundle(param).total_size_in_bytes();
+    }
+    MIDOUT_END();
+    return 0;
+}
+
+SmallVector<ConvBiasImpl::NCBKern>
+ConvBiasImpl::AlgoF32DirectNCHW88::dispatch_kerns(
+        const NCBKernSizeParam& param) const {
+    auto&& fm = param.filter_meta;
+    WorkspaceBundle wbundle = get_bundle(param);
+    conv_fun do_conv_fun = nullptr;
+
+    DISPATCH_CONV_KERN(do_conv_kern);
+    megdnn_assert(do_conv_fun);
+
+    int oh_block, ih2, iw2;
+    get_rectified_size(param, oh_block, ih2, iw2);
+    CpuNDRange ncb_range = {param.n, fm.group,
+                            div_ceil<size_t>(param.osz[0], oh_block)};
+    auto do_conv = [wbundle, do_conv_fun](
+                           const NCBKernParam& kern_param,
+                           const NCBKernIndex& ncb_index) mutable {
+        wbundle.set(kern_param.workspace_ptr);
+        do_conv_fun(wbundle, kern_param, ncb_index);
+    };
+    return {{do_conv, ncb_range}};
+}
+
+/* ===================== nchw to nchw88 algo ===================== */
+bool ConvBiasImpl::AlgoF32DirectNCHWNCHW88::usable(
+        const NCBKernSizeParam& param, AlgoSelectionStrategy) const {
+    return is_avx2_fp32(param) &&
+           nchw_nchwxx_valid<NchwNchwxxType::NCHW88>(
+                   param.src_type.enumv(), param.filter_type.enumv(),
+                   param.dst_type.enumv(), param.filter_meta, param.bias_mode,
+                   param.nonlineMode);
+}
+
+size_t ConvBiasImpl::AlgoF32DirectNCHWNCHW88::get_workspace(
+        const NCBKernSizeParam& param) const {
+    MIDOUT_BEGIN(megdnn_x86_conv_bias_f32_nchw88,
+                 midout_iv("AlgoF32DirectNCHWNCHW88::get_workspace"_hash)) {
+        return get_bundle(param).total_size_in_bytes();
+    }
+    MIDOUT_END();
+    return 0;
+}
+
+SmallVector<ConvBiasImpl::NCBKern>
+ConvBiasImpl::AlgoF32DirectNCHWNCHW88::dispatch_kerns(
+        const NCBKernSizeParam& param) const {
+    auto&& fm = param.filter_meta;
+    WorkspaceBundle wbundle = get_bundle(param);
+    conv_fun do_conv_fun = nullptr;
+
+    DISPATCH_CONV_KERN(do_conv_kern_nchw_nchw88);
+    megdnn_assert(do_conv_fun);
+
+    int oh_block, ih2, iw2;
+    get_rectified_size(param, oh_block, ih2, iw2);
+    CpuNDRange ncb_range = {param.n, 1_z,
+                            div_ceil<size_t>(param.osz[0], oh_block)};
+    auto do_conv = [wbundle, do_conv_fun](
+                           const NCBKernParam& kern_param,
+                           const NCBKernIndex& ncb_index) mutable {
+        wbundle.set(kern_param.workspace_ptr);
+        do_conv_fun(wbundle, kern_param, ncb_index);
+    };
+    return {{do_conv, ncb_range}};
+}
+
+/* ===================== channel wise nchw88 algo ===================== */
+bool ConvBiasImpl::AlgoF32ChannelWiseNCHW88::usable(
+        const NCBKernSizeParam& param, AlgoSelectionStrategy) const {
+    auto&& fm = param.filter_meta;
+    return is_avx2_fp32(param) && fm.icpg == 1 && fm.ocpg == 1 &&
+           fm.group % PACK_SIZE == 0;
+}
+
+size_t ConvBiasImpl::AlgoF32ChannelWiseNCHW88::get_workspace(
+        const NCBKernSizeParam& param) const {
+    MIDOUT_BEGIN(megdnn_x86_conv_bias_f32_nchw88,
+                 midout_iv("AlgoF32ChannelWiseNCHW88::get_workspace"_hash)) {
+        return get_bundle_chanwise(param).total_size_in_bytes();
+    }
+    MIDOUT_END();
+    return 0;
+}
+
+SmallVector<ConvBiasImpl::NCBKern>
+ConvBiasImpl::AlgoF32ChannelWiseNCHW88::dispatch_kerns(
+        const NCBKernSizeParam& param) const {
+    auto&& fm = param.filter_meta;
+    WorkspaceBundle wbundle = get_bundle_chanwise(param);
+    conv_fun do_conv_fun = nullptr;
+
+    DISPATCH_CONV_KERN(do_conv_kern_chanwise);
+    megdnn_assert(do_conv_fun);
+
+    CpuNDRange ncb_range = {param.n, fm.group / PACK_SIZE};
+    auto do_conv = [wbundle, do_conv_fun](
+                           const NCBKernParam& kern_param,
+                           const NCBKernIndex& ncb_index) mutable {
+        wbundle.set(kern_param.workspace_ptr);
+        do_conv_fun(wbundle, kern_param, ncb_index);
+    };
+    return {{do_conv, ncb_range}};
+}
+
+#undef DO_CONV_KERN_FUN
+#undef GET_STRIDE_PARAM
+#undef GET_OP_PARAM
+#undef GET_BIAS_MODE_PARAM
+#undef DISPATCH_CONV_KERN
+
+// vim: syntax=cpp.doxygen
@@ -0,0 +1,305 @@
+/**
+ * \file dnn/src/x86/conv_bias/f32/nchw88_kern.h
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ */
+#pragma once
+
+#include <cstring>
+#include "src/common/utils.h"
+#include "src/fallback/conv_bias/common.h"
+#include "src/x86/elemwise_op.h"
+#include "src/x86/simd_macro/immintrin.h"
+
+namespace megdnn {
+namespace x86 {
+namespace nchw88 {
+
+//! channels packed in the innermost dim of nchw88, one __m256 of fp32
+constexpr int PACK_SIZE = 8;
+//! number of output pixels along ow computed by one micro kernel
+constexpr int OW_BLOCK = 8;
+
+/*!
+ * \brief oh block size of one task, so that the padded src rows of a task
+ *      fit in L2 cache and the tasks are balanced between threads
+ */
+static inline int get_oh_block(int nr_threads, int oh, int bytes_per_row) {
+    constexpr int l2_cache_size = 256 * 1024;
+    int block_per_thread = div_ceil(oh, nr_threads);
+    int best_block = std::max(
+            std::min(oh, (l2_cache_size + bytes_per_row / 2) / bytes_per_row),
+            1);
+    int nr_blocks = div_ceil(block_per_thread, best_block);
+    return div_ceil(block_per_thread, nr_blocks);
+}
+
+//! width of padded src rows, so that full OW_BLOCK kernels never read past it
+static inline int get_padded_iw(int ow, int filter, int stride) {
+    return round_up(ow, OW_BLOCK) * stride + filter - stride;
+}
+
+/*!
+ * \brief copy \p nr_rows rows of \p nr_channels channels into a zero padded
+ *      buffer
+ *
+ * \param src start of the channels, with the given channel stride
+ * \param ih_start the input row of the first row in dst, which may be
+ *      negative in the top padding area
+ * \param pack elements of each pixel, PACK_SIZE for nchw88 and 1 for nchw
+ */
+static inline void pack_src_padding(float* dst, const float* src,
+                                    int nr_channels, size_t src_channel_stride,
+                                    int ih, int iw, int ih_start, int nr_rows,
+                                    int iw2, int pw, int pack) {
+    const int iw_valid = std::min(iw, iw2 - pw);
+    for (int c = 0; c < nr_channels; ++c) {
+        const float* sptr = src + c * src_channel_stride;
+        for (int r = 0; r < nr_rows; ++r) {
+            float* dptr = dst + (c * nr_rows + r) * iw2 * pack;
+            int ih_cur = ih_start + r;
+            if (ih_cur < 0 || ih_cur >= ih || iw_valid <= 0) {
+                memset(dptr, 0, sizeof(float) * iw2 * pack);
+                continue;
+            }
+            memset(dptr, 0, sizeof(float) * pw * pack);
+            memcpy(dptr + pw * pack, sptr + ih_cur * iw * pack,
+                   sizeof(float) * iw_valid * pack);
+            memset(dptr + (pw + iw_valid) * pack, 0,
+                   sizeof(float) * (iw2 - pw - iw_valid) * pack);
+        }
+    }
+}
+
+/*!
+ * \brief initialize accumulators with bias of one oc block
+ *
+ * \p bias points to the 8 channel bias for BROADCAST_CHANNEL_BIAS, or the
+ * first output pixel for BIAS; accumulators past \p ow_valid are unused
+ */
+template <BiasMode bias_mode>
+MEGDNN_ATTRIBUTE_TARGET("avx2")
+static inline void init_acc(__m256 (&acc)[OW_BLOCK], const float* bias,
+                            int ow_valid) {
+    if (bias_mode == BiasMode::BROADCAST_CHANNEL_BIAS) {
+        __m256 vbias = _mm256_loadu_ps(bias);
+        for (int j = 0; j < OW_BLOCK; ++j) {
+            acc[j] = vbias;
+        }
+    } else if (bias_mode == BiasMode::BIAS) {
+        for (int j = 0; j < OW_BLOCK; ++j) {
+            acc[j] = j < ow_valid ? _mm256_loadu_ps(bias + j * PACK_SIZE)
+                                  : _mm256_setzero_ps();
+        }
+    } else {
+        for (int j = 0; j < OW_BLOCK; ++j) {
+            acc[j] = _mm256_setzero_ps();
+        }
+    }
+}
+
+template <typename Op>
+MEGDNN_ATTRIBUTE_TARGET("avx2")
+static inline void store_acc(const __m256 (&acc)[OW_BLOCK], float* dst,
+                             int ow_valid, const Op& op) {
+    for (int j = 0; j < OW_BLOCK; ++j) {
+        if (j < ow_valid) {
+            _mm256_storeu_ps(dst + j * PACK_SIZE, op(acc[j]));
+        }
+    }
+}
+
+/*!
+ * \brief dense nchw88 direct conv of one output row block of one oc block
+ *
+ * src is the padded buffer in [ic/8, ih2, iw2, 8] starting at the first input
+ * pixel of the output row, filter is in [ic/8, fh, fw, 8ic, 8oc]
+ */
+template <BiasMode bias_mode, typename Op, int filter, int stride>
+MEGDNN_ATTRIBUTE_TARGET("avx2,fma")
+static inline void conv_direct_ow_block(const float* src, const float* fptr,
+                                        const float* bias, float* dst,
+                                        int ic_blocks, size_t src_ic_stride,
+                                        int iw2, int ow_valid, const Op& op) {
+    __m256 acc[OW_BLOCK];
+    init_acc<bias_mode>(acc, bias, ow_valid);
+    for (int icb = 0; icb < ic_blocks; ++icb) {
+        const float* sptr = src + icb * src_ic_stride;
+        const float* wptr = fptr + icb * filter * filter * PACK_SIZE * PACK_SIZE;
+        for (int fh = 0; fh < filter; ++fh) {
+            for (int fw = 0; fw < filter; ++fw) {
+                const float* s = sptr + (fh * iw2 + fw) * PACK_SIZE;
+                const float* w = wptr + (fh * filter + fw) * PACK_SIZE * PACK_SIZE;
+                for (int ic = 0; ic < PACK_SIZE; ++ic) {
+                    __m256 vw = _mm256_loadu_ps(w + ic * PACK_SIZE);
+                    for (int j = 0; j < OW_BLOCK; ++j) {
+                        acc[j] = _mm256_fmadd_ps(
+                                _mm256_broadcast_ss(
+                                        s + j * stride * PACK_SIZE + ic),
+                                vw, acc[j]);
+                    }
+                }
+            }
+        }
+    }
+    store_acc(acc, dst, ow_valid, op);
+}
+
+/*!
+ * \brief nchw to nchw88 conv of one output row block of one oc block
+ *
+ * src is the padded buffer in [ic, ih2, iw2] starting at the first input
+ * pixel of the output row, filter is in [fh, fw, ic, 8oc]
+ */
+template <BiasMode bias_mode, typename Op, int filter, int stride>
+MEGDNN_ATTRIBUTE_TARGET("avx2,fma")
+static inline void conv_nchw_nchw88_ow_block(const float* src,
+                                             const float* fptr,
+                                             const float* bias, float* dst,
+                                             int ic, size_t src_ic_stride,
+                                             int iw2, int ow_valid,
+                                             const Op& op) {
+    __m256 acc[OW_BLOCK];
+    init_acc<bias_mode>(acc, bias, ow_valid);
+    for (int fh = 0; fh < filter; ++fh) {
+        for (int fw = 0; fw < filter; ++fw) {
+            const float* w = fptr + (fh * filter + fw) * ic * PACK_SIZE;
+            for (int c = 0; c < ic; ++c) {
+                const float* s = src + c * src_ic_stride + fh * iw2 + fw;
+                __m256 vw = _mm256_loadu_ps(w + c * PACK_SIZE);
+                for (int j = 0; j < OW_BLOCK; ++j) {
+                    acc[j] = _mm256_fmadd_ps(_mm256_broadcast_ss(s + j * stride),
+                                             vw, acc[j]);
+                }
+            }
+        }
+    }
+    store_acc(acc, dst, ow_valid, op);
+}
+
+/*!
+ * \brief channel wise nchw88 conv of one output row block of 8 channels
+ *
+ * src is the padded buffer in [ih2, iw2, 8] starting at the first input pixel
+ * of the output row, filter is in [fh, fw, 8]
+ */
+template <BiasMode bias_mode, typename Op, int filter, int stride>
+MEGDNN_ATTRIBUTE_TARGET("avx2,fma")
+static inline void conv_chanwise_ow_block(const float* src, const float* fptr,
+                                          const float* bias, float* dst,
+                                          int iw2, int ow_valid,
+                                          const Op& op) {
+    __m256 acc[OW_BLOCK];
+    init_acc<bias_mode>(acc, bias, ow_valid);
+    for (int fh = 0; fh < filter; ++fh) {
+        for (int fw = 0; fw < filter; ++fw) {
+            const float* s = src + (fh * iw2 + fw) * PACK_SIZE;
+            __m256 vw = _mm256_loadu_ps(fptr + (fh * filter + fw) * PACK_SIZE);
+            for (int j = 0; j < OW_BLOCK; ++j) {
+                acc[j] = _mm256_fmadd_ps(
+                        _mm256_loadu_ps(s + j * stride * PACK_SIZE), vw,
+                        acc[j]);
+            }
+        }
+    }
+    store_acc(acc, dst, ow_valid, op);
+}
+
+/*!
+ * \brief compute output rows [oh_start, oh_start + oh_block) of all oc blocks
+ *      of a dense nchw88 conv
+ *
+ * \param src padded buffer whose first row is the input row of oh_start
+ * \param bias bias of the group; for BIAS mode it is in dst layout
+ */
+template <BiasMode bias_mode, typename Op, int filter, int stride>
+static void conv_direct_nchw88(const float* src, const float* fptr,
+                               const float* bias, float* dst, int oc_blocks,
+                               int ic_blocks, int ih2, int iw2, int oh,
+                               int ow, int oh_start, int oh_block,
+                               const Op& op) {
+    const size_t src_ic_stride = static_cast<size_t>(ih2) * iw2 * PACK_SIZE;
+    const size_t filter_oc_stride = static_cast<size_t>(ic_blocks) * filter *
+                                    filter * PACK_SIZE * PACK_SIZE;
+    for (int ocb = 0; ocb < oc_blocks; ++ocb) {
+        const float* wptr = fptr + ocb * filter_oc_stride;
+        for (int oh_idx = 0; oh_idx < oh_block; ++oh_idx) {
+            const float* sptr = src + oh_idx * stride * iw2 * PACK_SIZE;
+            size_t dst_offset =
+                    ((static_cast<size_t>(ocb) * oh + oh_start + oh_idx) * ow) *
+                    PACK_SIZE;
+            for (int ow_idx = 0; ow_idx < ow; ow_idx += OW_BLOCK) {
+                size_t out_offset = dst_offset + ow_idx * PACK_SIZE;
+                const float* bptr =
+                        bias_mode == BiasMode::BIAS
+                                ? bias + out_offset
+                                : bias + ocb * PACK_SIZE;
+                conv_direct_ow_block<bias_mode, Op, filter, stride>(
+                        sptr + ow_idx * stride * PACK_SIZE, wptr, bptr,
+                        dst + out_offset, ic_blocks, src_ic_stride, iw2,
+                        ow - ow_idx, op);
+            }
+        }
+    }
+}
+
+//! the nchw src version of conv_direct_nchw88, used for the first layer
+template <BiasMode bias_mode, typename Op, int filter, int stride>
+static void conv_nchw_nchw88(const float* src, const float* fptr,
+                             const float* bias, float* dst, int oc_blocks,
+                             int ic, int ih2, int iw2, int oh, int ow,
+                             int oh_start, int oh_block, const Op& op) {
+    const size_t src_ic_stride = static_cast<size_t>(ih2) * iw2;
+    const size_t filter_oc_stride =
+            static_cast<size_t>(filter) * filter * ic * PACK_SIZE;
+    for (int ocb = 0; ocb < oc_blocks; ++ocb) {
+        const float* wptr = fptr + ocb * filter_oc_stride;
+        for (int oh_idx = 0; oh_idx < oh_block; ++oh_idx) {
+            const float* sptr = src + oh_idx * stride * iw2;
+            size_t dst_offset =
+                    ((static_cast<size_t>(ocb) * oh + oh_start + oh_idx) * ow) *
+                    PACK_SIZE;
+            for (int ow_idx = 0; ow_idx < ow; ow_idx += OW_BLOCK) {
+                size_t out_offset = dst_offset + ow_idx * PACK_SIZE;
+                const float* bptr =
+                        bias_mode == BiasMode::BIAS
+                                ? bias + out_offset
+                                : bias + ocb * PACK_SIZE;
+                conv_nchw_nchw88_ow_block<bias_mode, Op, filter, stride>(
+                        sptr + ow_idx * stride, wptr, bptr, dst + out_offset,
+                        ic, src_ic_stride, iw2, ow - ow_idx, op);
+            }
+        }
+    }
+}
+
+//! compute all output rows of 8 channels of a channel wise nchw88 conv
+template <BiasMode bias_mode, typename Op, int filter, int stride>
+static void conv_chanwise_nchw88(const float* src, const float* fptr,
+                                 const float* bias, float* dst, int iw2,
+                                 int oh, int ow, const Op& op) {
+    for (int oh_idx = 0; oh_idx < oh; ++oh_idx) {
+        const float* sptr = src + oh_idx * stride * iw2 * PACK_SIZE;
+        size_t dst_offset = static_cast<size_t>(oh_idx) * ow * PACK_SIZE;
+        for (int ow_idx = 0; ow_idx < ow; ow_idx += OW_BLOCK) {
+            size_t out_offset = dst_offset + ow_idx * PACK_SIZE;
+            const float* bptr =
+                    bias_mode == BiasMode::BIAS ? bias + out_offset : bias;
+            conv_chanwise_ow_block<bias_mode, Op, filter, stride>(
+                    sptr + ow_idx * stride * PACK_SIZE, fptr, bptr,
+                    dst + out_offset, iw2, ow - ow_idx, op);
+        }
+    }
+}
+
+}  // namespace nchw88
+}  // namespace x86
+}  // namespace megdnn
+
+// vim: syntax=cpp.doxygen
@@ -75,6 +75,18 @@ void* ConvBiasImpl::AlgoChanWiseAvx2Stride2Qint8::type() const {
     return x86_algo_type;
 }
 
+void* ConvBiasImpl::AlgoF32DirectNCHW88::type() const {
+    return x86_algo_type;
+}
+
+void* ConvBiasImpl::AlgoF32DirectNCHWNCHW88::type() const {
+    return x86_algo_type;
+}
+
+void* ConvBiasImpl::AlgoF32ChannelWiseNCHW88::type() const {
+    return x86_algo_type;
+}
+
 class ConvBiasImpl::AlgoPack : NonCopyableObj {
     AlgoDirect stride1_direct;
     AlgoDirectStride2 stride2_direct;
@@ -83,6 +95,9 @@ class ConvBiasImpl::AlgoPack : NonCopyableObj {
     AlgoChanWiseAvx2Stride1Qint8 avx2_stride1_chanwsie_qint8;
     AlgoChanWiseAvx2Stride2Qint8 avx2_stride2_chanwsie_qint8;
     AlgoMatrixMul matmul;
+    AlgoF32DirectNCHW88 f32_direct_nchw88;
+    AlgoF32DirectNCHWNCHW88 f32_direct_nchw_nchw88;
+    AlgoF32ChannelWiseNCHW88 f32_chanwise_nchw88;
 #if MEGDNN_X86_WITH_MKL_DNN
     AlgoMkldnnMatmulQint8 mkldnn_matmul_qint8;
     //! Because the mkldnnconv need handle
@@ -101,6 +116,9 @@ public:
         all_algos.emplace_back(&mkldnn_matmul_qint8);
         all_algos.emplace_back(&mkldnn_qint8);
 #endif
+        all_algos.emplace_back(&f32_direct_nchw88);
+        all_algos.emplace_back(&f32_direct_nchw_nchw88);
+        all_algos.emplace_back(&f32_chanwise_nchw88);
         all_algos.emplace_back(&stride1_direct);
         all_algos.emplace_back(&stride2_direct);
         all_algos.emplace_back(&avx2_stride1_chanwsie_qint8);
@@ -194,7 +212,7 @@ ConvBiasImpl::suggest_algo_category_order(const NCBKernSizeParam& param) const {
         param.filter_meta.format == param::ConvBias::Format::NCHW88_WINOGRAD) {
         return {AlgoCategory::WINOGRAD};
     }
-    //! nchw88 use mkl-dnn which algo is direct
+    //! nchw88 algos (native avx2 or mkl-dnn) are all direct
     if (param.filter_meta.format == param::ConvBias::Format::NCHW88) {
         return {AlgoCategory::DIRECT, AlgoCategory::IM2COL};
     }
@@ -15,6 +15,8 @@
 #include "src/x86/handle.h"
 
 #include "src/x86/add_update/opr_impl.h"
+#include "src/x86/argsort/opr_impl.h"
+#include "src/x86/batched_matrix_mul/opr_impl.h"
 #include "src/x86/conv_bias/opr_impl.h"
 #include "src/x86/cvt_color/opr_impl.h"
 #include "src/x86/elemwise/opr_impl.h"
@@ -24,9 +26,12 @@
 #include "src/x86/lrn/opr_impl.h"
 #include "src/x86/matrix_mul/opr_impl.h"
 #include "src/x86/pooling/opr_impl.h"
+#include "src/x86/reduce/opr_impl.h"
+#include "src/x86/relayout/opr_impl.h"
 #include "src/x86/resize/opr_impl.h"
 #include "src/x86/separable_conv/opr_impl.h"
 #include "src/x86/separable_filter/opr_impl.h"
+#include "src/x86/topk/opr_impl.h"
 #include "src/x86/type_cvt/opr_impl.h"
 #include "src/x86/utils.h"
 #include "src/x86/warp_affine/opr_impl.h"
@@ -78,6 +83,7 @@ MEGDNN_SPECIALIZE_CREATE_OPERATOR(Pooling)
 MEGDNN_SPECIALIZE_CREATE_OPERATOR(Local)
 MEGDNN_SPECIALIZE_CREATE_OPERATOR(LRN)
 MEGDNN_SPECIALIZE_CREATE_OPERATOR(MatrixMul)
+MEGDNN_SPECIALIZE_CREATE_OPERATOR(BatchedMatrixMul)
 MEGDNN_SPECIALIZE_CREATE_OPERATOR(Elemwise)
 MEGDNN_SPECIALIZE_CREATE_OPERATOR(ElemwiseMultiType)
 MEGDNN_SPECIALIZE_CREATE_OPERATOR(CvtColor)
@@ -88,6 +94,10 @@ MEGDNN_SPECIALIZE_CREATE_OPERATOR(WarpPerspective)
 MEGDNN_SPECIALIZE_CREATE_OPERATOR(AddUpdate)
 MEGDNN_SPECIALIZE_CREATE_OPERATOR(TypeCvt)
 MEGDNN_SPECIALIZE_CREATE_OPERATOR(ConvBias)
+MEGDNN_SPECIALIZE_CREATE_OPERATOR(Reduce)
+MEGDNN_SPECIALIZE_CREATE_OPERATOR(RelayoutForward)
+MEGDNN_SPECIALIZE_CREATE_OPERATOR(TopK)
+MEGDNN_SPECIALIZE_CREATE_OPERATOR(ArgsortForward)
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wpragmas"
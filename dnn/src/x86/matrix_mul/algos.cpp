@@ -20,6 +20,7 @@
 
 MIDOUT_DECL(megdnn_x86_matmul_kern)
 MIDOUT_DECL(megdnn_x86_matmul_kern_mk8_8x8)
+MIDOUT_DECL(megdnn_x86_matmul_kern_f32_packed)
 using namespace megdnn;
 using namespace x86;
 
@@ -661,4 +662,105 @@ size_t MatrixMulImpl::AlgoF32MK8_8x8::get_workspace(
     MIDOUT_END();
 }
 
+/*************************AlgoF32 packed gemm********************/
+namespace {
+template <typename Strategy>
+void f32_packed_kern(const MatrixMulImpl::KernParam& kern_param) {
+    constexpr int cacheline = 64;
+    auto M = kern_param.M, N = kern_param.N, K = kern_param.K;
+    Strategy strategy(M, N, K, kern_param.A_type, kern_param.B_type,
+                      kern_param.C_type);
+    megdnn::matmul::GemmInterleaved<Strategy>(M, N, K, kern_param.trA,
+                                              kern_param.trB, strategy,
+                                              cacheline)
+            .execute(kern_param.A<float>(), kern_param.LDA,
+                     kern_param.B<float>(), kern_param.LDB,
+                     kern_param.C<float>(), kern_param.LDC,
+                     kern_param.workspace_ptr);
+}
+
+template <typename Strategy>
+size_t f32_packed_workspace(const MatrixMulImpl::KernSizeParam& kern_param) {
+    constexpr int cacheline = 64;
+    auto M = kern_param.M, N = kern_param.N, K = kern_param.K;
+    Strategy strategy(M, N, K, kern_param.A_type, kern_param.B_type,
+                      kern_param.C_type);
+    return megdnn::matmul::GemmInterleaved<Strategy>(
+                   M, N, K, kern_param.trA, kern_param.trB, strategy,
+                   cacheline)
+            .get_workspace_size();
+}
+
+bool f32_packed_usable(const MatrixMulImpl::KernSizeParam& kern_size_param) {
+    return kern_size_param.compute_mode ==
+                   param::MatrixMul::ComputeMode::DEFAULT &&
+           kern_size_param.format == param::MatrixMul::Format::DEFAULT &&
+           kern_size_param.B_type.enumv() == kern_size_param.A_type.enumv() &&
+           kern_size_param.C_type.enumv() == kern_size_param.A_type.enumv() &&
+           kern_size_param.A_type.enumv() == DTypeEnum::Float32;
+}
+}  // anonymous namespace
+
+MatrixMulImpl::kern_t MatrixMulImpl::AlgoF32AVX2M6N16::get_kern(
+        const KernSizeParam&) const {
+    auto kern = [](const MatrixMulImpl::KernParam& kern_param) {
+        MIDOUT_BEGIN(megdnn_x86_matmul_kern_f32_packed, midout_iv(0)) {
+            f32_packed_kern<x86::matmul::sgemm_avx2_6x16>(kern_param);
+        }
+        MIDOUT_END();
+    };
+    return kern;
+}
+
+bool MatrixMulImpl::AlgoF32AVX2M6N16::usable(
+        const KernSizeParam& kern_size_param) const {
+    return f32_packed_usable(kern_size_param) &&
+           is_supported(SIMDType::AVX) && is_supported(SIMDType::FMA);
+}
+
+size_t MatrixMulImpl::AlgoF32AVX2M6N16::get_workspace(
+        const KernSizeParam& kern_param) const {
+    MIDOUT_BEGIN(megdnn_x86_matmul_kern_f32_packed, midout_iv(1)) {
+        return f32_packed_workspace<x86::matmul::sgemm_avx2_6x16>(kern_param);
+    }
+    MIDOUT_END();
+}
+
+MEGDNN_REG_GEMM_FUNC_FOR_IM2COL_IMPL(AlgoF32AVX2M6N16, megdnn_x86_matmul_kern,
+                                     "AlgoF32AVX2M6N16"_hash,
+                                     x86::matmul::sgemm_avx2_6x16, float, float,
+                                     AlgoDataType::FLOAT32, DEFAULT);
+
+MatrixMulImpl::kern_t MatrixMulImpl::AlgoF32AVX512M14N32::get_kern(
+        const KernSizeParam&) const {
+    auto kern = [](const MatrixMulImpl::KernParam& kern_param) {
+        MIDOUT_BEGIN(megdnn_x86_matmul_kern_f32_packed, midout_iv(2)) {
+            f32_packed_kern<x86::matmul::sgemm_avx512_14x32>(kern_param);
+        }
+        MIDOUT_END();
+    };
+    return kern;
+}
+
+bool MatrixMulImpl::AlgoF32AVX512M14N32::usable(
+        const KernSizeParam& kern_size_param) const {
+    return f32_packed_usable(kern_size_param) &&
+           is_supported(SIMDType::AVX512F);
+}
+
+size_t MatrixMulImpl::AlgoF32AVX512M14N32::get_workspace(
+        const KernSizeParam& kern_param) const {
+    MIDOUT_BEGIN(megdnn_x86_matmul_kern_f32_packed, midout_iv(3)) {
+        return f32_packed_workspace<x86::matmul::sgemm_avx512_14x32>(
+                kern_param);
+    }
+    MIDOUT_END();
+}
+
+MEGDNN_REG_GEMM_FUNC_FOR_IM2COL_IMPL(AlgoF32AVX512M14N32,
+                                     megdnn_x86_matmul_kern,
+                                     "AlgoF32AVX512M14N32"_hash,
+                                     x86::matmul::sgemm_avx512_14x32, float,
+                                     float, AlgoDataType::FLOAT32, DEFAULT);
+
 // vim: syntax=cpp.doxygen
@@ -0,0 +1,121 @@
+/**
+ * \file dnn/src/x86/matrix_mul/f32/common.h
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include "src/common/utils.h"
+
+namespace megdnn {
+namespace x86 {
+namespace matmul_f32 {
+
+/*!
+ * \brief pack a matrix into panels of W rows (or columns), each panel stored
+ *      k-major as W interleaved values for each k
+ *
+ * This overload handles the case where the W values of the same k are
+ * contiguous in the input, i.e. transposed A and non-transposed B:
+ * value (x, k) is in[k * ldin + x].
+ *
+ * The panels are zero padded to W.
+ */
+template <size_t W>
+void pack_contig(float* out, const float* in, int ldin, int x0, int xmax,
+                 int k0, int kmax) {
+    for (int x = x0; x < xmax; x += W) {
+        size_t valid = std::min<size_t>(W, xmax - x);
+        const float* inptr = in + k0 * ldin + x;
+        for (int k = k0; k < kmax; ++k) {
+            memcpy(out, inptr, sizeof(float) * valid);
+            if (valid < W) {
+                memset(out + valid, 0, sizeof(float) * (W - valid));
+            }
+            out += W;
+            inptr += ldin;
+        }
+    }
+}
+
+/*!
+ * \brief pack panels like pack_contig, for the case where value (x, k) is
+ *      in[x * ldin + k], i.e. non-transposed A and transposed B
+ */
+template <size_t W>
+void pack_strided(float* out, const float* in, int ldin, int x0, int xmax,
+                  int k0, int kmax) {
+    size_t K = kmax - k0;
+    for (int x = x0; x < xmax; x += W) {
+        size_t valid = std::min<size_t>(W, xmax - x);
+        for (size_t i = 0; i < valid; ++i) {
+            const float* inptr = in + (x + i) * ldin + k0;
+            float* outptr = out + i;
+            for (size_t k = 0; k < K; ++k) {
+                outptr[k * W] = inptr[k];
+            }
+        }
+        for (size_t i = valid; i < W; ++i) {
+            for (size_t k = 0; k < K; ++k) {
+                out[k * W + i] = 0;
+            }
+        }
+        out += K * W;
+    }
+}
+
+/*!
+ * \brief compute C[M, N] (+)= packA * packB with a micro kernel of H x W
+ *
+ * Rows of packA are processed in blocks of MB rows so that they stay in L2
+ * while each panel of packB is reused from L1. Edge tiles are computed into
+ * a temporary tile.
+ *
+ * \param kern micro kernel of signature (packA, packB, K, C, LDC, is_first_k)
+ */
+template <size_t H, size_t W, typename Kern>
+void gemm_kern_driver(Kern kern, const float* packA, const float* packB,
+                      size_t M, size_t N, size_t K, float* C, size_t LDC,
+                      bool is_first_k) {
+    constexpr size_t MB = H * 16;
+    alignas(64) float tmp[H * W];
+    for (size_t m0 = 0; m0 < M; m0 += MB) {
+        size_t m1 = std::min(m0 + MB, M);
+        for (size_t n = 0; n < N; n += W) {
+            size_t nr = std::min(W, N - n);
+            const float* pb = packB + n * K;
+            for (size_t m = m0; m < m1; m += H) {
+                size_t mr = std::min(H, m1 - m);
+                const float* pa = packA + m * K;
+                float* c = C + m * LDC + n;
+                if (mr == H && nr == W) {
+                    kern(pa, pb, K, c, LDC, is_first_k);
+                    continue;
+                }
+                if (!is_first_k) {
+                    for (size_t i = 0; i < mr; ++i) {
+                        memcpy(tmp + i * W, c + i * LDC, sizeof(float) * nr);
+                    }
+                }
+                kern(pa, pb, K, tmp, W, is_first_k);
+                for (size_t i = 0; i < mr; ++i) {
+                    memcpy(c + i * LDC, tmp + i * W, sizeof(float) * nr);
+                }
+            }
+        }
+    }
+}
+
+}  // namespace matmul_f32
+}  // namespace x86
+}  // namespace megdnn
+
+// vim: syntax=cpp.doxygen
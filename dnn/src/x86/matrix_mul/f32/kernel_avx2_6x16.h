@@ -0,0 +1,107 @@
+/**
+ * \file dnn/src/x86/matrix_mul/f32/kernel_avx2_6x16.h
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ */
+#pragma once
+
+#include <immintrin.h>
+#include "src/common/unroll_macro.h"
+#include "src/common/utils.h"
+
+namespace megdnn {
+namespace x86 {
+namespace matmul_avx2_6x16 {
+
+/*!
+ * \brief compute a 6x16 tile of C with 12 ymm accumulators
+ *
+ * packA holds 6 values and packB holds 16 values for each k.
+ */
+MEGDNN_ATTRIBUTE_TARGET("avx,fma")
+static inline void kern_6x16(const float* packA, const float* packB, size_t K,
+                             float* C, size_t LDC, bool is_first_k) {
+#define cb(i)                             \
+    __m256 c##i##0 = _mm256_setzero_ps(); \
+    __m256 c##i##1 = _mm256_setzero_ps();
+    UNROLL_CALL_NOWRAPPER(6, cb);
+#undef cb
+
+    for (size_t k = 0; k < K; ++k) {
+        __m256 b0 = _mm256_loadu_ps(packB);
+        __m256 b1 = _mm256_loadu_ps(packB + 8);
+        __m256 a;
+#define cb(i)                                      \
+    a = _mm256_broadcast_ss(packA + i);            \
+    c##i##0 = _mm256_fmadd_ps(a, b0, c##i##0);     \
+    c##i##1 = _mm256_fmadd_ps(a, b1, c##i##1);
+        UNROLL_CALL_NOWRAPPER(6, cb);
+#undef cb
+        packA += 6;
+        packB += 16;
+    }
+
+    if (!is_first_k) {
+#define cb(i)                                                         \
+    c##i##0 = _mm256_add_ps(c##i##0, _mm256_loadu_ps(C + i * LDC));   \
+    c##i##1 = _mm256_add_ps(c##i##1, _mm256_loadu_ps(C + i * LDC + 8));
+        UNROLL_CALL_NOWRAPPER(6, cb);
+#undef cb
+    }
+#define cb(i)                                      \
+    _mm256_storeu_ps(C + i * LDC, c##i##0);        \
+    _mm256_storeu_ps(C + i * LDC + 8, c##i##1);
+    UNROLL_CALL_NOWRAPPER(6, cb);
+#undef cb
+}
+
+/*!
+ * \brief compute a 6x16 tile of C = A * B without packing, used for small
+ *      matrices where packing costs more than the multiplication
+ *
+ * value (i, k) of A is A[i * a_row_step + k * a_k_step], and row k of B is
+ * the 16 contiguous values at B + k * LDB. C is overwritten.
+ */
+MEGDNN_ATTRIBUTE_TARGET("avx,fma")
+static inline void kern_6x16_direct(const float* A, size_t a_row_step,
+                                    size_t a_k_step, const float* B,
+                                    size_t LDB, size_t K, float* C,
+                                    size_t LDC) {
+#define cb(i)                             \
+    __m256 c##i##0 = _mm256_setzero_ps(); \
+    __m256 c##i##1 = _mm256_setzero_ps();
+    UNROLL_CALL_NOWRAPPER(6, cb);
+#undef cb
+
+    for (size_t k = 0; k < K; ++k) {
+        __m256 b0 = _mm256_loadu_ps(B);
+        __m256 b1 = _mm256_loadu_ps(B + 8);
+        __m256 a;
+#define cb(i)                                      \
+    a = _mm256_broadcast_ss(A + i * a_row_step);   \
+    c##i##0 = _mm256_fmadd_ps(a, b0, c##i##0);     \
+    c##i##1 = _mm256_fmadd_ps(a, b1, c##i##1);
+        UNROLL_CALL_NOWRAPPER(6, cb);
+#undef cb
+        A += a_k_step;
+        B += LDB;
+    }
+
+#define cb(i)                                      \
+    _mm256_storeu_ps(C + i * LDC, c##i##0);        \
+    _mm256_storeu_ps(C + i * LDC + 8, c##i##1);
+    UNROLL_CALL_NOWRAPPER(6, cb);
+#undef cb
+}
+
+}  // namespace matmul_avx2_6x16
+}  // namespace x86
+}  // namespace megdnn
+
+// vim: syntax=cpp.doxygen
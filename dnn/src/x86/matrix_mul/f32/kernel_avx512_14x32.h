@@ -0,0 +1,69 @@
+/**
+ * \file dnn/src/x86/matrix_mul/f32/kernel_avx512_14x32.h
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ */
+#pragma once
+
+#include <immintrin.h>
+#include "src/common/unroll_macro.h"
+#include "src/common/utils.h"
+
+namespace megdnn {
+namespace x86 {
+namespace matmul_avx512_14x32 {
+
+/*!
+ * \brief compute a 14x32 tile of C with 28 zmm accumulators
+ *
+ * packA holds 14 values and packB holds 32 values for each k.
+ */
+MEGDNN_ATTRIBUTE_TARGET("avx512f")
+static inline void kern_14x32(const float* packA, const float* packB,
+                              size_t K, float* C, size_t LDC,
+                              bool is_first_k) {
+#define cb(i)                             \
+    __m512 c##i##0 = _mm512_setzero_ps(); \
+    __m512 c##i##1 = _mm512_setzero_ps();
+    UNROLL_CALL_NOWRAPPER(14, cb);
+#undef cb
+
+    for (size_t k = 0; k < K; ++k) {
+        __m512 b0 = _mm512_loadu_ps(packB);
+        __m512 b1 = _mm512_loadu_ps(packB + 16);
+        __m512 a;
+#define cb(i)                                      \
+    a = _mm512_set1_ps(packA[i]);                  \
+    c##i##0 = _mm512_fmadd_ps(a, b0, c##i##0);     \
+    c##i##1 = _mm512_fmadd_ps(a, b1, c##i##1);
+        UNROLL_CALL_NOWRAPPER(14, cb);
+#undef cb
+        packA += 14;
+        packB += 32;
+    }
+
+    if (!is_first_k) {
+#define cb(i)                                                          \
+    c##i##0 = _mm512_add_ps(c##i##0, _mm512_loadu_ps(C + i * LDC));    \
+    c##i##1 = _mm512_add_ps(c##i##1, _mm512_loadu_ps(C + i * LDC + 16));
+        UNROLL_CALL_NOWRAPPER(14, cb);
+#undef cb
+    }
+#define cb(i)                                      \
+    _mm512_storeu_ps(C + i * LDC, c##i##0);        \
+    _mm512_storeu_ps(C + i * LDC + 16, c##i##1);
+    UNROLL_CALL_NOWRAPPER(14, cb);
+#undef cb
+}
+
+}  // namespace matmul_avx512_14x32
+}  // namespace x86
+}  // namespace megdnn
+
+// vim: syntax=cpp.doxygen
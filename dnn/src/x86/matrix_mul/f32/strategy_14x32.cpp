@@ -0,0 +1,56 @@
+/**
+ * \file dnn/src/x86/matrix_mul/f32/strategy_14x32.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ */
+
+#include "src/common/utils.h"
+#include "src/x86/matrix_mul/f32/common.h"
+#include "src/x86/matrix_mul/f32/kernel_avx512_14x32.h"
+#include "src/x86/matrix_mul/f32/strategy.h"
+
+using namespace megdnn;
+using namespace x86;
+using namespace x86::matmul;
+
+MEGDNN_REG_GEMM_STRATEGY_IMPL(sgemm_avx512_14x32);
+
+void sgemm_avx512_14x32::pack_A(float* out, const float* in, int ldin, int y0,
+        int ymax, int k0, int kmax, bool transpose_A) const {
+    if (transpose_A) {
+        matmul_f32::pack_contig<14>(out, in, ldin, y0, ymax, k0, kmax);
+    } else {
+        matmul_f32::pack_strided<14>(out, in, ldin, y0, ymax, k0, kmax);
+    }
+}
+
+void sgemm_avx512_14x32::pack_B(float* out, const float* in, int ldin, int x0,
+        int xmax, int k0, int kmax, bool transpose_B) const {
+    if (transpose_B) {
+        matmul_f32::pack_strided<32>(out, in, ldin, x0, xmax, k0, kmax);
+    } else {
+        matmul_f32::pack_contig<32>(out, in, ldin, x0, xmax, k0, kmax);
+    }
+}
+
+void sgemm_avx512_14x32::kern(const float* packA, const float* packB, size_t M,
+        size_t N, size_t K, float* C, size_t LDC, bool is_first_k, const float*,
+        float*) const {
+    megdnn_assert(A_dtype.enumv() == B_dtype.enumv() &&
+                  A_dtype.enumv() == C_dtype.enumv() &&
+                  A_dtype.enumv() == DTypeEnum::Float32);
+    MEGDNN_MARK_USED_VAR(A_dtype);
+    MEGDNN_MARK_USED_VAR(B_dtype);
+    MEGDNN_MARK_USED_VAR(C_dtype);
+    matmul_f32::gemm_kern_driver<14, 32>(
+            matmul_avx512_14x32::kern_14x32, packA, packB, M, N, K, C, LDC,
+            is_first_k);
+}
+
+// vim: syntax=cpp.doxygen
@@ -40,6 +40,8 @@ class MatrixMulImpl::AlgoPack : NonCopyableObj {
     AlgoInt8x8x16AVX2 algoint8x8x16avx2_m4n16k2;
     AlgoInt8x8x16SSE algoint8x8x16sse_m4n8k2;
     AlgoF32MK8_8x8 algof32mk8_8x8;
+    AlgoF32AVX512M14N32 algof32avx512_m14n32;
+    AlgoF32AVX2M6N16 algof32avx2_m6n16;
 
 public:
     AlgoPack() {
@@ -61,6 +63,8 @@ public:
 #if MEGDNN_X86_WITH_MKL && SUPPORT_MKL_PACKED_GEMM
         all_algos.emplace_back(&f32mkl_packa);
 #endif
+        all_algos.emplace_back(&algof32avx512_m14n32);
+        all_algos.emplace_back(&algof32avx2_m6n16);
     }
     SmallVector<AlgoBase*> all_algos;
 };
@@ -52,6 +52,8 @@ protected:
     class AlgoInt8x8x32Mkldnn;
 #endif
 
+    class AlgoF32AVX2M6N16;
+    class AlgoF32AVX512M14N32;
     class AlgoInt8x8x32AVX2M2N4K16;
     class AlgoInt8x8x32AVX2M4N16K2;
     class AlgoInt8x8x32SSEM4N8K2;
@@ -0,0 +1,631 @@
+/**
+ * \file dnn/src/x86/reduce/opr_impl.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+#include "src/x86/reduce/opr_impl.h"
+
+#include <immintrin.h>
+#include <cmath>
+#include <limits>
+#include "src/common/reduce_helper.h"
+#include "src/common/utils.h"
+#include "src/naive/handle.h"
+#include "src/x86/utils.h"
+
+using namespace megdnn;
+using namespace x86;
+
+#include "midout.h"
+MIDOUT_DECL(megdnn_x86_reduce)
+
+//! all the kernels require avx2; f16c, which is available on every cpu with
+//! avx2, is only used to load and store float16
+#define REDUCE_TARGET MEGDNN_ATTRIBUTE_TARGET("avx2,f16c")
+
+namespace {
+
+/*****************************load and store***********************/
+template <typename ctype>
+struct FloatIO;
+
+template <>
+struct FloatIO<dt_float32> {
+    static __m256 load(const dt_float32* addr) REDUCE_TARGET {
+        return _mm256_loadu_ps(addr);
+    }
+    static void store(dt_float32* addr, __m256 v) REDUCE_TARGET {
+        _mm256_storeu_ps(addr, v);
+    }
+    static float load_one(const dt_float32* addr) { return *addr; }
+    static void store_one(dt_float32* addr, float v) { *addr = v; }
+};
+
+#if !MEGDNN_DISABLE_FLOAT16
+//! float16 is computed in float32 and rounded once when storing the result
+template <>
+struct FloatIO<dt_float16> {
+    static __m256 load(const dt_float16* addr) REDUCE_TARGET {
+        return _mm256_cvtph_ps(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(addr)));
+    }
+    static void store(dt_float16* addr, __m256 v) REDUCE_TARGET {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(addr),
+                         _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT));
+    }
+    static float load_one(const dt_float16* addr) {
+        return static_cast<float>(*addr);
+    }
+    static void store_one(dt_float16* addr, float v) {
+        *addr = static_cast<dt_float16>(v);
+    }
+};
+#endif
+
+/*****************************float ops***********************/
+//! apply() accumulates an input value, merge() combines two partial results
+struct VecAdd {
+    static float init() { return 0.f; }
+    static __m256 apply(__m256 acc, __m256 v) REDUCE_TARGET {
+        return _mm256_add_ps(acc, v);
+    }
+    static float apply(float acc, float v) { return acc + v; }
+    static __m256 merge(__m256 a, __m256 b) REDUCE_TARGET {
+        return _mm256_add_ps(a, b);
+    }
+    static float merge(float a, float b) { return a + b; }
+};
+
+struct VecSqrAdd {
+    static float init() { return 0.f; }
+    static __m256 apply(__m256 acc, __m256 v) REDUCE_TARGET {
+        return _mm256_add_ps(acc, _mm256_mul_ps(v, v));
+    }
+    static float apply(float acc, float v) { return acc + v * v; }
+    static __m256 merge(__m256 a, __m256 b) REDUCE_TARGET {
+        return _mm256_add_ps(a, b);
+    }
+    static float merge(float a, float b) { return a + b; }
+};
+
+struct VecMul {
+    static float init() { return 1.f; }
+    static __m256 apply(__m256 acc, __m256 v) REDUCE_TARGET {
+        return _mm256_mul_ps(acc, v);
+    }
+    static float apply(float acc, float v) { return acc * v; }
+    static __m256 merge(__m256 a, __m256 b) REDUCE_TARGET {
+        return _mm256_mul_ps(a, b);
+    }
+    static float merge(float a, float b) { return a * b; }
+};
+
+struct VecMax {
+    static float init() { return std::numeric_limits<float>::lowest(); }
+    static __m256 apply(__m256 acc, __m256 v) REDUCE_TARGET {
+        return _mm256_max_ps(acc, v);
+    }
+    static float apply(float acc, float v) { return std::max(acc, v); }
+    static __m256 merge(__m256 a, __m256 b) REDUCE_TARGET {
+        return _mm256_max_ps(a, b);
+    }
+    static float merge(float a, float b) { return std::max(a, b); }
+};
+
+struct VecMin {
+    static float init() { return std::numeric_limits<float>::max(); }
+    static __m256 apply(__m256 acc, __m256 v) REDUCE_TARGET {
+        return _mm256_min_ps(acc, v);
+    }
+    static float apply(float acc, float v) { return std::min(acc, v); }
+    static __m256 merge(__m256 a, __m256 b) REDUCE_TARGET {
+        return _mm256_min_ps(a, b);
+    }
+    static float merge(float a, float b) { return std::min(a, b); }
+};
+
+/*****************************float reducer***********************/
+/*!
+ * Reducers follow the interface of arm_common: feed() consumes SIMD_WIDTH
+ * elements, feed_remain() a single one. The C1 reducers keep four
+ * independent accumulators (selected by \p idx) to hide the latency of the
+ * reduction op, and post() writes the single result; the strided reducers
+ * write SIMD_WIDTH adjacent results in post() and one in post_remain().
+ */
+template <typename Op, typename T, bool mean, bool C1>
+struct FloatReducer;
+
+template <typename Op, typename T, bool mean>
+struct FloatReducer<Op, T, mean, true> {
+    using ctype = T;
+    using IO = FloatIO<T>;
+    static constexpr size_t SIMD_WIDTH = 8;
+
+    __m256 res[4];
+    float remain;
+    float coef;
+    FloatReducer(DType, size_t cnt) REDUCE_TARGET
+            : remain(Op::init()),
+              coef(mean ? 1.f / cnt : 1.f) {
+        for (auto&& i : res) {
+            i = _mm256_set1_ps(Op::init());
+        }
+    }
+    void feed(const ctype* val, size_t idx) REDUCE_TARGET {
+        res[idx] = Op::apply(res[idx], IO::load(val));
+    }
+    void feed_remain(const ctype* val) {
+        remain = Op::apply(remain, IO::load_one(val));
+    }
+    void post(ctype* dst) REDUCE_TARGET {
+        __m256 sum = Op::merge(Op::merge(res[0], res[1]),
+                               Op::merge(res[2], res[3]));
+        alignas(32) float lanes[SIMD_WIDTH];
+        _mm256_store_ps(lanes, sum);
+        float result = remain;
+        for (float i : lanes) {
+            result = Op::merge(result, i);
+        }
+        IO::store_one(dst, result * coef);
+    }
+};
+
+template <typename Op, typename T, bool mean>
+struct FloatReducer<Op, T, mean, false> {
+    using ctype = T;
+    using IO = FloatIO<T>;
+    static constexpr size_t SIMD_WIDTH = 8;
+
+    __m256 res;
+    float remain;
+    float coef;
+    FloatReducer(DType, size_t cnt) REDUCE_TARGET
+            : remain(Op::init()),
+              coef(mean ? 1.f / cnt : 1.f) {
+        res = _mm256_set1_ps(Op::init());
+    }
+    void feed(const ctype* val) REDUCE_TARGET {
+        res = Op::apply(res, IO::load(val));
+    }
+    void feed_remain(const ctype* val) {
+        remain = Op::apply(remain, IO::load_one(val));
+    }
+    void post(ctype* dst) REDUCE_TARGET {
+        if (mean) {
+            res = _mm256_mul_ps(res, _mm256_set1_ps(coef));
+        }
+        IO::store(dst, res);
+    }
+    void post_remain(ctype* dst) { IO::store_one(dst, remain * coef); }
+};
+
+/*****************************quantized reducer***********************/
+template <typename ctype>
+struct QuantizedTrait;
+
+template <>
+struct QuantizedTrait<int8_t> {
+    //! int8 values are biased by 128 to use the unsigned sad instruction
+    static constexpr int64_t BIAS = 128;
+    static int32_t zero_point(DType) { return 0; }
+    static __m256i to_unsigned(__m256i v) REDUCE_TARGET {
+        return _mm256_xor_si256(v, _mm256_set1_epi8(-128));
+    }
+    static __m256i widen(__m128i v) REDUCE_TARGET {
+        return _mm256_cvtepi8_epi32(v);
+    }
+};
+
+template <>
+struct QuantizedTrait<uint8_t> {
+    static constexpr int64_t BIAS = 0;
+    static int32_t zero_point(DType dtype) {
+        return dtype.param<dtype::Quantized8Asymm>().zero_point;
+    }
+    static __m256i to_unsigned(__m256i v) REDUCE_TARGET { return v; }
+    static __m256i widen(__m128i v) REDUCE_TARGET {
+        return _mm256_cvtepu8_epi32(v);
+    }
+};
+
+template <typename T, bool C1>
+struct QuantizedMeanReducer;
+
+template <typename T>
+struct QuantizedMeanReducer<T, true> {
+    using ctype = T;
+    using Trait = QuantizedTrait<T>;
+    static constexpr size_t SIMD_WIDTH = 32;
+
+    //! 64-bit partial sums of the biased values
+    __m256i res[4];
+    int64_t remain;
+    size_t nr_biased;
+    int32_t zp;
+    size_t cnt;
+    float coef;
+    QuantizedMeanReducer(DType src_dtype, size_t cnt) REDUCE_TARGET
+            : remain(0),
+              nr_biased(0),
+              zp(Trait::zero_point(src_dtype)),
+              cnt(cnt),
+              coef(1.f / cnt) {
+        for (auto&& i : res) {
+            i = _mm256_setzero_si256();
+        }
+    }
+    void feed(const ctype* val, size_t idx) REDUCE_TARGET {
+        __m256i v = Trait::to_unsigned(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(val)));
+        res[idx] = _mm256_add_epi64(
+                res[idx], _mm256_sad_epu8(v, _mm256_setzero_si256()));
+        nr_biased += SIMD_WIDTH;
+    }
+    void feed_remain(const ctype* val) { remain += *val; }
+    void post(ctype* dst) REDUCE_TARGET {
+        __m256i sum = _mm256_add_epi64(_mm256_add_epi64(res[0], res[1]),
+                                       _mm256_add_epi64(res[2], res[3]));
+        alignas(32) int64_t lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), sum);
+        int64_t result = remain + lanes[0] + lanes[1] + lanes[2] + lanes[3] -
+                         Trait::BIAS * static_cast<int64_t>(nr_biased);
+        float mean = (result - static_cast<int64_t>(zp) * static_cast<int64_t>(cnt)) * coef;
+        *dst = static_cast<ctype>(std::round(mean) + zp);
+    }
+};
+
+template <typename T>
+struct QuantizedMeanReducer<T, false> {
+    using ctype = T;
+    using Trait = QuantizedTrait<T>;
+    static constexpr size_t SIMD_WIDTH = 8;
+
+    __m256i res;
+    int32_t remain;
+    int32_t zp;
+    size_t cnt;
+    float coef;
+    QuantizedMeanReducer(DType src_dtype, size_t cnt) REDUCE_TARGET
+            : remain(0),
+              zp(Trait::zero_point(src_dtype)),
+              cnt(cnt),
+              coef(1.f / cnt) {
+        res = _mm256_setzero_si256();
+    }
+    void feed(const ctype* val) REDUCE_TARGET {
+        res = _mm256_add_epi32(
+                res, Trait::widen(_mm_loadl_epi64(
+                             reinterpret_cast<const __m128i*>(val))));
+    }
+    void feed_remain(const ctype* val) { remain += *val; }
+    ctype finalize(int32_t sum) const {
+        float mean = (sum - static_cast<int64_t>(zp) * static_cast<int64_t>(cnt)) * coef;
+        return static_cast<ctype>(std::round(mean) + zp);
+    }
+    void post(ctype* dst) REDUCE_TARGET {
+        alignas(32) int32_t lanes[SIMD_WIDTH];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), res);
+        for (size_t i = 0; i < SIMD_WIDTH; ++i) {
+            dst[i] = finalize(lanes[i]);
+        }
+    }
+    void post_remain(ctype* dst) { *dst = finalize(remain); }
+};
+
+template <typename ctype, bool is_max>
+struct QuantizedCmp;
+
+#define cb(_ctype, _is_max, _intrin, _init, _func)                      \
+    template <>                                                         \
+    struct QuantizedCmp<_ctype, _is_max> {                              \
+        static _ctype init() { return std::numeric_limits<_ctype>::_init(); } \
+        static __m256i apply(__m256i a, __m256i b) REDUCE_TARGET {      \
+            return _intrin(a, b);                                       \
+        }                                                               \
+        static _ctype apply(_ctype a, _ctype b) { return _func(a, b); } \
+    };
+cb(int8_t, true, _mm256_max_epi8, lowest, std::max);
+cb(int8_t, false, _mm256_min_epi8, max, std::min);
+cb(uint8_t, true, _mm256_max_epu8, lowest, std::max);
+cb(uint8_t, false, _mm256_min_epu8, max, std::min);
+#undef cb
+
+template <typename T, bool is_max, bool C1>
+struct QuantizedMinMaxReducer;
+
+template <typename T, bool is_max>
+struct QuantizedMinMaxReducer<T, is_max, true> {
+    using ctype = T;
+    using Cmp = QuantizedCmp<T, is_max>;
+    static constexpr size_t SIMD_WIDTH = 32;
+
+    __m256i res[4];
+    ctype remain;
+    QuantizedMinMaxReducer(DType, size_t) REDUCE_TARGET
+            : remain(Cmp::init()) {
+        for (auto&& i : res) {
+            i = _mm256_set1_epi8(Cmp::init());
+        }
+    }
+    void feed(const ctype* val, size_t idx) REDUCE_TARGET {
+        res[idx] = Cmp::apply(
+                res[idx],
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(val)));
+    }
+    void feed_remain(const ctype* val) { remain = Cmp::apply(remain, *val); }
+    void post(ctype* dst) REDUCE_TARGET {
+        __m256i v = Cmp::apply(Cmp::apply(res[0], res[1]),
+                               Cmp::apply(res[2], res[3]));
+        alignas(32) ctype lanes[SIMD_WIDTH];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), v);
+        ctype result = remain;
+        for (ctype i : lanes) {
+            result = Cmp::apply(result, i);
+        }
+        *dst = result;
+    }
+};
+
+template <typename T, bool is_max>
+struct QuantizedMinMaxReducer<T, is_max, false> {
+    using ctype = T;
+    using Cmp = QuantizedCmp<T, is_max>;
+    static constexpr size_t SIMD_WIDTH = 32;
+
+    __m256i res;
+    ctype remain;
+    QuantizedMinMaxReducer(DType, size_t) REDUCE_TARGET
+            : remain(Cmp::init()) {
+        res = _mm256_set1_epi8(Cmp::init());
+    }
+    void feed(const ctype* val) REDUCE_TARGET {
+        res = Cmp::apply(
+                res, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(val)));
+    }
+    void feed_remain(const ctype* val) { remain = Cmp::apply(remain, *val); }
+    void post(ctype* dst) REDUCE_TARGET {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), res);
+    }
+    void post_remain(ctype* dst) { *dst = remain; }
+};
+
+/**************************************do reduce*************************/
+
+/*!
+ * \brief reduce the (A, B, C) tensor along B for a in [a_begin, a_end) and
+ *      c in [c_begin, c_end)
+ */
+template <typename Reducer, bool C1>
+struct Exec;
+
+template <typename Reducer>
+struct Exec<Reducer, true> {
+    using ctype = typename Reducer::ctype;
+    static constexpr size_t W = Reducer::SIMD_WIDTH;
+
+    static void do_reduce(const ctype* src, ctype* dst, DType src_dtype,
+                          size_t a_begin, size_t a_end, size_t, size_t,
+                          size_t B, size_t) REDUCE_TARGET {
+        for (size_t a = a_begin; a < a_end; ++a) {
+            Reducer reducer(src_dtype, B);
+            const ctype* sptr = src + a * B;
+            size_t b = 0;
+            for (; b + 4 * W <= B; b += 4 * W, sptr += 4 * W) {
+                reducer.feed(sptr, 0);
+                reducer.feed(sptr + W, 1);
+                reducer.feed(sptr + 2 * W, 2);
+                reducer.feed(sptr + 3 * W, 3);
+            }
+            for (; b + W <= B; b += W, sptr += W) {
+                reducer.feed(sptr, 0);
+            }
+            for (; b < B; ++b, ++sptr) {
+                reducer.feed_remain(sptr);
+            }
+            reducer.post(dst + a);
+        }
+    }
+};
+
+template <typename Reducer>
+struct Exec<Reducer, false> {
+    using ctype = typename Reducer::ctype;
+    static constexpr size_t W = Reducer::SIMD_WIDTH;
+
+    static void do_reduce(const ctype* src, ctype* dst, DType src_dtype,
+                          size_t a_begin, size_t a_end, size_t c_begin,
+                          size_t c_end, size_t B, size_t C) REDUCE_TARGET {
+        for (size_t a = a_begin; a < a_end; ++a) {
+            const ctype* sptr = src + a * B * C;
+            ctype* dptr = dst + a * C;
+            size_t c = c_begin;
+            //! four column blocks at once for independent accumulators
+            for (; c + 4 * W <= c_end; c += 4 * W) {
+                Reducer r0(src_dtype, B), r1(src_dtype, B), r2(src_dtype, B),
+                        r3(src_dtype, B);
+                const ctype* ptr = sptr + c;
+                for (size_t b = 0; b < B; ++b, ptr += C) {
+                    r0.feed(ptr);
+                    r1.feed(ptr + W);
+                    r2.feed(ptr + 2 * W);
+                    r3.feed(ptr + 3 * W);
+                }
+                r0.post(dptr + c);
+                r1.post(dptr + c + W);
+                r2.post(dptr + c + 2 * W);
+                r3.post(dptr + c + 3 * W);
+            }
+            for (; c + W <= c_end; c += W) {
+                Reducer reducer(src_dtype, B);
+                const ctype* ptr = sptr + c;
+                for (size_t b = 0; b < B; ++b, ptr += C) {
+                    reducer.feed(ptr);
+                }
+                reducer.post(dptr + c);
+            }
+            for (; c < c_end; ++c) {
+                Reducer reducer(src_dtype, B);
+                const ctype* ptr = sptr + c;
+                for (size_t b = 0; b < B; ++b, ptr += C) {
+                    reducer.feed_remain(ptr);
+                }
+                reducer.post_remain(dptr + c);
+            }
+        }
+    }
+};
+
+template <typename ctype>
+using ReduceKern = void (*)(const ctype*, ctype*, DType, size_t, size_t,
+                            size_t, size_t, size_t, size_t);
+
+/*!
+ * \brief split the reduction into tasks over A and, when A is too small to
+ *      feed all the threads, over blocks of C
+ */
+template <typename ctype>
+void dispatch_reduce(naive::HandleImpl* handle, ReduceKern<ctype> kern,
+                     const ctype* src, ctype* dst, DType src_dtype, size_t A,
+                     size_t B, size_t C) {
+    //! minimal number of source elements processed by one task
+    constexpr size_t MIN_TASK_ELEMS = 16384;
+    //! column blocks are kept multiples of the widest SIMD_WIDTH
+    constexpr size_t C_ALIGN = 32;
+
+    size_t nr_threads = handle->megcore_dispatcher()->nr_threads();
+    size_t nr_tasks = 1;
+    if (nr_threads > 1) {
+        nr_tasks = std::min(nr_threads * 4,
+                            std::max<size_t>(A * B * C / MIN_TASK_ELEMS, 1));
+    }
+    size_t a_block = div_ceil(A, std::min(A, nr_tasks));
+    size_t nr_a_blocks = div_ceil(A, a_block);
+    size_t c_block = C;
+    if (C > 1 && nr_a_blocks < nr_tasks) {
+        c_block = std::min(
+                C, round_up(div_ceil(C, div_ceil(nr_tasks, nr_a_blocks)),
+                            C_ALIGN));
+    }
+    size_t nr_c_blocks = div_ceil(C, c_block);
+    auto run = [=](size_t index, size_t) {
+        size_t a_begin = index / nr_c_blocks * a_block,
+               c_begin = index % nr_c_blocks * c_block;
+        kern(src, dst, src_dtype, a_begin, std::min(A, a_begin + a_block),
+             c_begin, std::min(C, c_begin + c_block), B, C);
+    };
+    MEGDNN_DISPATCH_MULTI_THREAD_CPU_KERN(handle, nr_a_blocks * nr_c_blocks,
+                                          run);
+}
+
+}  // anonymous namespace
+
+void ReduceImpl::exec(_megdnn_tensor_in src, _megdnn_tensor_out dst,
+                      _megdnn_workspace workspace) {
+    check_exec(src.layout, dst.layout, workspace.size);
+    size_t A, B, C;
+    reduce::get_ABC(src.layout, A, B, C, param().axis);
+    bool execed = false;
+    using Mode = param::Reduce::Mode;
+    auto handle = static_cast<naive::HandleImpl*>(this->handle());
+    DType src_dtype = src.layout.dtype;
+#define DISPATCH_FUNC(_Reducer, _ctype, _args, _midout_iv)                   \
+    MIDOUT_BEGIN(megdnn_x86_reduce, _ctype, midout_iv(_midout_iv)) {         \
+        auto sptr = reinterpret_cast<const _ctype*>(src.raw_ptr);            \
+        auto dptr = reinterpret_cast<_ctype*>(dst.raw_ptr);                  \
+        if (C == 1) {                                                        \
+            dispatch_reduce<_ctype>(                                         \
+                    handle, Exec<_Reducer<_args, true>, true>::do_reduce,    \
+                    sptr, dptr, src_dtype, A, B, C);                         \
+        } else {                                                             \
+            dispatch_reduce<_ctype>(                                         \
+                    handle, Exec<_Reducer<_args, false>, false>::do_reduce,  \
+                    sptr, dptr, src_dtype, A, B, C);                         \
+        }                                                                    \
+        execed = true;                                                       \
+    }                                                                        \
+    MIDOUT_END();
+
+#define DISPATCH_MODE_FLOAT(_ctype)                                          \
+    switch (param().mode) {                                                  \
+        case Mode::SUM:                                                      \
+            DISPATCH_FUNC(FloatReducer, _ctype,                              \
+                          VecAdd MEGDNN_COMMA _ctype MEGDNN_COMMA false, 0); \
+            break;                                                           \
+        case Mode::MEAN:                                                     \
+            DISPATCH_FUNC(FloatReducer, _ctype,                              \
+                          VecAdd MEGDNN_COMMA _ctype MEGDNN_COMMA true, 1);  \
+            break;                                                           \
+        case Mode::SUM_SQR:                                                  \
+            DISPATCH_FUNC(FloatReducer, _ctype,                              \
+                          VecSqrAdd MEGDNN_COMMA _ctype MEGDNN_COMMA false,  \
+                          2);                                                \
+            break;                                                           \
+        case Mode::PRODUCT:                                                  \
+            DISPATCH_FUNC(FloatReducer, _ctype,                              \
+                          VecMul MEGDNN_COMMA _ctype MEGDNN_COMMA false, 3); \
+            break;                                                           \
+        case Mode::MAX:                                                      \
+            DISPATCH_FUNC(FloatReducer, _ctype,                              \
+                          VecMax MEGDNN_COMMA _ctype MEGDNN_COMMA false, 4); \
+            break;                                                           \
+        case Mode::MIN:                                                      \
+            DISPATCH_FUNC(FloatReducer, _ctype,                              \
+                          VecMin MEGDNN_COMMA _ctype MEGDNN_COMMA false, 5); \
+            break;                                                           \
+        default:                                                             \
+            break;                                                           \
+    }
+
+#define DISPATCH_MODE_QUANTIZED(_ctype)                                      \
+    switch (param().mode) {                                                  \
+        case Mode::MEAN:                                                     \
+            DISPATCH_FUNC(QuantizedMeanReducer, _ctype, _ctype, 6);          \
+            break;                                                           \
+        case Mode::MAX:                                                      \
+            DISPATCH_FUNC(QuantizedMinMaxReducer, _ctype,                    \
+                          _ctype MEGDNN_COMMA true, 7);                      \
+            break;                                                           \
+        case Mode::MIN:                                                      \
+            DISPATCH_FUNC(QuantizedMinMaxReducer, _ctype,                    \
+                          _ctype MEGDNN_COMMA false, 8);                     \
+            break;                                                           \
+        default:                                                             \
+            break;                                                           \
+    }
+
+    if (is_supported(SIMDType::AVX2) && src.layout.is_contiguous() &&
+        param().data_type == param::Reduce::DataType::DEFAULT) {
+        switch (src_dtype.enumv()) {
+            case DTypeEnum::Float32:
+                DISPATCH_MODE_FLOAT(dt_float32);
+                break;
+#if !MEGDNN_DISABLE_FLOAT16
+            case DTypeEnum::Float16:
+                DISPATCH_MODE_FLOAT(dt_float16);
+                break;
+#endif
+            case DTypeEnum::QuantizedS8:
+                DISPATCH_MODE_QUANTIZED(int8_t);
+                break;
+            case DTypeEnum::Quantized8Asymm:
+                DISPATCH_MODE_QUANTIZED(uint8_t);
+                break;
+            default:
+                break;
+        }
+    }
+#undef DISPATCH_MODE_QUANTIZED
+#undef DISPATCH_MODE_FLOAT
+#undef DISPATCH_FUNC
+
+    if (!execed) {
+        return fallback::ReduceImpl::exec(src, dst, workspace);
+    }
+}
+
+// vim: syntax=cpp.doxygen
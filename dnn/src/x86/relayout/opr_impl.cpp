@@ -0,0 +1,297 @@
+/**
+ * \file dnn/src/x86/relayout/opr_impl.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "src/common/utils.h"
+#include "src/common/relayout_helper.h"
+
+#include "src/x86/handle.h"
+#include "src/x86/relayout/opr_impl.h"
+#include "src/x86/utils.h"
+
+#include <immintrin.h>
+
+using namespace megdnn;
+using namespace relayout;
+
+namespace {
+
+struct TransposeByte {
+    uint8_t v;
+};
+
+struct Transpose2Byte {
+    uint16_t v;
+};
+
+struct Transpose4Byte {
+    uint32_t v;
+};
+
+MEGDNN_ATTRIBUTE_TARGET("sse2")
+void trans_16x16_u8(const void* src, void* dst, const size_t src_step,
+                    const size_t dst_step) {
+    auto sptr = static_cast<const uint8_t*>(src);
+    auto dptr = static_cast<uint8_t*>(dst);
+    __m128i a[16], b[16];
+    for (size_t i = 0; i < 16; ++i) {
+        a[i] = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(sptr + i * src_step));
+    }
+    //! b[i]: rows (2i, 2i + 1), b[i + 8]: the same rows of columns 8 to 15
+    for (size_t i = 0; i < 8; ++i) {
+        b[i] = _mm_unpacklo_epi8(a[2 * i], a[2 * i + 1]);
+        b[i + 8] = _mm_unpackhi_epi8(a[2 * i], a[2 * i + 1]);
+    }
+    //! a[4 * q + k]: rows [4k, 4k + 4) of columns [4q, 4q + 4)
+    for (size_t k = 0; k < 4; ++k) {
+        a[k] = _mm_unpacklo_epi16(b[2 * k], b[2 * k + 1]);
+        a[k + 4] = _mm_unpackhi_epi16(b[2 * k], b[2 * k + 1]);
+        a[k + 8] = _mm_unpacklo_epi16(b[2 * k + 8], b[2 * k + 9]);
+        a[k + 12] = _mm_unpackhi_epi16(b[2 * k + 8], b[2 * k + 9]);
+    }
+    //! b[2 * c + p]: rows [8p, 8p + 8) of columns (2c, 2c + 1)
+    for (size_t q = 0; q < 4; ++q) {
+        for (size_t p = 0; p < 2; ++p) {
+            b[4 * q + p] =
+                    _mm_unpacklo_epi32(a[4 * q + 2 * p], a[4 * q + 2 * p + 1]);
+            b[4 * q + 2 + p] =
+                    _mm_unpackhi_epi32(a[4 * q + 2 * p], a[4 * q + 2 * p + 1]);
+        }
+    }
+    for (size_t c = 0; c < 8; ++c) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dptr + 2 * c * dst_step),
+                         _mm_unpacklo_epi64(b[2 * c], b[2 * c + 1]));
+        _mm_storeu_si128(
+                reinterpret_cast<__m128i*>(dptr + (2 * c + 1) * dst_step),
+                _mm_unpackhi_epi64(b[2 * c], b[2 * c + 1]));
+    }
+}
+
+MEGDNN_ATTRIBUTE_TARGET("sse2")
+void trans_8x8_u16(const void* src, void* dst, const size_t src_step,
+                   const size_t dst_step) {
+    auto sptr = static_cast<const uint16_t*>(src);
+    auto dptr = static_cast<uint16_t*>(dst);
+    __m128i a[8], b[8];
+    for (size_t i = 0; i < 8; ++i) {
+        a[i] = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(sptr + i * src_step));
+    }
+    for (size_t i = 0; i < 4; ++i) {
+        b[2 * i] = _mm_unpacklo_epi16(a[2 * i], a[2 * i + 1]);
+        b[2 * i + 1] = _mm_unpackhi_epi16(a[2 * i], a[2 * i + 1]);
+    }
+    for (size_t i = 0; i < 2; ++i) {
+        a[4 * i] = _mm_unpacklo_epi32(b[4 * i], b[4 * i + 2]);
+        a[4 * i + 1] = _mm_unpackhi_epi32(b[4 * i], b[4 * i + 2]);
+        a[4 * i + 2] = _mm_unpacklo_epi32(b[4 * i + 1], b[4 * i + 3]);
+        a[4 * i + 3] = _mm_unpackhi_epi32(b[4 * i + 1], b[4 * i + 3]);
+    }
+    for (size_t i = 0; i < 4; ++i) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dptr + 2 * i * dst_step),
+                         _mm_unpacklo_epi64(a[i], a[i + 4]));
+        _mm_storeu_si128(
+                reinterpret_cast<__m128i*>(dptr + (2 * i + 1) * dst_step),
+                _mm_unpackhi_epi64(a[i], a[i + 4]));
+    }
+}
+
+MEGDNN_ATTRIBUTE_TARGET("avx")
+void trans_8x8_u32(const void* src, void* dst, const size_t src_step,
+                   const size_t dst_step) {
+    auto sptr = static_cast<const float*>(src);
+    auto dptr = static_cast<float*>(dst);
+    __m256 a[8], b[8];
+    for (size_t i = 0; i < 8; ++i) {
+        a[i] = _mm256_loadu_ps(sptr + i * src_step);
+    }
+    for (size_t i = 0; i < 4; ++i) {
+        b[2 * i] = _mm256_unpacklo_ps(a[2 * i], a[2 * i + 1]);
+        b[2 * i + 1] = _mm256_unpackhi_ps(a[2 * i], a[2 * i + 1]);
+    }
+    for (size_t i = 0; i < 2; ++i) {
+        a[4 * i] = _mm256_shuffle_ps(b[4 * i], b[4 * i + 2],
+                                     _MM_SHUFFLE(1, 0, 1, 0));
+        a[4 * i + 1] = _mm256_shuffle_ps(b[4 * i], b[4 * i + 2],
+                                         _MM_SHUFFLE(3, 2, 3, 2));
+        a[4 * i + 2] = _mm256_shuffle_ps(b[4 * i + 1], b[4 * i + 3],
+                                         _MM_SHUFFLE(1, 0, 1, 0));
+        a[4 * i + 3] = _mm256_shuffle_ps(b[4 * i + 1], b[4 * i + 3],
+                                         _MM_SHUFFLE(3, 2, 3, 2));
+    }
+    for (size_t i = 0; i < 4; ++i) {
+        _mm256_storeu_ps(dptr + i * dst_step,
+                         _mm256_permute2f128_ps(a[i], a[i + 4], 0x20));
+        _mm256_storeu_ps(dptr + (i + 4) * dst_step,
+                         _mm256_permute2f128_ps(a[i], a[i + 4], 0x31));
+    }
+}
+
+}  // anonymous namespace
+
+namespace megdnn {
+namespace relayout {
+namespace transpose_fallback {
+template <>
+struct transpose_traits<TransposeByte> {
+    static constexpr size_t block_size = 16;
+};
+
+template <>
+void transpose_block<TransposeByte>(const TransposeByte* src,
+                                    TransposeByte* dst, const size_t src_stride,
+                                    const size_t dst_stride) {
+    trans_16x16_u8(src, dst, src_stride, dst_stride);
+}
+
+template <>
+struct transpose_traits<Transpose2Byte> {
+    static constexpr size_t block_size = 8;
+};
+
+template <>
+void transpose_block<Transpose2Byte>(const Transpose2Byte* src,
+                                     Transpose2Byte* dst,
+                                     const size_t src_stride,
+                                     const size_t dst_stride) {
+    trans_8x8_u16(src, dst, src_stride, dst_stride);
+}
+
+template <>
+struct transpose_traits<Transpose4Byte> {
+    static constexpr size_t block_size = 8;
+};
+
+template <>
+void transpose_block<Transpose4Byte>(const Transpose4Byte* src,
+                                     Transpose4Byte* dst,
+                                     const size_t src_stride,
+                                     const size_t dst_stride) {
+    trans_8x8_u32(src, dst, src_stride, dst_stride);
+}
+
+}  // namespace transpose_fallback
+}  // namespace relayout
+}  // namespace megdnn
+
+namespace {
+
+/*!
+ * rows of a (m, n) matrix transposed together: the blocks are visited column
+ * by column inside such a band, so the source rows of the band stay in cache
+ * and each destination row receives a contiguous run of BAND_ROWS elements
+ */
+constexpr size_t BAND_ROWS = 64;
+
+//! minimal number of elements transposed by one task
+constexpr size_t MIN_TASK_ELEMS = 16384;
+
+template <typename T>
+void transpose_band(size_t m, size_t n, size_t i_begin, size_t i_end,
+                    size_t j_begin, size_t j_end, const T* src, T* dst) {
+    constexpr size_t B = transpose_fallback::transpose_traits<T>::block_size;
+    for (size_t j = j_begin; j < j_end; j += B) {
+        size_t w = std::min(B, j_end - j);
+        for (size_t i = i_begin; i < i_end; i += B) {
+            size_t h = std::min(B, i_end - i);
+            auto sptr = src + i * n + j;
+            auto dptr = dst + j * m + i;
+            if (h == B && w == B) {
+                transpose_fallback::transpose_block(sptr, dptr, n, m);
+            } else {
+                transpose_fallback::transpose_block(sptr, dptr, n, m, h, w);
+            }
+        }
+    }
+}
+
+/*!
+ * \brief transpose contiguous (batch, m, n) to (batch, n, m) with the tasks
+ *      split over the (batch, row band) pairs, and over blocks of columns if
+ *      there are not enough of them to feed all the threads
+ */
+template <typename T>
+void dispatch_transpose(naive::HandleImpl* handle, const TransposeParam& p,
+                        const T* src, T* dst) {
+    constexpr size_t B = transpose_fallback::transpose_traits<T>::block_size;
+    size_t batch = p.batch, m = p.m, n = p.n;
+    size_t nr_threads = handle->megcore_dispatcher()->nr_threads();
+    size_t nr_tasks = 1;
+    if (nr_threads > 1) {
+        nr_tasks = std::min(nr_threads * 4,
+                            std::max<size_t>(batch * m * n / MIN_TASK_ELEMS, 1));
+    }
+    size_t nr_bands = div_ceil(m, BAND_ROWS);
+    size_t nr_units = batch * nr_bands;
+    size_t units_per_task = div_ceil(nr_units, std::min(nr_units, nr_tasks));
+    size_t nr_unit_blocks = div_ceil(nr_units, units_per_task);
+    size_t j_block = n;
+    if (nr_unit_blocks < nr_tasks) {
+        j_block = std::min(
+                n, round_up(div_ceil(n, div_ceil(nr_tasks, nr_unit_blocks)),
+                            B));
+    }
+    size_t nr_j_blocks = div_ceil(n, j_block);
+    auto run = [=](size_t index, size_t) {
+        size_t unit_begin = index / nr_j_blocks * units_per_task,
+               unit_end = std::min(nr_units, unit_begin + units_per_task),
+               j_begin = index % nr_j_blocks * j_block,
+               j_end = std::min(n, j_begin + j_block);
+        for (size_t unit = unit_begin; unit < unit_end; ++unit) {
+            size_t b = unit / nr_bands, i_begin = unit % nr_bands * BAND_ROWS;
+            transpose_band(m, n, i_begin, std::min(m, i_begin + BAND_ROWS),
+                           j_begin, j_end, src + b * m * n, dst + b * m * n);
+        }
+    };
+    MEGDNN_DISPATCH_MULTI_THREAD_CPU_KERN(handle, nr_unit_blocks * nr_j_blocks,
+                                          run);
+}
+
+}  // anonymous namespace
+
+void x86::RelayoutForwardImpl::exec(_megdnn_tensor_in src0,
+                                    _megdnn_tensor_out dst0,
+                                    Handle* src_handle) {
+    check_cpu_handle(src_handle);
+    TensorND src = src0, dst = dst0;
+    check_layout_and_canonize(src.layout, dst.layout);
+
+    relayout::TransposeParam trans_param;
+    bool trans = relayout::is_transpose(src.layout, dst.layout, trans_param);
+    if (trans) {
+        //! the channels are moved together, so treat them as a single element
+        auto dsize = src.layout.dtype.size() * trans_param.c;
+        auto src_addr = reinterpret_cast<uintptr_t>(src.raw_ptr),
+             dst_addr = reinterpret_cast<uintptr_t>(dst.raw_ptr);
+        bool aligned = !((src_addr | dst_addr) & (dsize - 1));
+        auto handle = static_cast<naive::HandleImpl*>(this->handle());
+#define DISPATCH(_T)                                                   \
+    do {                                                               \
+        dispatch_transpose<_T>(handle, trans_param,                    \
+                               static_cast<const _T*>(src.raw_ptr),    \
+                               static_cast<_T*>(dst.raw_ptr));         \
+        return;                                                        \
+    } while (0)
+        if (dsize == 1) {
+            DISPATCH(TransposeByte);
+        }
+        if (dsize == 2 && aligned) {
+            DISPATCH(Transpose2Byte);
+        }
+        if (dsize == 4 && aligned && x86::is_supported(x86::SIMDType::AVX)) {
+            DISPATCH(Transpose4Byte);
+        }
+#undef DISPATCH
+    }
+    exec_after_preprocess(src, dst, trans ? &trans_param : nullptr);
+}
+
+// vim: syntax=cpp.doxygen
@@ -0,0 +1,355 @@
+/**
+ * \file dnn/src/x86/topk/opr_impl.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+#include "src/x86/topk/opr_impl.h"
+
+#include <immintrin.h>
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include "src/common/utils.h"
+#include "src/naive/handle.h"
+#include "src/x86/utils.h"
+
+using namespace megdnn;
+using namespace x86;
+
+#include "midout.h"
+MIDOUT_DECL(megdnn_x86_topk)
+
+#define TOPK_TARGET MEGDNN_ATTRIBUTE_TARGET("avx2")
+
+namespace {
+
+//! minimal number of elements in a row segment processed by one task
+constexpr size_t MIN_SEG_LEN = 8192;
+//! extra room of the candidate buffer besides 2k
+constexpr size_t FILTER_SLACK = 256;
+//! the candidate buffer is shrunk when it has less room than this
+constexpr size_t MIN_ROOM = 64;
+
+struct Plan {
+    size_t kk;       //!< number of selected elements of each row
+    size_t nr_seg;   //!< number of segments of each row
+    size_t scratch;  //!< number of pairs in the scratch of each thread
+    size_t nr_threads;
+
+    Plan(int k, size_t m, size_t n, size_t nr_threads)
+            : kk{std::min<size_t>(std::abs(k), n)}, nr_threads{nr_threads} {
+        nr_seg = 1;
+        if (nr_threads > 1 && m && m < nr_threads) {
+            nr_seg = std::min(div_ceil(nr_threads, m),
+                              n / std::max(MIN_SEG_LEN, kk * 8));
+            nr_seg = std::max<size_t>(nr_seg, 1);
+        }
+        //! segments shorter than the candidate buffer are copied as a whole
+        scratch = std::min(div_ceil(n, nr_seg), kk * 2 + FILTER_SLACK);
+    }
+
+    size_t seg_begin(size_t seg, size_t n) const { return seg * n / nr_seg; }
+
+    //! number of pairs of the workspace
+    size_t workspace_size(size_t m) const {
+        return nr_threads * scratch + (nr_seg > 1 ? m * nr_seg * kk : 0);
+    }
+};
+
+template <typename ctype>
+using Pair = std::pair<ctype, uint32_t>;
+
+//! whether \p a ranks before \p b
+template <typename ctype, bool largest>
+bool before(ctype a, ctype b) {
+    return largest ? b < a : a < b;
+}
+
+template <typename ctype, bool largest>
+using PairCmp = typename std::conditional<largest, std::greater<Pair<ctype>>,
+                                          std::less<Pair<ctype>>>::type;
+
+/*!
+ * \brief append the elements of src[0:n) ranking before thresh to dst
+ * \return number of appended elements
+ */
+template <typename ctype>
+using FilterFunc = size_t (*)(const ctype* src, size_t n, ctype thresh,
+                              uint32_t base, Pair<ctype>* dst);
+
+template <typename ctype, bool largest>
+size_t filter_naive(const ctype* src, size_t n, ctype thresh, uint32_t base,
+                    Pair<ctype>* dst) {
+    size_t cnt = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (before<ctype, largest>(src[i], thresh)) {
+            dst[cnt++] = {src[i], static_cast<uint32_t>(base + i)};
+        }
+    }
+    return cnt;
+}
+
+template <typename ctype, bool largest>
+struct SimdCmp;
+
+template <bool largest>
+struct SimdCmp<dt_float32, largest> {
+    using vtype = __m256;
+    static __m256 set1(dt_float32 v) TOPK_TARGET { return _mm256_set1_ps(v); }
+    static uint32_t mask(const dt_float32* src, __m256 thresh) TOPK_TARGET {
+        return _mm256_movemask_ps(_mm256_cmp_ps(
+                _mm256_loadu_ps(src), thresh,
+                largest ? _CMP_GT_OQ : _CMP_LT_OQ));
+    }
+};
+
+template <bool largest>
+struct SimdCmp<dt_int32, largest> {
+    using vtype = __m256i;
+    static __m256i set1(dt_int32 v) TOPK_TARGET {
+        return _mm256_set1_epi32(v);
+    }
+    static uint32_t mask(const dt_int32* src, __m256i thresh) TOPK_TARGET {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+        __m256i r = largest ? _mm256_cmpgt_epi32(v, thresh)
+                            : _mm256_cmpgt_epi32(thresh, v);
+        return _mm256_movemask_ps(_mm256_castsi256_ps(r));
+    }
+};
+
+template <typename ctype>
+inline size_t append_masked(const ctype* src, uint32_t mask,
+                            uint32_t base, Pair<ctype>* dst) {
+    size_t cnt = 0;
+    while (mask) {
+        uint32_t i = __builtin_ctz(mask);
+        dst[cnt++] = {src[i], base + i};
+        mask &= mask - 1;
+    }
+    return cnt;
+}
+
+template <typename ctype, bool largest>
+TOPK_TARGET size_t filter_avx2(const ctype* src, size_t n, ctype thresh,
+                               uint32_t base, Pair<ctype>* dst) {
+    using Cmp = SimdCmp<ctype, largest>;
+    auto t = Cmp::set1(thresh);
+    size_t cnt = 0, i = 0;
+    //! most blocks have no candidate once the threshold is tight
+    for (; i + 32 <= n; i += 32) {
+        uint32_t mask = Cmp::mask(src + i, t) | Cmp::mask(src + i + 8, t) << 8 |
+                        Cmp::mask(src + i + 16, t) << 16 |
+                        Cmp::mask(src + i + 24, t) << 24;
+        if (mask) {
+            cnt += append_masked(src + i, mask, base + i, dst + cnt);
+        }
+    }
+    for (; i + 8 <= n; i += 8) {
+        uint32_t mask = Cmp::mask(src + i, t);
+        if (mask) {
+            cnt += append_masked(src + i, mask, base + i, dst + cnt);
+        }
+    }
+    return cnt + filter_naive<ctype, largest>(src + i, n - i, thresh, base + i,
+                                              dst + cnt);
+}
+
+template <typename ctype, bool largest>
+struct FilterSelector {
+    static FilterFunc<ctype> get() { return filter_naive<ctype, largest>; }
+};
+
+#define INST(_ctype)                                        \
+    template <bool largest>                                 \
+    struct FilterSelector<_ctype, largest> {                \
+        static FilterFunc<_ctype> get() {                   \
+            if (is_supported(SIMDType::AVX2)) {             \
+                return filter_avx2<_ctype, largest>;        \
+            }                                               \
+            return filter_naive<_ctype, largest>;           \
+        }                                                   \
+    };
+INST(dt_float32)
+INST(dt_int32)
+#undef INST
+
+/*!
+ * \brief collect the candidates of the top kk elements of src[0:len)
+ *
+ * \param buf candidate buffer with \p cap pairs
+ * \return number of candidates in buf, which is at least kk and contains the
+ *      top kk elements
+ */
+template <typename ctype, bool largest>
+size_t select_candidates(const ctype* src, size_t len, uint32_t base,
+                         size_t kk, Pair<ctype>* buf, size_t cap,
+                         FilterFunc<ctype> filter) {
+    if (len <= cap) {
+        for (size_t i = 0; i < len; ++i) {
+            buf[i] = {src[i], static_cast<uint32_t>(base + i)};
+        }
+        return len;
+    }
+    megdnn_assert(cap >= kk + MIN_ROOM);
+    ctype thresh = src[0];
+    for (size_t i = 0; i < kk; ++i) {
+        buf[i] = {src[i], static_cast<uint32_t>(base + i)};
+        if (before<ctype, largest>(thresh, src[i])) {
+            thresh = src[i];
+        }
+    }
+    size_t size = kk;
+    for (size_t i = kk; i < len;) {
+        size_t chunk = std::min(len - i, cap - size);
+        size += filter(src + i, chunk, thresh, base + i, buf + size);
+        i += chunk;
+        if (cap - size < MIN_ROOM) {
+            std::nth_element(buf, buf + kk - 1, buf + size,
+                             PairCmp<ctype, largest>{});
+            size = kk;
+            thresh = buf[kk - 1].first;
+        }
+    }
+    return size;
+}
+
+template <typename ctype, bool largest>
+void write_result(Pair<ctype>* cand, size_t size, size_t kk,
+                  TopK::Param::Mode mode, ctype* values, int32_t* indices) {
+    using Mode = TopK::Param::Mode;
+    PairCmp<ctype, largest> cmp;
+    switch (mode) {
+        case Mode::KTH_ONLY:
+            std::nth_element(cand, cand + kk - 1, cand + size, cmp);
+            values[0] = cand[kk - 1].first;
+            return;
+        case Mode::VALUE_IDX_NOSORT:
+            std::nth_element(cand, cand + kk - 1, cand + size, cmp);
+            break;
+        case Mode::VALUE_IDX_SORTED:
+            std::partial_sort(cand, cand + kk, cand + size, cmp);
+            break;
+        default:
+            megdnn_throw("invalid TopK mode");
+    }
+    for (size_t i = 0; i < kk; ++i) {
+        values[i] = cand[i].first;
+        indices[i] = cand[i].second;
+    }
+}
+
+template <typename ctype, bool largest>
+void dispatch_topk(naive::HandleImpl* handle, const Plan& plan,
+                   TopK::Param::Mode mode, size_t m, size_t n, ptrdiff_t lda,
+                   const ctype* data, ctype* values, int32_t* indices,
+                   void* workspace) {
+    using Mode = TopK::Param::Mode;
+    auto filter = FilterSelector<ctype, largest>::get();
+    auto scratch = static_cast<Pair<ctype>*>(workspace);
+    size_t kk = plan.kk, cap = plan.scratch,
+           ostride = mode == Mode::KTH_ONLY ? 1 : kk;
+
+    if (plan.nr_seg == 1) {
+        auto run = [=](size_t row, size_t thread_id) {
+            auto buf = scratch + thread_id * cap;
+            size_t size = select_candidates<ctype, largest>(
+                    data + row * lda, n, 0, kk, buf, cap, filter);
+            write_result<ctype, largest>(
+                    buf, size, kk, mode, values + row * ostride,
+                    indices ? indices + row * ostride : nullptr);
+        };
+        MEGDNN_DISPATCH_MULTI_THREAD_CPU_KERN(handle, m, run);
+        return;
+    }
+
+    //! select kk candidates from each segment and then from the nr_seg * kk
+    //! candidates of each row
+    size_t nr_seg = plan.nr_seg;
+    auto seg_cand = scratch + plan.nr_threads * cap;
+    auto run_seg = [=](size_t index, size_t thread_id) {
+        size_t row = index / nr_seg, seg = index % nr_seg,
+               begin = plan.seg_begin(seg, n),
+               end = plan.seg_begin(seg + 1, n);
+        auto buf = scratch + thread_id * cap;
+        size_t size = select_candidates<ctype, largest>(
+                data + row * lda + begin, end - begin, begin, kk, buf, cap,
+                filter);
+        std::nth_element(buf, buf + kk - 1, buf + size,
+                         PairCmp<ctype, largest>{});
+        std::copy(buf, buf + kk, seg_cand + index * kk);
+    };
+    MEGDNN_DISPATCH_MULTI_THREAD_CPU_KERN(handle, m * nr_seg, run_seg);
+    auto run_merge = [=](size_t row, size_t) {
+        write_result<ctype, largest>(
+                seg_cand + row * nr_seg * kk, nr_seg * kk, kk, mode,
+                values + row * ostride,
+                indices ? indices + row * ostride : nullptr);
+    };
+    MEGDNN_DISPATCH_MULTI_THREAD_CPU_KERN(handle, m, run_merge);
+}
+
+size_t get_nr_threads(Handle* handle) {
+    return static_cast<naive::HandleImpl*>(handle)
+            ->megcore_dispatcher()
+            ->nr_threads();
+}
+
+}  // anonymous namespace
+
+void TopKImpl::do_exec(int k, _megdnn_tensor_in data, _megdnn_tensor_out values,
+                       int32_t* indices, _megdnn_workspace workspace) {
+    size_t m = data.layout[0], n = data.layout[1];
+    ptrdiff_t lda = data.layout.stride[0];
+    megdnn_assert(n <= std::numeric_limits<uint32_t>::max());
+    Plan plan{k, m, n, get_nr_threads(handle())};
+    auto handle = static_cast<naive::HandleImpl*>(this->handle());
+    switch (data.layout.dtype.enumv()) {
+#define cb(t)                                                                 \
+    case DTypeTrait<t>::enumv:                                                \
+        do {                                                                  \
+            using ct = DTypeTrait<t>::ctype;                                  \
+            if (k < 0) {                                                      \
+                MIDOUT_BEGIN(megdnn_x86_topk, ct, midout_iv(true)) {          \
+                    dispatch_topk<ct, true>(handle, plan, param().mode, m, n, \
+                                            lda, data.ptr<ct>(),              \
+                                            values.ptr<ct>(), indices,        \
+                                            workspace.raw_ptr);               \
+                    return;                                                   \
+                }                                                             \
+                MIDOUT_END();                                                 \
+            } else {                                                          \
+                MIDOUT_BEGIN(megdnn_x86_topk, ct, midout_iv(false)) {         \
+                    dispatch_topk<ct, false>(handle, plan, param().mode, m,   \
+                                             n, lda, data.ptr<ct>(),          \
+                                             values.ptr<ct>(), indices,       \
+                                             workspace.raw_ptr);              \
+                    return;                                                   \
+                }                                                             \
+                MIDOUT_END();                                                 \
+            }                                                                 \
+        } while (0);
+        MEGDNN_FOREACH_COMPUTING_DTYPE(cb);
+#undef cb
+        default:
+            break;
+    }
+    naive::TopKImpl::do_exec(k, data, values, indices, workspace);
+}
+
+size_t TopKImpl::get_workspace_in_bytes(int k, const TensorLayout& data,
+                                        const TensorLayout& values,
+                                        const TensorLayout& indices) {
+    MEGDNN_MARK_USED_VAR(values);
+    MEGDNN_MARK_USED_VAR(indices);
+    Plan plan{k, data[0], data[1], get_nr_threads(handle())};
+    //! also large enough for the naive impl, which needs 2 * n elements
+    return std::max(sizeof(uint32_t), data.dtype.size()) * 2 *
+           std::max(plan.workspace_size(data[0]), data[1]);
+}
+
+// vim: syntax=cpp.doxygen
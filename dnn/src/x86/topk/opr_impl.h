@@ -0,0 +1,42 @@
+/**
+ * \file dnn/src/x86/topk/opr_impl.h
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+#pragma once
+
+#include "src/naive/topk/opr_impl.h"
+
+namespace megdnn {
+namespace x86 {
+
+/*!
+ * \brief TopK by threshold filtering: candidates smaller (or larger) than the
+ *      current k-th value are collected with SIMD compares and the candidate
+ *      buffer is shrunk by nth_element when it is full
+ *
+ * Rows are processed in parallel; rows much longer than k are also split into
+ * segments when there are fewer rows than threads.
+ */
+class TopKImpl : public naive::TopKImpl {
+protected:
+    void do_exec(int k, _megdnn_tensor_in data, _megdnn_tensor_out values,
+                 int32_t* indices, _megdnn_workspace workspace) override;
+
+public:
+    using naive::TopKImpl::TopKImpl;
+
+    size_t get_workspace_in_bytes(int k, const TensorLayout& data,
+                                  const TensorLayout& values,
+                                  const TensorLayout& indices) override;
+};
+
+}  // namespace x86
+}  // namespace megdnn
+
+// vim: syntax=cpp.doxygen
@@ -105,6 +105,38 @@ bool feature_detect_avx2()
 
 }
 
+bool feature_detect_avx512f()
+{
+    uint32_t eax, ebx, ecx, edx;
+
+    // check cpu support
+#if defined(_WIN32)
+    int cpuInfo[4];
+    __cpuid(cpuInfo, 7);
+    eax = cpuInfo[0];
+    ebx = cpuInfo[1];
+    ecx = cpuInfo[2];
+    edx = cpuInfo[3];
+#else
+    asm volatile(
+        "cpuid\n"
+        : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx)
+        : "a"(7), "c"(0)
+        : "cc");
+#endif
+    //avx512f  ---> 16 ebx
+    if (!bit(ebx, 16))
+        return false;
+
+    // check os support: xmm, ymm, opmask and upper zmm states
+    asm volatile(
+        "xgetbv"
+        : "=a"(eax), "=d"(edx)
+        : "c"(0));
+
+    return (eax & 0xe6) == 0xe6;
+}
+
 bool feature_detect_vnni()
 {
     uint32_t eax, ebx, ecx, edx;
@@ -164,6 +196,7 @@ bool feature_detect_avx_fma(int ftr) {
 bool is_avx_supported = feature_detect_avx_fma(28);
 bool is_fma_supported = feature_detect_avx_fma(12);
 bool is_avx2_supported = feature_detect_avx2();
+bool is_avx512f_supported = feature_detect_avx512f();
 bool is_vnni_supported = feature_detect_vnni();
 
 SIMDType disabled_simd_type_thresh = SIMDType::__NR_SIMD_TYPE;
@@ -196,6 +229,8 @@ bool x86::is_supported(SIMDType type) {
             return is_fma_supported;
         case SIMDType::AVX2:
             return is_avx2_supported;
+        case SIMDType::AVX512F:
+            return is_avx512f_supported;
         case SIMDType::VNNI:
             return is_vnni_supported;
         default:
@@ -37,6 +37,7 @@ enum class SIMDType {
     AVX,
     AVX2,
     FMA,
+    AVX512F,
     VNNI,
     NONE,
     __NR_SIMD_TYPE  //! total number of SIMD types; used for testing
@@ -39,6 +39,25 @@ std::vector<CondTakeTestcase> CondTakeTestcase::make() {
                 });
     }
 
+    init_data(ret);
+    return ret;
+}
+
+std::vector<CondTakeTestcase> CondTakeTestcase::make_large(size_t size) {
+    std::vector<CondTakeTestcase> ret;
+    for (uint32_t mode = 0; mode < Param::MODE_NR_MEMBER; ++ mode) {
+        ret.push_back({
+                Param{static_cast<Param::Mode>(mode), 100},
+                TensorLayout{{size}, dtype::Float32()},
+                TensorLayout{{size}, dtype::Int32()},
+                });
+    }
+
+    init_data(ret);
+    return ret;
+}
+
+void CondTakeTestcase::init_data(std::vector<CondTakeTestcase>& cases) {
     NormalRNG data_rng;
     UniformIntRNG rng_byte(0, 255);
     auto fill_data = [&](TensorND data) {
@@ -54,7 +73,7 @@ std::vector<CondTakeTestcase> CondTakeTestcase::make() {
         }
     };
 
-    for (auto &&i: ret) {
+    for (auto &&i: cases) {
         auto size0 = i.m_data.layout.span().dist_byte(),
              size1 = i.m_mask.layout.span().dist_byte();
         i.m_mem.reset(new uint8_t[size0 + size1]);
@@ -72,8 +91,6 @@ std::vector<CondTakeTestcase> CondTakeTestcase::make() {
             rng.gen(i.m_mask);
         }
     }
-
-    return ret;
 }
 
 CondTakeTestcase::Result CondTakeTestcase::run(CondTake* opr) {
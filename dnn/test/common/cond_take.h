@@ -24,12 +24,18 @@ class CondTakeTestcase {
                      const TensorLayout& mask)
             : m_param{param}, m_data{nullptr, data}, m_mask{nullptr, mask} {}
 
+    //! allocate and fill the data and mask of \p cases
+    static void init_data(std::vector<CondTakeTestcase>& cases);
+
 public:
     //! pair of (data, idx)
     using Result =
             std::pair<std::shared_ptr<TensorND>, std::shared_ptr<TensorND>>;
     Result run(CondTake* opr);
     static std::vector<CondTakeTestcase> make();
+
+    //! one case of \p size elements for each mode
+    static std::vector<CondTakeTestcase> make_large(size_t size);
 };
 
 }  // namespace test
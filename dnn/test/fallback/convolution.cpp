@@ -459,6 +459,130 @@ TEST_F(FALLBACK, CONVOLUTION_BACKWARD_DATA) {
     }
 }
 
+TEST_F(FALLBACK_MULTI_THREADS, CONVOLUTION_BACKWARD_DATA) {
+    Checker<ConvolutionBackwardData> checker(handle());
+    using Param = ConvolutionBackwardData::Param;
+
+    Param param;
+    auto run = [&](size_t n, size_t ic, size_t oh, size_t ow, size_t oc,
+                   size_t fh, size_t fw, size_t stride, size_t padding,
+                   size_t group, const char* algo) {
+        param.pad_h = param.pad_w = padding;
+        param.stride_h = param.stride_w = stride;
+
+        TensorLayout diff =
+                TensorLayout{{n, oc * group, oh, ow}, dtype::Float32()};
+        TensorLayout grad;
+        TensorLayout filter;
+        if (group == 1) {
+            param.sparse = Param::Sparse::DENSE;
+            filter = {{oc, ic, fh, fw}, dtype::Float32()};
+        } else {
+            param.sparse = Param::Sparse::GROUP;
+            filter = {{group, oc, ic, fh, fw}, dtype::Float32()};
+        }
+        {
+            auto opr = handle()->create_operator<ConvolutionBackwardData>();
+            opr->param() = param;
+            opr->deduce_layout(filter, diff, grad);
+        }
+        checker.set_param(param)
+                .set_dtype(0, dtype::Float32())
+                .set_dtype(1, dtype::Float32())
+                .set_before_exec_callback(
+                        AlgoChecker<ConvolutionBackwardData>(algo));
+        checker.exec(TensorLayoutArray{filter, diff, grad});
+    };
+
+    for (auto mode :
+         {Param::Mode::CONVOLUTION, Param::Mode::CROSS_CORRELATION}) {
+        param.mode = mode;
+        for (auto algo : {"DeconvMatmul", "DeconvDirect"}) {
+            run(7, 3, 10, 13, 5, 1, 1, 1, 0, 1, algo);
+            run(5, 5, 24, 43, 11, 3, 3, 2, 1, 2, algo);
+            run(1, 4, 9, 12, 2, 4, 6, 1, 0, 5, algo);
+            run(9, 3, 6, 7, 9, 3, 2, 2, 1, 3, algo);
+        }
+    }
+}
+
+TEST_F(FALLBACK, CONVOLUTION_BACKWARD_FILTER) {
+    Checker<ConvolutionBackwardFilter> checker(handle());
+    using Param = ConvolutionBackwardFilter::Param;
+
+    Param param;
+    auto run = [&](size_t n, size_t ic, size_t ih, size_t iw, size_t oc,
+                   size_t fh, size_t fw, size_t stride, size_t padding,
+                   size_t dilate, size_t group, const char* algo) {
+        param.pad_h = param.pad_w = padding;
+        param.stride_h = param.stride_w = stride;
+        param.dilate_h = param.dilate_w = dilate;
+
+        TensorLayout src{{n, ic * group, ih, iw}, dtype::Float32()};
+        TensorLayout filter, diff;
+        if (group == 1) {
+            param.sparse = Param::Sparse::DENSE;
+            filter = {{oc, ic, fh, fw}, dtype::Float32()};
+        } else {
+            param.sparse = Param::Sparse::GROUP;
+            filter = {{group, oc, ic, fh, fw}, dtype::Float32()};
+        }
+        {
+            auto opr = handle()->create_operator<Convolution>();
+            opr->param() = param;
+            opr->deduce_layout(src, filter, diff);
+        }
+        checker.set_param(param)
+                .set_epsilon(1e-3)
+                .set_before_exec_callback(
+                        AlgoChecker<ConvolutionBackwardFilter>(algo));
+        checker.exec(TensorLayoutArray{src, diff, filter});
+    };
+
+    for (auto mode :
+         {Param::Mode::CONVOLUTION, Param::Mode::CROSS_CORRELATION}) {
+        param.mode = mode;
+        run(4, 3, 10, 13, 5, 1, 1, 1, 0, 1, 1, "ConvBwdFilterMatmul");
+        run(5, 5, 24, 43, 11, 3, 3, 2, 1, 1, 2, "ConvBwdFilterMatmul");
+        run(2, 3, 20, 33, 3, 5, 7, 3, 2, 2, 3, "ConvBwdFilterMatmul");
+        run(1, 4, 9, 12, 2, 4, 6, 1, 0, 1, 1, "ConvBwdFilterMatmul");
+        run(4, 1, 10, 13, 1, 3, 3, 1, 1, 1, 8, "ConvBwdFilterChanwise");
+        run(3, 1, 24, 43, 1, 5, 5, 2, 2, 1, 5, "ConvBwdFilterChanwise");
+        run(2, 1, 20, 33, 1, 3, 3, 1, 2, 2, 4, "ConvBwdFilterChanwise");
+    }
+}
+
+TEST_F(FALLBACK_MULTI_THREADS, CONVOLUTION_BACKWARD_FILTER) {
+    Checker<ConvolutionBackwardFilter> checker(handle());
+    using Param = ConvolutionBackwardFilter::Param;
+
+    auto run = [&](size_t n, size_t ic, size_t ih, size_t iw, size_t oc,
+                   size_t fh, size_t fw, size_t stride, size_t padding,
+                   size_t group) {
+        Param param;
+        param.pad_h = param.pad_w = padding;
+        param.stride_h = param.stride_w = stride;
+        TensorLayout filter;
+        if (group == 1) {
+            filter = {{oc, ic, fh, fw}, dtype::Float32()};
+        } else {
+            param.sparse = Param::Sparse::GROUP;
+            filter = {{group, oc, ic, fh, fw}, dtype::Float32()};
+        }
+        size_t oh = (ih + 2 * padding - fh) / stride + 1,
+               ow = (iw + 2 * padding - fw) / stride + 1;
+        checker.set_param(param).set_epsilon(1e-3).exec(
+                {{n, ic * group, ih, iw}, {n, oc * group, oh, ow}, filter});
+    };
+
+    // batch split into chunks whose results are summed
+    run(9, 3, 10, 13, 5, 3, 3, 1, 1, 1);
+    run(2, 8, 12, 12, 16, 3, 3, 2, 1, 1);
+    run(7, 3, 9, 12, 2, 1, 1, 1, 0, 3);
+    // channel-wise
+    run(5, 1, 14, 14, 1, 3, 3, 1, 1, 32);
+}
+
 TEST_F(FALLBACK, CONVOLUTION_BACKWARD_DATA_INT8_INT8_INT32) {
     Checker<ConvolutionBackwardData> checker(handle());
     using Param = ConvolutionBackwardData::Param;
@@ -0,0 +1,155 @@
+/**
+ * \file dnn/test/fallback/rng.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+#include "megdnn.h"
+#include "src/fallback/rng/opr_impl.h"
+#include "test/common/tensor.h"
+#include "test/fallback/fixture.h"
+#include "test/naive/rng.h"
+
+#include <cstring>
+
+using namespace megdnn;
+using namespace test;
+
+namespace {
+template <typename dtype>
+void run_uniform(Handle* handle) {
+    auto opr = handle->create_operator<UniformRNG>();
+    Tensor<typename DTypeTrait<dtype>::ctype> t(
+            handle, {TensorShape{200000}, dtype()});
+    opr->exec(t.tensornd(), {});
+    assert_uniform_correct(t.ptr(), t.layout().total_nr_elems());
+}
+
+template <typename dtype>
+void run_gaussian(Handle* handle) {
+    using ctype = typename DTypeTrait<dtype>::ctype;
+    auto opr = handle->create_operator<GaussianRNG>();
+    opr->param().mean = 0.8;
+    opr->param().std = 2.3;
+    Tensor<ctype> t(handle, {TensorShape{200001}, dtype()});
+    opr->exec(t.tensornd(), {});
+
+    auto ptr = t.ptr();
+    auto size = t.layout().total_nr_elems();
+    for (size_t i = 0; i < size; ++i) {
+        ASSERT_LE(std::abs(ptr[i] - 0.8), ctype(15));
+    }
+    auto stat = get_mean_var(ptr, size, ctype(0.8));
+    ASSERT_LE(std::abs(stat.first - 0.8), 5e-3);
+    ASSERT_LE(std::abs(stat.second - 2.3 * 2.3), 5e-2);
+}
+
+//! run \p Opr twice on each handle and check the outputs are identical
+template <typename Opr>
+void run_thread_invariant(Handle* handle_multi) {
+    auto handle_single = create_cpu_handle(1);
+    Handle* handles[] = {handle_single.get(), handle_multi};
+    // odd size to cover the last incomplete block
+    TensorLayout layout{TensorShape{100003}, dtype::Float32()};
+    std::vector<float> results[2][2];
+    for (int i = 0; i < 2; ++i) {
+        auto opr = handles[i]->create_operator<Opr>();
+        opr->param().seed = 2333;
+        for (int run = 0; run < 2; ++run) {
+            Tensor<float> t(handles[i], layout);
+            opr->exec(t.tensornd(), {});
+            results[i][run].assign(t.ptr(), t.ptr() + layout.total_nr_elems());
+        }
+    }
+    for (int run = 0; run < 2; ++run) {
+        ASSERT_EQ(0, memcmp(results[0][run].data(), results[1][run].data(),
+                            layout.total_nr_elems() * sizeof(float)));
+    }
+    // the stream advances between runs
+    ASSERT_NE(results[0][0], results[0][1]);
+}
+}  // anonymous namespace
+
+TEST(FALLBACK_RNG, PHILOX_KNOWN_ANSWER) {
+    // ctr = 0, key = 0 from the Random123 known-answer tests
+    uint32_t words[fallback::Philox4x32::BATCH * 4];
+    fallback::Philox4x32::fill(0, 0, words);
+    ASSERT_EQ(0x6627e8d5u, words[0]);
+    ASSERT_EQ(0xe169c58du, words[1]);
+    ASSERT_EQ(0xbc57ac4cu, words[2]);
+    ASSERT_EQ(0x9b00dbd8u, words[3]);
+
+    // block i of a batch is block (counter + i)
+    uint32_t next[fallback::Philox4x32::BATCH * 4];
+    fallback::Philox4x32::fill(0, 1, next);
+    ASSERT_EQ(0, memcmp(words + 4, next,
+                        sizeof(uint32_t) * (fallback::Philox4x32::BATCH - 1) *
+                                4));
+}
+
+TEST_F(FALLBACK, UNIFORM_RNG_STREAM_POSITION) {
+    constexpr uint64_t SEED = 0x123456789abcdefULL;
+    //! value i of the stream after the seed is set
+    auto expect = [](uint64_t seed, size_t i) {
+        uint32_t words[fallback::Philox4x32::BATCH * 4];
+        fallback::Philox4x32::fill(seed, i / 4, words);
+        return static_cast<float>((words[i % 4] >> 8) + 1) / (1 << 24);
+    };
+    auto opr = handle()->create_operator<UniformRNG>();
+    auto run = [&](size_t size) {
+        Tensor<float> t(handle(), {TensorShape{size}, dtype::Float32()});
+        opr->exec(t.tensornd(), {});
+        return std::vector<float>(t.ptr(), t.ptr() + size);
+    };
+
+    // each exec starts at a new block: the first call consumes blocks 0 and
+    // 1, so the second one starts at value 8
+    opr->param().seed = SEED;
+    auto out0 = run(5);
+    auto out1 = run(3);
+    for (size_t i = 0; i < 5; ++i) {
+        ASSERT_EQ(expect(SEED, i), out0[i]) << "i=" << i;
+    }
+    for (size_t i = 0; i < 3; ++i) {
+        ASSERT_EQ(expect(SEED, 8 + i), out1[i]) << "i=" << i;
+    }
+
+    // setting a new seed restarts from block 0
+    opr->param().seed = SEED + 1;
+    auto out2 = run(4);
+    for (size_t i = 0; i < 4; ++i) {
+        ASSERT_EQ(expect(SEED + 1, i), out2[i]) << "i=" << i;
+    }
+}
+
+TEST_F(FALLBACK, UNIFORM_RNG_F32) {
+    run_uniform<dtype::Float32>(handle());
+}
+
+TEST_F(FALLBACK, GAUSSIAN_RNG_F32) {
+    run_gaussian<dtype::Float32>(handle());
+}
+
+#if !MEGDNN_DISABLE_FLOAT16
+TEST_F(FALLBACK, UNIFORM_RNG_F16) {
+    run_uniform<dtype::Float16>(handle());
+}
+
+TEST_F(FALLBACK, GAUSSIAN_RNG_F16) {
+    run_gaussian<dtype::Float16>(handle());
+}
+#endif
+
+TEST_F(FALLBACK_MULTI_THREADS, UNIFORM_RNG_THREAD_INVARIANT) {
+    run_thread_invariant<UniformRNG>(handle());
+}
+
+TEST_F(FALLBACK_MULTI_THREADS, GAUSSIAN_RNG_THREAD_INVARIANT) {
+    run_thread_invariant<GaussianRNG>(handle());
+}
+
+// vim: syntax=cpp.doxygen
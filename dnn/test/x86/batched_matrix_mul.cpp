@@ -0,0 +1,124 @@
+/**
+ * \file dnn/test/x86/batched_matrix_mul.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ */
+#include "test/x86/fixture.h"
+
+#include "test/common/benchmarker.h"
+#include "test/common/checker.h"
+#include "test/common/matrix_mul.h"
+#include "test/common/rng.h"
+
+using namespace megdnn;
+using namespace test;
+
+namespace {
+TensorShape shape_a(size_t b, size_t m, size_t k, bool trans) {
+    return trans ? TensorShape{b, k, m} : TensorShape{b, m, k};
+}
+
+void run_batched_matmul_test(Handle* handle) {
+    Checker<BatchedMatrixMul> checker(handle);
+    checker.set_epsilon(1e-3);
+    using Param = MatrixMul::Param;
+    auto args = matrix_mul::get_batched_matmul_args();
+    for (auto&& arg : args) {
+        Param param;
+        param.transposeA = arg.mask & 1;
+        param.transposeB = arg.mask & 2;
+        checker.set_param(param).execs(
+                {shape_a(arg.b, arg.m, arg.k, param.transposeA),
+                 shape_a(arg.b, arg.k, arg.n, param.transposeB),
+                 {}});
+    }
+
+    //! small matrices with odd edges, and matrices large enough for the
+    //! packed kernels
+    for (unsigned mask = 0; mask < 4; ++mask) {
+        Param param;
+        param.transposeA = mask & 1;
+        param.transposeB = mask & 2;
+        checker.set_param(param);
+        for (auto&& shp : std::vector<std::array<size_t, 4>>{
+                     {9, 7, 17, 5},
+                     {16, 64, 64, 64},
+                     {3, 130, 129, 131},
+                     {1, 250, 200, 300}}) {
+            size_t b = shp[0], m = shp[1], n = shp[2], k = shp[3];
+            checker.execs({shape_a(b, m, k, param.transposeA),
+                           shape_a(b, k, n, param.transposeB),
+                           {}});
+        }
+    }
+}
+
+void run_broadcast_b_test(Handle* handle) {
+    Checker<BatchedMatrixMul> checker(handle);
+    checker.set_epsilon(1e-3);
+    using Param = MatrixMul::Param;
+    for (unsigned mask = 0; mask < 4; ++mask) {
+        Param param;
+        param.transposeA = mask & 1;
+        param.transposeB = mask & 2;
+        checker.set_param(param);
+        for (auto&& shp : std::vector<std::array<size_t, 4>>{
+                     {8, 33, 47, 29}, {5, 200, 150, 170}}) {
+            size_t b = shp[0], m = shp[1], n = shp[2], k = shp[3];
+            TensorLayout A{shape_a(b, m, k, param.transposeA),
+                           dtype::Float32()};
+            TensorLayout B{shape_a(b, k, n, param.transposeB),
+                           dtype::Float32()};
+            B.stride[0] = 0;
+            checker.execl({A, B, {{b, m, n}, dtype::Float32()}});
+        }
+    }
+}
+}  // anonymous namespace
+
+TEST_F(X86, BATCHED_MATRIX_MUL) {
+    run_batched_matmul_test(handle());
+}
+
+TEST_F(X86, BATCHED_MATRIX_MUL_BROADCAST_B) {
+    run_broadcast_b_test(handle());
+}
+
+TEST_F(X86_MULTI_THREADS, BATCHED_MATRIX_MUL) {
+    run_batched_matmul_test(handle());
+}
+
+TEST_F(X86_MULTI_THREADS, BATCHED_MATRIX_MUL_BROADCAST_B) {
+    run_broadcast_b_test(handle());
+}
+
+#if MEGDNN_WITH_BENCHMARK
+TEST_F(X86, BENCHMARK_BATCHED_MATRIX_MUL) {
+    constexpr size_t RUNS = 20;
+    Benchmarker<BatchedMatrixMul> benchmarker(handle());
+    Benchmarker<BatchedMatrixMul> benchmarker_fallback(fallback_handle());
+    benchmarker.set_times(RUNS).set_display(false);
+    benchmarker_fallback.set_times(RUNS).set_display(false);
+    auto run = [&](size_t b, size_t m, size_t n, size_t k) {
+        TensorShapeArray shapes{{b, m, k}, {b, k, n}, {}};
+        auto cur = benchmarker.execs(shapes) / RUNS;
+        auto fallback = benchmarker_fallback.execs(shapes) / RUNS;
+        printf("batched matmul (%zu, %zu, %zu, %zu): fallback=%.3fms "
+               "cur=%.3fms speedup=%.2f\n",
+               b, m, n, k, fallback, cur, fallback / cur);
+    };
+    run(512, 64, 64, 64);
+    run(96, 128, 128, 64);
+    run(16, 384, 384, 64);
+    run(4, 512, 512, 512);
+    run(2, 1024, 1024, 1024);
+}
+#endif
+
+// vim: syntax=cpp.doxygen
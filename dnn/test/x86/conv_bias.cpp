@@ -1767,6 +1767,130 @@ TEST_F(X86_MULTI_THREADS, BENCHMARK_CONVBIAS_FP32_MKLDNN) {
 #endif
 #endif
 
+/************************* NCHW88 direct ****************************/
+namespace {
+std::vector<conv_bias::TestArg> get_nchw88_conv_bias_args(
+        std::vector<size_t> kernels, size_t stride, bool is_hybrid,
+        bool is_chanwise) {
+    using namespace conv_bias;
+    using NLMode = param::ConvBias::NonlineMode;
+    std::vector<TestArg> args;
+    auto pack = [](size_t n, size_t c, size_t h, size_t w) {
+        return TensorShape{n, c / 8, h, w, 8};
+    };
+    auto run = [&](size_t n, size_t group, size_t ic, size_t oc, size_t h,
+                   size_t w, size_t kernel, size_t pad, BiasMode bias_mode,
+                   NLMode nlmode) {
+        if (h + 2 * pad < kernel || w + 2 * pad < kernel)
+            return;
+        param::ConvBias param;
+        param.format = param::ConvBias::Format::NCHW88;
+        param.stride_h = param.stride_w = stride;
+        param.pad_h = param.pad_w = pad;
+        param.nonlineMode = nlmode;
+        size_t oh = (h + 2 * pad - kernel) / stride + 1;
+        size_t ow = (w + 2 * pad - kernel) / stride + 1;
+
+        TensorShape src = pack(n, ic * group, h, w), filter;
+        if (is_hybrid) {
+            src = TensorShape{n, ic, h, w};
+            filter = TensorShape{oc / 8, kernel, kernel, ic, 8};
+        } else if (is_chanwise) {
+            param.sparse = param::ConvBias::Sparse::GROUP;
+            filter = TensorShape{group / 8, 1, 1, kernel, kernel, 8};
+        } else if (group > 1) {
+            param.sparse = param::ConvBias::Sparse::GROUP;
+            filter = TensorShape{group, oc / 8, ic / 8, kernel, kernel, 8, 8};
+        } else {
+            filter = TensorShape{oc / 8, ic / 8, kernel, kernel, 8, 8};
+        }
+        TensorShape bias;
+        if (bias_mode == BiasMode::BROADCAST_CHANNEL_BIAS) {
+            bias = pack(1, oc * group, 1, 1);
+        } else if (bias_mode == BiasMode::BIAS) {
+            bias = pack(n, oc * group, oh, ow);
+        }
+        args.emplace_back(param, src, filter, bias);
+    };
+
+    // clang-format off
+    for (auto bias_mode : {BiasMode::NO_BIAS, BiasMode::BROADCAST_CHANNEL_BIAS,
+                           BiasMode::BIAS})
+    for (auto nlmode : {NLMode::IDENTITY, NLMode::RELU, NLMode::SIGMOID,
+                        NLMode::H_SWISH})
+    for (size_t kernel : kernels)
+    for (size_t h : {7, 16, 23}) {
+        size_t pad = kernel / 2;
+        if (is_hybrid) {
+            if (bias_mode == BiasMode::BIAS)
+                continue;
+            for (size_t ic : {1, 3, 4})
+                run(2, 1, ic, 16, h, h + 2, kernel, pad, bias_mode, nlmode);
+        } else if (is_chanwise) {
+            for (size_t group : {8, 24})
+                run(2, group, 1, 1, h, h + 2, kernel, pad, bias_mode, nlmode);
+            run(1, 16, 1, 1, h, h, kernel, 0, bias_mode, nlmode);
+        } else {
+            run(2, 1, 8, 16, h, h + 2, kernel, pad, bias_mode, nlmode);
+            run(1, 1, 24, 8, h, h, kernel, 0, bias_mode, nlmode);
+            run(1, 2, 16, 8, h, h + 1, kernel, pad, bias_mode, nlmode);
+        }
+    }
+    // clang-format on
+    return args;
+}
+
+void check_conv_bias_nchw88(const std::vector<conv_bias::TestArg>& args,
+                            Handle* handle, const char* algo_name) {
+    if (!x86::is_supported(x86::SIMDType::AVX2) ||
+        !x86::is_supported(x86::SIMDType::FMA)) {
+        return;
+    }
+    Checker<ConvBiasForward> checker(handle);
+    checker.set_before_exec_callback(
+            conv_bias::ConvBiasAlgoChecker<ConvBiasForward>(algo_name));
+    checker.set_epsilon(1e-3);
+    for (auto&& arg : args) {
+        checker.set_param(arg.param).execs(
+                {arg.src, arg.filter, arg.bias, {}, {}});
+    }
+}
+}  // namespace
+
+TEST_F(X86, CONV_BIAS_F32_DIRECT_NCHW88) {
+    check_conv_bias_nchw88(
+            get_nchw88_conv_bias_args({1, 2, 3, 5, 7}, 1, false, false),
+            handle(), "X86_F32_CONV_NCHW88_DIRECT");
+}
+
+TEST_F(X86_MULTI_THREADS, CONV_BIAS_F32_DIRECT_NCHW88_S1) {
+    check_conv_bias_nchw88(
+            get_nchw88_conv_bias_args({1, 2, 3, 5, 7}, 1, false, false),
+            handle(), "X86_F32_CONV_NCHW88_DIRECT");
+}
+
+TEST_F(X86_MULTI_THREADS, CONV_BIAS_F32_DIRECT_NCHW88_S2) {
+    check_conv_bias_nchw88(
+            get_nchw88_conv_bias_args({1, 2, 3, 5, 7}, 2, false, false),
+            handle(), "X86_F32_CONV_NCHW88_DIRECT");
+}
+
+TEST_F(X86_MULTI_THREADS, CONV_BIAS_F32_NCHW_NCHW88) {
+    for (size_t stride : {1, 2}) {
+        check_conv_bias_nchw88(
+                get_nchw88_conv_bias_args({2, 3, 5, 7}, stride, true, false),
+                handle(), "X86_F32_CONV_NCHW_NCHW88");
+    }
+}
+
+TEST_F(X86_MULTI_THREADS, CONV_BIAS_F32_CHANNEL_WISE_NCHW88) {
+    for (size_t stride : {1, 2}) {
+        check_conv_bias_nchw88(
+                get_nchw88_conv_bias_args({2, 3, 5, 7}, stride, false, true),
+                handle(), "X86_F32_CHANNEL_WISE_NCHW88");
+    }
+}
+
 /************************* Winograd ****************************/
 namespace {
 std::vector<conv_bias::TestArg> get_winograd_mk_nchw88_args() {
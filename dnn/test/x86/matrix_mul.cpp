@@ -75,6 +75,23 @@ TEST_F(X86, MATRIX_MUL_AVX2_MK8_8X8) {
                                  param::MatrixMul::Format::MK8, 1);
 }
 
+TEST_F(X86, MATRIX_MUL_AVX2_F32_6X16) {
+    matrix_mul::check_matrix_mul(dtype::Float32{}, dtype::Float32{},
+                                 dtype::Float32{}, handle(),
+                                 "X86_F32_AVX2_6X16");
+}
+
+TEST_F(X86, MATRIX_MUL_AVX512_F32_14X32) {
+    if (!is_supported(SIMDType::AVX512F)) {
+        std::cout << "skip avx512 fp32 matmul check for no avx512f support"
+                  << std::endl;
+        return;
+    }
+    matrix_mul::check_matrix_mul(dtype::Float32{}, dtype::Float32{},
+                                 dtype::Float32{}, handle(),
+                                 "X86_F32_AVX512_14X32");
+}
+
 #if MEGDNN_WITH_BENCHMARK
 
 TEST_F(X86, BENCHMARK_MATRIX_MUL_AVX2_MK8_8X8) {
@@ -86,6 +103,22 @@ TEST_F(X86, BENCHMARK_MATRIX_MUL_AVX2_MK8_8X8) {
             "X86_F32_BLAS");
 }
 
+TEST_F(X86, BENCHMARK_MATRIX_MUL_F32_PACKED) {
+    auto args = matrix_mul::get_benchmark_matmul_args();
+    matrix_mul::benchmark_with_contrast(
+            handle(), args, dtype::Float32{}, dtype::Float32{},
+            dtype::Float32{}, "X86_F32_AVX2_6X16",
+            param::MatrixMul::Format::DEFAULT, dtype::Float32{},
+            dtype::Float32{}, dtype::Float32{}, "X86_F32_BLAS");
+    if (is_supported(SIMDType::AVX512F)) {
+        matrix_mul::benchmark_with_contrast(
+                handle(), args, dtype::Float32{}, dtype::Float32{},
+                dtype::Float32{}, "X86_F32_AVX512_14X32",
+                param::MatrixMul::Format::DEFAULT, dtype::Float32{},
+                dtype::Float32{}, dtype::Float32{}, "X86_F32_BLAS");
+    }
+}
+
 TEST_F(X86, BENCHMARK_MATRIX_MUL_8X8X32) {
     constexpr size_t RUNS = 50;
     auto rng = std::make_unique<UniformIntRNG>(-127, 127);
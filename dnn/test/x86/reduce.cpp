@@ -0,0 +1,130 @@
+/**
+ * \file dnn/test/x86/reduce.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+#include "test/x86/fixture.h"
+
+#include "megdnn/oprs.h"
+#include "test/common/benchmarker.h"
+#include "test/common/checker.h"
+
+namespace megdnn {
+namespace test {
+
+namespace {
+void run_reduce_test(Handle* handle, const std::vector<size_t>& As,
+                     const std::vector<size_t>& Bs,
+                     const std::vector<size_t>& Cs) {
+    using Param = Reduce::Param;
+    using Mode = Param::Mode;
+    Checker<Reduce> checker(handle);
+    UniformIntRNG rng{INT8_MIN >> 1, INT8_MAX >> 1};
+    checker.set_rng(0, &rng);
+    for (auto mode : {Mode::MEAN, Mode::MAX, Mode::MIN})
+        for (auto dtype : std::vector<DType>{
+                     dtype::QuantizedS8(1.3f),
+                     dtype::Quantized8Asymm(1.3f, static_cast<uint8_t>(3))})
+            for (int32_t axis : {0, 1, 2})
+                for (size_t A : As)
+                    for (size_t B : Bs)
+                        for (size_t C : Cs) {
+                            checker.set_dtype(0, dtype)
+                                    .set_param(Param(mode, axis))
+                                    .execs({{A, B, C}, {}});
+                        }
+
+    UniformFloatRNG rng_float(-2, 2);
+    checker.set_rng(0, &rng_float);
+    for (auto mode : {Mode::SUM, Mode::MEAN, Mode::SUM_SQR, Mode::PRODUCT,
+                      Mode::MAX, Mode::MIN})
+        for (auto dtype :
+             std::vector<DType>{dtype::Float32(), dtype::Float16()})
+            for (int32_t axis : {0, 1, 2})
+                for (size_t A : As)
+                    for (size_t B : Bs)
+                        for (size_t C : Cs) {
+                            //! the product of many elements easily
+                            //! overflows or underflows
+                            if (mode == Mode::PRODUCT && A * B * C > 8192)
+                                continue;
+                            //! the naive impl accumulates float16 in float16
+                            if (dtype == dtype::Float16() && B > 256)
+                                continue;
+                            checker.set_epsilon(
+                                    dtype == dtype::Float16() ? 1e-1 : 1e-3);
+                            checker.set_dtype(0, dtype)
+                                    .set_param(Param(mode, axis))
+                                    .execs({{A, B, C}, {}});
+                        }
+}
+}  // anonymous namespace
+
+TEST_F(X86, REDUCE) {
+    run_reduce_test(handle(), {1, 3, 5}, {4, 6, 9, 16, 33, 45, 130},
+                    {1, 4, 9, 16, 33, 45, 130});
+}
+
+TEST_F(X86_MULTI_THREADS, REDUCE) {
+    run_reduce_test(handle(), {1, 2, 7}, {3, 100, 1025}, {1, 7, 96, 1027});
+}
+
+#if MEGDNN_WITH_BENCHMARK
+TEST_F(X86, BENCHMARK_REDUCE) {
+    auto run = [&](size_t A, size_t B, size_t C, size_t axis,
+                   param::Reduce::Mode mode, DType dtype) {
+        Benchmarker<Reduce> benchmarker(handle());
+        Benchmarker<Reduce> benchmarker_fallback(fallback_handle());
+        benchmarker_fallback.set_display(false);
+        benchmarker.set_display(false);
+        constexpr size_t RUNS = 50;
+        benchmarker_fallback.set_times(RUNS);
+        benchmarker.set_times(RUNS);
+        param::Reduce param;
+        param.axis = axis;
+        param.mode = mode;
+        benchmarker.set_param(param).set_dtype(0, dtype);
+        benchmarker_fallback.set_param(param).set_dtype(0, dtype);
+
+        TensorLayout src({A, B, C}, dtype), dst;
+        auto opr = handle()->create_operator<Reduce>();
+        opr->param() = param;
+        opr->deduce_layout(src, dst);
+
+        auto cur = benchmarker.execs({src, dst}) / RUNS;
+        auto fallback = benchmarker_fallback.execs({src, dst}) / RUNS;
+        float computation =
+                src.total_nr_elems() / 1024.0 / 1024.0 / 1024.0 * 1e3;
+        printf("run %s->%s %s: fallback: %fms %fGflops "
+               "cur: %fms %fGflops speedup=%f\n",
+               src.to_string().c_str(), dst.to_string().c_str(),
+               dtype.name(), fallback, computation / fallback, cur,
+               computation / cur, fallback / cur);
+    };
+
+    for (auto mode : {param::Reduce::Mode::SUM, param::Reduce::Mode::MEAN,
+                      param::Reduce::Mode::MAX})
+        for (int32_t axis : {1, 2})
+            for (auto dtype : std::vector<DType>{
+                         dtype::Float32(), dtype::Float16(),
+                         dtype::QuantizedS8(4.2f)}) {
+                if (mode == param::Reduce::Mode::SUM &&
+                    dtype.category() == DTypeCategory::QUANTIZED)
+                    continue;
+                run(1, 1024, 49, axis, mode, dtype);
+                run(2, 10, 10000, axis, mode, dtype);
+                run(2, 100, 10000, axis, mode, dtype);
+                run(256, 1000, 1, axis, mode, dtype);
+            }
+}
+#endif
+
+}  // namespace test
+}  // namespace megdnn
+
+// vim: syntax=cpp.doxygen
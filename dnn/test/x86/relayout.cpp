@@ -0,0 +1,82 @@
+/**
+ * \file dnn/test/x86/relayout.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "test/common/benchmarker.h"
+#include "test/common/checker.h"
+#include "test/common/relayout.h"
+#include "test/x86/fixture.h"
+
+#include "megdnn/basic_types.h"
+
+using namespace megdnn;
+using namespace test;
+
+namespace {
+template <typename tag>
+class X86_RELAYOUT : public X86 {};
+TYPED_TEST_CASE(X86_RELAYOUT, relayout::test_types);
+TYPED_TEST(X86_RELAYOUT, run) {
+    relayout::run_test<TypeParam>(this->handle());
+}
+
+//! (batch, m, n, c) viewed from a contiguous (batch, n, m, c) tensor
+TensorLayout make_transpose_src(size_t batch, size_t m, size_t n, size_t c,
+                                DType dtype) {
+    return TensorLayout(TensorShape{batch, n, m, c},
+                        {static_cast<std::ptrdiff_t>(n * m * c),
+                         static_cast<std::ptrdiff_t>(c),
+                         static_cast<std::ptrdiff_t>(n * c), 1},
+                        dtype);
+}
+}  // anonymous namespace
+
+TEST_F(X86_MULTI_THREADS, RELAYOUT_TRANSPOSE) {
+    Checker<Relayout> checker(handle());
+    for (auto dtype : std::vector<DType>{dtype::Uint8(), dtype::Float16(),
+                                         dtype::Float32()})
+        for (size_t c : {1, 2, 4})
+            for (size_t batch : {1, 3})
+                for (size_t m : {1, 15, 64, 130, 257})
+                    for (size_t n : {1, 17, 64, 300, 1025}) {
+                        auto src = make_transpose_src(batch, m, n, c, dtype);
+                        checker.execl({src, {{batch, n, m, c}, dtype}});
+                    }
+}
+
+#if MEGDNN_WITH_BENCHMARK
+TEST_F(X86, BENCHMARK_RELAYOUT_TRANSPOSE) {
+    Benchmarker<Relayout> benchmarker(handle());
+    Benchmarker<Relayout> benchmarker_fallback(fallback_handle());
+    constexpr size_t RUNS = 20;
+    benchmarker.set_times(RUNS).set_display(false);
+    benchmarker_fallback.set_times(RUNS).set_display(false);
+    auto run = [&](size_t batch, size_t m, size_t n, size_t c, DType dtype) {
+        auto src = make_transpose_src(batch, m, n, c, dtype);
+        TensorLayout dst{{batch, n, m, c}, dtype};
+        auto cur = benchmarker.execl({src, dst}) / RUNS;
+        auto fallback = benchmarker_fallback.execl({src, dst}) / RUNS;
+        double k = dst.span().dist_byte() * 1e3 / (1024 * 1024 * 1024);
+        printf("%s %s: fallback=%7.3fms,%5.2fGiB/s cur=%7.3fms,%5.2fGiB/s "
+               "speedup=%.2f\n",
+               dst.TensorShape::to_string().c_str(), dtype.name(), fallback,
+               k / fallback, cur, k / cur, fallback / cur);
+    };
+    for (auto dtype : std::vector<DType>{dtype::Uint8(), dtype::Float16(),
+                                         dtype::Float32()}) {
+        run(1, 1024, 1024, 1, dtype);
+        run(1, 513, 1025, 1, dtype);
+        run(32, 56 * 56, 64, 1, dtype);
+        run(32, 64, 56 * 56, 1, dtype);
+    }
+}
+#endif
+
+// vim: syntax=cpp.doxygen
@@ -0,0 +1,126 @@
+/**
+ * \file dnn/test/x86/topk.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+#include "test/common/topk.h"
+#include "test/x86/fixture.h"
+
+#include "test/common/benchmarker.h"
+#include "test/common/checker.h"
+#include "test/common/rng.h"
+
+using namespace megdnn;
+using namespace test;
+
+namespace {
+void run_long_row_topk_test(Handle* handle) {
+    using Mode = TopK::Param::Mode;
+    Checker<TopK> checker(handle);
+    UniformFloatRNG rng0{-100.f, 100.f};
+    NoReplacementRNG rng{&rng0};
+    checker.set_rng(0, &rng);
+    for (auto mode : {Mode::KTH_ONLY, Mode::VALUE_IDX_SORTED})
+        for (int k : {1, -1, 100, -100, 600})
+            for (size_t m : {1, 5}) {
+                checker.set_proxy(k).set_param(mode);
+                if (mode == Mode::KTH_ONLY) {
+                    checker.execs({{m, 100000}, {}});
+                } else {
+                    checker.execs({{m, 100000}, {}, {}});
+                }
+            }
+}
+
+void run_argsort_test(Handle* handle) {
+    using Order = Argsort::Param::Order;
+    Checker<ArgsortForward> checker(handle);
+    UniformFloatRNG rng_float{-100.f, 100.f};
+    UniformIntRNG rng_int{-1000, 1000};
+    checker.set_dtype(2, dtype::Int32());
+    for (auto dtype : std::vector<DType>{
+                 dtype::Float32(), dtype::Int32(),
+                 MEGDNN_INC_FLOAT16(dtype::Float16())}) {
+        checker.set_dtype(0, dtype).set_rng(
+                0, dtype == dtype::Int32() ? static_cast<RNG*>(&rng_int)
+                                           : &rng_float);
+        for (auto order : {Order::ASCENDING, Order::DESCENDING})
+            for (size_t m : {1, 3, 13})
+                for (size_t n : {1, 7, 63, 64, 1000, 10007}) {
+                    //! values of float16 have many ties, whose order is
+                    //! also checked
+                    checker.set_param(order).execs({{m, n}, {}, {}});
+                }
+    }
+}
+}  // anonymous namespace
+
+TEST_F(X86, TOP_K) {
+    run_topk_test<dtype::Float32>(handle());
+}
+
+TEST_F(X86, TOP_K_I32) {
+    run_topk_test<dtype::Int32>(handle());
+}
+
+#if !MEGDNN_DISABLE_FLOAT16
+TEST_F(X86, TOP_K_F16) {
+    run_topk_test<dtype::Float16>(handle());
+}
+#endif
+
+TEST_F(X86, TOP_K_LONG_ROW) {
+    run_long_row_topk_test(handle());
+}
+
+TEST_F(X86_MULTI_THREADS, TOP_K) {
+    run_topk_test<dtype::Float32>(handle());
+}
+
+TEST_F(X86_MULTI_THREADS, TOP_K_LONG_ROW) {
+    run_long_row_topk_test(handle());
+}
+
+TEST_F(X86, ARGSORT_FORWARD) {
+    run_argsort_test(handle());
+}
+
+TEST_F(X86_MULTI_THREADS, ARGSORT_FORWARD) {
+    run_argsort_test(handle());
+}
+
+#if MEGDNN_WITH_BENCHMARK
+TEST_F(X86, BENCHMARK_TOP_K) {
+    using Mode = TopK::Param::Mode;
+    constexpr size_t RUNS = 20;
+    auto run = [&](int k, size_t m, size_t n, Mode mode) {
+        Benchmarker<TopK> benchmarker(handle());
+        Benchmarker<TopK> benchmarker_fallback(fallback_handle());
+        UniformFloatRNG rng{-100.f, 100.f};
+        for (auto b : {&benchmarker, &benchmarker_fallback}) {
+            std::unique_ptr<OprProxy<TopK>> proxy{new OprProxy<TopK>{k}};
+            b->set_times(RUNS).set_display(false).set_rng(0, &rng);
+            b->set_proxy(proxy).set_param(mode);
+        }
+        auto cur = benchmarker.execs({{m, n}, {}, {}}) / RUNS;
+        auto fallback = benchmarker_fallback.execs({{m, n}, {}, {}}) / RUNS;
+        printf("topk k=%d (%zu,%zu) mode=%d: fallback=%.3fms cur=%.3fms "
+               "speedup=%.2f\n",
+               k, m, n, static_cast<int>(mode), fallback, cur,
+               fallback / cur);
+    };
+    for (auto mode : {Mode::VALUE_IDX_NOSORT, Mode::VALUE_IDX_SORTED}) {
+        run(-100, 1, 100000, mode);
+        run(-100, 16, 100000, mode);
+        run(100, 64, 8192, mode);
+        run(-1000, 4, 1000000, mode);
+    }
+}
+#endif
+
+// vim: syntax=cpp.doxygen
@@ -285,6 +285,7 @@ def dump_graph(
     keep_var_name: int = 1,
     keep_param_name: bool = False,
     keep_opr_priority: bool = False,
+    tensor_value_align: int = 0,
     strip_info_file=None,
     append_json=False
 ):
@@ -306,6 +307,9 @@ def dump_graph(
     :param keep_param_name: whether to keep param names, so param values can be
         easily manipulated after loading model
     :param keep_opr_priority: whether to keep priority setting for operators
+    :param tensor_value_align: if nonzero, align the offsets of tensor values in
+        the dumped content, so the params can be used without copy when the
+        saved model is memory-mapped (e.g. ``load-and-run --mmap-model``)
     :param strip_info_file: a string for path or a file handler. if is not None,
         then the dump information for code strip would be written to ``strip_info_file``
     :param append_json: will be check when `strip_info_file` is not None. if set
@@ -348,6 +352,7 @@ def dump_graph(
         keep_var_name,
         keep_param_name,
         keep_opr_priority,
+        tensor_value_align,
         stat,
         inputs,
         outputs,
@@ -28,6 +28,11 @@ class StaticData:
 _sd = None
 
 
+def _device_type():
+    # the shm backend communicates between processes on CPU comp nodes
+    return "cpu" if _sd.backend == "shm" else "gpu"
+
+
 class Group:
     def __init__(self, proc_ranks):
         if len(proc_ranks) == 0:  # empty group
@@ -67,7 +72,7 @@ class Group:
     @property
     def comp_node(self):
         assert len(self.proc_ranks) > 0, "invalid group"
-        return "gpu{}:{}".format(_sd.device, self.stream)
+        return "{}{}:{}".format(_device_type(), _sd.device, self.stream)
 
 
 WORLD = Group([])
@@ -88,8 +93,10 @@ def init_process_group(
     :param port: port available for all processes to communicate.
     :param world_size: total number of processes participating in the job.
     :param rank: rank of the current process.
-    :param device: the GPU device id to bind this process to.
-    :param backend: communicator backend, currently support 'nccl' and 'ucx'.
+    :param device: the GPU device id to bind this process to, or the CPU
+        comp node id if backend is 'shm'.
+    :param backend: communicator backend, currently support 'nccl', 'ucx' and
+        'shm' (shared memory between processes on the same host, for CPU).
     """
     if not isinstance(master_ip, str):
         raise TypeError("Expect type str but got {}".format(type(master_ip)))
@@ -124,7 +131,7 @@ def init_process_group(
 
     WORLD.reset(list(range(world_size)))
 
-    set_default_device("gpu{}".format(device))
+    set_default_device("{}{}".format(_device_type(), device))
 
 
 def is_distributed() -> bool:
@@ -300,6 +300,7 @@ void init_graph_rt(py::module m) {
         int keep_var_name,
         bool keep_param_name,
         bool keep_opr_priority,
+        size_t tensor_value_align,
         py::list& stat,
         py::list& inputs,
         py::list& outputs,
@@ -311,6 +312,7 @@ void init_graph_rt(py::module m) {
 
         ser::GraphDumper::DumpConfig config{keep_var_name, keep_param_name,
                                        keep_opr_priority};
+        config.tensor_value_align = tensor_value_align;
 
         auto rst = dumper->dump(symvars, config);
         for (auto i : rst.inputs) {
@@ -401,7 +403,9 @@ void init_graph_rt(py::module m) {
     py::class_<cg::ComputingGraph::Options::SeqOpt>(PyComputingGraphOptions, "SeqOpt")
         DEF_READWRITE(enable_mem_plan_opt)
         DEF_READWRITE(enable_mem_reuse_alloc)
-        DEF_READWRITE(enable_seq_comp_node_opt);
+        DEF_READWRITE(enable_seq_comp_node_opt)
+        DEF_READWRITE(static_mem_plan_cache_size)
+        DEF_READWRITE(enable_parallel_static_mem_alloc);
 
 #undef CURRENT_CLASS
 #define CURRENT_CLASS cg::ComputingGraph::Options::GraphOpt
@@ -77,6 +77,7 @@ void init_imperative_rt(py::module m) {
         .def("get_shape", &Interpreter::Channel::get_shape)
         .def("_get_dev_tensor", &Interpreter::Channel::get_dev_tensor)
         .def("apply_op", &Interpreter::Channel::apply_op)
+        .def("config_cmd_batch_size", &Interpreter::Channel::config_cmd_batch_size)
         .def("sync", &Interpreter::Channel::sync, py::call_guard<py::gil_scoped_release>());
 
     std::unique_ptr<Interpreter::Channel> ch = Interpreter::inst().create_channel();
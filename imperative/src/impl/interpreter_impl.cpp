@@ -10,6 +10,7 @@
  */
 
 #include "./interpreter_impl.h"
+#include "megbrain/imperative/ops/elemwise.h"
 
 
 using namespace mgb;
@@ -33,7 +34,7 @@ void* ChannelImpl::put(const HostTensorND& value) {
     info->desc.comp_node = value.comp_node();
     info->desc.value = value.proxy_to_default_cpu();
     m_valid_handle.insert(info);
-    m_worker.add_task(Put{info, value});
+    enqueue(Put{info, value});
     return info;
 }
 
@@ -48,7 +49,7 @@ void* ChannelImpl::put(const DeviceTensorND& data) {
 
 void ChannelImpl::del(void* handle) {
     mgb_assert(m_valid_handle.erase(handle), "invalid handle: %p", handle);
-    m_worker.add_task(Del{reinterpret_cast<TensorInfo*>(handle)});
+    enqueue(Del{reinterpret_cast<TensorInfo*>(handle)});
 }
 
 SmallVector<void*> ChannelImpl::apply_op(
@@ -75,7 +76,7 @@ SmallVector<void*> ChannelImpl::apply_op(
         cmd.outputs.push_back(info);
         outputs.push_back(info);
     }
-    m_worker.add_task(std::move(cmd));
+    enqueue(std::move(cmd));
     return outputs;
 }
 
@@ -83,11 +84,21 @@ HostTensorND ChannelImpl::get_value(void* handle) {
     mgb_assert(m_valid_handle.find(handle) != m_valid_handle.end(),
                "invalid handle: %p", handle);
     auto info = reinterpret_cast<TensorInfo*>(handle);
+    bool value_fetched;
+    {
+        MGB_LOCK_GUARD(m_mutex);
+        value_fetched = info->value_fetched;
+    }
+    if (!value_fetched) {
+        // the predicate below covers the case that the worker finishes
+        // before m_waitee is set
+        enqueue(GetValue{info});
+        flush();
+    }
     std::unique_lock<decltype(m_mutex)> lock(m_mutex);
     mgb_assert(!m_waitee);
     if (!info->value_fetched) {
         m_waitee = info;
-        m_worker.add_task(GetValue{info});
         m_cv.wait(lock, [&]() {
             check_worker_exc_unsafe();
             return info->value_fetched;
@@ -105,6 +116,7 @@ TensorShape ChannelImpl::get_shape(void* handle) {
     if (info->desc.layout.ndim != 0) {
         return info->desc.layout;
     }
+    flush();
     std::unique_lock<decltype(m_mutex)> lock(m_mutex);
     mgb_assert(!m_waitee);
     m_waitee = info;
@@ -140,6 +152,7 @@ DeviceTensorND ChannelImpl::get_dev_tensor(void* handle) {
     mgb_assert(m_valid_handle.find(handle) != m_valid_handle.end(),
                "invalid handle: %p", handle);
     auto info = reinterpret_cast<TensorInfo*>(handle);
+    flush();
     std::unique_lock<decltype(m_mutex)> lock(m_mutex);
     mgb_assert(!m_waitee);
     m_waitee = info;
@@ -148,10 +161,22 @@ DeviceTensorND ChannelImpl::get_dev_tensor(void* handle) {
         return bool(info->ptr);
     });
     m_waitee = nullptr;
-    return info->ptr->dev_tensor();
+    auto&& ptr = info->ptr;
+    if (ptr->blob_shared() || !ptr->layout().is_contiguous()) {
+        // the returned tensor may be modified in place, so copy on write is
+        // applied to views and tensors viewed by others; pending commands
+        // must finish first since they read info->ptr without lock
+        lock.unlock();
+        m_worker.wait_all_task_finish();
+        lock.lock();
+        check_worker_exc_unsafe();
+        ptr = ptr->copy_contiguous();
+    }
+    return ptr->dev_tensor();
 }
 
 void ChannelImpl::sync() {
+    flush();
     m_worker.wait_all_task_finish();
     MGB_LOCK_GUARD(m_mutex);
     check_worker_exc_unsafe();
@@ -165,6 +190,17 @@ void ChannelImpl::config_async_level(int level) {
     mgb_assert(0);
 }
 
+void ChannelImpl::config_cmd_batch_size(size_t size) {
+    mgb_assert(size >= 1, "invalid command batch size: %zu", size);
+    flush();
+    m_cmd_batch_size = size;
+}
+
+ChannelImpl::Stats ChannelImpl::stats() {
+    sync();
+    return m_stats;
+}
+
 TensorInfo* ChannelImpl::alloc() {
     MGB_LOCK_GUARD(m_mutex);
     return m_pool.alloc();
@@ -179,6 +215,164 @@ ChannelImpl::~ChannelImpl() {
     close();
 }
 
+void ChannelImpl::enqueue(Command cmd) {
+    m_buffer.emplace_back(std::move(cmd));
+    if (m_buffer.size() >= m_cmd_batch_size) {
+        flush();
+    }
+}
+
+void ChannelImpl::flush() {
+    if (m_buffer.empty()) {
+        return;
+    }
+    if (m_buffer.size() > 1) {
+        optimize_buffer();
+    }
+    CommandBatch batch;
+    batch.swap(m_buffer);
+    m_worker.add_task(std::move(batch));
+}
+
+void ChannelImpl::optimize_buffer() {
+    using Mode = Elemwise::Mode;
+    constexpr size_t NONE = std::numeric_limits<size_t>::max();
+    auto&& cmds = m_buffer;
+
+    //! uses of a tensor within the batch; GetValue also counts as a use
+    struct Usage {
+        size_t nr_use = 0, producer = NONE, del = NONE;
+    };
+    ThinHashMap<TensorInfo*, Usage> usage;
+    for (size_t i = 0; i < cmds.size(); ++i) {
+        auto&& cmd = cmds[i];
+        if (auto put = std::get_if<Put>(&cmd)) {
+            usage[put->dest].producer = i;
+        } else if (auto apply = std::get_if<ApplyOp>(&cmd)) {
+            for (auto inp : apply->inputs) {
+                ++usage[inp].nr_use;
+            }
+            for (auto out : apply->outputs) {
+                usage[out].producer = i;
+            }
+        } else if (auto del = std::get_if<Del>(&cmd)) {
+            usage[del->dest].del = i;
+        } else if (auto get = std::get_if<GetValue>(&cmd)) {
+            ++usage[get->dest].nr_use;
+        }
+    }
+
+    std::vector<bool> removed(cmds.size(), false);
+    SmallVector<TensorInfo*> elided;
+
+    // a tensor put and deleted without being used needs no copy at all
+    for (auto&& i : usage) {
+        auto&& u = i.second;
+        if (!u.nr_use && u.producer != NONE && u.del != NONE &&
+            std::holds_alternative<Put>(cmds[u.producer])) {
+            removed[u.producer] = removed[u.del] = true;
+            elided.push_back(i.first);
+        }
+    }
+
+    auto as_elemwise = [&](size_t idx) -> const Elemwise* {
+        auto apply = std::get_if<ApplyOp>(&cmds[idx]);
+        if (!apply || removed[idx] || apply->outputs.size() != 1) {
+            return nullptr;
+        }
+        return apply->op->try_cast_final<Elemwise>();
+    };
+
+    // fuse y = f(g(a, b), ...) into one fused elemwise mode if the
+    // intermediate g(a, b) is used only by f and deleted within this batch
+    for (size_t k = 0; k < cmds.size(); ++k) {
+        auto consumer = as_elemwise(k);
+        if (!consumer) {
+            continue;
+        }
+        auto&& apply_k = std::get<ApplyOp>(cmds[k]);
+        for (size_t pos = 0; pos < apply_k.inputs.size(); ++pos) {
+            auto mid = apply_k.inputs[pos];
+            auto&& u = usage[mid];
+            if (u.nr_use != 1 || u.producer == NONE || u.producer >= k ||
+                u.del == NONE) {
+                continue;
+            }
+            auto producer = as_elemwise(u.producer);
+            if (!producer) {
+                continue;
+            }
+            auto&& apply_i = std::get<ApplyOp>(cmds[u.producer]);
+
+            Mode fused_mode;
+            SmallVector<TensorInfo*> fused_inputs = apply_i.inputs;
+            if (producer->mode == Mode::ADD) {
+                switch (consumer->mode) {
+                    case Mode::RELU:
+                        fused_mode = Mode::FUSE_ADD_RELU;
+                        break;
+                    case Mode::SIGMOID:
+                        fused_mode = Mode::FUSE_ADD_SIGMOID;
+                        break;
+                    case Mode::TANH:
+                        fused_mode = Mode::FUSE_ADD_TANH;
+                        break;
+                    case Mode::H_SWISH:
+                        fused_mode = Mode::FUSE_ADD_H_SWISH;
+                        break;
+                    default:
+                        continue;
+                }
+            } else if (producer->mode == Mode::MUL &&
+                       consumer->mode == Mode::ADD) {
+                fused_mode = Mode::FUSE_MUL_ADD3;
+                fused_inputs.push_back(apply_k.inputs[1 - pos]);
+            } else {
+                continue;
+            }
+
+            auto dtype = mid->desc.layout.dtype;
+            auto trait = Elemwise::ModeTrait::from_mode(fused_mode);
+            if (!dtype.valid() ||
+                !(dtype.category() == DTypeCategory::FLOAT
+                          ? trait.allow_float
+                          : dtype.category() == DTypeCategory::INT &&
+                                    trait.allow_int)) {
+                continue;
+            }
+            // inputs of the producer are read later by the fused op, so they
+            // must outlive it
+            bool inputs_alive = true;
+            for (auto inp : apply_i.inputs) {
+                auto iter = usage.find(inp);
+                if (iter->second.del != NONE && iter->second.del < k) {
+                    inputs_alive = false;
+                }
+            }
+            if (!inputs_alive) {
+                continue;
+            }
+
+            apply_k.op = Elemwise::make(fused_mode);
+            apply_k.inputs = std::move(fused_inputs);
+            removed[u.producer] = true;
+            u.nr_use = 0;
+            break;
+        }
+    }
+
+    CommandBatch optimized;
+    for (size_t i = 0; i < cmds.size(); ++i) {
+        if (!removed[i]) {
+            optimized.emplace_back(std::move(cmds[i]));
+        }
+    }
+    cmds.swap(optimized);
+    for (auto i : elided) {
+        free(i);
+    }
+}
+
 void ChannelImpl::produce_tensor(TensorInfo* dest, TensorPtr ptr) {
     MGB_LOCK_GUARD(m_mutex);
     dest->value_fetched = ptr->value_fetched();
@@ -194,8 +388,10 @@ void ChannelImpl::process_one_task(Command& cmd) {
         using T = std::remove_reference_t<decltype(cmd)>;
         try {
             if constexpr (std::is_same_v<T, Put>) {
+                ++m_stats.nr_put;
                 produce_tensor(cmd.dest, Tensor::make(cmd.value));
             } else if constexpr (std::is_same_v<T, ApplyOp>) {
+                ++m_stats.nr_apply_op;
                 SmallVector<TensorPtr> tensor_inputs;
                 tensor_inputs.reserve(cmd.inputs.size());
                 for (auto i : cmd.inputs) {
@@ -49,6 +49,8 @@ using Command = std::variant<Put,
                              ApplyOp,
                              Del,
                              GetValue>;
+//! commands submitted to the worker at once
+using CommandBatch = SmallVector<Command, 1>;
 
 struct ChannelImpl : Interpreter::Channel {
     ChannelImpl() : m_worker(this) {}
@@ -74,11 +76,26 @@ struct ChannelImpl : Interpreter::Channel {
     void close() override;
 
     void config_async_level(int level) override;
+    void config_cmd_batch_size(size_t size) override;
+
+    //! number of commands executed by the worker, after optimize_buffer()
+    struct Stats {
+        size_t nr_put = 0, nr_apply_op = 0;
+    };
+    //! wait for pending commands and get the stats
+    Stats stats();
 
 private:
     TensorInfo* alloc();
     void free(TensorInfo*);
 
+    //! append a command to the pending batch, flush it if full
+    void enqueue(Command cmd);
+    //! optimize the pending batch and submit it to the worker
+    void flush();
+    //! elide Put->Del pairs and fuse chained elemwise ops in m_buffer
+    void optimize_buffer();
+
     void process_one_task(Command&);
 
     void check_worker_exc_unsafe();
@@ -92,15 +109,23 @@ private:
     TensorInfo* m_waitee = nullptr;
     std::exception_ptr m_worker_exc;
 
-    struct WorkQueue : AsyncQueueSC<Command, WorkQueue> {
+    struct WorkQueue : AsyncQueueSC<CommandBatch, WorkQueue> {
         WorkQueue(ChannelImpl* owner) : m_owner(owner) {}
-        void process_one_task(Command& cmd) {
-            m_owner->process_one_task(cmd);
+        void process_one_task(CommandBatch& batch) {
+            for (auto&& cmd : batch) {
+                m_owner->process_one_task(cmd);
+            }
         }
     private:
         ChannelImpl* m_owner;
     } m_worker;
 
+    //! commands not yet submitted to the worker; only accessed by the caller
+    CommandBatch m_buffer;
+    size_t m_cmd_batch_size = 1;
+    //! only updated by the worker
+    Stats m_stats;
+
     int m_async_level = 2;
 };
 
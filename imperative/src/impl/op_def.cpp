@@ -33,6 +33,20 @@ std::shared_ptr<OpDef> OpDef::make_from_op_node(
 SmallVector<TensorPtr> OpDef::apply_on_physical_tensor(
     const OpDef& def,
     const SmallVector<TensorPtr>& inputs) {
+    // views forwarded by view operators may be strided, while operators
+    // expect contiguous inputs
+    auto strided = [](const TensorPtr& i) {
+        return !i->layout().is_contiguous();
+    };
+    if (std::any_of(inputs.begin(), inputs.end(), strided)) {
+        auto contig_inputs = inputs;
+        for (auto&& i : contig_inputs) {
+            if (strided(i)) {
+                i = i->copy_contiguous();
+            }
+        }
+        return def.trait()->apply_on_physical_tensor(def, contig_inputs);
+    }
     return def.trait()->apply_on_physical_tensor(def, inputs);
 }
 
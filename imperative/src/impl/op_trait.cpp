@@ -120,6 +120,12 @@ SmallVector<LogicalTensorDesc> fallback_infer_output_attrs(const OpDef& def,
 }
 
 OpTraitRegistry& OpTraitRegistry::fallback() {
+    // let the proxy graph allocate outputs, so that memory could be forwarded
+    if (!trait->apply_on_physical_tensor && !trait->exec &&
+        !trait->infer_output_attrs && trait->apply_on_var_node) {
+        trait->apply_on_physical_tensor =
+                proxy_graph_detail::apply_on_physical_tensor;
+    }
     if (!trait->exec && trait->apply_on_var_node) {
         trait->exec = proxy_graph_detail::exec;
     }
@@ -354,6 +354,14 @@ TensorPtr Tensor::sub(size_t offset, TensorShape shape) {
     return Tensor::make(m_blob, offset + m_offset, layout);
 }
 
+TensorPtr Tensor::copy_contiguous() {
+    TensorLayout layout{m_layout.dtype};
+    layout.init_contiguous_stride(m_layout);
+    auto ret = Tensor::make(layout, comp_node());
+    ret->dev_tensor().copy_from_fixlayout(dev_tensor());
+    return ret;
+}
+
 void Tensor::add_release_callback(CompNode cn) {
     AsyncReleaser::inst()->add(m_blob, cn);
 }
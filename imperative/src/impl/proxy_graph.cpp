@@ -14,6 +14,7 @@
 #include "megbrain/graph/static_infer.h"
 #include "megbrain/graph/operator_node.h"
 #include "megbrain/opr/io.h"
+#include "megbrain/opr/rand.h"
 #include "megbrain/opr/utility.h"
 #include "megbrain/imperative/ops/opr_attr.h"
 #include "megbrain/imperative/ops/backward_graph.h"
@@ -79,13 +80,21 @@ public:
     static SymbolVar make(ComputingGraph& graph, Tensor& tensor) {
         auto opr = graph.insert_opr(
             std::make_unique<InputPlaceholder>(graph, &tensor));
-        auto var = opr->output(0);
+        opr->cast_final<InputPlaceholder>().rebind(tensor);
+        return opr->output(0);
+    }
+
+    //! bind the output var to \p tensor, which is used when a cached proxy
+    //! opr is reused with another input tensor of the same layout
+    void rebind(Tensor& tensor) {
+        m_tensor = &tensor;
+        m_static_infer_value = {};
+        auto var = output(0);
         auto&& dev_tensor = tensor.dev_tensor();
         var->m_comp_node = dev_tensor.comp_node();
         var->m_shape = dev_tensor.shape();
         var->m_dev_tensor = dev_tensor;
         var->reset_dev_tensor_from_tensor(dev_tensor);
-        return var;
     }
 
     static SymbolVar make(ComputingGraph& graph, const LogicalTensorDesc& desc) {
@@ -162,6 +171,9 @@ public:
     std::vector<std::optional<ShapeInferDesc>> shape_descs;
     std::vector<std::optional<ValueInferDesc>> value_descs;
     std::vector<Result> inferred_outputs;
+    //! number of times that values of input placeholders are requested,
+    //! used to find out whether inference depends on input values
+    size_t nr_input_value_access = 0;
 
     StaticInferManager(ProxyGraph* owner_) : owner(owner_) {}
 
@@ -241,10 +253,14 @@ public:
                 auto* shp = &dest->shape();
                 return shp->ndim ? shp : nullptr;
             } else {
+                ++ nr_input_value_access;
                 return opr->get_static_infer_value(may_sync);
             }
         }
 
+        // infer descs are initialized lazily, since shape inference of a
+        // reused proxy opr could be skipped
+        update();
         mgb_assert(cur_opr);
         mgb_assert(cur_opr->output().size() == shape_descs.size());
 
@@ -288,6 +304,7 @@ public:
                         return nullptr;
                     }
                 } else {
+                    ++ nr_input_value_access;
                     if (auto* p = opr->get_static_infer_value(may_sync)) {
                         push_value(p);
                     } else {
@@ -357,6 +374,90 @@ class ProxyGraph::SeqCompNodeOptimizer : public cg::SeqCompNodeOptimizer {
     StreamPropType stream_prop_type(VarNode*) override {mgb_assert(0);}
 };
 
+/*!
+ * \brief key of cached proxy oprs and output descs, made of the OpDef and
+ *      layouts and comp nodes of the inputs
+ *
+ * def only refers to the OpDef on lookup, and is owned by def_holder when
+ * the key is inserted into a cache
+ */
+struct ProxyGraph::OprCacheKey {
+    const OpDef* def = nullptr;
+    std::shared_ptr<OpDef> def_holder;
+    SmallVector<TensorLayout> layouts;
+    SmallVector<CompNode> comp_nodes;
+    size_t hash = 0;
+
+    struct Hash {
+        size_t operator()(const OprCacheKey& key) const { return key.hash; }
+    };
+
+    bool operator==(const OprCacheKey& rhs) const {
+        if (hash != rhs.hash || layouts.size() != rhs.layouts.size() ||
+            !def->is_same(*rhs.def)) {
+            return false;
+        }
+        for (size_t i = 0; i < layouts.size(); ++ i) {
+            if (comp_nodes[i] != rhs.comp_nodes[i] ||
+                !layouts[i].eq_layout(rhs.layouts[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void own_def() {
+        def_holder = def->copy();
+        def = def_holder.get();
+    }
+
+    //! return false if def could not be hashed
+    template<typename Input, typename Getter>
+    bool init(ProxyGraph* owner, const OpDef& opdef,
+              const SmallVector<Input>& inputs, Getter&& get_layout_cn) {
+        auto type = opdef.dyn_typeinfo();
+        if (owner->m_uncacheable_op_types.count(type)) {
+            return false;
+        }
+        size_t def_hash;
+        MGB_TRY {
+            def_hash = opdef.hash();
+        } MGB_CATCH(MegBrainError&, {
+            owner->m_uncacheable_op_types.insert(type);
+            return false;
+        });
+        def = &opdef;
+        layouts.reserve(inputs.size());
+        comp_nodes.reserve(inputs.size());
+        SmallVector<size_t> data;
+        data.push_back(def_hash);
+        for (auto&& i : inputs) {
+            auto&& layout_cn = get_layout_cn(i);
+            auto&& layout = layout_cn.first;
+            data.push_back(mgb::hash(layout.dtype.handle()));
+            data.push_back(mgb::hash(layout_cn.second));
+            data.push_back(layout.ndim);
+            for (size_t j = 0; j < layout.ndim; ++ j) {
+                data.push_back(layout.shape[j]);
+                data.push_back(layout.stride[j]);
+            }
+            layouts.push_back(layout);
+            comp_nodes.push_back(layout_cn.second);
+        }
+        XXHash state;
+        state.update(data.data(), data.size() * sizeof(size_t));
+        hash = state.digest();
+        return true;
+    }
+};
+
+struct ProxyGraph::CachedOpr {
+    OperatorNodeBase* opr;
+    //! whether output shapes of opr could be reused, i.e. they have been
+    //! inferred without reading input values
+    bool shape_reusable = false;
+};
+
 class ProxyGraph::ProxyGraphImpl : public cg::ComputingGraph {
     static std::atomic<size_t> m_node_id;
     ProxyGraph* m_owner;
@@ -365,6 +466,14 @@ class ProxyGraph::ProxyGraphImpl : public cg::ComputingGraph {
     CompNode::UnorderedSet m_used_comp_node;
     VarReceiverInfo m_var_receiver_info;
 public:
+    //! proxy oprs of the physical tensor API, which are reused by rebinding
+    //! input tensors; they are released with the graph
+    std::unordered_map<OprCacheKey, CachedOpr, OprCacheKey::Hash> opr_cache;
+    //! output descs inferred by the logical tensor API
+    std::unordered_map<OprCacheKey, SmallVector<LogicalTensorDesc>,
+                       OprCacheKey::Hash>
+            output_desc_cache;
+
     ~ProxyGraphImpl() {
         mgb_assert(!m_owner->m_cur_opr);
         if (is_finalized()) return;
@@ -432,6 +541,8 @@ public:
         // FIXME: mutex
         mgb_assert(!m_owner->m_cur_opr);
         // finalize would do sync first
+        opr_cache.clear();
+        output_desc_cache.clear();
         m_opr_refkeeper.clear();
         return {};
     }
@@ -516,11 +627,49 @@ void ProxyGraph::invoke_op(const OpDef& opdef,
         const SmallVector<Tensor*>& inputs,
         const SmallVector<Tensor*>& outputs) {
     CUR_OPR_GUARD(get_proxy_opr(opdef, inputs));
-    init_output_tensor(outputs);
-    for (auto oup : m_cur_opr->output()) {
-        m_graph->add_used_comp_node(oup->comp_node());
+    auto views = init_output_tensor(outputs);
+    execute_cur_opr(inputs);
+    // outputs forwarded from inputs are views, which should be copied to the
+    // given output tensors
+    for (size_t i = 0; i < views.size(); ++ i) {
+        if (views[i]) {
+            outputs[i]->dev_tensor().copy_from_fixlayout(
+                    views[i]->dev_tensor());
+        }
+    }
+}
+
+SmallVector<TensorPtr> ProxyGraph::apply_on_physical_tensor(
+        const OpDef& opdef,
+        const SmallVector<Tensor*>& inputs) {
+    CUR_OPR_GUARD(get_proxy_opr(opdef, inputs));
+    auto outputs = init_output_tensor({});
+    execute_cur_opr(inputs);
+    return outputs;
+}
+
+void ProxyGraph::execute_cur_opr(const SmallVector<Tensor*>& inputs) {
+    CompNode::UnorderedSet used_cns;
+    for (auto&& out : m_cur_opr->output()) {
+        auto cn = out->comp_node();
+        if (used_cns.insert(cn).second) {
+            m_graph->add_used_comp_node(cn);
+            for (auto&& in : inputs) {
+                if (in->comp_node() != cn) {
+                    auto&& e = in->get_or_create_event();
+                    e->device_wait_by(cn);
+                }
+            }
+        }
     }
     m_cur_opr->execute(*m_env);
+    for (auto&& cn : used_cns) {
+        for (auto&& in : inputs) {
+            if (in->comp_node() != cn) {
+                in->add_release_callback(cn);
+            }
+        }
+    }
 }
 
 void ProxyGraph::cleanup() {
@@ -534,17 +683,30 @@ void ProxyGraph::cleanup() {
         m_static_infer_manager->clear();
     }
     m_cur_opr = nullptr;
+    m_cur_cached_opr = nullptr;
 }
 
-void ProxyGraph::init_output_tensor(const SmallVector<Tensor*>& outputs) {
+SmallVector<TensorPtr> ProxyGraph::init_output_tensor(
+        const SmallVector<Tensor*>& outputs) {
     // get proxy opr
     auto proxy = m_cur_opr;
 
     do_shape_infer(true);
 
+    for (auto&& var : proxy->output()) {
+        var->m_mem_plan.reset_from_owner_var();
+    }
+    // Memory forwarding was bypassed in megbrain with graph option
+    // imerative_proxy_graph on; instead, VarNode::set_fwd_in2out_readonly
+    // binds the output to a view of the input, which is taken as the output
+    // tensor sharing memory with the input tensor. This also initializes
+    // some opr(e.g. Subtensor)'s internal state
+    proxy->mem_plan_fwd_in2out_readonly();
+
+    SmallVector<TensorPtr> ret;
     size_t j = 0;
     for (auto&& var : proxy->output()) {
-        auto &&chk = var->m_mem_plan.reset_from_owner_var().chunk();
+        auto &&chk = var->m_mem_plan.chunk();
         if (var->contain_flag(VarNode::Flag::VOLATILE_CONTENT)) {
             // alloc workspace
             TensorLayout layout{var->shape(), var->dtype(), var->format()};
@@ -552,9 +714,21 @@ void ProxyGraph::init_output_tensor(const SmallVector<Tensor*>& outputs) {
             storage.comp_node(var->comp_node())
                    .ensure_size(layout.dtype.size(layout.total_nr_elems()));
             var->m_dev_tensor.reset(storage, layout);
+        } else if (!var->m_dev_tensor.empty()) {
+            ret.push_back(make_view_tensor(var));
+            ++ j;
         } else {
-            mgb_assert(j < outputs.size());
-            auto &&tensor = outputs[j];
+            Tensor* tensor;
+            if (outputs.empty()) {
+                ret.push_back(Tensor::make(
+                        TensorLayout{var->shape(), var->dtype()},
+                        var->comp_node()));
+                tensor = ret.back().get();
+            } else {
+                mgb_assert(j < outputs.size());
+                ret.emplace_back();
+                tensor = outputs[j];
+            }
             auto &&layout = tensor->layout();
             mgb_assert(var->comp_node() == tensor->comp_node() &&
                         var->shape().eq_shape(layout) &&
@@ -564,13 +738,8 @@ void ProxyGraph::init_output_tensor(const SmallVector<Tensor*>& outputs) {
         }
         chk.mem_alloc_status.set_from_owner_var();
     }
-    mgb_assert(j == outputs.size());
+    mgb_assert(outputs.empty() || j == outputs.size());
 
-    // Memory forwarding was bypassed in megbrain with graph option
-    // imerative_proxy_graph on, here we call mem_plan_fwd_in2out_readonly
-    // to initialize some opr(e.g. Subtensor)'s internal state
-    // TODO: implement memory forwarding
-    proxy->mem_plan_fwd_in2out_readonly();
     {
         // some opr (e.g. Reduce) rely on on_mem_status_changed to set
         // input/output tensor corretly, since we bypass var_node_mem_mgr
@@ -580,21 +749,73 @@ void ProxyGraph::init_output_tensor(const SmallVector<Tensor*>& outputs) {
             cb.val()();
         }
     }
+    return ret;
+}
+
+TensorPtr ProxyGraph::make_view_tensor(VarNode* var) {
+    auto&& view = var->m_dev_tensor;
+    for (auto&& inp : m_cur_opr->input()) {
+        auto&& inp_storage = inp->m_dev_tensor.storage();
+        if (inp_storage.empty() ||
+            inp_storage.raw_storage() != view.storage().raw_storage()) {
+            continue;
+        }
+        auto tensor = inp->owner_opr()->cast_final<InputPlaceholder>().m_tensor;
+        auto&& blob = tensor->blob();
+        auto offset = view.raw_ptr() - blob->storage().get();
+        mgb_assert(offset >= 0);
+        return Tensor::make(blob, static_cast<size_t>(offset), view.layout());
+    }
+    mgb_throw(GraphError, "output %s is not forwarded from inputs of %s",
+              var->cname(), m_cur_opr->cname());
 }
 
 cg::OperatorNodeBase* ProxyGraph::get_proxy_opr(
         const OpDef& opdef,
         const SmallVector<Tensor*>& inputs) {
+    mgb_assert(!m_cur_opr);
+    OprCacheKey key;
+    bool cacheable = key.init(this, opdef, inputs, [](Tensor* tensor) {
+        return std::make_pair(tensor->layout(), tensor->comp_node());
+    });
+    if (cacheable) {
+        auto iter = m_graph->opr_cache.find(key);
+        if (iter != m_graph->opr_cache.end()) {
+            auto opr = iter->second.opr;
+            mgb_assert(opr->input().size() == inputs.size());
+            for (size_t i = 0; i < inputs.size(); ++ i) {
+                opr->input(i)->owner_opr()
+                        ->cast_final<InputPlaceholder>().rebind(*inputs[i]);
+            }
+            m_cur_cached_opr = &iter->second;
+            return opr;
+        }
+    }
+
     VarNodeArray vinputs(inputs.size());
     for (size_t i = 0; i < inputs.size(); ++ i) {
         vinputs[i] = InputPlaceholder::make(*m_graph, *inputs[i]).node();
     }
+    auto nr_value_access = m_static_infer_manager->nr_input_value_access;
     auto opr = OpDef::apply_on_var_node(opdef, vinputs);
     mgb_assert(opr->dyn_typeinfo() != InputPlaceholder::typeinfo());
     for (auto &&i : opr->input()) {
         mgb_assert(i->owner_opr()->dyn_typeinfo() ==
                 InputPlaceholder::typeinfo());
     }
+    // an opr which reads input values on construction may depend on them,
+    // so it is not reused; inputs are rebound by their indices on reuse.
+    // RNG oprs keep their stream position between executions, so reusing
+    // them would break reproducibility after reseeding
+    auto opr_type = opr->dyn_typeinfo();
+    bool stateful = opr_type == opr::UniformRNG::typeinfo() ||
+                    opr_type == opr::GaussianRNG::typeinfo();
+    if (cacheable && !stateful && opr->input() == vinputs &&
+        nr_value_access == m_static_infer_manager->nr_input_value_access) {
+        key.own_def();
+        auto ins = m_graph->opr_cache.emplace(std::move(key), CachedOpr{opr});
+        m_cur_cached_opr = &ins.first->second;
+    }
     return opr;
 }
 
@@ -608,6 +829,22 @@ size_t ProxyGraph::get_opr_output_size(const OpDef& opdef,
 SmallVector<LogicalTensorDesc> ProxyGraph::infer_output_attrs_fallible(
         const OpDef& opdef,
         const SmallVector<LogicalTensorDesc>& inputs) {
+    // output descs only depend on the OpDef and layouts of inputs if no input
+    // value is given
+    OprCacheKey key;
+    bool cacheable =
+            std::all_of(inputs.begin(), inputs.end(),
+                        [](auto&& i) { return i.value.empty(); }) &&
+            key.init(this, opdef, inputs, [](const LogicalTensorDesc& desc) {
+                return std::make_pair(desc.layout, desc.comp_node);
+            });
+    if (cacheable) {
+        auto iter = m_graph->output_desc_cache.find(key);
+        if (iter != m_graph->output_desc_cache.end()) {
+            return iter->second;
+        }
+    }
+
     auto opr = get_proxy_opr(opdef, inputs);
     CUR_OPR_GUARD(opr);
     do_shape_infer(false);
@@ -615,6 +852,10 @@ SmallVector<LogicalTensorDesc> ProxyGraph::infer_output_attrs_fallible(
     for (auto&& i : opr->usable_output()) {
         ret.push_back({{i->shape(), i->dtype()}, i->comp_node()});
     }
+    if (cacheable) {
+        key.own_def();
+        m_graph->output_desc_cache.emplace(std::move(key), ret);
+    }
     return ret;
 }
 
@@ -812,8 +1053,14 @@ VarNodeArray ProxyGraph::make_input_place_holders(const SmallVector<LogicalTenso
 /*********************** Common Impl ***********************/
 
 void ProxyGraph::do_shape_infer(bool sync_value) {
+    // shapes of a reused opr are kept in its output vars
+    if (m_cur_cached_opr && m_cur_cached_opr->shape_reusable) {
+        return;
+    }
+
     m_static_infer_manager->update();
 
+    auto nr_value_access = m_static_infer_manager->nr_input_value_access;
     for (auto* var : m_cur_opr->output()) {
         if (sync_value) {
             var->shape(m_static_infer_manager->infer_shape(var));
@@ -821,6 +1068,10 @@ void ProxyGraph::do_shape_infer(bool sync_value) {
             var->shape(*shape);
         }
     }
+    if (m_cur_cached_opr) {
+        m_cur_cached_opr->shape_reusable = sync_value &&
+                nr_value_access == m_static_infer_manager->nr_input_value_access;
+    }
 }
 
 TensorPtr ProxyGraph::as_tensor(cg::OperatorNodeBase* opr, bool share) {
@@ -36,6 +36,17 @@ public:
             const SmallVector<Tensor*>& inputs,
             const SmallVector<Tensor*>& outputs);
 
+    /*!
+     * \brief execute the op with outputs allocated by the proxy graph
+     *
+     * Outputs which are readonly forwarded from inputs by the opr (e.g.
+     * Subtensor, Reshape, Broadcast, Dimshuffle and AxisAddRemove) are
+     * views sharing the blob of the input, and may be strided.
+     */
+    SmallVector<TensorPtr> apply_on_physical_tensor(
+            const OpDef& opdef,
+            const SmallVector<Tensor*>& inputs);
+
     BackwardGraphResult make_backward_graph(
             const OpDef& opdef,
             const SmallVector<LogicalTensorDesc>& input_descs,
@@ -63,6 +74,8 @@ private:
     struct ProxyGraphInst;
     struct GradGraph;
     struct CurOprGuard;
+    struct OprCacheKey;
+    struct CachedOpr;
 
     void reset();
 
@@ -70,9 +83,26 @@ private:
 
     void cleanup();
 
-    void init_output_tensor(
+    /*!
+     * \brief bind memory of outputs of m_cur_opr
+     *
+     * Outputs forwarded from inputs are bound to views of the inputs, and
+     * others to \p outputs, or to newly allocated tensors if \p outputs is
+     * empty.
+     *
+     * \return tensors of the non-volatile outputs: views for forwarded
+     *      outputs, newly allocated tensors, or nullptr for outputs bound
+     *      to \p outputs
+     */
+    SmallVector<TensorPtr> init_output_tensor(
             const SmallVector<Tensor*>& outputs);
 
+    //! make a tensor sharing the blob of the input \p var is forwarded from
+    TensorPtr make_view_tensor(VarNode* var);
+
+    //! execute m_cur_opr, and synchronize inputs on other comp nodes
+    void execute_cur_opr(const SmallVector<Tensor*>& inputs);
+
     cg::OperatorNodeBase* get_proxy_opr(
             const OpDef& opdef,
             const SmallVector<Tensor*>& inputs);
@@ -94,7 +124,11 @@ private:
 
     cg::OperatorNodeBase* m_cur_opr = nullptr;
     std::unique_ptr<ProxyGraphImpl> m_graph;
+    //! cache entry of m_cur_opr if it is a reused proxy opr
+    CachedOpr* m_cur_cached_opr = nullptr;
     size_t m_max_op_cnt = 1000;
+    //! OpDef types without hash(), which could not be cached
+    ThinHashSet<Typeinfo*> m_uncacheable_op_types;
     std::unique_ptr<ExecEnv> m_env;
     std::unique_ptr<StaticInferManager> m_static_infer_manager;
     std::unique_ptr<SeqCompNodeOptimizer> m_seq_comp_node_optimizer;
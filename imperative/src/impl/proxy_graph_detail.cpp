@@ -39,26 +39,13 @@ void exec(const OpDef& def,
     auto&& graph = ProxyGraph::get_default_graph();
     auto inputs = to_raw_ptr_array(inputs_),
          outputs = to_raw_ptr_array(outputs_);
-    CompNode::UnorderedSet used_cns;
-    for (auto&& out: outputs) {
-        auto cn = out->comp_node();
-        if (used_cns.insert(cn).second) {
-            for (auto&& in: inputs) {
-                if (in->comp_node() != cn) {
-                    auto&& e = in->get_or_create_event();
-                    e->device_wait_by(cn);
-                }
-            }
-        }
-    }
     graph->invoke_op(def, inputs, outputs);
-    for (auto&& cn: used_cns) {
-        for (auto&& in: inputs) {
-            if (in->comp_node() != cn) {
-                in->add_release_callback(cn);
-            }
-        }
-    }
+}
+
+SmallVector<TensorPtr> apply_on_physical_tensor(const OpDef& def,
+        const SmallVector<TensorPtr>& inputs) {
+    auto&& graph = ProxyGraph::get_default_graph();
+    return graph->apply_on_physical_tensor(def, to_raw_ptr_array(inputs));
 }
 
 SmallVector<LogicalTensorDesc> infer_output_attrs(const OpDef& def,
@@ -21,6 +21,9 @@ void exec(const OpDef& def,
         const SmallVector<TensorPtr>& inputs_,
         const SmallVector<TensorPtr>& outputs_);
 
+SmallVector<TensorPtr> apply_on_physical_tensor(const OpDef& def,
+        const SmallVector<TensorPtr>& inputs);
+
 SmallVector<LogicalTensorDesc> infer_output_attrs(const OpDef& def,
         const SmallVector<TensorPtr>& inputs);
 
@@ -41,6 +41,10 @@ struct Interpreter {
         virtual void close() = 0;
 
         virtual void config_async_level(int level) = 0;
+
+        //! set the max number of commands submitted to the worker at once;
+        //! commands in a batch may be fused or elided (1 means no batching)
+        virtual void config_cmd_batch_size(size_t size) = 0;
     };
 
     virtual std::unique_ptr<Channel> create_channel() = 0;
@@ -106,6 +106,15 @@ public:
         return m_blob;
     }
 
+    //! whether the blob may be shared with other tensors, e.g. views
+    //! forwarded from this tensor by view operators
+    bool blob_shared() const {
+        return m_blob.use_count() > 1;
+    }
+
+    //! copy value to a new tensor with contiguous layout and its own blob
+    TensorPtr copy_contiguous();
+
     void fetch_value();
     bool value_fetched();
     TensorPtr sub(size_t offset, TensorShape shape);
@@ -18,6 +18,7 @@
 #include "megbrain/opr/utility.h"
 #include "megbrain/imperative/blob_manager.h"
 #include "megbrain/imperative/ops/opr_attr.h"
+#include "megbrain/imperative/ops/broadcast.h"
 #include "megbrain/comp_node_env.h"
 
 
@@ -96,6 +97,107 @@ TEST(TestImperative, Split) {
      OprChecker(op).run({TensorShape{100}, s1, s2});
 }
 
+TEST(TestImperative, ReuseProxyOpr) {
+     auto op = OprAttr::make("Elemwise");
+     auto&& attr = op->cast_final_safe<OprAttr>();
+     using Param = opr::Elemwise::Param;
+     Param param{Param::Mode::ADD};
+     attr.param.write_pod(param);
+
+     HostTensorGenerator<> gen;
+     for (int i = 0; i < 3; ++ i) {
+          auto host_x = gen({23}), host_y = gen({23});
+          auto out = OpDef::apply_on_physical_tensor(*op,
+                    {Tensor::make(*host_x), Tensor::make(*host_y)}).at(0);
+          HostTensorND host_out;
+          host_out.copy_from(out->dev_tensor()).sync();
+          for (size_t j = 0; j < 23; ++ j) {
+               ASSERT_EQ(host_x->ptr<float>()[j] + host_y->ptr<float>()[j],
+                         host_out.ptr<float>()[j]);
+          }
+     }
+
+     // output shapes depend on input values, which must be inferred again
+     OprAttr::Param split_param;
+     split_param.write_pod(megdnn::param::Axis(0));
+     auto split = OprAttr::make("Split", split_param, OperatorNodeConfig{});
+     auto cn = CompNode::load("xpu0");
+     auto x = Tensor::make(*gen({100}));
+     for (int size : {20, 30}) {
+          HostTensorND s1{cn, {{1}, dtype::Int32()}};
+          s1.ptr<int>()[0] = size;
+          HostTensorND s2{cn, {{1}, dtype::Int32()}};
+          s2.ptr<int>()[0] = 100 - size;
+          auto outs = OpDef::apply_on_physical_tensor(*split,
+                    {x, Tensor::make(s1), Tensor::make(s2)});
+          ASSERT_EQ(2u, outs.size());
+          ASSERT_EQ(size_t(size), outs[0]->layout().shape[0]);
+          ASSERT_EQ(size_t(100 - size), outs[1]->layout().shape[0]);
+     }
+}
+
+TEST(TestImperative, ReseedRNG) {
+     auto cn = CompNode::load("xpu0");
+     HostTensorND host_shape{cn, {{1}, dtype::Int32()}};
+     host_shape.ptr<int>()[0] = 100;
+     auto shape = Tensor::make(host_shape);
+     auto run = [&](uint64_t seed) {
+          OprAttr::Param param;
+          param.write_pod(megdnn::param::UniformRNG{seed});
+          auto op = OprAttr::make("UniformRNG", param, OperatorNodeConfig{});
+          auto out = OpDef::apply_on_physical_tensor(*op, {shape}).at(0);
+          HostTensorND ret;
+          ret.copy_from(out->dev_tensor()).sync();
+          return ret;
+     };
+     // the same seed gives the same values, so RNG oprs must not be reused
+     // with their advanced stream
+     auto v0 = run(23), v1 = run(23), v2 = run(24);
+     MGB_ASSERT_TENSOR_EQ(v0, v1);
+     ASSERT_NE(0, memcmp(v0.raw_ptr(), v2.raw_ptr(),
+                         v0.layout().span().dist_byte()));
+}
+
+TEST(TestImperative, ForwardView) {
+     HostTensorGenerator<> gen;
+     auto cn = CompNode::load("xpu0");
+     auto host_x = gen({6, 4}, cn);
+     auto x = Tensor::make(*host_x);
+     auto make_shape = [cn](std::vector<int> shape) {
+          HostTensorND ret{cn, {{shape.size()}, dtype::Int32()}};
+          std::copy(shape.begin(), shape.end(), ret.ptr<int>());
+          return Tensor::make(ret);
+     };
+
+     OprAttr::Param param;
+     param.write_pod(megdnn::param::OptionalAxisV1{});
+     auto reshape = OprAttr::make("ReshapeV1", param, OperatorNodeConfig{});
+     auto y = OpDef::apply_on_physical_tensor(
+               *reshape, {x, make_shape({4, 6})}).at(0);
+     ASSERT_EQ(x->blob(), y->blob());
+     ASSERT_TRUE(y->layout().eq_layout(TensorLayout{{4, 6}, dtype::Float32()}));
+
+     // broadcast makes a strided view, which is copied when used as input
+     auto z = OpDef::apply_on_physical_tensor(
+               *Broadcast::make(), {y, make_shape({2, 4, 6})}).at(0);
+     ASSERT_EQ(x->blob(), z->blob());
+     ASSERT_FALSE(z->layout().is_contiguous());
+
+     auto add = OprAttr::make("Elemwise");
+     add->cast_final_safe<OprAttr>().param.write_pod(
+               opr::Elemwise::Param{opr::Elemwise::Param::Mode::ADD});
+     auto w = OpDef::apply_on_physical_tensor(*add, {z, z}).at(0);
+     ASSERT_TRUE(w->layout().is_contiguous());
+     HostTensorND host_z, host_w;
+     host_z.copy_from(z->dev_tensor()).sync();
+     host_w.copy_from(w->dev_tensor()).sync();
+     auto px = host_x->ptr<float>();
+     for (size_t i = 0; i < 2 * 24; ++ i) {
+          ASSERT_EQ(px[i % 24], host_z.ptr<float>()[i]);
+          ASSERT_EQ(px[i % 24] * 2, host_w.ptr<float>()[i]);
+     }
+}
+
 #if MGB_CUDA && MGB_ENABLE_EXCEPTION
 void run_graph(size_t mem_reserved, bool enable_defrag) {
      CompNode::try_coalesce_all_free_memory();
@@ -0,0 +1,97 @@
+/**
+ * \file imperative/src/test/interpreter.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "./helper.h"
+#include "../impl/interpreter_impl.h"
+#include "megbrain/imperative/ops/elemwise.h"
+
+using namespace mgb;
+using namespace imperative;
+using namespace interpreter;
+
+TEST(TestInterpreter, CmdBatch) {
+    using Mode = Elemwise::Mode;
+    HostTensorGenerator<> gen;
+    auto host_a = gen({3, 4}), host_b = gen({3, 4}), host_c = gen({1, 4});
+
+    auto run = [&](size_t batch_size) {
+        auto channel_ptr = Interpreter::inst().create_channel();
+        auto channel = static_cast<intl::ChannelImpl*>(channel_ptr.get());
+        channel->config_cmd_batch_size(batch_size);
+        auto apply = [&](Mode mode,
+                         const SmallVector<Interpreter::Handle>& inputs) {
+            auto outputs = channel->apply_op(Elemwise::make(mode), inputs);
+            mgb_assert(outputs.size() == 1);
+            return outputs[0];
+        };
+        auto a = channel->put(*host_a), b = channel->put(*host_b),
+             c = channel->put(*host_c);
+        // put then deleted without use
+        channel->del(channel->put(*host_a));
+
+        // relu(a * b + c + a), where the intermediates can be fused
+        auto t0 = apply(Mode::MUL, {a, b});
+        auto t1 = apply(Mode::ADD, {t0, c});
+        channel->del(t0);
+        auto t2 = apply(Mode::ADD, {t1, a});
+        channel->del(t1);
+        auto y = apply(Mode::RELU, {t2});
+        channel->del(t2);
+        // an intermediate that is still alive must not be fused
+        auto t3 = apply(Mode::MUL, {a, a});
+        auto z = apply(Mode::ADD, {t3, b});
+
+        HostTensorND host_y, host_z, host_t3;
+        host_y.copy_from(channel->get_value(y));
+        host_z.copy_from(channel->get_value(z));
+        host_t3.copy_from(channel->get_value(t3));
+        for (auto i : {a, b, c, y, z, t3}) {
+            channel->del(i);
+        }
+        auto stats = channel->stats();
+        channel->close();
+        return std::make_tuple(host_y, host_z, host_t3, stats);
+    };
+
+    HostTensorND expect_y{host_a->comp_node(), host_a->layout()},
+            expect_z{host_a->comp_node(), host_a->layout()},
+            expect_t3{host_a->comp_node(), host_a->layout()};
+    auto pa = host_a->ptr<float>(), pb = host_b->ptr<float>(),
+         pc = host_c->ptr<float>();
+    for (size_t i = 0; i < 12; ++i) {
+        auto v = pa[i] * pb[i] + pc[i % 4] + pa[i];
+        expect_y.ptr<float>()[i] = std::max(v, 0.f);
+        expect_t3.ptr<float>()[i] = pa[i] * pa[i];
+        expect_z.ptr<float>()[i] = pa[i] * pa[i] + pb[i];
+    }
+
+    for (size_t batch_size : {1, 3, 64}) {
+        auto ret = run(batch_size);
+        MGB_ASSERT_TENSOR_NEAR(expect_y, std::get<0>(ret), 1e-6);
+        MGB_ASSERT_TENSOR_NEAR(expect_z, std::get<1>(ret), 1e-6);
+        MGB_ASSERT_TENSOR_NEAR(expect_t3, std::get<2>(ret), 1e-6);
+        auto stats = std::get<3>(ret);
+        if (batch_size == 1) {
+            // every command is executed as is
+            ASSERT_EQ(4u, stats.nr_put);
+            ASSERT_EQ(6u, stats.nr_apply_op);
+        } else if (batch_size == 64) {
+            // all the commands before get_value(y) are in one batch: the
+            // unused put is elided and a * b + c is fused into
+            // FUSE_MUL_ADD3; t1 is deleted before relu, so t1 + a can not be
+            // fused with it
+            ASSERT_EQ(3u, stats.nr_put);
+            ASSERT_EQ(5u, stats.nr_apply_op);
+        }
+    }
+}
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
@@ -20,6 +20,8 @@
 #include "megbrain/serialization/extern_c_opr.h"
 #include "megbrain/plugin/opr_io_dump.h"
 #include "megbrain/plugin/profiler.h"
+#include "megbrain/plugin/perf_counter.h"
+#include "megbrain/utils/trace_event.h"
 #include "megbrain/plugin/num_range_checker.h"
 #include "megbrain/plugin/cpu_dispatch_checker.h"
 #include "megbrain/plugin/var_value_checker.h"
@@ -37,8 +39,15 @@
 #include <cerrno>
 #include <cstdio>
 #include <cctype>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
 #include <numeric>
+#include <random>
 #include <sstream>
+#include <thread>
 
 #if defined(_WIN32)
 #include <io.h>
@@ -83,6 +92,16 @@ R"__usage__(
         profiling device time, which may cause additional overhead and make it
         hard to profile host time. Use --profile-host to focus on host time
         profiling.
+  --perf-counter <output>
+    Write hardware performance counters (cycles, instructions, LLC misses) and
+    achieved GFLOP/s and GB/s of each operator on cpu comp nodes to given file
+    in JSON format, along with the measured roofline of the comp nodes, which
+    tells whether an operator is compute bound or memory bound.
+  --timeline <output>
+    Write a timeline in the Trace Event Format to given file, which can be
+    viewed in chrome://tracing or https://ui.perfetto.dev. It contains the host
+    time of each operator, the kernels of the last run on each comp node, tasks
+    on the CPU worker threads and thread pools, and memory usage.
   --input [ filepath | string]
     Set up inputs for megbrain model. for example: --data image.ppm --data
     param.json --data bbox:bbox.npy@batchid:b.npy --data rect:[0,0,227,227];
@@ -127,6 +146,10 @@ R"__usage__(
   --share-param-mem
     Share the memory used by model params with model storage. This can be used
     to reduce memory usage when computing on CPU.
+  --mmap-model
+    Map the model file into memory instead of reading it. Params whose file
+    offsets are aligned (dumped with `tensor_value_align`) are used in place,
+    so the pages can be shared by multiple processes loading the same model.
   --record-comp-seq | --record-comp-seq2
     Record the computing sequence, in level 1 or 2. It reduces overhead of API
     calls of some asynchronous computing devices, especially for OpenCL. In
@@ -145,6 +168,11 @@ R"__usage__(
 R"__usage__(
   --fast-run-algo-policy <path>
     It will read the cache file before profile, and save new fastrun in cache file.
+  --fast-run-shared-cache <path>
+    Use a fast-run cache file that can be shared by concurrent processes. New
+    profiling results are appended to the file immediately, and entries are
+    discarded if the file was generated by other library versions or CPUs.
+    See `mgb::FilePersistentCache` for more details.
   --reproducible
     Enable choose algo which is reproducible. It mainly used for cudnn algos.
     See https://docs.nvidia.com/deeplearning/sdk/cudnn-developer-guide/index.html#reproducibility
@@ -159,6 +187,18 @@ R"__usage__(
     Number of threads to run concurrently. All threads perform the same work of
     loading and executing models. This is used for test thread safety, not for
     speed up on multiple cores.
+  --serve <nr_executor>
+    Serving benchmark mode. The model is loaded once into given number of
+    executors which share the params, and each executor serves requests on its
+    own thread; the total number of requests is --iter times the number of
+    executors. Throughput, latency percentiles (p50/p90/p99/p999) and the
+    utilization of each cpu core are reported. Use --cpu-default or
+    --multithread-default to run the kernels on the executor threads;
+    otherwise the executors share and queue on the same comp node workers.
+  --serve-qps <qps>
+    Requests arrive as a Poisson process with given rate in serving mode, and
+    latency includes the time waiting for an idle executor. By default requests
+    are issued in a closed loop.
   --disable-assert-throw
     Do not throw exception in case AssertEqual fails. Note that the exit code
     would also be zero if this option is enabled. This should only be used for
@@ -489,15 +529,19 @@ struct Args {
 
     bool disable_assert_throw = false;
     bool share_param_mem = false;
+    bool mmap_model = false;
 #if MGB_ENABLE_FASTRUN
     bool use_fast_run = false;
 #endif
     bool reproducible = false;
     std::string fast_run_cache_path;
+    std::string fast_run_shared_cache_path;
     bool copy_to_host = false;
     int nr_run = 10;
     int nr_warmup = 1;
     int nr_thread = 1;
+    size_t nr_serve_executor = 0;
+    double serve_qps = 0;
     int multithread_number = 1;
     size_t workspace_limit = SIZE_MAX;
     std::vector<std::string> data_files;
@@ -506,6 +550,9 @@ struct Args {
     std::unique_ptr<GraphProfiler> profiler;
 #endif
     std::string profiler_output;
+    std::string timeline_output;
+    std::unique_ptr<PerfCounterProfiler> perf_counter;
+    std::string perf_counter_output;
     std::string bin_out_dump;
 
     std::unique_ptr<OprIODumpBase> iodump;
@@ -596,6 +643,88 @@ public:
     }
 };
 
+//! set algo strategy and fast-run cache of the oprs given by args
+void setup_algo_policy(Args& env, const SymbolVarArray& vars) {
+    mgb::gopt::set_opr_algo_workspace_limit_inplace(vars, env.workspace_limit);
+    using S = opr::mixin::Convolution::ExecutionPolicy::Strategy;
+    S strategy = S::HEURISTIC;
+#if MGB_ENABLE_FASTRUN
+    if (env.use_fast_run) {
+        if (env.reproducible) {
+            strategy = S::PROFILE_REPRODUCIBLE;
+        } else {
+            strategy = S::PROFILE;
+        }
+    } else if (env.reproducible) {
+        strategy = S::HEURISTIC_REPRODUCIBLE;
+    }
+#else
+    if (env.reproducible) {
+        strategy = S::HEURISTIC_REPRODUCIBLE;
+    }
+#endif
+    mgb::gopt::modify_opr_algo_strategy_inplace(vars, strategy);
+    if (!env.fast_run_shared_cache_path.empty()) {
+        mgb_assert(env.fast_run_cache_path.empty(),
+                   "--fast-run-algo-policy and --fast-run-shared-cache can "
+                   "not be used together");
+        PersistentCache::set_impl(std::make_shared<FilePersistentCache>(
+                env.fast_run_shared_cache_path));
+#if MGB_ENABLE_FASTRUN
+        if (!env.use_fast_run)
+#endif
+            mgb::gopt::enable_opr_use_profiling_cache_inplace(vars);
+    } else if (!env.fast_run_cache_path.empty()) {
+#if MGB_ENABLE_FASTRUN
+        if (!access(env.fast_run_cache_path.c_str(), F_OK)) {
+#else
+        mgb_assert(access(env.fast_run_cache_path.c_str(), F_OK) == 0,
+                   "fast-run cache file can't be accessed");
+#endif
+            FILE* fin = fopen(env.fast_run_cache_path.c_str(), "rb");
+            auto flen = get_file_size(fin);
+            std::unique_ptr<uint8_t[]> buf{new uint8_t[flen]};
+            size_t ret = fread(buf.get(), flen, 1, fin);
+            MGB_MARK_USED_VAR(ret);
+            mgb_assert(ret == 1, "read 1 block (got %zu), and block size %zu.",
+                       ret, flen);
+            fclose(fin);
+            PersistentCache::set_impl(
+                    std::make_shared<InFilePersistentCache>(buf.get(), flen));
+#if MGB_ENABLE_FASTRUN
+        } else {
+            mgb_assert(env.use_fast_run, "fast-run should be enabled");
+            PersistentCache::set_impl(
+                    std::make_shared<InFilePersistentCache>());
+        }
+        if (!env.use_fast_run)
+#endif
+            mgb::gopt::enable_opr_use_profiling_cache_inplace(vars);
+    }
+}
+
+//! feed the values given by --input to the input tensors
+void set_data_inputs(const Args& env,
+                     serialization::GraphLoader::LoadResult::TensorMap&
+                             tensormap) {
+    DataParser parser;
+    for (auto path : env.data_files) {
+        parser.feed(path);
+    }
+    auto inputs = parser.inputs;
+    if (inputs.size() > 1) {
+        for (auto& i : inputs) {
+            mgb_assert(tensormap.find(i.first) != tensormap.end());
+
+            auto& in = tensormap.find(i.first)->second;
+            in->copy_from(i.second);
+        }
+    } else {
+        auto& in = tensormap.begin()->second;
+        in->copy_from(inputs.begin()->second);
+    }
+}
+
 void run_test_st(Args &env) {
     std::unique_ptr<serialization::InputFile> inp_file;
 
@@ -610,6 +739,8 @@ void run_test_st(Args &env) {
         mgb_assert(nr == size);
         fclose(fin);
         inp_file = serialization::InputFile::make_mem_proxy(buf, size);
+    } else if (env.mmap_model) {
+        inp_file = serialization::InputFile::make_mmap(env.model_path.c_str());
     } else {
         inp_file = serialization::InputFile::make_fs(
                 env.model_path.c_str());
@@ -670,52 +801,7 @@ void run_test_st(Args &env) {
         vars.push_back(i.first);
     }
 
-    mgb::gopt::set_opr_algo_workspace_limit_inplace(vars, env.workspace_limit);
-    using S = opr::mixin::Convolution::ExecutionPolicy::Strategy;
-    S strategy = S::HEURISTIC;
-#if MGB_ENABLE_FASTRUN
-    if (env.use_fast_run) {
-        if (env.reproducible) {
-            strategy = S::PROFILE_REPRODUCIBLE;
-        } else {
-            strategy = S::PROFILE;
-        }
-    } else if (env.reproducible) {
-        strategy = S::HEURISTIC_REPRODUCIBLE;
-    }
-#else
-    if (env.reproducible) {
-        strategy = S::HEURISTIC_REPRODUCIBLE;
-    }
-#endif
-    mgb::gopt::modify_opr_algo_strategy_inplace(vars, strategy);
-    if (!env.fast_run_cache_path.empty()) {
-#if MGB_ENABLE_FASTRUN
-        if (!access(env.fast_run_cache_path.c_str(), F_OK)) {
-#else
-        mgb_assert(access(env.fast_run_cache_path.c_str(), F_OK) == 0,
-                   "fast-run cache file can't be accessed");
-#endif
-            FILE* fin = fopen(env.fast_run_cache_path.c_str(), "rb");
-            auto flen = get_file_size(fin);
-            std::unique_ptr<uint8_t[]> buf{new uint8_t[flen]};
-            size_t ret = fread(buf.get(), flen, 1, fin);
-            MGB_MARK_USED_VAR(ret);
-            mgb_assert(ret == 1, "read 1 block (got %zu), and block size %zu.",
-                       ret, flen);
-            fclose(fin);
-            PersistentCache::set_impl(
-                    std::make_shared<InFilePersistentCache>(buf.get(), flen));
-#if MGB_ENABLE_FASTRUN
-        } else {
-            mgb_assert(env.use_fast_run, "fast-run should be enabled");
-            PersistentCache::set_impl(
-                    std::make_shared<InFilePersistentCache>());
-        }
-        if (!env.use_fast_run)
-#endif
-            mgb::gopt::enable_opr_use_profiling_cache_inplace(vars);
-    }
+    setup_algo_policy(env, vars);
 
     auto func = env.load_ret.graph_compile(out_spec);
     auto warmup = [&]() {
@@ -800,24 +886,7 @@ void run_test_st(Args &env) {
 
         printf("=== total time: %.3fms\n", tot_time);
     } else if (not env.data_files.empty()) {
-        auto& tensormap = env.load_ret.tensor_map;
-
-        DataParser parser;
-        for (auto path : env.data_files) {
-            parser.feed(path);
-        }
-        auto inputs = parser.inputs;
-        if (inputs.size() > 1) {
-            for (auto& i : inputs) {
-                mgb_assert(tensormap.find(i.first) != tensormap.end());
-
-                auto& in = tensormap.find(i.first)->second;
-                in->copy_from(i.second);
-            }
-        } else {
-            auto& in = tensormap.begin()->second;
-            in->copy_from(inputs.begin()->second);
-        }
+        set_data_inputs(env, env.load_ret.tensor_map);
 
         warmup();
         timer.reset();
@@ -847,11 +916,21 @@ void run_test_st(Args &env) {
     }
 
 #if MGB_ENABLE_JSON
-    if (env.profiler) {
+    if (env.profiler && !env.profiler_output.empty()) {
         env.profiler->to_json_full(func.get())->writeto_fpath(
                 env.profiler_output);
         mgb_log("profiling result written to %s", env.profiler_output.c_str());
     }
+    if (env.perf_counter) {
+        env.perf_counter->to_json()->writeto_fpath(env.perf_counter_output);
+        mgb_log("perf counters written to %s",
+                env.perf_counter_output.c_str());
+    }
+    if (!env.timeline_output.empty()) {
+        env.profiler->record_trace_events();
+        TraceEventRecorder::inst().stop();
+        mgb_log("timeline written to %s", env.timeline_output.c_str());
+    }
 #endif
 #if MGB_ENABLE_FASTRUN
     if (!env.fast_run_cache_path.empty()) {
@@ -866,6 +945,279 @@ void run_test_st(Args &env) {
 #endif
 }
 
+#if MGB_HAVE_THREAD
+//! busy and total time of each cpu core read from /proc/stat
+std::vector<std::pair<uint64_t, uint64_t>> read_cpu_times() {
+    std::vector<std::pair<uint64_t, uint64_t>> ret;
+#if __linux__
+    std::ifstream fin{"/proc/stat"};
+    std::string line;
+    while (std::getline(fin, line)) {
+        // skip the line of all cpus and other stats
+        if (line.compare(0, 3, "cpu") || !isdigit(line[3])) {
+            continue;
+        }
+        std::istringstream ss{line.substr(line.find(' '))};
+        uint64_t val, total = 0, idle = 0;
+        // user nice system idle iowait irq softirq steal
+        for (int i = 0; i < 8 && ss >> val; ++i) {
+            total += val;
+            if (i == 3 || i == 4) {
+                idle += val;
+            }
+        }
+        ret.emplace_back(total - idle, total);
+    }
+#endif
+    return ret;
+}
+
+/*!
+ * \brief copy the options set by from_argv() to the graph of another executor
+ *
+ * Options is not copyable as a whole since it holds the user data (e.g. the
+ * plugins) of the graph; oprs attributes and extra deps refer to the vars of
+ * the source graph, so they are not copied either.
+ */
+void copy_graph_options(const cg::ComputingGraph::Options& src,
+                        cg::ComputingGraph::Options& dst) {
+    dst.seq_opt = src.seq_opt;
+    dst.graph_opt = src.graph_opt;
+    dst.graph_opt_level = src.graph_opt_level;
+    dst.allreduce_pack_max_size = src.allreduce_pack_max_size;
+    dst.allreduce_pack_ignore_first = src.allreduce_pack_ignore_first;
+    dst.log_level = src.log_level;
+    dst.async_exec_level = src.async_exec_level;
+    dst.cpu_task_priority = src.cpu_task_priority;
+    dst.force_dynamic_alloc = src.force_dynamic_alloc;
+    dst.var_sanity_check_first_run = src.var_sanity_check_first_run;
+    dst.allocate_static_mem_after_graph_compile =
+            src.allocate_static_mem_after_graph_compile;
+    dst.fake_next_exec = src.fake_next_exec;
+    dst.enable_sublinear_memory_opt = src.enable_sublinear_memory_opt;
+    dst.sublinear_mem_config = src.sublinear_mem_config;
+    dst.no_profiling_on_shape_change = src.no_profiling_on_shape_change;
+    dst.enable_var_mem_defragment = src.enable_var_mem_defragment;
+    dst.enable_grad_var_static_reshape = src.enable_grad_var_static_reshape;
+    dst.enable_memory_swap = src.enable_memory_swap;
+    dst.comp_node_seq_record_level = src.comp_node_seq_record_level;
+#if !MGB_BUILD_SLIM_SERVING
+    dst.eager_evaluation = src.eager_evaluation;
+#endif
+    dst.imperative_proxy_graph = src.imperative_proxy_graph;
+    dst.no_force_inplace = src.no_force_inplace;
+}
+
+/*!
+ * \brief load the model into multiple executors sharing the params, and drive
+ *      them concurrently to measure throughput and latency distribution
+ *
+ * Each executor runs on its own thread. Requests either arrive as a Poisson
+ * process with given QPS and are served in arrival order, or are issued in a
+ * closed loop where each executor starts a new request once the previous one
+ * finishes. Latency includes the time waiting for an idle executor.
+ */
+void run_serving_benchmark(Args& env) {
+    mgb_assert(!env.iodump && env.bin_out_dump.empty()
+#if MGB_ENABLE_JSON
+                       && !env.profiler && !env.perf_counter
+#endif
+               ,
+               "profiling and dumping are not supported in serving mode");
+    using namespace serialization;
+    using Clock = std::chrono::steady_clock;
+
+    // load from memory so all the executors share the same param storage
+    FILE* fin = fopen(env.model_path.c_str(), "rb");
+    mgb_assert(fin, "failed to open %s: %s", env.model_path.c_str(),
+               strerror(errno));
+    auto size = get_file_size(fin);
+    std::shared_ptr<void> buf{malloc(size), free};
+    auto nr = fread(buf.get(), 1, size, fin);
+    mgb_assert(nr == size);
+    fclose(fin);
+    uint32_t nr_test;
+    size_t model_offset;
+    {
+        auto header = InputFile::make_mem_proxy(buf.get(), size);
+        nr_test = read_nr_test(*header);
+        model_offset = header->tell();
+    }
+    // the loader rewinds to the beginning of the model for each executor
+    std::shared_ptr<void> model_buf{
+            buf, static_cast<uint8_t*>(buf.get()) + model_offset};
+    auto inp_file =
+            InputFile::make_mem_proxy(model_buf, size - model_offset, false);
+    auto format = GraphLoader::identify_graph_dump_format(*inp_file);
+    mgb_assert(format.valid(),
+               "invalid model: unknown model format, please make sure input "
+               "file is generated by GraphDumper");
+    auto loader = GraphLoader::make(std::move(inp_file), format.val());
+
+    struct Executor {
+        GraphLoader::LoadResult load_ret;
+        std::unique_ptr<cg::AsyncExecutable> func;
+    };
+    size_t nr_executor = env.nr_serve_executor;
+    std::vector<Executor> executors(nr_executor);
+    RealTimer timer;
+    for (size_t i = 0; i < nr_executor; ++i) {
+        auto config = env.load_config;
+        if (i) {
+            // a new graph with the same options, but without plugins
+            config.comp_graph = ComputingGraph::make();
+            copy_graph_options(env.load_config.comp_graph->options(),
+                               config.comp_graph->options());
+        }
+        executors[i].load_ret = loader->load(config, true);
+    }
+    env.load_config.comp_graph.reset();
+    printf("load %zu executors: %.3fms\n", nr_executor,
+           timer.get_msecs_reset());
+
+    if (nr_test) {
+        // use the inputs of the first testcase, which follows the model
+        GraphLoader::LoadConfig tc_config;
+        tc_config.comp_node_mapper = env.load_config.comp_node_mapper;
+        auto tc_loader = GraphLoader::make(loader->reset_file(), format.val());
+        auto testcase = tc_loader->load(tc_config, false);
+        for (auto&& exe : executors) {
+            std::vector<std::pair<std::string, HostTensorND*>> inp_tensors;
+            for (auto&& i : exe.load_ret.tensor_map) {
+                inp_tensors.emplace_back(i.first, i.second.get());
+            }
+            std::sort(inp_tensors.begin(), inp_tensors.end());
+            mgb_assert(testcase.output_var_list.size() == inp_tensors.size());
+            for (size_t i = 0; i < inp_tensors.size(); ++i) {
+                auto&& opr = testcase.output_var_list[i]
+                                     .node()
+                                     ->owner_opr()
+                                     ->cast_final_safe<opr::SharedDeviceTensor>();
+                inp_tensors[i].second->copy_from(
+                        HostTensorND::make_proxy(*opr.dev_data()));
+            }
+        }
+    } else if (!env.data_files.empty()) {
+        for (auto&& exe : executors) {
+            set_data_inputs(env, exe.load_ret.tensor_map);
+        }
+    }
+
+    for (auto&& exe : executors) {
+        ComputingGraph::OutputSpec out_spec;
+        SymbolVarArray vars;
+        for (auto&& i : exe.load_ret.output_var_list) {
+            ComputingGraph::Callback cb;
+            if (env.copy_to_host) {
+                HostTensorND val;
+                cb = [val](const DeviceTensorND& dv) mutable {
+                    val.copy_from(dv);
+                };
+            }
+            out_spec.emplace_back(i, std::move(cb));
+            vars.push_back(i);
+        }
+        setup_algo_policy(env, vars);
+        exe.func = exe.load_ret.graph_compile(out_spec);
+    }
+
+    // arrival time of each request relative to the start
+    size_t nr_request = nr_executor * env.nr_run;
+    std::vector<double> arrival(nr_request, 0);
+    if (env.serve_qps > 0) {
+        std::mt19937 rng{42};
+        std::exponential_distribution<double> interval{env.serve_qps};
+        for (size_t i = 1; i < nr_request; ++i) {
+            arrival[i] = arrival[i - 1] + interval(rng);
+        }
+    }
+    std::vector<double> latency(nr_request);
+    std::atomic_size_t next_request{0}, nr_ready{0};
+    std::atomic_bool started{false};
+    Clock::time_point start;
+
+    auto worker = [&](size_t id) {
+        auto&& func = *executors[id].func;
+        for (int i = 0; i < env.nr_warmup; ++i) {
+            func.execute().wait();
+        }
+        nr_ready.fetch_add(1);
+        while (!started.load()) {
+            std::this_thread::yield();
+        }
+        for (;;) {
+            auto idx = next_request.fetch_add(1);
+            if (idx >= nr_request) {
+                break;
+            }
+            auto begin = Clock::now();
+            if (env.serve_qps > 0) {
+                auto arrive =
+                        start + std::chrono::duration_cast<Clock::duration>(
+                                        std::chrono::duration<double>(
+                                                arrival[idx]));
+                std::this_thread::sleep_until(arrive);
+                begin = arrive;
+            }
+            func.execute().wait();
+            latency[idx] =
+                    std::chrono::duration<double, std::milli>(Clock::now() -
+                                                              begin)
+                            .count();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < nr_executor; ++i) {
+        threads.emplace_back(worker, i);
+    }
+    while (nr_ready.load() < nr_executor) {
+        std::this_thread::yield();
+    }
+    auto cpu_times_begin = read_cpu_times();
+    start = Clock::now();
+    started.store(true);
+    for (auto&& i : threads) {
+        i.join();
+    }
+    double wall_time =
+            std::chrono::duration<double>(Clock::now() - start).count();
+    auto cpu_times_end = read_cpu_times();
+
+    if (env.serve_qps > 0) {
+        printf("=== serving %zu requests by %zu executors with Poisson "
+               "arrival at %.2f qps\n",
+               nr_request, nr_executor, env.serve_qps);
+    } else {
+        printf("=== serving %zu requests by %zu executors in closed loop\n",
+               nr_request, nr_executor);
+    }
+    printf("throughput: %.2f qps (%.3fs in total)\n", nr_request / wall_time,
+           wall_time);
+    double mean = std::accumulate(latency.begin(), latency.end(), 0.) /
+                  nr_request;
+    std::sort(latency.begin(), latency.end());
+    auto percentile = [&](double p) {
+        auto rank = static_cast<size_t>(std::ceil(p * nr_request));
+        return latency[std::max<size_t>(rank, 1) - 1];
+    };
+    printf("latency: mean=%.3fms p50=%.3fms p90=%.3fms p99=%.3fms "
+           "p999=%.3fms max=%.3fms\n",
+           mean, percentile(0.5), percentile(0.9), percentile(0.99),
+           percentile(0.999), latency.back());
+    if (!cpu_times_end.empty() &&
+        cpu_times_end.size() == cpu_times_begin.size()) {
+        printf("cpu utilization:");
+        for (size_t i = 0; i < cpu_times_end.size(); ++i) {
+            auto busy = cpu_times_end[i].first - cpu_times_begin[i].first,
+                 total = cpu_times_end[i].second - cpu_times_begin[i].second;
+            printf(" cpu%zu=%.1f%%", i, total ? 100. * busy / total : 0.);
+        }
+        printf("\n");
+    }
+}
+#endif
+
 }  // anonymous namespace
 
 int mgb_load_and_run_main(int argc, char** argv) {
@@ -883,7 +1235,14 @@ int mgb_load_and_run_main(int argc, char** argv) {
         return env.args_parse_ret;
     }
 
-    if (env.nr_thread == 1) {
+    if (env.nr_serve_executor) {
+#if MGB_HAVE_THREAD
+        run_serving_benchmark(env);
+#else
+        mgb_log_error("serving mode requested, but load-and-run was compiled "
+                      "without thread support.");
+#endif
+    } else if (env.nr_thread == 1) {
         run_test_st(env);
     } else {
 #if MGB_HAVE_THREAD
@@ -1058,6 +1417,25 @@ Args Args::from_argv(int argc, char **argv) {
             ret.profiler_output = argv[i];
             continue;
         }
+        if (!strcmp(argv[i], "--perf-counter")) {
+            ++i;
+            mgb_assert(i < argc, "output file not given for --perf-counter");
+            ret.perf_counter = std::make_unique<PerfCounterProfiler>(
+                    ret.load_config.comp_graph.get());
+            ret.perf_counter_output = argv[i];
+            continue;
+        }
+        if (!strcmp(argv[i], "--timeline")) {
+            ++i;
+            mgb_assert(i < argc, "output file not given for --timeline");
+            if (!ret.profiler) {
+                ret.profiler = std::make_unique<GraphProfiler>(
+                        ret.load_config.comp_graph.get());
+            }
+            ret.timeline_output = argv[i];
+            TraceEventRecorder::inst().start(ret.timeline_output);
+            continue;
+        }
 #endif
         if (!strcmp(argv[i], "--input")) {
             ++i;
@@ -1190,6 +1568,11 @@ Args Args::from_argv(int argc, char **argv) {
             ret.fast_run_cache_path = argv[i];
             continue;
         }
+        if (!strcmp(argv[i], "--fast-run-shared-cache")) {
+            ++i;
+            ret.fast_run_shared_cache_path = argv[i];
+            continue;
+        }
         if (!strcmp(argv[i], "--reproducible")) {
             ret.reproducible = true;
             continue;
@@ -1202,6 +1585,10 @@ Args Args::from_argv(int argc, char **argv) {
             ret.share_param_mem = true;
             continue;
         }
+        if (!strcmp(argv[i], "--mmap-model")) {
+            ret.mmap_model = true;
+            continue;
+        }
         if (!strcmp(argv[i], "--disable-assert-throw")) {
             ret.disable_assert_throw = true;
             continue;
@@ -1234,6 +1621,20 @@ Args Args::from_argv(int argc, char **argv) {
             continue;
         }
 #endif
+        if (!strcmp(argv[i], "--serve")) {
+            ++i;
+            mgb_assert(i < argc, "value not given for --serve");
+            ret.nr_serve_executor = std::stoul(argv[i]);
+            mgb_assert(ret.nr_serve_executor > 0,
+                       "number of executors must be positive");
+            continue;
+        }
+        if (!strcmp(argv[i], "--serve-qps")) {
+            ++i;
+            mgb_assert(i < argc, "value not given for --serve-qps");
+            ret.serve_qps = std::stod(argv[i]);
+            continue;
+        }
         if (!strcmp(argv[i], "--thread")) {
             ++ i;
             mgb_assert(i < argc, "value not given for --thread");
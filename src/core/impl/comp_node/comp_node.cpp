@@ -559,6 +559,7 @@ void CompNode::finalize() {
 
 void CompNode::try_coalesce_all_free_memory() {
     CudaCompNode::try_coalesce_all_free_memory();
+    CpuCompNode::try_coalesce_all_free_memory();
     ROCmCompNode::try_coalesce_all_free_memory();
     CambriconCompNode::try_coalesce_all_free_memory();
 }
@@ -12,14 +12,18 @@
 #include "./comp_node.h"
 
 #include "megbrain/comp_node_env.h"
+#include "megbrain/comp_node/alloc.h"
 #include "megbrain/system.h"
 #include "megbrain/utils/arith_helper.h"
 #include "megbrain/utils/thread.h"
 #include "megbrain/utils/timer.h"
+#include "megbrain/utils/trace_event.h"
 #include "megbrain/utils/thread_pool.h"
 #include "megbrain/common.h"
 
 #include <condition_variable>
+#include <cctype>
+#include <cerrno>
 #include <cstdint>
 #include <cstring>
 #include <atomic>
@@ -28,6 +32,12 @@
 #ifndef __APPLE__
 #include <malloc.h>
 #endif
+#if defined(__linux__) && !defined(ANDROID) && !defined(__ANDROID__)
+#define MGB_CPU_ALLOC_USE_MMAP 1
+#include <sys/mman.h>
+#else
+#define MGB_CPU_ALLOC_USE_MMAP 0
+#endif
 
 using namespace mgb;
 
@@ -42,8 +52,144 @@ struct TaskElem {
     //! number of the parallelism
     size_t nr_parallelism;
 };
+
+/*!
+ * \brief raw allocator for the arenas of the CPU caching allocator
+ *
+ * On linux the arenas are mapped directly and advised to be backed by
+ * transparent huge pages.
+ */
+class CpuRawAllocator final : public mem_alloc::RawAllocator {
+    const size_t m_alignment;
+#if MGB_CPU_ALLOC_USE_MMAP
+    std::mutex m_mtx;
+    std::unordered_map<void*, size_t> m_mapped_size;
+#endif
+
+public:
+    explicit CpuRawAllocator(size_t alignment) : m_alignment{alignment} {}
+
+    void* alloc(size_t size) override {
+#if MGB_CPU_ALLOC_USE_MMAP
+        void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ptr == MAP_FAILED) {
+            return nullptr;
+        }
+#ifdef MADV_HUGEPAGE
+        madvise(ptr, size, MADV_HUGEPAGE);
+#endif
+        MGB_LOCK_GUARD(m_mtx);
+        m_mapped_size[ptr] = size;
+        return ptr;
+#elif defined(WIN32)
+        return _aligned_malloc(size, m_alignment);
+#elif defined(__ANDROID__) || defined(ANDROID)
+        return memalign(m_alignment, size);
+#else
+        void* ptr = nullptr;
+        if (posix_memalign(&ptr, m_alignment, size)) {
+            return nullptr;
+        }
+        return ptr;
+#endif
+    }
+
+    void free(void* ptr) override {
+#if MGB_CPU_ALLOC_USE_MMAP
+        size_t size;
+        {
+            MGB_LOCK_GUARD(m_mtx);
+            auto iter = m_mapped_size.find(ptr);
+            mgb_assert(iter != m_mapped_size.end());
+            size = iter->second;
+            m_mapped_size.erase(iter);
+        }
+        munmap(ptr, size);
+#elif defined(WIN32)
+        _aligned_free(ptr);
+#else
+        ::free(ptr);
+#endif
+    }
+
+    void get_mem_info(size_t& free, size_t& tot) override {
+        std::tie(tot, free) = sys::get_ram_status_bytes();
+    }
+};
+
+//! the caching allocator shared by all CPU comp nodes; null if disabled
+std::atomic<mem_alloc::SizeClassCachingAlloc*> cpu_caching_alloc_ptr{nullptr};
+
+/*!
+ * \brief owner of the caching allocator shared by all CPU comp nodes
+ *
+ * The allocator is disabled by default. It is enabled by setting env var
+ * MGB_CPU_CACHING_ALLOC to the max size of cached free memory in MiB, which is
+ * clamped to max_cached_size_limit.
+ *
+ * The allocator is destroyed at static destruction, which happens after
+ * CompNode::finalize(). If some blocks are still in use, they might be freed
+ * later, so only the free arenas are released and the allocator is kept.
+ */
+class CpuCachingAllocOwner {
+    static constexpr size_t max_cached_size_limit = 1024;
+
+    std::unique_ptr<mem_alloc::SizeClassCachingAlloc> m_alloc;
+
+public:
+    CpuCachingAllocOwner() {
+        auto setting = MGB_GETENV("MGB_CPU_CACHING_ALLOC");
+        if (!setting) {
+            return;
+        }
+        char* end = nullptr;
+        errno = 0;
+        size_t max_cached_mb = strtoull(setting, &end, 10);
+        mgb_assert(isdigit(setting[0]) && !*end && !errno,
+                   "invalid MGB_CPU_CACHING_ALLOC=%s: expect max size of "
+                   "cached memory in MiB, or 0 to disable",
+                   setting);
+        if (!max_cached_mb) {
+            return;
+        }
+        if (max_cached_mb > max_cached_size_limit) {
+            mgb_log_warn(
+                    "MGB_CPU_CACHING_ALLOC=%zu exceeds limit; use %zuMiB",
+                    max_cached_mb, max_cached_size_limit);
+            max_cached_mb = max_cached_size_limit;
+        }
+        mem_alloc::SizeClassCachingAlloc::Config config;
+        config.max_cached_size = max_cached_mb * 1024 * 1024;
+        m_alloc = mem_alloc::SizeClassCachingAlloc::make(
+                std::make_unique<CpuRawAllocator>(config.alignment), config);
+        cpu_caching_alloc_ptr.store(m_alloc.get());
+    }
+
+    ~CpuCachingAllocOwner() {
+        if (!m_alloc) {
+            return;
+        }
+        m_alloc->trim();
+        if (m_alloc->get_used_memory()) {
+            m_alloc.release();
+            return;
+        }
+        cpu_caching_alloc_ptr.store(nullptr);
+        m_alloc.reset();
+    }
+};
+
+//! create the caching allocator on first call
+void init_cpu_caching_alloc() {
+    static CpuCachingAllocOwner owner;
+}
 }  // anonymous namespace
 
+mem_alloc::SizeClassCachingAlloc* mem_alloc::cpu_caching_alloc() {
+    return cpu_caching_alloc_ptr.load(std::memory_order_relaxed);
+}
+
 using CpuCompNodeImpl = CpuCompNode::CompNodeImpl;
 
 void CpuCompNode::CpuDispatchableBase::add_callback(Task&& task) {
@@ -81,6 +227,23 @@ public:
     }
 
     void process_one_task(const TaskElem& task_elem) {
+        if (TraceEventRecorder::enabled()) {
+            auto&& recorder = TraceEventRecorder::inst();
+            auto start = TraceEventRecorder::now();
+            if (task_elem.dispatch_time > 0) {
+                recorder.add_span("cpu_queue", "queue_wait",
+                                  task_elem.dispatch_time, start);
+            }
+            run_task(task_elem);
+            recorder.add_span(
+                    "cpu_queue", "task", start, TraceEventRecorder::now(),
+                    {{"parallelism", task_elem.nr_parallelism}});
+        } else {
+            run_task(task_elem);
+        }
+    }
+
+    void run_task(const TaskElem& task_elem) {
         if (m_thread_pool) {
             m_thread_pool->add_task(task_elem);
         } else {
@@ -320,23 +483,39 @@ class CpuCompNode::CompNodeImpl final: public CpuDispatchableBase {
 #endif
         }
 
+        //! allocate from the caching allocator if it is enabled
+        void* cached_alloc(size_t size) {
+            if (auto alloc = mem_alloc::cpu_caching_alloc()) {
+                return alloc->alloc(size);
+            }
+            return mgb_aligned_alloc(size);
+        }
+
+        void cached_free(void* ptr) {
+            if (auto alloc = mem_alloc::cpu_caching_alloc()) {
+                alloc->free(ptr);
+            } else {
+                mgb_aligned_free(ptr);
+            }
+        }
+
         void* alloc_device(size_t size) override {
             if (sm_cur_recorder) {
                 sm_cur_recorder->on_alloc(this);
             }
-            return mgb_aligned_alloc(size);
+            return cached_alloc(size);
         }
 
         void free_device(void *ptr) {
             if (sm_cur_recorder || check_global_finalized("free_device()")) {
-                mgb_aligned_free(ptr);
+                cached_free(ptr);
                 if (sm_cur_recorder) {
                     sm_cur_recorder->on_free(this);
                 }
                 return;
             } else {
-                auto do_free = [ptr]() {
-                    mgb_aligned_free(ptr);
+                auto do_free = [this, ptr]() {
+                    cached_free(ptr);
                 };
                 m_env.cpu_env().dispatch(do_free);
             }
@@ -346,18 +525,18 @@ class CpuCompNode::CompNodeImpl final: public CpuDispatchableBase {
             if (m_worker_queue) {
                 m_worker_queue->check_exception();
             }
-            return mgb_aligned_alloc(size);
+            return cached_alloc(size);
         }
 
         void free_host(void *ptr) {
             if (check_global_finalized("free_host()")) {
-                mgb_aligned_free(ptr);
+                cached_free(ptr);
                 return;
             }
             if (m_worker_queue) {
                 m_worker_queue->check_exception();
             }
-            return mgb_aligned_free(ptr);
+            return cached_free(ptr);
         }
 
         void copy_to_host(void *host_ptr,
@@ -491,6 +670,14 @@ class CpuCompNode::WorkerQueue::DispatcherImpl final: public CPUDispatcher {
     std::shared_ptr<WorkerQueue> m_queue;
     CpuCompNode::CompNodeImpl* const m_comp_node;
 
+    //! add a task to the queue, and record the time if tracing is enabled
+    void add_task(TaskElem&& task_elem) {
+        if (TraceEventRecorder::enabled()) {
+            task_elem.dispatch_time = TraceEventRecorder::now();
+        }
+        m_queue->add_task(std::move(task_elem));
+    }
+
 public:
     DispatcherImpl(const std::shared_ptr<WorkerQueue>& queue,
                    CpuCompNode::CompNodeImpl* comp_node)
@@ -502,7 +689,7 @@ public:
         } else {
             m_nr_task.fetch_add(1, std::memory_order_relaxed);
             auto kern = [task](size_t, size_t) { task(); };
-            m_queue->add_task({kern, static_cast<size_t>(1_z)});
+            add_task({kern, static_cast<size_t>(1_z)});
         }
     }
 
@@ -511,7 +698,7 @@ public:
             recorder->dispatch({std::move(task), parallelism}, m_comp_node);
         } else {
             m_nr_task.fetch_add(1, std::memory_order_relaxed);
-            m_queue->add_task({std::move(task), parallelism});
+            add_task({std::move(task), parallelism});
         }
     }
 
@@ -541,7 +728,7 @@ public:
             auto affinity_run = [affinity_cb](size_t, size_t) {
                 affinity_cb(0);
             };
-            m_queue->add_task({affinity_run, 1_z});
+            add_task({affinity_run, 1_z});
         }
     }
 };
@@ -616,6 +803,7 @@ CpuCompNode::CompNodeImpl::CompNodeImpl(
           m_worker_queue{worker_queue},
           m_locator(locator),
           m_locator_logical(locator_logical) {
+    init_cpu_caching_alloc();
     auto cn = make_comp_node_from_impl(this);
     if (locator.type == DeviceType::MULTITHREAD) {
         m_thread_pool = std::unique_ptr<ThreadPool>(
@@ -773,6 +961,17 @@ void CpuCompNode::finalize() {
     }
 }
 
+void CpuCompNode::try_coalesce_all_free_memory() {
+    if (auto alloc = mem_alloc::cpu_caching_alloc()) {
+        // memory of tensors released on the workers would be freed after sync
+        sync_all();
+        auto size = alloc->trim();
+        MGB_MARK_USED_VAR(size);
+        mgb_log_debug("released %.2fMiB cached CPU memory",
+                      size / 1024.0 / 1024);
+    }
+}
+
 size_t CpuCompNode::get_device_count() {
     return sys::get_cpu_count();
 }
@@ -57,6 +57,8 @@ namespace mgb {
 
             static void foreach(thin_function<void(CompNode)> callback);
             static void finalize();
+            //! release cached free memory of the CPU caching allocator
+            static void try_coalesce_all_free_memory();
             static size_t get_device_count();
             static Impl* load_cpu(Locator locator, Locator locator_logical);
             static void sync_all();
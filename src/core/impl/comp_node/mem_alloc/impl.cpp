@@ -450,4 +450,142 @@ FreeMemStat SimpleCachingAllocImpl::get_free_memory_dev() {
     return get_free_memory();
 }
 
+/* ===================== SizeClassCachingAllocImpl ===================== */
+
+std::unique_ptr<SizeClassCachingAlloc> SizeClassCachingAlloc::make(
+        std::unique_ptr<RawAllocator> raw_alloc, const Config& config) {
+    return std::make_unique<SizeClassCachingAllocImpl>(std::move(raw_alloc),
+                                                       config);
+}
+
+size_t SizeClassCachingAlloc::size_class(size_t size, size_t alignment) {
+    size = get_aligned_power2(std::max<size_t>(size, 1), alignment);
+    // for size in (4 * step, 8 * step], round up to multiples of step
+    size_t step = alignment;
+    while (step * 8 < size) {
+        step *= 2;
+    }
+    return get_aligned_power2(size, step);
+}
+
+SizeClassCachingAllocImpl::SizeClassCachingAllocImpl(
+        std::unique_ptr<RawAllocator> raw_alloc, const Config& config)
+        : m_raw_alloc(std::move(raw_alloc)), m_config(config) {
+    mgb_assert(config.alignment && !(config.alignment & (config.alignment - 1)),
+               "alignment must be power of 2: %zu", config.alignment);
+    mgb_assert(config.arena_size % config.alignment == 0);
+}
+
+void* SizeClassCachingAllocImpl::alloc(size_t size) {
+    if (size <= m_config.arena_size) {
+        size = size_class(size, m_config.alignment);
+    } else {
+        size = get_aligned_power2(size, m_config.alignment);
+    }
+    auto addr = do_alloc(size, true);
+    auto ptr = addr.addr_ptr();
+    MGB_LOCK_GUARD(m_mutex);
+    m_allocated_blocks[ptr] = {addr.is_head, size};
+    m_used_size += size;
+    ++m_stat.nr_alloc;
+    return ptr;
+}
+
+void SizeClassCachingAllocImpl::free(void* ptr) {
+    MGB_LOCK_GUARD(m_mutex);
+    auto iter = m_allocated_blocks.find(ptr);
+    mgb_assert(iter != m_allocated_blocks.end(),
+               "releasing bad pointer: %p", ptr);
+    auto size = iter->second.size;
+    FreeBlock fb{MemAddr{iter->second.is_head, reinterpret_cast<size_t>(ptr)},
+                 size};
+    m_allocated_blocks.erase(iter);
+    merge_free_unsafe(fb);
+    m_used_size -= size;
+    if (m_stat.reserved - m_used_size > m_config.max_cached_size) {
+        trim_unsafe();
+    }
+}
+
+size_t SizeClassCachingAllocImpl::trim() {
+    MGB_LOCK_GUARD(m_mutex);
+    return trim_unsafe();
+}
+
+size_t SizeClassCachingAllocImpl::trim_unsafe() {
+    size_t released = 0;
+    for (auto iter = m_alloc_from_raw.begin();
+         iter != m_alloc_from_raw.end();) {
+        auto addr = reinterpret_cast<size_t>(iter->first);
+        auto fiter = m_free_blk_addr.find(addr);
+        if (fiter == m_free_blk_addr.end() ||
+            fiter->second.size != iter->second) {
+            ++iter;
+            continue;
+        }
+        mgb_assert(fiter->second.is_head);
+        m_free_blk_size.erase(fiter->second.siter);
+        m_free_blk_addr.erase(fiter);
+        m_raw_alloc->free(iter->first);
+        released += iter->second;
+        ++m_stat.nr_raw_free;
+        iter = m_alloc_from_raw.erase(iter);
+    }
+    m_stat.reserved -= released;
+    return released;
+}
+
+SizeClassCachingAllocImpl::MemAddr SizeClassCachingAllocImpl::alloc_from_parent(
+        size_t size) {
+    auto arena = get_aligned_power2(size, m_config.arena_size);
+    void* ptr = m_raw_alloc->alloc(arena);
+    if (!ptr) {
+        auto released = trim();
+        if (released) {
+            ptr = m_raw_alloc->alloc(arena);
+        }
+        if (!ptr) {
+            print_memory_state();
+            mgb_throw(MemAllocError,
+                      "failed to allocate %zu bytes (request %zu bytes) from "
+                      "raw allocator",
+                      arena, size);
+        }
+    }
+    MGB_LOCK_GUARD(m_mutex);
+    m_alloc_from_raw[ptr] = arena;
+    ++m_stat.nr_raw_alloc;
+    m_stat.reserved += arena;
+    update_max(m_stat.peak_reserved, m_stat.reserved);
+    MemAddr ret{true, reinterpret_cast<size_t>(ptr)};
+    if (arena > size) {
+        insert_free_unsafe({ret + size, arena - size});
+    }
+    return ret;
+}
+
+SizeClassCachingAllocImpl::~SizeClassCachingAllocImpl() {
+    for (auto&& ptr_size : m_alloc_from_raw) {
+        m_raw_alloc->free(ptr_size.first);
+    }
+}
+
+std::string SizeClassCachingAllocImpl::get_name() const {
+    return "SizeClassCachingAllocImpl";
+}
+
+SizeClassCachingAlloc::Stat SizeClassCachingAllocImpl::stat() {
+    MGB_LOCK_GUARD(m_mutex);
+    return m_stat;
+}
+
+size_t SizeClassCachingAllocImpl::get_used_memory() {
+    MGB_LOCK_GUARD(m_mutex);
+    return m_used_size;
+}
+
+FreeMemStat SizeClassCachingAllocImpl::get_free_memory_dev() {
+    return get_free_memory();
+}
+
 // vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
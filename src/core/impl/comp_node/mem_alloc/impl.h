@@ -251,6 +251,40 @@ protected:
     std::string get_name() const override;
 };
 
+class SizeClassCachingAllocImpl final : public SizeClassCachingAlloc,
+                                        public MemAllocImplHelper {
+    struct AllocatedBlock {
+        bool is_head;
+        size_t size;
+    };
+
+    std::unique_ptr<RawAllocator> m_raw_alloc;
+    const Config m_config;
+    std::unordered_map<void*, size_t> m_alloc_from_raw;
+    std::unordered_map<void*, AllocatedBlock> m_allocated_blocks;
+    size_t m_used_size = 0;
+    Stat m_stat;
+
+    //! release free arenas, with m_mutex held
+    size_t trim_unsafe();
+
+public:
+    SizeClassCachingAllocImpl(std::unique_ptr<RawAllocator> raw_alloc,
+                              const Config& config);
+    ~SizeClassCachingAllocImpl();
+
+    void* alloc(size_t size) override;
+    void free(void* ptr) override;
+    size_t trim() override;
+    Stat stat() override;
+    size_t get_used_memory() override;
+    FreeMemStat get_free_memory_dev() override;
+
+protected:
+    MemAddr alloc_from_parent(size_t size) override;
+    std::string get_name() const override;
+};
+
 }
 }
 // vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
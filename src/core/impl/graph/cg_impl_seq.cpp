@@ -270,6 +270,7 @@ ComputingGraphImpl::ComputingSequence::check_enable_comp_node_seq_recorder() {
 
 void ComputingGraphImpl::ComputingSequence::do_execute(
         MegDNNDtorCheck* dtor_check) {
+    TaskPriorityGuard priority_guard{m_owner_graph->options().cpu_task_priority};
     ExecContext exec_ctx{this};
 
     if (dtor_check) {
@@ -705,6 +706,7 @@ AsyncExecutable& ComputingGraphImpl::RecordedComputingSequence::execute() {
     for (auto i : m_runtime_checks) {
         i->do_runtime_check();
     }
+    TaskPriorityGuard priority_guard{m_task_priority};
     m_recorder->replay();
     return *this;
 }
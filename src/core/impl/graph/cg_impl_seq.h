@@ -228,6 +228,8 @@ class ComputingGraphImpl::RecordedComputingSequence final
     //! valid if owner graph is not destroyed
     ComputingGraphImpl* m_owner_graph;
     mutable Maybe<double> m_prev_exec_time;
+    //! copied from owner graph options, see Options::cpu_task_priority
+    TaskPriority m_task_priority;
 
     std::shared_ptr<void> on_comp_node_finalize() override {
         clear_device_memory();
@@ -244,7 +246,8 @@ class ComputingGraphImpl::RecordedComputingSequence final
 
 public:
     explicit RecordedComputingSequence(ComputingGraphImpl* owner_graph)
-            : m_owner_graph{owner_graph} {}
+            : m_owner_graph{owner_graph},
+              m_task_priority{owner_graph->options().cpu_task_priority} {}
 
     ~RecordedComputingSequence() {
         if (m_owner_graph) {
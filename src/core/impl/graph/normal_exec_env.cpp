@@ -100,6 +100,7 @@ void NormalExecEnv::run_task_seq_impl(const TaskSeq& seq) {
 
 template <bool check_exec_pause>
 void NormalExecEnv::run_task_seq(const TaskSeq& seq) {
+    TaskPriorityGuard priority_guard{m_task_priority};
 #if MGB_ENABLE_COND_EXEC
     if (m_has_exec_mask) {
         return run_task_seq_impl<check_exec_pause, true>(seq);
@@ -127,6 +128,7 @@ void NormalExecEnv::dispatch_on_comp_node_with_mask(CompNode cn, Task&& task,
 }
 
 void NormalExecEnv::start_exec() {
+    m_task_priority = get_thread_task_priority();
 #if MGB_HAVE_THREAD
     resume_exec();
 #endif
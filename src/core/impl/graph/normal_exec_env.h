@@ -14,6 +14,7 @@
 #include "megbrain/graph/execution_mask.h"
 #include "megbrain/graph/operator_node.h"
 #include "megbrain/utils/async_worker.h"
+#include "megbrain/utils/thread_pool.h"
 
 namespace mgb {
 namespace cg {
@@ -50,6 +51,9 @@ class NormalExecEnv final : public GraphExecutable::ExecEnv {
     using TaskSeq = std::vector<TaskSeqElem>;
 
     int m_async_level = 1;
+    //! task priority of the thread calling start_exec(), which is forwarded
+    //! to the async dispatch workers
+    TaskPriority m_task_priority = TaskPriority::LATENCY_CRITICAL;
 
 #if MGB_HAVE_THREAD
     std::atomic_bool m_exec_paused{false};
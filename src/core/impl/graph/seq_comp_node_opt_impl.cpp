@@ -13,6 +13,8 @@
 #include "./var_node_mem_mgr.h"
 #include "./cg_impl.h"
 
+#include "megbrain/plugin/opr_footprint.h"
+
 #include <queue>
 
 using namespace mgb;
@@ -23,6 +25,9 @@ void SeqCompNodeOptimizerImpl::optimize_comp_nodes(
     mgb_assert(m_comp_node_to_restore.empty() &&
             m_comp_node_changed_oprs.empty(), "restore_comp_nodes not called");
     change_to_specific_stream(endpoints);
+    if (m_comp_node_to_restore.empty()) {
+        parallelize_cpu_branches(endpoints);
+    }
 
     for (auto &&i: m_comp_node_to_restore) {
         auto opr = i.first->owner_opr();
@@ -178,6 +183,179 @@ void SeqCompNodeOptimizerImpl::change_to_specific_stream(
     }
 }
 
+void SeqCompNodeOptimizerImpl::parallelize_cpu_branches(
+        const VarNodeArray &endpoints) {
+    auto &&options = m_owner_graph->options();
+    size_t nr_stream = options.seq_opt.cpu_branch_parallelism;
+    if (nr_stream <= 1 || !options.seq_opt.enable_seq_comp_node_opt ||
+            options.comp_node_seq_record_level) {
+        return;
+    }
+
+    OprNodeArray oprs;
+    CompNode cn;
+    bool single_cn = true;
+    DepOprIter dep_iter{[&](OperatorNodeBase *opr) {
+        oprs.push_back(opr);
+        for (auto i: opr->output()) {
+            if (!cn.valid()) {
+                cn = i->comp_node();
+            } else if (cn != i->comp_node()) {
+                single_cn = false;
+            }
+        }
+    }};
+    for (auto i: endpoints) {
+        dep_iter.add(i->owner_opr());
+    }
+    // cpu:default executes inplace on the caller thread, and multithread comp
+    // nodes (whose device type is also CPU) already use a thread pool, so
+    // only plain CPU comp nodes with their own workers can be used
+    if (!single_cn || !cn.valid() ||
+            cn.locator().type != CompNode::DeviceType::CPU ||
+            cn.locator().device < 0) {
+        mgb_log_debug("cpu branch parallelism disabled: oprs not on a single "
+                "CPU comp node with its own worker");
+        return;
+    }
+
+    OprFootprint footprint;
+    auto opr_cost = [&](OperatorNodeBase *opr) -> uint64_t {
+        update_output_var_shapes(opr);
+        bool shape_valid = true;
+        uint64_t nr_elems = 0;
+        for (auto i: opr->input()) {
+            shape_valid &= i->shape().ndim != 0;
+        }
+        for (auto i: opr->output()) {
+            shape_valid &= i->shape().ndim != 0;
+            if (i->shape().ndim) {
+                nr_elems += i->shape().total_nr_elems();
+            }
+        }
+        if (shape_valid) {
+            if (auto comp = footprint.get_computation(opr)) {
+                return comp;
+            }
+        }
+        // fallback to output size for oprs without footprint trait
+        return std::max<uint64_t>(nr_elems, 1);
+    };
+
+    // oprs that only produce persistent values or have no input (usually
+    // for I/O) are kept on the original stream
+    auto opr_movable = [](OperatorNodeBase *opr) {
+        if (opr->input().empty() ||
+                opr->node_prop().contain(
+                    OperatorNodeBase::NodeProp::Flag::
+                    DISALLOW_COMP_NODE_OPTIMIZE)) {
+            return false;
+        }
+        for (auto i: opr->output()) {
+            if (i->contain_flag(VarNode::Flag::PERSISTENT_DEVICE_VALUE))
+                return false;
+        }
+        return true;
+    };
+
+    // split oprs into chains: an opr joins the chain of its input opr if it
+    // is the only input opr and the only reader of that opr
+    struct Chain {
+        bool movable;
+        uint64_t cost = 0, finish = 0;
+        size_t stream = 0;
+        SmallVector<size_t> pred;
+        OprNodeArray oprs;
+    };
+    std::vector<Chain> chains;
+    ThinHashMap<OperatorNodeBase*, size_t> opr2chain, nr_reader;
+    std::vector<SmallVector<OperatorNodeBase*>> opr_inputs(oprs.size());
+    for (size_t i = 0; i < oprs.size(); ++ i) {
+        ThinHashSet<OperatorNodeBase*> visited;
+        for (auto inp: oprs[i]->input()) {
+            auto iopr = inp->owner_opr();
+            if (visited.insert(iopr).second) {
+                opr_inputs[i].push_back(iopr);
+                ++ nr_reader[iopr];
+            }
+        }
+    }
+    for (size_t i = 0; i < oprs.size(); ++ i) {
+        auto opr = oprs[i];
+        auto &&inputs = opr_inputs[i];
+        bool movable = opr_movable(opr);
+        size_t chain_id = chains.size();
+        if (inputs.size() == 1 && nr_reader.at(inputs[0]) == 1 &&
+                chains[opr2chain.at(inputs[0])].movable == movable) {
+            chain_id = opr2chain.at(inputs[0]);
+        } else {
+            chains.emplace_back();
+            chains.back().movable = movable;
+            for (auto iopr: inputs) {
+                auto pred = opr2chain.at(iopr);
+                auto &&dst = chains.back().pred;
+                if (std::find(dst.begin(), dst.end(), pred) == dst.end()) {
+                    dst.push_back(pred);
+                }
+            }
+        }
+        opr2chain[opr] = chain_id;
+        chains[chain_id].cost += opr_cost(opr);
+        chains[chain_id].oprs.push_back(opr);
+    }
+
+    // list scheduling: chains are visited in topological order, and each
+    // chain is assigned to the stream on which it can start earliest,
+    // preferring the stream of its latest predecessor to avoid sync
+    std::vector<uint64_t> stream_avail(nr_stream, 0);
+    size_t nr_changed_chain = 0;
+    for (auto &&chain: chains) {
+        uint64_t ready = 0;
+        size_t best = 0;
+        for (auto pred: chain.pred) {
+            if (chains[pred].finish >= ready) {
+                ready = chains[pred].finish;
+                best = chains[pred].stream;
+            }
+        }
+        auto start = std::max(ready, stream_avail[best]);
+        if (chain.movable) {
+            for (size_t s = 0; s < nr_stream; ++ s) {
+                auto cur = std::max(ready, stream_avail[s]);
+                if (cur < start) {
+                    start = cur;
+                    best = s;
+                }
+            }
+        } else {
+            best = 0;
+            start = std::max(ready, stream_avail[0]);
+        }
+        chain.stream = best;
+        chain.finish = stream_avail[best] = start + chain.cost;
+        nr_changed_chain += best != 0;
+    }
+    if (!nr_changed_chain) {
+        return;
+    }
+
+    auto base_stream = cn.locator().stream;
+    for (auto &&chain: chains) {
+        if (!chain.stream)
+            continue;
+        auto new_cn = cn.change_stream(base_stream + chain.stream);
+        for (auto opr: chain.oprs) {
+            for (auto var: opr->output()) {
+                m_comp_node_to_restore.emplace_back(var, cn);
+                var->comp_node(new_cn);
+            }
+        }
+    }
+    mgb_log_debug("cpu branch parallelism: %zu of %zu chains moved to other "
+            "streams of %s", nr_changed_chain, chains.size(),
+            cn.to_string().c_str());
+}
+
 void SeqCompNodeOptimizerImpl::register_stream_var(
         VarNode *var, StreamPropType stream_prop_type) {
     int stream = stream_prop_type.stream;
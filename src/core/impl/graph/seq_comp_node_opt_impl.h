@@ -43,6 +43,17 @@ class SeqCompNodeOptimizerImpl final: public SeqCompNodeOptimizer {
     //! m_comp_node_to_restore
     void var_to_specific_stream(VarNode *var, const int stream);
 
+    /*!
+     * \brief distribute independent branches among streams of the CPU comp
+     *      node if all oprs are on it, as configured by
+     *      Options::SeqOpt::cpu_branch_parallelism
+     *
+     * Memory safety of concurrent branches is ensured by the memory manager:
+     * static memory is planned for each stream separately, and vars read
+     * from other streams are allocated dynamically.
+     */
+    void parallelize_cpu_branches(const VarNodeArray &endpoints);
+
     public:
         SeqCompNodeOptimizerImpl(ComputingGraphImpl *graph):
             m_owner_graph(graph)
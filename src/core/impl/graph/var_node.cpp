@@ -12,6 +12,7 @@
 #include "megbrain/graph/var_node.h"
 #include "megbrain/graph/operator_node.h"
 #include "megbrain/graph/helper.h"
+#include "megbrain/utils/trace_event.h"
 #include "./cg_impl.h"
 
 using namespace mgb;
@@ -126,6 +127,14 @@ MemAllocPlan& MemAllocPlan::release_chunk() {
         if (chk->size()) {
             mgb_assert(chk->mem_alloc_status.is_from_owner_var());
             chk->m_size = 0;
+            if (TraceEventRecorder::enabled()) {
+                auto&& recorder = TraceEventRecorder::inst();
+                recorder.update_counter(
+                        "memory " + dv.comp_node().to_string(), "dynamic",
+                        -static_cast<double>(dv.storage().size()));
+                recorder.add_instant("memory", "free " + chk->owner_var->name(),
+                                     {{"size", dv.storage().size()}});
+            }
         }
         chk->mem_alloc_status.set_invalid();
         dv.storage({});
@@ -231,7 +240,15 @@ VarNode& VarNode::format(TensorFormat format) {
 bool VarNode::set_fwd_in2out_readonly(
         VarNode *input, const SubTensorSpec &sub) {
     if (owner_graph()->options().imperative_proxy_graph) {
-        return false;
+        // there is no mem plan in the imperative proxy graph; the output is
+        // bound to the view directly, which is taken as an output tensor
+        // sharing memory with the input by imperative::ProxyGraph
+        if (input->comp_node() != comp_node() ||
+            input->dtype() != dtype() || input->m_dev_tensor.empty()) {
+            return false;
+        }
+        m_dev_tensor = input->m_dev_tensor.sub(sub);
+        return true;
     }
     return ComputingGraphImpl::downcast(owner_graph())
         ->var_node_mem_manager().fwd_in2out_readonly(input, sub, this);
@@ -22,6 +22,7 @@
 
 #include "megbrain/system.h"
 #include "megbrain/utils/timer.h"
+#include "megbrain/utils/trace_event.h"
 #include "megbrain/utils/arith_helper.h"
 
 #include <chrono>
@@ -456,6 +457,10 @@ bool VarNodeMemManager::make_static_var_tensor_from_alloc_plan() {
         DeviceTensorStorage storage = dev_mem_mgr.alloc(m_owner_graph, i.first,
                                                         i.second, cur_version);
         m_static_mem_refholder.emplace_back(storage);
+        if (TraceEventRecorder::enabled()) {
+            TraceEventRecorder::inst().set_counter(
+                    "memory " + i.first.to_string(), "static", storage.size());
+        }
         // the reference has been kept in m_static_mem_refholder, and we drop
         // the ref now so clear_static_device_memory() can be easily implemented
         using S = DeviceTensorStorage::RawStorage;
@@ -1260,6 +1265,7 @@ void VarNodeMemManager::var_alloc_with_shape(VarNode* var,
     if (chk.owner_var == var) {
         storage = var->m_dev_tensor.storage();
         if (storage.size() < size_req) {
+            size_t prev_size = storage.size();
             // clear storage ref in var
             var->m_dev_tensor.storage(DeviceTensorStorage{});
             m_var_dev_mem_defragmenter.alloc_var_storage(var, storage,
@@ -1270,6 +1276,14 @@ void VarNodeMemManager::var_alloc_with_shape(VarNode* var,
                     addr && !(addr & (alignment - 1)),
                     "address unaligned: 0x%zx (alignment: 0x%zx); size_req=%zu",
                     addr, alignment, size_req);
+            if (TraceEventRecorder::enabled()) {
+                auto&& recorder = TraceEventRecorder::inst();
+                recorder.update_counter(
+                        "memory " + var->comp_node().to_string(), "dynamic",
+                        static_cast<double>(storage.size()) - prev_size);
+                recorder.add_instant("memory", "alloc " + var->name(),
+                                     {{"size", storage.size()}});
+            }
         }
         chk.update_size_for_dynamic_alloc(size_req);
         chk.mem_alloc_status.set_from_owner_var();
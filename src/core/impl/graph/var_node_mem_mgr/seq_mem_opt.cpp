@@ -18,12 +18,79 @@
 #include "megbrain/graph/exc_extra_info.h"
 #include "megbrain/utils/metahelper.h"
 #include "megbrain/utils/arith_helper.h"
+#include "megbrain/utils/hash.h"
+
+#include <array>
+#include <future>
+#include <list>
+#include <unordered_map>
 
 using namespace mgb;
 using namespace cg;
 
 constexpr double BYTE2MB = 1.0 / 1024.0 / 1024;
 
+/*!
+ * \brief LRU cache of static memory allocation plans, keyed by the complete
+ *      input of the allocator
+ *
+ * The life intervals and sizes only depend on the operator sequence and var
+ * shapes, so a graph whose shapes switch among a few buckets solves each
+ * bucket only once.
+ */
+class SeqMemOptimizer::StaticMemPlanCache {
+    public:
+        //! encoded allocation problem
+        using Key = std::vector<size_t>;
+
+        struct Plan {
+            size_t tot_alloc = 0, tot_alloc_lower_bound = 0;
+            //! start address of each chunk, in the order they are added
+            std::vector<size_t> offsets;
+        };
+
+        //! get a cached plan, or nullptr if not found
+        const Plan* get(const Key &key) {
+            auto iter = m_key2item.find(&key);
+            if (iter == m_key2item.end())
+                return nullptr;
+            m_items.splice(m_items.begin(), m_items, iter->second);
+            return &iter->second->second;
+        }
+
+        //! insert a plan and evict the least recently used ones
+        const Plan& put(Key key, Plan plan, size_t capacity) {
+            m_items.emplace_front(std::move(key), std::move(plan));
+            auto ins = m_key2item.emplace(&m_items.front().first,
+                    m_items.begin());
+            mgb_assert(ins.second);
+            while (m_items.size() > capacity) {
+                m_key2item.erase(&m_items.back().first);
+                m_items.pop_back();
+            }
+            return m_items.front().second;
+        }
+
+    private:
+        struct KeyPtrHash {
+            size_t operator()(const Key *key) const {
+                return XXHash{}
+                        .update(key->data(), key->size() * sizeof(size_t))
+                        .digest();
+            }
+        };
+        struct KeyPtrEq {
+            bool operator()(const Key *a, const Key *b) const {
+                return *a == *b;
+            }
+        };
+
+        //! most recently used first
+        std::list<std::pair<Key, Plan>> m_items;
+        std::unordered_map<const Key*, decltype(m_items)::iterator,
+            KeyPtrHash, KeyPtrEq> m_key2item;
+};
+
 class SeqMemOptimizer::StaticMemAllocLogger {
     public:
         virtual ~StaticMemAllocLogger() = default;
@@ -75,6 +142,13 @@ class SeqMemOptimizer::StaticMemAllocLogger::LogImpl final:
 };
 
 
+SeqMemOptimizer::SeqMemOptimizer(ComputingGraphImpl *graph):
+    m_graph(graph),
+    m_static_mem_plan_cache(std::make_unique<StaticMemPlanCache>())
+{}
+
+SeqMemOptimizer::~SeqMemOptimizer() noexcept = default;
+
 void SeqMemOptimizer::optimize_mem_plan_dynamic(OperatorNodeBase *opr) {
     mgb_assert(!m_status);
     m_status = Status::ALLOW_FWD_IN2OUT_READONLY;
@@ -296,58 +370,127 @@ bool SeqMemOptimizer::run_static_mem_alloc_on_comp_node(
         const std::vector<MemChunkLifeInterval> &chunks,
         StaticMemAllocLogger &static_mem_alloc_logger) {
 
+    using Plan = StaticMemPlanCache::Plan;
+    using Algo = StaticMemAlloc::AllocatorAlgo;
+
     size_t size_ub = 0;
 
-    auto allocator = StaticMemAlloc::make(
-            StaticMemAlloc::AllocatorAlgo::PUSHDOWN);
-    allocator->alignment(comp_node.get_mem_addr_alignment());
-    allocator->padding(comp_node.get_mem_padding());
-#if MGB_ENABLE_DEBUG_UTIL
-    allocator->dbg_key2varnode = [](StaticMemAlloc::UserKeyType key) {
-        return static_cast<const MemChunkLifeInterval*>(key)->chunk->owner_var;
-    };
-#endif
-    ThinHashMap<MemAllocPlan::Chunk*, size_t> chunk2allocatorid;
-    for (auto &&chk: chunks) {
-        auto id = allocator->add(
-                chk.begin, chk.end, chk.chunk->size(), &chk);
-        auto ins_rst = chunk2allocatorid.emplace(chk.chunk, id);
+    // chunks are identified by their indices, which are also the interval ids
+    // returned by StaticMemAlloc::add()
+    ThinHashMap<MemAllocPlan::Chunk*, size_t> chunk2id;
+    for (size_t i = 0; i < chunks.size(); ++ i) {
+        auto ins_rst = chunk2id.emplace(chunks[i].chunk, i);
         mgb_assert(ins_rst.second);
-        size_ub += chk.chunk->size();
+        size_ub += chunks[i].chunk->size();
     }
 
+    // (overwriter id, overwritten id, offset)
+    std::vector<std::array<size_t, 3>> overwrite_specs;
     for (auto &&i: m_writable_fwd_mem_plans) {
-        auto from_iter = chunk2allocatorid.find(&i.first->chunk()),
-             to_iter = chunk2allocatorid.find(&i.second->chunk());
+        auto from_iter = chunk2id.find(&i.first->chunk()),
+             to_iter = chunk2id.find(&i.second->chunk());
 
         // ignore mem fwd specs that involve other chunks
-        if (from_iter != chunk2allocatorid.end() &&
-                to_iter != chunk2allocatorid.end()) {
-
-            allocator->add_overwrite_spec(to_iter->second, from_iter->second,
-                    i.first->offset_in_chunk_byte());
+        if (from_iter != chunk2id.end() && to_iter != chunk2id.end()) {
+            overwrite_specs.push_back({to_iter->second, from_iter->second,
+                    i.first->offset_in_chunk_byte()});
         }
     }
     {
-        decltype(chunk2allocatorid) v;
-        chunk2allocatorid.swap(v);
+        decltype(chunk2id) v;
+        chunk2id.swap(v);
     }
 
-    allocator->solve();
-    size_t size = allocator->tot_alloc(),
-           size_lb = allocator->tot_alloc_lower_bound();
+    auto solve = [&](Algo algo) {
+        auto allocator = StaticMemAlloc::make(algo);
+        allocator->alignment(comp_node.get_mem_addr_alignment());
+        allocator->padding(comp_node.get_mem_padding());
+#if MGB_ENABLE_DEBUG_UTIL
+        allocator->dbg_key2varnode = [](StaticMemAlloc::UserKeyType key) {
+            return static_cast<const MemChunkLifeInterval*>(key)
+                    ->chunk->owner_var;
+        };
+#endif
+        for (auto &&chk: chunks) {
+            allocator->add(chk.begin, chk.end, chk.chunk->size(), &chk);
+        }
+        for (auto &&i: overwrite_specs) {
+            allocator->add_overwrite_spec(i[0], i[1], i[2]);
+        }
+        allocator->solve();
+
+        Plan plan;
+        plan.tot_alloc = allocator->tot_alloc();
+        plan.tot_alloc_lower_bound = allocator->tot_alloc_lower_bound();
+        plan.offsets.reserve(chunks.size());
+        for (auto &&chk: chunks) {
+            plan.offsets.push_back(allocator->get_start_addr(&chk));
+        }
+        return plan;
+    };
+
+    auto &&opt = m_graph->options().seq_opt;
+    bool parallel = opt.enable_parallel_static_mem_alloc;
+
+    auto solve_best = [&]() {
+        if (!parallel) {
+            return solve(Algo::PUSHDOWN);
+        }
+#if MGB_HAVE_THREAD
+        constexpr auto policy = std::launch::async;
+#else
+        constexpr auto policy = std::launch::deferred;
+#endif
+        auto interval_move = std::async(policy, solve, Algo::INTERVAL_MOVE),
+             best_fit = std::async(policy, solve, Algo::BEST_FIT);
+        Plan best = solve(Algo::PUSHDOWN);
+        for (auto fut: {&interval_move, &best_fit}) {
+            Plan cur = fut->get();
+            if (cur.tot_alloc < best.tot_alloc) {
+                best = std::move(cur);
+            }
+        }
+        return best;
+    };
+
+    Plan uncached_plan;
+    const Plan *plan = nullptr;
+    bool plan_cache_hit = false;
+    if (opt.static_mem_plan_cache_size) {
+        StaticMemPlanCache::Key key{parallel, comp_node.get_mem_addr_alignment(),
+            comp_node.get_mem_padding(), chunks.size()};
+        key.reserve(key.size() + chunks.size() * 3 +
+                overwrite_specs.size() * 3);
+        for (auto &&chk: chunks) {
+            key.insert(key.end(), {chk.begin, chk.end, chk.chunk->size()});
+        }
+        for (auto &&i: overwrite_specs) {
+            key.insert(key.end(), i.begin(), i.end());
+        }
+        plan = m_static_mem_plan_cache->get(key);
+        plan_cache_hit = plan != nullptr;
+        if (!plan) {
+            plan = &m_static_mem_plan_cache->put(std::move(key), solve_best(),
+                    opt.static_mem_plan_cache_size);
+        }
+    } else {
+        uncached_plan = solve_best();
+        plan = &uncached_plan;
+    }
 
-    static_mem_alloc_logger.push(comp_node, size, size_lb, size_ub);
+    size_t size = plan->tot_alloc;
+    static_mem_alloc_logger.push(comp_node, size, plan->tot_alloc_lower_bound,
+            size_ub);
 
     bool should_realloc = false;
     m_graph->event().signal_inplace<event::StaticMemAlloc>(
-            &should_realloc, comp_node, size);
+            &should_realloc, comp_node, size, plan_cache_hit);
 
     if (!should_realloc) {
         m_static_mem_usage.val()[comp_node] = size;
-        for (auto&& chk : chunks) {
-            chk.chunk->mem_alloc_status.set_static_offset(
-                    allocator->get_start_addr(&chk));
+        for (size_t i = 0; i < chunks.size(); ++ i) {
+            chunks[i].chunk->mem_alloc_status.set_static_offset(
+                    plan->offsets[i]);
         }
     }
 
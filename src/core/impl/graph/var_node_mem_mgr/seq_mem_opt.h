@@ -23,6 +23,7 @@ namespace cg {
  */
 class SeqMemOptimizer {
     class StaticMemAllocLogger;
+    class StaticMemPlanCache;
 
     /*!
      * \brief life interval for a memory chunk
@@ -48,6 +49,9 @@ class SeqMemOptimizer {
     std::vector<std::pair<MemAllocPlan*, MemAllocPlan*>>
         m_writable_fwd_mem_plans;
 
+    //! static allocation plans reused across shape changes
+    std::unique_ptr<StaticMemPlanCache> m_static_mem_plan_cache;
+
     bool should_static_alloc_var(VarNode *var);
 
     bool in_sys_alloc(OperatorNodeBase *opr) const {
@@ -63,9 +67,8 @@ class SeqMemOptimizer {
             StaticMemAllocLogger &static_mem_alloc_logger);
 
     public:
-        SeqMemOptimizer(ComputingGraphImpl *graph):
-            m_graph(graph)
-        {}
+        SeqMemOptimizer(ComputingGraphImpl *graph);
+        ~SeqMemOptimizer() noexcept;
 
         /*!
          * \brief reset the operator sequence to be optimized
@@ -11,10 +11,20 @@
 
 #include "megbrain/utils/persistent_cache.h"
 #include "megbrain/comp_node_env.h"
+#include "megbrain/version.h"
+#include "megdnn/version.h"
 
+#include <cerrno>
 #include <cstdio>
 #include <cstring>
 
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #ifdef WIN32
 #define snprintf _snprintf
 #endif
@@ -141,6 +151,338 @@ std::string PersistentCache::make_category_from_comp_node(CompNode comp_node) {
     }
 }
 
+/* ====================== FilePersistentCache ====================== */
+
+namespace {
+constexpr char FILE_CACHE_MAGIC[8] = {'m', 'g', 'b', 'c', 'a', 'c', 'h', 'e'};
+constexpr uint32_t FILE_CACHE_FORMAT_VERSION = 1;
+//! sanity limit of a single field, to detect corrupted files
+constexpr uint32_t FILE_CACHE_MAX_FIELD_SIZE = 64 * 1024 * 1024;
+
+void append_uint32(std::string& buf, uint32_t v) {
+    buf.append(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+void append_field(std::string& buf, const void* ptr, size_t size) {
+    mgb_assert(size <= FILE_CACHE_MAX_FIELD_SIZE,
+               "persistent cache field too large: %zu", size);
+    append_uint32(buf, size);
+    buf.append(static_cast<const char*>(ptr), size);
+}
+
+std::string make_file_cache_header(const std::string& tag) {
+    std::string ret{FILE_CACHE_MAGIC, sizeof(FILE_CACHE_MAGIC)};
+    append_uint32(ret, FILE_CACHE_FORMAT_VERSION);
+    append_field(ret, tag.data(), tag.size());
+    return ret;
+}
+
+#ifndef WIN32
+void pwrite_all(int fd, const std::string& data, size_t offset,
+                const std::string& path) {
+    size_t done = 0;
+    while (done < data.size()) {
+        auto ret = pwrite(fd, data.data() + done, data.size() - done,
+                          offset + done);
+        if (ret < 0 && errno == EINTR)
+            continue;
+        if (ret <= 0) {
+            mgb_throw(SystemError, "failed to write %s: %s", path.c_str(),
+                      strerror(errno));
+        }
+        done += ret;
+    }
+}
+
+//! read [offset, EOF) of the file
+std::string pread_to_end(int fd, size_t offset, const std::string& path) {
+    struct stat st;
+    mgb_throw_if(fstat(fd, &st), SystemError, "failed to stat %s: %s",
+                 path.c_str(), strerror(errno));
+    std::string ret;
+    if (static_cast<size_t>(st.st_size) <= offset)
+        return ret;
+    ret.resize(st.st_size - offset);
+    size_t done = 0;
+    while (done < ret.size()) {
+        auto nr = pread(fd, &ret[done], ret.size() - done, offset + done);
+        if (nr < 0 && errno == EINTR)
+            continue;
+        mgb_throw_if(nr < 0, SystemError, "failed to read %s: %s",
+                     path.c_str(), strerror(errno));
+        if (!nr)
+            break;
+        done += nr;
+    }
+    ret.resize(done);
+    return ret;
+}
+#endif
+}  // anonymous namespace
+
+//! RAII wrapper of flock(); the cache file is guarded by advisory locks
+class FilePersistentCache::FileLock : public NonCopyableObj {
+    int m_fd;
+
+public:
+    FileLock(int fd, bool exclusive) : m_fd{fd} {
+#ifndef WIN32
+        int ret;
+        do {
+            ret = flock(m_fd, exclusive ? LOCK_EX : LOCK_SH);
+        } while (ret && errno == EINTR);
+        mgb_throw_if(ret, SystemError, "failed to lock cache file: %s",
+                     strerror(errno));
+#endif
+    }
+
+    ~FileLock() {
+#ifndef WIN32
+        flock(m_fd, LOCK_UN);
+#endif
+    }
+};
+
+FilePersistentCache::FilePersistentCache(std::string path,
+                                         const std::string& tag)
+        : m_path{std::move(path)},
+          m_mem_cache{std::make_shared<InMemoryPersistentCache>()} {
+#ifdef WIN32
+    mgb_throw(MegBrainError, "FilePersistentCache is unsupported on windows");
+#else
+    auto header = make_file_cache_header(tag);
+    // the file is never truncated in place, since other processes may have
+    // it open: a file with another tag is replaced by rename(), and the
+    // opening is retried if the file has been replaced by another process
+    // before the lock is acquired
+    for (;;) {
+        m_fd = open(m_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        mgb_throw_if(m_fd < 0, SystemError, "failed to open %s: %s",
+                     m_path.c_str(), strerror(errno));
+        bool retry = false;
+        MGB_TRY {
+            FileLock lock{m_fd, true};
+            bool is_current = is_current_file();
+            std::string cur;
+            if (is_current) {
+                cur = pread_to_end(m_fd, 0, m_path);
+            }
+            if (!is_current) {
+                retry = true;
+            } else if (cur.empty()) {
+                // newly created file, from which no record can be loaded
+                pwrite_all(m_fd, header, 0, m_path);
+            } else if (cur.compare(0, header.size(), header) != 0) {
+                mgb_log_warn(
+                        "persistent cache %s is corrupted or generated by "
+                        "another environment; replace it (expected tag: "
+                        "%s)",
+                        m_path.c_str(), tag.c_str());
+                replace_file(header);
+                retry = true;
+            }
+            if (!retry) {
+                m_loaded_size = header.size();
+                load_new_records();
+            }
+        }
+        MGB_CATCH(..., {
+            close(m_fd);
+            m_fd = -1;
+            throw;
+        });
+        if (!retry) {
+            break;
+        }
+        close(m_fd);
+    }
+#endif
+}
+
+bool FilePersistentCache::is_current_file() const {
+#ifdef WIN32
+    return true;
+#else
+    struct stat st_fd, st_path;
+    mgb_throw_if(fstat(m_fd, &st_fd), SystemError, "failed to stat %s: %s",
+                 m_path.c_str(), strerror(errno));
+    if (stat(m_path.c_str(), &st_path)) {
+        return false;
+    }
+    return st_fd.st_dev == st_path.st_dev && st_fd.st_ino == st_path.st_ino;
+#endif
+}
+
+void FilePersistentCache::replace_file(const std::string& header) {
+#ifndef WIN32
+    auto tmp_path = ssprintf("%s.tmp.%d", m_path.c_str(),
+                             static_cast<int>(getpid()));
+    int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                  0644);
+    mgb_throw_if(fd < 0, SystemError, "failed to open %s: %s",
+                 tmp_path.c_str(), strerror(errno));
+    MGB_TRY { pwrite_all(fd, header, 0, tmp_path); }
+    MGB_CATCH(..., {
+        close(fd);
+        unlink(tmp_path.c_str());
+        throw;
+    });
+    close(fd);
+    if (rename(tmp_path.c_str(), m_path.c_str())) {
+        auto err = errno;
+        unlink(tmp_path.c_str());
+        mgb_throw(SystemError, "failed to rename %s to %s: %s",
+                  tmp_path.c_str(), m_path.c_str(), strerror(err));
+    }
+#endif
+}
+
+FilePersistentCache::~FilePersistentCache() {
+#ifndef WIN32
+    if (m_fd >= 0) {
+        close(m_fd);
+    }
+#endif
+}
+
+bool FilePersistentCache::load_new_records() {
+#ifdef WIN32
+    return true;
+#else
+    auto buf = pread_to_end(m_fd, m_loaded_size, m_path);
+    size_t pos = 0;
+    auto read_field = [&](Blob& dst) {
+        uint32_t size;
+        if (buf.size() - pos < sizeof(size))
+            return false;
+        memcpy(&size, buf.data() + pos, sizeof(size));
+        if (size > FILE_CACHE_MAX_FIELD_SIZE ||
+            buf.size() - pos - sizeof(size) < size)
+            return false;
+        dst.ptr = buf.data() + pos + sizeof(size);
+        dst.size = size;
+        pos += sizeof(size) + size;
+        return true;
+    };
+    size_t nr_record = 0;
+    for (;;) {
+        auto record_begin = pos;
+        Blob category, key, value;
+        if (!read_field(category) || !read_field(key) || !read_field(value)) {
+            pos = record_begin;
+            break;
+        }
+        // existing entries are kept, since blobs returned by get() refer
+        // to them
+        std::string category_str{static_cast<const char*>(category.ptr),
+                                 category.size};
+        if (!m_mem_cache->get(category_str, key).valid()) {
+            m_mem_cache->put(category_str, key, value);
+        }
+        ++nr_record;
+    }
+    m_loaded_size += pos;
+    if (nr_record) {
+        mgb_log_debug("loaded %zu records from persistent cache %s",
+                      nr_record, m_path.c_str());
+    }
+    return pos == buf.size();
+#endif
+}
+
+Maybe<PersistentCache::Blob> FilePersistentCache::get(
+        const std::string& category, const Blob& key) {
+    MGB_LOCK_GUARD(m_mtx);
+    auto ret = m_mem_cache->get(category, key);
+    if (!ret.valid()) {
+        // other processes may have profiled this key since last load
+        FileLock lock{m_fd, false};
+        load_new_records();
+        ret = m_mem_cache->get(category, key);
+    }
+    return ret;
+}
+
+void FilePersistentCache::put(const std::string& category, const Blob& key,
+                              const Blob& value) {
+#ifndef WIN32
+    std::string record;
+    record.reserve(sizeof(uint32_t) * 3 + category.size() + key.size +
+                   value.size);
+    append_field(record, category.data(), category.size());
+    append_field(record, key.ptr, key.size);
+    append_field(record, value.ptr, value.size);
+
+    MGB_LOCK_GUARD(m_mtx);
+    FileLock lock{m_fd, true};
+    if (!load_new_records()) {
+        // drop the partial record left by an interrupted writer; this is
+        // safe with the exclusive lock held, since no process loads
+        // partial records, so only bytes beyond every process's loaded size
+        // are removed
+        mgb_log_warn("drop incomplete record at the end of %s",
+                     m_path.c_str());
+        mgb_throw_if(ftruncate(m_fd, m_loaded_size), SystemError,
+                     "failed to truncate %s: %s", m_path.c_str(),
+                     strerror(errno));
+    }
+    if (m_mem_cache->get(category, key).valid()) {
+        // the first record of a key wins; overwriting it would invalidate
+        // the blobs returned by get()
+        return;
+    }
+    pwrite_all(m_fd, record, m_loaded_size, m_path);
+    m_loaded_size += record.size();
+    m_mem_cache->put(category, key, value);
+#endif
+}
+
+std::string FilePersistentCache::default_tag() {
+    auto mgb_ver = get_version();
+    auto dnn_ver = megdnn::get_version();
+    auto ret = ssprintf("mgb=%d.%d.%d;megdnn=%d.%d.%d;arch=", mgb_ver.major,
+                        mgb_ver.minor, mgb_ver.patch, dnn_ver.major,
+                        dnn_ver.minor, dnn_ver.patch);
+#if defined(__x86_64__) || defined(_M_X64)
+    ret.append("x86_64");
+#elif defined(__i386__) || defined(_M_IX86)
+    ret.append("x86");
+#elif defined(__aarch64__)
+    ret.append("aarch64");
+#elif defined(__arm__)
+    ret.append("armv7");
+#else
+    ret.append("unknown");
+#endif
+    ret.append(";cpu=");
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+    __builtin_cpu_init();
+#define CHECK(feature)                      \
+    if (__builtin_cpu_supports(feature)) { \
+        ret.append(feature ",");            \
+    }
+    CHECK("sse4.2");
+    CHECK("avx");
+    CHECK("fma");
+    CHECK("avx2");
+    CHECK("avx512f");
+    CHECK("avx512vl");
+    CHECK("avx512bw");
+#undef CHECK
+#else
+#if defined(__ARM_FEATURE_DOTPROD)
+    ret.append("dotprod,");
+#endif
+#if defined(__ARM_FEATURE_FP16_VECTOR_ARITHMETIC)
+    ret.append("fp16,");
+#endif
+#endif
+    if (ret.back() == ',') {
+        ret.pop_back();
+    }
+    return ret;
+}
+
 AlgoChooserProfileCache::AlgoChooserProfileCache(
         CompNode cn, const char *opr_type) {
     m_category = "profile:";
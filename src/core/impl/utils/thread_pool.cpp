@@ -10,11 +10,188 @@
  */
 
 #include "megbrain/utils/thread_pool.h"
+#include "megbrain/utils/trace_event.h"
+#include <algorithm>
 #include <chrono>
+#include <limits>
 
 using namespace mgb;
 
+#ifndef IOS
+namespace {
+thread_local TaskPriority tl_task_priority = TaskPriority::LATENCY_CRITICAL;
+}  // anonymous namespace
+
+TaskPriority mgb::get_thread_task_priority() {
+    return tl_task_priority;
+}
+
+void mgb::set_thread_task_priority(TaskPriority priority) {
+    tl_task_priority = priority;
+}
+#else
+#include <pthread.h>
+
+namespace {
+//! thread_local is not supported on IOS (see comp_node/cpu/comp_node.cpp),
+//! so the priority is kept in pthread thread-specific data; an unset value
+//! reads as nullptr, i.e. LATENCY_CRITICAL
+pthread_key_t task_priority_key() {
+    static pthread_key_t key = []() {
+        pthread_key_t ret;
+        mgb_assert(!pthread_key_create(&ret, nullptr),
+                   "failed to create pthread key for task priority");
+        return ret;
+    }();
+    return key;
+}
+}  // anonymous namespace
+
+TaskPriority mgb::get_thread_task_priority() {
+    return static_cast<TaskPriority>(reinterpret_cast<uintptr_t>(
+            pthread_getspecific(task_priority_key())));
+}
+
+void mgb::set_thread_task_priority(TaskPriority priority) {
+    pthread_setspecific(task_priority_key(),
+                        reinterpret_cast<void*>(
+                                static_cast<uintptr_t>(priority)));
+}
+#endif
+
 #if MGB_HAVE_THREAD
+namespace {
+//! number of polls an idle worker makes before blocking on the cv
+size_t spin_count() {
+    static size_t count = []() -> size_t {
+        if (auto env = MGB_GETENV("MGB_THREAD_POOL_SPIN")) {
+            return std::stoul(env);
+        }
+        return 1 << 14;
+    }();
+    return count;
+}
+
+inline void cpu_relax() {
+#if defined(__i386__) || defined(__x86_64__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+//! a half-open range [begin, end) of sub task ids packed into 64 bits
+inline uint64_t pack_range(uint64_t begin, uint64_t end) {
+    return (begin << 32) | end;
+}
+inline uint64_t range_begin(uint64_t range) {
+    return range >> 32;
+}
+inline uint64_t range_end(uint64_t range) {
+    return range & 0xFFFFFFFFu;
+}
+}  // anonymous namespace
+
+/*!
+ * \brief sub tasks of one add_task() call
+ *
+ * The range of slot i is popped from the front by the thread with id i and
+ * stolen from the back by other threads, both through CAS.
+ */
+struct ThreadPool::TaskGroup {
+    struct Slot {
+        std::atomic<uint64_t> range{0};
+        //! avoid false sharing between the slots
+        char padding[64 - sizeof(std::atomic<uint64_t>)];
+    };
+
+    const TaskElem& task_elem;
+    const TaskPriority priority;
+    const size_t nr_slots;
+    std::unique_ptr<Slot[]> slots;
+    //! number of sub tasks not finished yet
+    std::atomic_size_t nr_unfinished;
+    //! number of worker threads referencing this group
+    std::atomic_size_t nr_users{0};
+
+    TaskGroup(const TaskElem& elem, TaskPriority prio, size_t nr_threads)
+            : task_elem{elem},
+              priority{prio},
+              nr_slots{nr_threads},
+              slots{new Slot[nr_threads]},
+              nr_unfinished{elem.nr_parallelism} {
+        size_t nr_task = elem.nr_parallelism;
+        mgb_assert(nr_task <= std::numeric_limits<uint32_t>::max(),
+                   "too many sub tasks: %zu", nr_task);
+        for (size_t i = 0; i < nr_slots; ++i) {
+            slots[i].range.store(pack_range(nr_task * i / nr_slots,
+                                            nr_task * (i + 1) / nr_slots),
+                                 std::memory_order_relaxed);
+        }
+    }
+
+    bool has_pending() const {
+        for (size_t i = 0; i < nr_slots; ++i) {
+            auto range = slots[i].range.load(std::memory_order_relaxed);
+            if (range_begin(range) < range_end(range)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    //! pop one sub task from the front of the slot
+    bool pop(size_t slot, size_t& index) {
+        auto&& dest = slots[slot].range;
+        auto range = dest.load(std::memory_order_acquire);
+        while (range_begin(range) < range_end(range)) {
+            auto begin = range_begin(range);
+            if (dest.compare_exchange_weak(range,
+                                           pack_range(begin + 1,
+                                                      range_end(range)),
+                                           std::memory_order_acq_rel)) {
+                index = begin;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    //! steal the back half of the range of another slot into the slot of
+    //! the thief, and return the first stolen sub task
+    bool steal(size_t thief, size_t& index) {
+        for (size_t off = 1; off < nr_slots; ++off) {
+            auto&& victim = slots[(thief + off) % nr_slots].range;
+            auto range = victim.load(std::memory_order_acquire);
+            while (range_begin(range) < range_end(range)) {
+                auto begin = range_begin(range), end = range_end(range),
+                     mid = end - (end - begin + 1) / 2;
+                if (victim.compare_exchange_weak(range, pack_range(begin, mid),
+                                                 std::memory_order_acq_rel)) {
+                    //! the slot of the thief is empty and only the thief
+                    //! could fill it
+                    slots[thief].range.store(pack_range(mid + 1, end),
+                                             std::memory_order_release);
+                    index = mid;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    //! claim all the remaining sub tasks without running them
+    void cancel() {
+        for (size_t i = 0; i < nr_slots; ++i) {
+            auto range = slots[i].range.exchange(0, std::memory_order_acq_rel);
+            if (range_begin(range) < range_end(range)) {
+                nr_unfinished.fetch_sub(range_end(range) - range_begin(range),
+                                        std::memory_order_acq_rel);
+            }
+        }
+    }
+};
+
 ThreadPool::ThreadPool(size_t threads_num)
         : m_nr_threads(threads_num),
           m_main_affinity_flag{false},
@@ -27,56 +204,132 @@ ThreadPool::ThreadPool(size_t threads_num)
                     "physical cpu cores, got: %zu core_number: %zu",
                     static_cast<size_t>(sys::get_cpu_count()), nr_threads());
         }
+        //! the workers wait on m_mutex until all of them are created
+        MGB_LOCK_GUARD(m_mutex);
+        m_workers.reserve(m_nr_threads - 1);
         for (uint32_t i = 0; i < m_nr_threads - 1; i++) {
-            m_workers.push_back(new Worker([this, i]() {
-                while (!m_stop) {
-                    while (m_active) {
-                        if (m_workers[i]->affinity_flag &&
-                            m_core_binding_function != nullptr) {
-                            m_core_binding_function(i);
-                            m_workers[i]->affinity_flag = false;
-                        }
-                        //! if the thread should work
-                        if (m_workers[i]->work_flag.load(
-                                    std::memory_order_acquire)) {
-                            int index = -1;
-                            //! Get one task and execute
-                            while ((index = m_task_iter.fetch_sub(
-                                            1, std::memory_order_acq_rel)) &&
-                                   index > 0) {
-                                //! index is decrease, use
-                                //! m_all_task_number - index to get the
-                                //! increase id which will pass to task
-                                m_task(static_cast<size_t>(m_nr_parallelism -
-                                                           index),
-                                       i);
-                            }
-                            //! Flag worker is finished
-                            m_workers[i]->work_flag.store(
-                                    false, std::memory_order_release);
-                        }
-                        //! Wait next task coming
-                        std::this_thread::yield();
-                    }
-                    {
-                        std::unique_lock<std::mutex> lock(m_mutex);
-                        if (!m_stop && !m_active) {
-                            m_cv.wait(lock,
-                                      [this] { return m_stop || m_active; });
-                        }
-                    }
+            m_workers.push_back(new Worker([this, i]() { worker_loop(i); }));
+        }
+    }
+}
+
+void ThreadPool::worker_loop(size_t id) {
+    { MGB_LOCK_GUARD(m_mutex); }
+    auto worker = m_workers[id];
+    size_t nr_idle = 0;
+    //! the version of the last scan that found nothing to run; no task can
+    //! become claimable until the version changes
+    size_t idle_version = m_version.load() - 1;
+    while (!m_stop.load(std::memory_order_acquire)) {
+        if (worker->affinity_flag.load(std::memory_order_acquire) &&
+            m_core_binding_function != nullptr) {
+            m_core_binding_function(id);
+            worker->affinity_flag.store(false, std::memory_order_release);
+        }
+        auto version = m_version.load(std::memory_order_acquire);
+        if (version != idle_version) {
+            if (try_run_any(id)) {
+                nr_idle = 0;
+                continue;
+            }
+            idle_version = version;
+        }
+        //! spin for a while before sleeping if the pool is active
+        if (m_active.load(std::memory_order_relaxed) &&
+            ++nr_idle < spin_count()) {
+            cpu_relax();
+            continue;
+        }
+        nr_idle = 0;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_nr_sleeping.fetch_add(1);
+        m_cv.wait(lock, [this, version] {
+            return m_stop || m_version.load() != version;
+        });
+        m_nr_sleeping.fetch_sub(1);
+    }
+}
+
+bool ThreadPool::try_run_any(size_t id) {
+    if (!m_nr_groups.load(std::memory_order_acquire)) {
+        return false;
+    }
+    TaskGroup* group = nullptr;
+    {
+        MGB_LOCK_GUARD(m_mutex_group);
+        for (auto i : m_groups) {
+            if (i->has_pending() &&
+                (!group || i->priority < group->priority)) {
+                group = i;
+                if (group->priority == TaskPriority::LATENCY_CRITICAL) {
+                    break;
                 }
-            }));
+            }
+        }
+        if (group) {
+            group->nr_users.fetch_add(1, std::memory_order_relaxed);
         }
     }
+    if (!group) {
+        return false;
+    }
+    run_group(*group, id, false);
+    group->nr_users.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+bool ThreadPool::should_yield(const TaskGroup& group) const {
+    return group.priority != TaskPriority::LATENCY_CRITICAL &&
+           m_nr_urgent_groups.load(std::memory_order_acquire);
 }
+
+void ThreadPool::run_group(TaskGroup& group, size_t id, bool is_caller) {
+    //! nested tasks inherit the priority of the group
+    TaskPriorityGuard priority_guard{group.priority};
+    bool trace = TraceEventRecorder::enabled();
+    double trace_begin = trace ? TraceEventRecorder::now() : 0;
+    size_t index, nr_run = 0;
+    while (group.pop(id, index) || group.steal(id, index)) {
+        MGB_TRY { group.task_elem.task(index, id); }
+        MGB_FINALLY(
+                group.nr_unfinished.fetch_sub(1, std::memory_order_acq_rel));
+        ++nr_run;
+        //! preempt at sub task boundary: workers go to serve the urgent
+        //! groups and the caller waits for them, since the caller can only
+        //! run its own group
+        if (should_yield(group)) {
+            if (!is_caller) {
+                break;
+            }
+            while (should_yield(group)) {
+                std::this_thread::yield();
+            }
+        }
+    }
+    //! one span for all the sub tasks of the group run by this thread
+    if (trace && nr_run) {
+        TraceEventRecorder::inst().add_span(
+                "thread_pool", is_caller ? "caller" : "worker", trace_begin,
+                TraceEventRecorder::now(),
+                {{"sub_tasks", nr_run},
+                 {"priority", static_cast<int>(group.priority)}});
+    }
+}
+
 void ThreadPool::add_task(const TaskElem& task_elem) {
+    //! the priority is carried by the task, which may be created on another
+    //! thread (e.g. forwarded by a comp node worker queue); kernels nested
+    //! in the task inherit it
+    auto priority = task_elem.priority;
+    TaskPriorityGuard priority_guard{priority};
     //! Make sure the main thread have bind
-    if (m_main_affinity_flag &&
+    if (m_main_affinity_flag.load(std::memory_order_acquire) &&
         m_core_binding_function != nullptr) {
         std::lock_guard<std::mutex> lock(m_mutex_task);
-        m_core_binding_function(m_nr_threads - 1);
-        m_main_affinity_flag = false;
+        if (m_main_affinity_flag) {
+            m_core_binding_function(m_nr_threads - 1);
+            m_main_affinity_flag = false;
+        }
     }
     size_t parallelism = task_elem.nr_parallelism;
     //! If only one thread or one task, execute directly
@@ -85,31 +338,57 @@ void ThreadPool::add_task(const TaskElem& task_elem) {
             task_elem.task(i, 0);
         }
         return;
-    } else {
-        std::lock_guard<std::mutex> lock(m_mutex_task);
-        mgb_assert(m_task_iter.load(std::memory_order_acquire) <= 0,
-                   "The init value of m_all_sub_task is not zero.");
-        active();
-        //! Set the task number, task iter and task
-        m_nr_parallelism = parallelism;
-        m_task_iter.exchange(parallelism, std::memory_order_relaxed);
-        m_task = [&task_elem](size_t index, size_t thread_id) {
-            task_elem.task(index, thread_id);
-        };
-        //! Set flag to start thread working
-        for (uint32_t i = 0; i < m_nr_threads - 1; i++) {
-            m_workers[i]->work_flag = true;
-        }
-        //! Main thread working
-        int index = -1;
-        while ((index = m_task_iter.fetch_sub(1, std::memory_order_acq_rel)) &&
-               (index > 0)) {
-            m_task(static_cast<size_t>(m_nr_parallelism - index),
-                   m_nr_threads - 1);
+    }
+    bool urgent = priority == TaskPriority::LATENCY_CRITICAL;
+    //! BATCH kernels do not start before urgent ones finish
+    while (!urgent && m_nr_urgent_groups.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+    active();
+    TaskGroup group{task_elem, priority, m_nr_threads};
+    {
+        MGB_LOCK_GUARD(m_mutex_group);
+        m_groups.push_back(&group);
+        m_nr_groups.fetch_add(1);
+        if (urgent) {
+            m_nr_urgent_groups.fetch_add(1);
         }
-        //! make sure all threads done
-        sync();
     }
+    m_version.fetch_add(1);
+    if (m_nr_sleeping.load()) {
+        MGB_LOCK_GUARD(m_mutex);
+        m_cv.notify_all();
+    }
+    auto finish = [&]() {
+        {
+            MGB_LOCK_GUARD(m_mutex_group);
+            m_groups.erase(std::find(m_groups.begin(), m_groups.end(), &group));
+            m_nr_groups.fetch_sub(1);
+        }
+        if (urgent) {
+            //! decreased after all the sub tasks finished, so that the
+            //! remaining workers keep away from the BATCH groups
+            while (group.nr_unfinished.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            m_nr_urgent_groups.fetch_sub(1);
+        }
+        //! make sure all threads done and no one refers to the group
+        while (group.nr_unfinished.load(std::memory_order_acquire) ||
+               group.nr_users.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+    };
+    //! the caller only runs sub tasks of its own group, so nested add_task
+    //! from a task can not deadlock or reuse a thread id inside the group
+    MGB_TRY { run_group(group, m_nr_threads - 1, true); }
+    MGB_CATCH(..., {
+        //! drop the unclaimed sub tasks
+        group.cancel();
+        finish();
+        throw;
+    });
+    finish();
 }
 
 void ThreadPool::set_affinity(AffinityCallBack affinity_cb) {
@@ -120,6 +399,10 @@ void ThreadPool::set_affinity(AffinityCallBack affinity_cb) {
         m_workers[i]->affinity_flag = true;
     }
     m_main_affinity_flag = true;
+    //! wake up the sleeping workers to bind themselves
+    m_version.fetch_add(1);
+    std::unique_lock<std::mutex> lock_cv(m_mutex);
+    m_cv.notify_all();
 }
 
 size_t ThreadPool::nr_threads() const {
@@ -127,34 +410,23 @@ size_t ThreadPool::nr_threads() const {
 }
 
 void ThreadPool::sync() {
-    bool no_finished = false;
-    do {
-        no_finished = false;
-        for (uint32_t i = 0; i < m_nr_threads - 1; ++i) {
-            if (m_workers[i]->work_flag) {
-                no_finished = true;
-                break;
-            }
-        }
-        if (no_finished) {
-            std::this_thread::yield();
-        }
-    } while (no_finished);
+    while (m_nr_groups.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
 }
 void ThreadPool::active() {
     if (!m_active) {
         std::unique_lock<std::mutex> lock(m_mutex);
         m_active = true;
+        m_version.fetch_add(1);
         m_cv.notify_all();
     }
 }
 void ThreadPool::deactive() {
-    std::lock_guard<std::mutex> lock_task(m_mutex_task);
-    std::unique_lock<std::mutex> lock(m_mutex);
     m_active = false;
 }
 ThreadPool::~ThreadPool() {
-    std::lock_guard<std::mutex> lock_task(m_mutex_task);
+    sync();
     {
         std::unique_lock<std::mutex> lock(m_mutex);
         m_stop = true;
@@ -0,0 +1,316 @@
+/**
+ * \file src/core/impl/utils/trace_event.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "megbrain/utils/trace_event.h"
+#include "megbrain/system.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+#ifdef IOS
+#include <pthread.h>
+#endif
+
+using namespace mgb;
+
+namespace {
+
+//! size of a thread buffer that triggers writing to the file
+constexpr size_t FLUSH_SIZE = 1 << 20;
+
+int process_id() {
+    static int pid = getpid();
+    return pid;
+}
+
+void append_escaped(std::string& dst, const std::string& src) {
+    for (char ch : src) {
+        switch (ch) {
+            case '"':
+                dst += "\\\"";
+                break;
+            case '\\':
+                dst += "\\\\";
+                break;
+            case '\n':
+                dst += "\\n";
+                break;
+            case '\t':
+                dst += "\\t";
+                break;
+            default:
+                if (static_cast<unsigned char>(ch) < 0x20) {
+                    dst += ssprintf("\\u%04x", ch);
+                } else {
+                    dst += ch;
+                }
+        }
+    }
+}
+
+void append_args(std::string& dst, const TraceEventRecorder::Args& args) {
+    if (args.empty()) {
+        return;
+    }
+    dst += ",\"args\":{";
+    for (size_t i = 0; i < args.size(); ++i) {
+        if (i) {
+            dst += ',';
+        }
+        dst += ssprintf("\"%s\":%.15g", args[i].first, args[i].second);
+    }
+    dst += '}';
+}
+
+}  // anonymous namespace
+
+/*!
+ * The buffer is referenced by m_buffers and by the owner thread, so it can be
+ * dropped by stop() once the thread has exited
+ */
+struct TraceEventRecorder::ThreadBuffer {
+    std::mutex mtx;
+    std::string data;
+    uint64_t track;
+};
+
+std::atomic_bool TraceEventRecorder::sm_enabled{false};
+
+TraceEventRecorder& TraceEventRecorder::inst() {
+    // never destroyed, since worker threads may record events during static
+    // destruction
+    static TraceEventRecorder* inst = []() {
+        auto ret = new TraceEventRecorder;
+        if (auto fpath = MGB_GETENV("MGB_TRACE_EVENT_FILE")) {
+            ret->start(fpath);
+            std::atexit([]() { TraceEventRecorder::inst().stop(); });
+        }
+        return ret;
+    }();
+    return *inst;
+}
+
+double TraceEventRecorder::now() {
+    using namespace std::chrono;
+    static const auto epoch = steady_clock::now();
+    return duration<double, std::micro>(steady_clock::now() - epoch).count();
+}
+
+void TraceEventRecorder::start(const std::string& fpath) {
+    stop();
+    MGB_LOCK_GUARD(m_mtx);
+    m_fout = fopen(fpath.c_str(), "w");
+    mgb_throw_if(!m_fout, SystemError, "failed to open %s: %s", fpath.c_str(),
+                 strerror(errno));
+    fputs("{\"traceEvents\":[\n", m_fout);
+    // drop the events added after last stop()
+    for (auto&& i : m_buffers) {
+        MGB_LOCK_GUARD(i->mtx);
+        i->data.clear();
+    }
+    m_counters.clear();
+    for (size_t i = 0; i < m_track_names.size(); ++i) {
+        write_track_name(i);
+    }
+    sm_enabled.store(true);
+}
+
+void TraceEventRecorder::stop() {
+    sm_enabled.store(false);
+    MGB_LOCK_GUARD(m_mtx);
+    if (!m_fout) {
+        return;
+    }
+    for (auto&& i : m_buffers) {
+        MGB_LOCK_GUARD(i->mtx);
+        fwrite(i->data.data(), 1, i->data.size(), m_fout);
+        i->data.clear();
+    }
+    // buffers only referenced here belong to exited threads
+    m_buffers.erase(
+            std::remove_if(m_buffers.begin(), m_buffers.end(),
+                           [](const std::shared_ptr<ThreadBuffer>& buf) {
+                               return buf.use_count() == 1;
+                           }),
+            m_buffers.end());
+    // the last event must not be followed by a comma
+    fprintf(m_fout,
+            "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":%d,"
+            "\"args\":{\"name\":\"megbrain\"}}\n]}\n",
+            process_id());
+    fclose(m_fout);
+    m_fout = nullptr;
+}
+
+TraceEventRecorder::ThreadBuffer& TraceEventRecorder::thread_buffer() {
+#ifndef IOS
+    thread_local std::shared_ptr<ThreadBuffer> buf;
+#else
+    //! thread_local is not supported on IOS, so the reference of the thread
+    //! is kept in pthread thread-specific data, released at thread exit
+    static pthread_key_t key = []() {
+        pthread_key_t ret;
+        mgb_assert(!pthread_key_create(&ret,
+                                       [](void* ptr) {
+                                           delete static_cast<std::shared_ptr<
+                                                   ThreadBuffer>*>(ptr);
+                                       }),
+                   "failed to create pthread key for trace event buffer");
+        return ret;
+    }();
+    auto buf_ptr =
+            static_cast<std::shared_ptr<ThreadBuffer>*>(pthread_getspecific(key));
+    if (!buf_ptr) {
+        buf_ptr = new std::shared_ptr<ThreadBuffer>;
+        pthread_setspecific(key, buf_ptr);
+    }
+    auto&& buf = *buf_ptr;
+#endif
+    if (buf) {
+        return *buf;
+    }
+    MGB_LOCK_GUARD(m_mtx);
+    buf = std::make_shared<ThreadBuffer>();
+    auto tid = std::this_thread::get_id();
+    auto iter = m_thread2track.find(tid);
+    if (iter == m_thread2track.end()) {
+        iter = m_thread2track.emplace(tid, new_track(sys::get_thread_name()))
+                       .first;
+    }
+    buf->track = iter->second;
+    m_buffers.push_back(buf);
+    return *buf;
+}
+
+uint64_t TraceEventRecorder::thread_track_id() {
+    return thread_buffer().track;
+}
+
+uint64_t TraceEventRecorder::thread_track_id(std::thread::id tid) {
+    MGB_LOCK_GUARD(m_mtx);
+    auto iter = m_thread2track.find(tid);
+    if (iter == m_thread2track.end()) {
+        iter = m_thread2track.emplace(tid, new_track(sys::get_thread_name(tid)))
+                       .first;
+    }
+    return iter->second;
+}
+
+uint64_t TraceEventRecorder::track_id(const std::string& name) {
+    MGB_LOCK_GUARD(m_mtx);
+    auto iter = m_name2track.find(name);
+    if (iter == m_name2track.end()) {
+        iter = m_name2track.emplace(name, new_track(name)).first;
+    }
+    return iter->second;
+}
+
+uint64_t TraceEventRecorder::new_track(const std::string& name) {
+    uint64_t ret = m_track_names.size();
+    m_track_names.push_back(name);
+    if (m_fout) {
+        write_track_name(ret);
+    }
+    return ret;
+}
+
+void TraceEventRecorder::write_track_name(uint64_t track) {
+    std::string str = ssprintf(
+            "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%d,"
+            "\"tid\":%llu,\"args\":{\"name\":\"",
+            process_id(), static_cast<unsigned long long>(track));
+    append_escaped(str, m_track_names[track]);
+    str += "\"}},\n";
+    fwrite(str.data(), 1, str.size(), m_fout);
+}
+
+void TraceEventRecorder::add_event(const std::string& event) {
+    auto&& buf = thread_buffer();
+    std::string data;
+    {
+        MGB_LOCK_GUARD(buf.mtx);
+        buf.data += event;
+        buf.data += ",\n";
+        if (buf.data.size() < FLUSH_SIZE) {
+            return;
+        }
+        data.swap(buf.data);
+    }
+    MGB_LOCK_GUARD(m_mtx);
+    if (m_fout) {
+        fwrite(data.data(), 1, data.size(), m_fout);
+    }
+}
+
+void TraceEventRecorder::add_span(uint64_t track, const char* cat,
+                                  const std::string& name, double begin,
+                                  double end, const Args& args) {
+    std::string str = ssprintf("{\"ph\":\"X\",\"cat\":\"%s\",\"name\":\"", cat);
+    append_escaped(str, name);
+    str += ssprintf("\",\"pid\":%d,\"tid\":%llu,\"ts\":%.3f,\"dur\":%.3f",
+                    process_id(), static_cast<unsigned long long>(track),
+                    begin, std::max(end - begin, 0.));
+    append_args(str, args);
+    str += '}';
+    add_event(str);
+}
+
+void TraceEventRecorder::add_instant(const char* cat, const std::string& name,
+                                     const Args& args) {
+    std::string str = ssprintf(
+            "{\"ph\":\"i\",\"s\":\"t\",\"cat\":\"%s\",\"name\":\"", cat);
+    append_escaped(str, name);
+    str += ssprintf("\",\"pid\":%d,\"tid\":%llu,\"ts\":%.3f", process_id(),
+                    static_cast<unsigned long long>(thread_track_id()), now());
+    append_args(str, args);
+    str += '}';
+    add_event(str);
+}
+
+void TraceEventRecorder::update_counter(const std::string& name,
+                                        const char* series, double delta) {
+    double value;
+    {
+        MGB_LOCK_GUARD(m_mtx);
+        value = (m_counters[name + '/' + series] += delta);
+    }
+    write_counter(name, series, value);
+}
+
+void TraceEventRecorder::set_counter(const std::string& name,
+                                     const char* series, double value) {
+    {
+        MGB_LOCK_GUARD(m_mtx);
+        m_counters[name + '/' + series] = value;
+    }
+    write_counter(name, series, value);
+}
+
+void TraceEventRecorder::write_counter(const std::string& name,
+                                       const char* series, double value) {
+    std::string str = "{\"ph\":\"C\",\"name\":\"";
+    append_escaped(str, name);
+    str += ssprintf("\",\"pid\":%d,\"ts\":%.3f", process_id(), now());
+    append_args(str, {{series, value}});
+    str += '}';
+    add_event(str);
+}
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
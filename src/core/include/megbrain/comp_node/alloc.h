@@ -382,6 +382,60 @@ public:
     };
 };
 
+/* ===================== SizeClassCachingAlloc ===================== */
+/*!
+ * \brief caching allocator for host memory, mainly used by CPU comp nodes
+ *
+ * Requests not larger than the arena size are rounded up to size classes (four
+ * classes between consecutive powers of two), so blocks freed by tensors of
+ * similar sizes can be reused. Memory is obtained from the raw allocator in
+ * arenas of at least arena_size bytes, and arenas that become completely free
+ * are returned to the raw allocator when the cached free memory exceeds
+ * max_cached_size or trim() is called.
+ */
+class SizeClassCachingAlloc : virtual public MemAllocBase {
+public:
+    struct Config {
+        size_t alignment = 64;
+        //! min size of memory chunks requested from raw allocator
+        size_t arena_size = 2 * 1024 * 1024;
+        //! free arenas are released if cached free memory exceeds this size
+        size_t max_cached_size = 256 * 1024 * 1024;
+    };
+
+    struct Stat {
+        size_t nr_alloc = 0;        //!< number of alloc() calls
+        size_t nr_raw_alloc = 0;    //!< number of arenas allocated
+        size_t nr_raw_free = 0;     //!< number of arenas released
+        size_t reserved = 0;        //!< size of all arenas currently held
+        size_t peak_reserved = 0;   //!< max value of reserved
+    };
+
+    virtual ~SizeClassCachingAlloc() = default;
+
+    static std::unique_ptr<SizeClassCachingAlloc> make(
+            std::unique_ptr<RawAllocator> raw_alloc, const Config& config);
+
+    virtual void* alloc(size_t size) = 0;
+    virtual void free(void* ptr) = 0;
+
+    //! release all completely free arenas; return number of bytes released
+    virtual size_t trim() = 0;
+
+    virtual Stat stat() = 0;
+
+    //! the size actually allocated for a request of given size
+    static size_t size_class(size_t size, size_t alignment);
+};
+
+/*!
+ * \brief the caching allocator shared by all CPU comp nodes
+ *
+ * It is created with the first CPU comp node if env var MGB_CPU_CACHING_ALLOC
+ * is set to a positive size in MiB; return nullptr if it is disabled.
+ */
+SizeClassCachingAlloc* cpu_caching_alloc();
+
 } // mem_alloc
 } // mgb
 
@@ -16,6 +16,7 @@
 #include "megbrain/graph/static_infer.h"
 #include "megbrain/graph/seq_comp_node_opt.h"
 #include "megbrain/utils/event.h"
+#include "megbrain/utils/thread_pool.h"
 #include "megbrain/system.h"
 
 #if MGB_ENABLE_JSON
@@ -326,6 +327,26 @@ class ComputingGraph : public std::enable_shared_from_this<ComputingGraph>,
                 //! whether to enable comp node optimization (e.g. using copy
                 //! stream for I/O operators)
                 bool enable_seq_comp_node_opt = true;
+
+                //! max number of static memory allocation plans cached by
+                //! the allocation problem (which is determined by var
+                //! shapes), so that recurring shapes reuse a previous plan
+                //! without solving it again; 0 to disable the cache
+                size_t static_mem_plan_cache_size = 0;
+
+                //! whether to run all the static memory allocation
+                //! algorithms concurrently and keep the plan with the
+                //! smallest peak usage
+                bool enable_parallel_static_mem_alloc = false;
+
+                //! max number of streams among which independent branches
+                //! are distributed when all oprs are on a single CPU comp
+                //! node with its own worker (i.e. not cpu:default), so
+                //! that branches run concurrently; each stream has its own
+                //! worker thread, and branches are assigned by list
+                //! scheduling with costs given by OprFootprint. 0 or 1 to
+                //! disable
+                size_t cpu_branch_parallelism = 0;
             } seq_opt;
 
             //! graph optimization options
@@ -387,6 +408,14 @@ class ComputingGraph : public std::enable_shared_from_this<ComputingGraph>,
              */
             uint16_t async_exec_level = 1;
 
+            /*!
+             * priority class of the kernels dispatched to cpu thread pools
+             * when executing the compiled function, so latency critical and
+             * batch graphs can share a multithread comp node; see
+             * TaskPriority
+             */
+            TaskPriority cpu_task_priority = TaskPriority::LATENCY_CRITICAL;
+
             //! force dynamic memory alloc for all vars
             bool force_dynamic_alloc = false;
 
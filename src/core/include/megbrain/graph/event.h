@@ -127,6 +127,9 @@ struct StaticMemAlloc {
     bool* need_realloc;
     CompNode comp_node;
     size_t alloc_size;
+    //! whether the plan is reused from the static memory plan cache; see
+    //! ComputingGraph::Options::SeqOpt::static_mem_plan_cache_size
+    bool plan_cache_hit = false;
 
     MGB_TYPEINFO_OBJ_DECL;
 };
@@ -13,6 +13,8 @@
 
 #include "megbrain/tensor.h"
 
+#include <mutex>
+
 namespace mgb {
 
     /*!
@@ -55,6 +57,67 @@ namespace mgb {
             static std::string make_category_from_comp_node(CompNode comp_node);
     };
 
+    /*!
+     * \brief PersistentCache backed by an append-only file, which can be
+     *      shared by multiple concurrent processes
+     *
+     * file format, all integers in local endian:
+     *
+     * header: <magic|char[8]><format_version|uint32_t>
+     *      <tag_size|uint32_t><tag|uint8_t*>
+     *
+     * followed by records: <category_size|uint32_t><category|uint8_t*>
+     *      <key_size|uint32_t><key|uint8_t*><value_size|uint32_t><value|uint8_t*>
+     *
+     * The tag identifies the library versions and host CPU features (see
+     * default_tag()); an existing file with a different tag or a corrupted
+     * header is replaced by a new file through rename(), so processes still
+     * using the old file are not affected. New entries are appended under
+     * an exclusive file lock, and entries appended by other processes are
+     * loaded lazily when a key misses, so profiling results are shared among
+     * workers without explicit dumping. An entry is never overwritten once
+     * present: the first record of a key wins, so blobs returned by get()
+     * stay valid.
+     */
+    class FilePersistentCache final: public PersistentCache {
+        class FileLock;
+
+        const std::string m_path;
+        int m_fd = -1;
+        //! file offset up to which records have been loaded
+        size_t m_loaded_size = 0;
+        std::shared_ptr<PersistentCache> m_mem_cache;
+        std::mutex m_mtx;
+
+        //! load records from m_loaded_size; return whether reached EOF
+        //! cleanly. Must be called with file lock held
+        bool load_new_records();
+
+        //! whether m_fd still refers to the file at m_path
+        bool is_current_file() const;
+
+        //! atomically replace the file at m_path by an empty cache file
+        void replace_file(const std::string &header);
+
+        public:
+            explicit FilePersistentCache(std::string path,
+                    const std::string &tag = default_tag());
+            ~FilePersistentCache();
+
+            Maybe<Blob> get(
+                    const std::string &category, const Blob &key) override;
+
+            void put(const std::string &category,
+                    const Blob &key, const Blob &value) override;
+
+            const std::string& path() const {
+                return m_path;
+            }
+
+            //! tag made of megbrain/megdnn versions and host CPU features
+            static std::string default_tag();
+    };
+
     /*!
      * \brief proxy PersistentCache to be better suited for managing profiling
      *      results of operator impl algorithms
@@ -26,6 +26,41 @@ namespace mgb {
 
 using MultiThreadingTask = thin_function<void(size_t, size_t)>;
 using AffinityCallBack = thin_function<void(size_t)>;
+
+/*!
+ * \brief priority class of the tasks added to ThreadPool
+ *
+ * The priority is recorded in TaskElem::priority from the thread creating the
+ * task, and ThreadPool::add_task() schedules by it; see TaskPriorityGuard.
+ */
+enum class TaskPriority : uint8_t {
+    //! latency sensitive tasks, served before all BATCH tasks
+    LATENCY_CRITICAL = 0,
+    //! throughput oriented tasks, which yield the threads at sub task and
+    //! kernel boundaries when LATENCY_CRITICAL tasks are pending
+    BATCH = 1,
+};
+
+//! get the task priority of the calling thread
+TaskPriority get_thread_task_priority();
+
+//! set the task priority of the calling thread
+void set_thread_task_priority(TaskPriority priority);
+
+/*!
+ * \brief set task priority of the calling thread in the current scope
+ */
+class TaskPriorityGuard : public NonCopyableObj {
+    TaskPriority m_prev;
+
+public:
+    explicit TaskPriorityGuard(TaskPriority priority)
+            : m_prev{get_thread_task_priority()} {
+        set_thread_task_priority(priority);
+    }
+    ~TaskPriorityGuard() { set_thread_task_priority(m_prev); }
+};
+
 /**
  * \brief task element
  */
@@ -34,6 +69,12 @@ struct TaskElem {
     MultiThreadingTask task;
     //! number of the parallelism
     size_t nr_parallelism;
+    //! priority of the thread creating the task, used when the task is
+    //! forwarded to another thread for execution
+    TaskPriority priority = get_thread_task_priority();
+    //! time of dispatching the task if TraceEventRecorder is enabled, or 0;
+    //! set by the dispatcher and used to trace the time waiting in the queue
+    double dispatch_time = 0;
 };
 
 /**
@@ -45,25 +86,43 @@ public:
     ~Worker() {
         thread.join();
     }
-    //! Worker thread
-    std::thread thread;
-    //! Indicate whether the Worker thread need run
-    std::atomic_bool work_flag{false};
     //! Indicate whether the Worker thread have binding core
-    bool affinity_flag{false};
+    std::atomic_bool affinity_flag{false};
+    //! Worker thread, declared last so that the flags above are initialized
+    //! before the thread starts running
+    std::thread thread;
 };
 
 #if MGB_HAVE_THREAD
 /**
  * \brief ThreadPool execute the task in multi-threads(nr_threads>1) mode , it
  * will fallback to single-thread mode if nr_thread is 1.
+ *
+ * Each add_task() call creates a task group whose sub tasks are split into
+ * one contiguous range per thread slot. A thread pops sub tasks from the
+ * front of its own range and steals half of the remaining range of another
+ * slot when its own range is exhausted, so unbalanced tasks are rebalanced
+ * without a global task counter.
+ *
+ * add_task() may be called concurrently from multiple threads (e.g. several
+ * graphs sharing one comp node) and from inside a running task (nested
+ * parallel region); each caller only executes sub tasks of its own group, so
+ * the thread id passed to a task is unique within the group. Idle workers
+ * spin for a while and then block on a condition variable (futex on linux);
+ * the spin count can be set by the MGB_THREAD_POOL_SPIN env var.
+ *
+ * Task groups added with TaskPriority::LATENCY_CRITICAL are served first;
+ * while any of them is running, workers leave BATCH groups after finishing
+ * the current sub task, the callers of BATCH groups pause between sub tasks
+ * and new BATCH groups wait before starting.
  */
 class ThreadPool : public NonCopyableObj {
 public:
     //! Create thread-pool nr_threads thread_pool
     ThreadPool(size_t nr_threads);
-    //! The main thread set the task, parallelism and worker flag to
-    //! notify other thread.
+    //! Run the task on the pool and return after all the sub tasks finished,
+    //! the calling thread also executes sub tasks with thread id
+    //! nr_threads() - 1
     void add_task(const TaskElem& task_elem);
 
     size_t nr_threads() const;
@@ -71,33 +130,51 @@ public:
     //! Set the affinity of all the threads
     void set_affinity(AffinityCallBack affinity_cb);
 
+    //! wait until all the task groups in the pool finished
     void sync();
     //! wake up all the threads from cv.wait(), when the thread pool is not
-    //! active, all the threads will go to sleep.
+    //! active, idle threads go to sleep without spinning.
     void active();
     //! all the threads go to sleep which will reduce CPU occupation
     void deactive();
     ~ThreadPool();
 
 private:
+    struct TaskGroup;
+
+    //! main loop of the worker with given id
+    void worker_loop(size_t id);
+    //! run sub tasks of some pending task group, return false if no task
+    //! group has sub tasks left
+    bool try_run_any(size_t id);
+    //! run the sub tasks of the group until no sub task can be claimed, or
+    //! until LATENCY_CRITICAL tasks arrive when a worker runs a BATCH group
+    void run_group(TaskGroup& group, size_t id, bool is_caller);
+    //! whether a BATCH group should yield to LATENCY_CRITICAL groups
+    bool should_yield(const TaskGroup& group) const;
+
     const size_t m_nr_threads = 0;
     //! Indicate whether the main thread have binding
-    bool m_main_affinity_flag;
+    std::atomic_bool m_main_affinity_flag;
     //! The callback binding the threads to cores
     AffinityCallBack m_core_binding_function{nullptr};
-    //! All the sub task number
-    size_t m_nr_parallelism = 0;
     std::atomic_bool m_stop{false};
     std::atomic_bool m_active{false};
-    //! The executable funcition pointer
-    MultiThreadingTask m_task;
 
     std::vector<Worker*> m_workers;
-    //! The task iter, when finished one, the m_all_task_iter sub 1
-    std::atomic_int m_task_iter{0};
+    //! the task groups that are being executed, guarded by m_mutex_group
+    std::vector<TaskGroup*> m_groups;
+    std::atomic_size_t m_nr_groups{0};
+    //! number of LATENCY_CRITICAL groups in m_groups
+    std::atomic_size_t m_nr_urgent_groups{0};
+    //! increased when new tasks arrive, used to wake up sleeping workers
+    std::atomic_size_t m_version{0};
+    //! number of workers waiting on m_cv
+    std::atomic_size_t m_nr_sleeping{0};
     //! The cv and mutex for threading activity
     std::condition_variable m_cv;
     std::mutex m_mutex;
+    std::mutex m_mutex_group;
     std::mutex m_mutex_task;
 };
 #else
@@ -0,0 +1,118 @@
+/**
+ * \file src/core/include/megbrain/utils/trace_event.h
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+#include "megbrain/common.h"
+#include "megbrain/utils/metahelper.h"
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace mgb {
+
+/*!
+ * \brief process wide recorder of timeline events, written as the Trace Event
+ *      Format of chrome://tracing and Perfetto
+ *
+ * Events are formatted into per-thread buffers, which are appended to the
+ * output file when they grow large and when recording stops, so memory usage
+ * does not grow with the length of the trace. Each thread is shown as a
+ * track named after sys::get_thread_name(); pseudo tracks (e.g. kernels on a
+ * device) can be created by track_id().
+ *
+ * Instrumented code should check enabled() before building events. Recording
+ * can also be started by setting MGB_TRACE_EVENT_FILE, in which case the
+ * file is completed at exit.
+ */
+class TraceEventRecorder : public NonCopyableObj {
+public:
+    using Args = std::vector<std::pair<const char*, double>>;
+
+    static TraceEventRecorder& inst();
+
+    static bool enabled() {
+        return sm_enabled.load(std::memory_order_relaxed);
+    }
+
+    //! current time in microseconds, which is the unit of timestamps
+    static double now();
+
+    //! start writing events to \p fpath; the previous file is completed
+    void start(const std::string& fpath);
+
+    //! write the buffered events and complete the file
+    void stop();
+
+    //! track id of the calling thread
+    uint64_t thread_track_id();
+
+    //! track id of a thread, which has recorded some events before
+    uint64_t thread_track_id(std::thread::id tid);
+
+    //! track id of a pseudo track with given name, created on first use
+    uint64_t track_id(const std::string& name);
+
+    //! add a span [begin, end) on the track of the calling thread
+    void add_span(const char* cat, const std::string& name, double begin,
+                  double end, const Args& args = {}) {
+        add_span(thread_track_id(), cat, name, begin, end, args);
+    }
+
+    void add_span(uint64_t track, const char* cat, const std::string& name,
+                  double begin, double end, const Args& args = {});
+
+    //! add an instant event on the track of the calling thread
+    void add_instant(const char* cat, const std::string& name,
+                     const Args& args = {});
+
+    //! add \p delta to a counter, and record its new value
+    void update_counter(const std::string& name, const char* series,
+                        double delta);
+
+    //! set the value of a counter
+    void set_counter(const std::string& name, const char* series,
+                     double value);
+
+private:
+    struct ThreadBuffer;
+
+    static std::atomic_bool sm_enabled;
+
+    TraceEventRecorder() = default;
+
+    ThreadBuffer& thread_buffer();
+    void add_event(const std::string& event);
+    void write_counter(const std::string& name, const char* series,
+                       double value);
+    //! create a track and write its name; m_mtx must be held
+    uint64_t new_track(const std::string& name);
+    void write_track_name(uint64_t track);
+
+    std::mutex m_mtx;
+    FILE* m_fout = nullptr;
+    //! names of all the tracks, indexed by track id
+    std::vector<std::string> m_track_names;
+    std::unordered_map<std::thread::id, uint64_t> m_thread2track;
+    std::unordered_map<std::string, uint64_t> m_name2track;
+    std::unordered_map<std::string, double> m_counters;
+    std::vector<std::shared_ptr<ThreadBuffer>> m_buffers;
+};
+
+}  // namespace mgb
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
@@ -1858,6 +1858,54 @@ TEST(TestGraph, In2OutOpStreamPropagate) {
     }
 }
 
+TEST(TestGraph, CPUBranchParallelism) {
+    REQUIRE_THREAD();
+    HostTensorGenerator<> gen;
+    auto cn = CompNode::load("cpu0");
+    auto host_x = gen({32, 64}, cn), host_w0 = gen({64, 64}, cn),
+         host_w1 = gen({64, 64}, cn);
+    auto run = [&](size_t parallelism, HostTensorND& host_y) {
+        auto graph = ComputingGraph::make();
+        graph->options().seq_opt.cpu_branch_parallelism = parallelism;
+        auto x = opr::Host2DeviceCopy::make(*graph, host_x),
+             w0 = opr::Host2DeviceCopy::make(*graph, host_w0),
+             w1 = opr::Host2DeviceCopy::make(*graph, host_w1);
+        // two independent branches joined by the final add
+        auto y0 = opr::MatrixMul::make(opr::MatrixMul::make(x, w0), w0),
+             y1 = opr::MatrixMul::make(opr::MatrixMul::make(x, w1), w1),
+             y = y0 + y1;
+        auto func = graph->compile({make_callback_copy(y, host_y)});
+        func->execute();
+        return y0.node()->comp_node() != y1.node()->comp_node();
+    };
+    HostTensorND host_y_expect, host_y;
+    ASSERT_FALSE(run(0, host_y_expect));
+    ASSERT_TRUE(run(2, host_y));
+    MGB_ASSERT_TENSOR_NEAR(host_y_expect, host_y, 1e-4);
+}
+
+TEST(TestGraph, CPUBranchParallelismMultiThread) {
+    REQUIRE_THREAD();
+    HostTensorGenerator<> gen;
+    // multithread comp nodes already run oprs on a thread pool; splitting
+    // branches would create extra pools and oversubscribe the cores
+    auto cn = CompNode::load("multithread2:0");
+    auto host_x = gen({32, 64}, cn), host_w0 = gen({64, 64}, cn),
+         host_w1 = gen({64, 64}, cn);
+    auto graph = ComputingGraph::make();
+    graph->options().seq_opt.cpu_branch_parallelism = 2;
+    auto x = opr::Host2DeviceCopy::make(*graph, host_x),
+         w0 = opr::Host2DeviceCopy::make(*graph, host_w0),
+         w1 = opr::Host2DeviceCopy::make(*graph, host_w1);
+    auto y0 = opr::MatrixMul::make(x, w0), y1 = opr::MatrixMul::make(x, w1),
+         y = y0 + y1;
+    HostTensorND host_y;
+    auto func = graph->compile({make_callback_copy(y, host_y)});
+    func->execute();
+    ASSERT_EQ(cn, y0.node()->comp_node());
+    ASSERT_EQ(cn, y1.node()->comp_node());
+}
+
 TEST(TestGraph, OperatorNodeConfigInstanceID) {
     OperatorNodeConfig config0, config1;
     void *p0 = &config0, *p1 = &config1;
@@ -543,6 +543,118 @@ TEST(TestSimpleCachingAlloc, Basic) {
     EXPECT_EQ(0u, raw_alloc->nr_free());
 };
 
+TEST(TestSizeClassCachingAlloc, SizeClass) {
+    using Alloc = SizeClassCachingAlloc;
+    EXPECT_EQ(16u, Alloc::size_class(0, 16));
+    EXPECT_EQ(16u, Alloc::size_class(1, 16));
+    EXPECT_EQ(112u, Alloc::size_class(100, 16));
+    EXPECT_EQ(640u, Alloc::size_class(600, 16));
+    EXPECT_EQ(1024u, Alloc::size_class(1000, 16));
+    EXPECT_EQ(1280u, Alloc::size_class(1025, 16));
+}
+
+TEST(TestSizeClassCachingAlloc, Basic) {
+    auto raw_alloc = new DummyAllocator(1024 * 1024);
+    SizeClassCachingAlloc::Config config;
+    config.alignment = 16;
+    config.arena_size = 1024;
+    config.max_cached_size = 2048;
+    auto alloc = SizeClassCachingAlloc::make(
+            std::unique_ptr<RawAllocator>(raw_alloc), config);
+
+    // small requests share one arena
+    auto p0 = alloc->alloc(100), p1 = alloc->alloc(100);
+    EXPECT_EQ(1u, raw_alloc->nr_alloc());
+    EXPECT_EQ(112, static_cast<char*>(p1) - static_cast<char*>(p0));
+    EXPECT_EQ(224u, alloc->get_used_memory());
+
+    // freed blocks are merged and reused
+    alloc->free(p0);
+    alloc->free(p1);
+    p0 = alloc->alloc(1000);
+    EXPECT_EQ(1u, raw_alloc->nr_alloc());
+    EXPECT_EQ(1024u, alloc->get_used_memory());
+
+    // large requests are rounded to arena size
+    p1 = alloc->alloc(3000);
+    EXPECT_EQ(2u, raw_alloc->nr_alloc());
+    EXPECT_EQ(1024u + 3072u, alloc->stat().reserved);
+
+    // cached memory exceeds max_cached_size, so free arenas are released
+    alloc->free(p1);
+    EXPECT_EQ(1u, raw_alloc->nr_free());
+    EXPECT_EQ(1024u, alloc->stat().reserved);
+    alloc->free(p0);
+    EXPECT_EQ(1u, raw_alloc->nr_free());
+    EXPECT_EQ(1024u, alloc->get_free_memory().tot);
+
+    EXPECT_EQ(1024u, alloc->trim());
+    EXPECT_EQ(2u, raw_alloc->nr_free());
+    auto stat = alloc->stat();
+    EXPECT_EQ(4u, stat.nr_alloc);
+    EXPECT_EQ(2u, stat.nr_raw_alloc);
+    EXPECT_EQ(2u, stat.nr_raw_free);
+    EXPECT_EQ(0u, stat.reserved);
+    EXPECT_EQ(4096u, stat.peak_reserved);
+    EXPECT_EQ(0u, alloc->get_free_memory().tot);
+}
+
+#if MGB_HAVE_THREAD && defined(__linux__)
+TEST(TestSizeClassCachingAlloc, CpuCompNode) {
+    // the allocator is chosen when the first CPU comp node is created, so run
+    // the check in a new process with MGB_CPU_CACHING_ALLOC set
+    ::testing::FLAGS_gtest_death_test_style = "threadsafe";
+    auto run = []() {
+        setenv("MGB_CPU_CACHING_ALLOC", "64", 1);
+        auto cn = CompNode::load("cpu0");
+        auto alloc = mem_alloc::cpu_caching_alloc();
+        ASSERT_NE(nullptr, alloc);
+
+        // dynamic shapes reuse cached memory
+        for (size_t i = 1; i < 100; ++i) {
+            HostTensorND hv{cn, {i * 37}, dtype::Float32()};
+            DeviceTensorND dv{cn, {i * 37}, dtype::Float32()};
+            ASSERT_EQ(0u, reinterpret_cast<uintptr_t>(dv.raw_ptr()) %
+                                  cn.get_mem_addr_alignment());
+            auto ptr = hv.ptr<float>();
+            for (size_t j = 0; j < i * 37; ++j) {
+                ptr[j] = j;
+            }
+            dv.copy_from_fixlayout(hv);
+            HostTensorND hv2;
+            hv2.copy_from(dv).sync();
+            MGB_ASSERT_TENSOR_EQ(hv, hv2);
+        }
+        cn.sync();
+        auto stat = alloc->stat();
+        // at least three blocks are allocated for each shape, and all of
+        // them fit in the first arena
+        ASSERT_GE(stat.nr_alloc, 99u * 3);
+        ASSERT_EQ(1u, stat.nr_raw_alloc);
+
+        CompNode::try_coalesce_all_free_memory();
+        ASSERT_LE(alloc->stat().reserved, stat.reserved);
+        exit(::testing::Test::HasFailure());
+    };
+    ASSERT_EXIT(run(), ::testing::ExitedWithCode(0), "");
+}
+
+TEST(TestSizeClassCachingAlloc, CpuCompNodeBadEnv) {
+    ::testing::FLAGS_gtest_death_test_style = "threadsafe";
+    auto run = []() {
+        setenv("MGB_CPU_CACHING_ALLOC", "64M", 1);
+        bool ok = false;
+        try {
+            CompNode::load("cpu0").activate();
+        } catch (const AssertionError& exc) {
+            ok = strstr(exc.what(), "invalid MGB_CPU_CACHING_ALLOC=64M");
+        }
+        exit(!ok);
+    };
+    ASSERT_EXIT(run(), ::testing::ExitedWithCode(0), "");
+}
+#endif
+
 namespace {
 class DevicePolicy {
 public:
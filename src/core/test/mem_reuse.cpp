@@ -15,6 +15,8 @@
 #include "megbrain/opr/tensor_manip.h"
 #include "megbrain/opr/utility.h"
 #include "megbrain/opr/blas.h"
+#include "megbrain/opr/basic_arith_wrapper.h"
+#include "megbrain/opr/basic_arith.h"
 
 #include "megbrain/test/helper.h"
 
@@ -125,6 +127,58 @@ TEST(TestMemReuse, PureMLP1) {
     EXPECT_EQ(host_inp->layout().span().dist_byte() * 32 * 2, alloc_size);
 }
 
+TEST(TestMemReuse, StaticMemPlanCache) {
+    for (bool parallel : {false, true}) {
+        auto graph = ComputingGraph::make();
+        graph->options().seq_opt.enable_parallel_static_mem_alloc = parallel;
+        graph->options().seq_opt.static_mem_plan_cache_size = 2;
+        HostTensorGenerator<> gen;
+        auto host_x = gen({3, 5});
+        auto x = opr::Host2DeviceCopy::make(*graph, host_x),
+             y0 = x * 2 + 1, y1 = opr::Concat::make({y0, x * y0}, 0),
+             y = opr::Reduce::make(y1 + 3,
+                     {opr::Reduce::Mode::SUM, 1});
+        size_t alloc_size = 0, nr_alloc = 0;
+        std::vector<bool> cache_hits;
+        auto hdl = graph->event().register_receiver<cg::event::StaticMemAlloc>(
+                [&](const cg::event::StaticMemAlloc& s) {
+                    if (s.comp_node.valid()) {
+                        alloc_size = s.alloc_size;
+                        cache_hits.push_back(s.plan_cache_hit);
+                        ++nr_alloc;
+                    }
+                });
+        HostTensorND host_y;
+        auto func = graph->compile({make_callback_copy(y, host_y)});
+
+        std::vector<size_t> alloc_sizes;
+        // with capacity 2, {11, 5} evicts the least recently used {7, 5},
+        // so the second {7, 5} is solved again while {3, 5} stays cached
+        for (size_t n : {3, 7, 3, 11, 3, 7}) {
+            *host_x = *gen({n, 5});
+            func->execute();
+            alloc_sizes.push_back(alloc_size);
+
+            auto px = host_x->ptr<float>();
+            for (size_t i = 0; i < 2 * n; ++i) {
+                float expect = 0;
+                for (size_t j = 0; j < 5; ++j) {
+                    float v = px[i % n * 5 + j], y0 = v * 2 + 1;
+                    expect += (i < n ? y0 : v * y0) + 3;
+                }
+                MGB_ASSERT_FLOAT_EQ(expect, host_y.ptr<float>()[i]);
+            }
+        }
+        ASSERT_EQ(6u, nr_alloc);
+        ASSERT_EQ((std::vector<bool>{false, false, true, false, true, false}),
+                  cache_hits);
+        ASSERT_EQ(alloc_sizes[0], alloc_sizes[2]);
+        ASSERT_EQ(alloc_sizes[0], alloc_sizes[4]);
+        ASSERT_EQ(alloc_sizes[1], alloc_sizes[5]);
+        ASSERT_LT(alloc_sizes[0], alloc_sizes[1]);
+    }
+}
+
 TEST(TestMemReuse, MultiCardSafety) {
     auto cns = load_multiple_xpus(3);
     static constexpr size_t N = 4;
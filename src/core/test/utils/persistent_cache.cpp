@@ -0,0 +1,141 @@
+/**
+ * \file src/core/test/utils/persistent_cache.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "megbrain/utils/persistent_cache.h"
+#include "megbrain/test/helper.h"
+
+#include <cstdio>
+#include <cstring>
+
+#ifndef WIN32
+using namespace mgb;
+
+namespace {
+using Blob = PersistentCache::Blob;
+
+Blob make_blob(const std::string& s) {
+    return {s.data(), s.size()};
+}
+
+std::string get_str(PersistentCache& cache, const std::string& category,
+                    const std::string& key) {
+    auto ret = cache.get(category, make_blob(key));
+    if (!ret.valid())
+        return "<none>";
+    return {static_cast<const char*>(ret->ptr), ret->size};
+}
+}  // anonymous namespace
+
+TEST(TestFilePersistentCache, Share) {
+    auto fpath = output_file("file_persistent_cache_share.bin");
+    std::remove(fpath.c_str());
+    FilePersistentCache c0{fpath}, c1{fpath};
+    c0.put("cat0", make_blob("k0"), make_blob("v0"));
+    c0.put("cat1", make_blob("k0"), make_blob("v1"));
+    // entries put by another instance are visible without dumping
+    ASSERT_EQ("v0", get_str(c1, "cat0", "k0"));
+    ASSERT_EQ("v1", get_str(c1, "cat1", "k0"));
+    ASSERT_EQ("<none>", get_str(c1, "cat0", "k1"));
+
+    // the first record of a key wins
+    c1.put("cat0", make_blob("k0"), make_blob("v2"));
+    ASSERT_EQ("v0", get_str(c1, "cat0", "k0"));
+    ASSERT_EQ("v0", get_str(c0, "cat0", "k0"));
+
+    FilePersistentCache c2{fpath};
+    ASSERT_EQ("v0", get_str(c2, "cat0", "k0"));
+    ASSERT_EQ("v1", get_str(c2, "cat1", "k0"));
+}
+
+TEST(TestFilePersistentCache, BlobValidAfterReload) {
+    auto fpath = output_file("file_persistent_cache_blob.bin");
+    std::remove(fpath.c_str());
+    FilePersistentCache cache{fpath};
+    cache.put("cat", make_blob("k0"), make_blob("v0"));
+    auto blob = cache.get("cat", make_blob("k0"));
+    ASSERT_TRUE(blob.valid());
+    {
+        // append a conflicting record, as a racing writer could do
+        auto fout = fopen(fpath.c_str(), "ab");
+        for (auto&& i : {"cat", "k0", "new_value"}) {
+            uint32_t size = strlen(i);
+            fwrite(&size, sizeof(size), 1, fout);
+            fwrite(i, 1, size, fout);
+        }
+        fclose(fout);
+    }
+    // a miss reloads the file, which must not replace the existing entry
+    ASSERT_EQ("<none>", get_str(cache, "cat", "k1"));
+    ASSERT_EQ("v0", std::string(static_cast<const char*>(blob->ptr),
+                                blob->size));
+    ASSERT_EQ("v0", get_str(cache, "cat", "k0"));
+}
+
+TEST(TestFilePersistentCache, Tag) {
+    auto fpath = output_file("file_persistent_cache_tag.bin");
+    std::remove(fpath.c_str());
+    {
+        FilePersistentCache cache{fpath, "tag0"};
+        cache.put("cat", make_blob("k"), make_blob("v"));
+    }
+    {
+        FilePersistentCache cache{fpath, "tag0"};
+        ASSERT_EQ("v", get_str(cache, "cat", "k"));
+    }
+    {
+        // files generated by another environment are discarded
+        FilePersistentCache cache{fpath, "tag1"};
+        ASSERT_EQ("<none>", get_str(cache, "cat", "k"));
+    }
+    FilePersistentCache cache{fpath, "tag0"};
+    ASSERT_EQ("<none>", get_str(cache, "cat", "k"));
+
+    // a file with another tag is replaced rather than truncated in place,
+    // so instances using the old file are not affected
+    cache.put("cat", make_blob("k0"), make_blob("v0"));
+    FilePersistentCache cache_other{fpath, "tag1"};
+    cache_other.put("cat", make_blob("k1"), make_blob("v1"));
+    cache.put("cat", make_blob("k2"), make_blob("v2"));
+    ASSERT_EQ("v0", get_str(cache, "cat", "k0"));
+    ASSERT_EQ("<none>", get_str(cache, "cat", "k1"));
+    ASSERT_EQ("<none>", get_str(cache_other, "cat", "k2"));
+    FilePersistentCache cache_reopen{fpath, "tag1"};
+    ASSERT_EQ("v1", get_str(cache_reopen, "cat", "k1"));
+    ASSERT_EQ("<none>", get_str(cache_reopen, "cat", "k0"));
+}
+
+TEST(TestFilePersistentCache, IncompleteRecord) {
+    auto fpath = output_file("file_persistent_cache_incomplete.bin");
+    std::remove(fpath.c_str());
+    {
+        FilePersistentCache cache{fpath};
+        cache.put("cat", make_blob("k0"), make_blob("v0"));
+    }
+    {
+        // simulate a writer killed while appending
+        auto fout = fopen(fpath.c_str(), "ab");
+        uint32_t size = 100;
+        fwrite(&size, sizeof(size), 1, fout);
+        fputs("cat", fout);
+        fclose(fout);
+    }
+    {
+        FilePersistentCache cache{fpath};
+        ASSERT_EQ("v0", get_str(cache, "cat", "k0"));
+        cache.put("cat", make_blob("k1"), make_blob("v1"));
+    }
+    FilePersistentCache cache{fpath};
+    ASSERT_EQ("v0", get_str(cache, "cat", "k0"));
+    ASSERT_EQ("v1", get_str(cache, "cat", "k1"));
+}
+#endif
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
@@ -62,6 +62,94 @@ TEST(TestThreadPool, BASIC) {
     }
 }
 
+TEST(TestThreadPool, CONCURRENT_AND_NESTED) {
+    constexpr size_t nr_threads = 4, nr_caller = 3, nr_run = 100,
+                     nr_outer = 7, nr_inner = 5;
+    auto thread_pool = std::make_shared<ThreadPool>(nr_threads);
+    std::atomic_size_t count{0};
+    std::atomic_bool id_conflict{false};
+    auto caller = [&]() {
+        for (size_t run = 0; run < nr_run; ++run) {
+            //! thread ids must be unique among the running sub tasks of one
+            //! add_task() call
+            std::atomic_int busy_outer[nr_threads] = {};
+            auto outer = [&](size_t, size_t thread_id) {
+                if (busy_outer[thread_id]++) {
+                    id_conflict = true;
+                }
+                std::atomic_int busy_inner[nr_threads] = {};
+                auto inner = [&](size_t, size_t thread_id) {
+                    if (busy_inner[thread_id]++) {
+                        id_conflict = true;
+                    }
+                    count++;
+                    busy_inner[thread_id]--;
+                };
+                thread_pool->add_task({inner, nr_inner});
+                busy_outer[thread_id]--;
+            };
+            thread_pool->add_task({outer, nr_outer});
+        }
+    };
+    std::vector<std::thread> callers;
+    for (size_t i = 0; i < nr_caller; ++i) {
+        callers.emplace_back(caller);
+    }
+    for (auto&& i : callers) {
+        i.join();
+    }
+    thread_pool->deactive();
+    ASSERT_FALSE(id_conflict);
+    ASSERT_EQ(count, nr_caller * nr_run * nr_outer * nr_inner);
+}
+
+TEST(TestThreadPool, PRIORITY) {
+    auto thread_pool = std::make_shared<ThreadPool>(4u);
+    std::atomic_bool batch_submitted{false}, batch_before_urgent{false};
+    std::atomic_size_t nr_urgent{0}, nr_batch{0};
+    std::thread batch_caller([&]() {
+        TaskPriorityGuard priority_guard{TaskPriority::BATCH};
+        while (!batch_submitted) {
+            std::this_thread::yield();
+        }
+        auto batch = [&](size_t, size_t) {
+            if (nr_urgent != 8) {
+                batch_before_urgent = true;
+            }
+            nr_batch++;
+        };
+        thread_pool->add_task({batch, 16});
+    });
+    auto urgent = [&](size_t index, size_t) {
+        if (!index) {
+            batch_submitted = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        nr_urgent++;
+    };
+    thread_pool->add_task({urgent, 8});
+    batch_caller.join();
+    thread_pool->deactive();
+    ASSERT_FALSE(batch_before_urgent);
+    ASSERT_EQ(nr_batch, 16u);
+}
+
+#if MGB_ENABLE_EXCEPTION
+TEST(TestThreadPool, EXCEPTION) {
+    auto thread_pool = std::make_shared<ThreadPool>(3u);
+    size_t main_thread_id = thread_pool->nr_threads() - 1;
+    auto func = [main_thread_id](size_t, size_t thread_id) {
+        if (thread_id == main_thread_id) {
+            mgb_throw(MegBrainError, "error in task");
+        }
+    };
+    ASSERT_THROW(thread_pool->add_task({func, 100}), MegBrainError);
+    std::atomic_size_t count{0};
+    thread_pool->add_task({[&](size_t, size_t) { count++; }, 10});
+    ASSERT_EQ(count, 10u);
+}
+#endif
+
 TEST(TestGraph, ParallelRunMultithreadMode) {
     // check race conditions when graphs are executed on multple threads
     std::atomic_size_t sync_counter{0};
@@ -0,0 +1,133 @@
+/**
+ * \file src/core/test/utils/trace_event.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "megbrain/utils/trace_event.h"
+#include "megbrain/comp_node_env.h"
+#include "megbrain/opr/basic_arith_wrapper.h"
+#include "megbrain/opr/io.h"
+#include "megbrain/system.h"
+#include "megbrain/test/helper.h"
+#include "megbrain/utils/thread_pool.h"
+
+#include <fstream>
+#include <sstream>
+
+using namespace mgb;
+
+namespace {
+std::string read_file(const std::string& fpath) {
+    std::ifstream fin{fpath};
+    std::stringstream ss;
+    ss << fin.rdbuf();
+    return ss.str();
+}
+
+size_t count_substr(const std::string& str, const std::string& sub) {
+    size_t cnt = 0;
+    for (auto pos = str.find(sub); pos != std::string::npos;
+         pos = str.find(sub, pos + sub.size())) {
+        ++cnt;
+    }
+    return cnt;
+}
+}  // anonymous namespace
+
+TEST(TestTraceEvent, Basic) {
+    auto fpath = output_file("trace_event_basic.json");
+    auto&& recorder = TraceEventRecorder::inst();
+    ASSERT_FALSE(TraceEventRecorder::enabled());
+    recorder.start(fpath);
+    ASSERT_TRUE(TraceEventRecorder::enabled());
+
+    auto worker = [&](const char* name) {
+        sys::set_thread_name(name);
+        for (int i = 0; i < 100; ++i) {
+            auto begin = TraceEventRecorder::now();
+            recorder.add_span("test", "span\"quoted\"", begin,
+                              TraceEventRecorder::now(), {{"i", i}});
+            recorder.update_counter("counter", "value", 1);
+        }
+    };
+    std::thread th0{worker, "trace_worker0"}, th1{worker, "trace_worker1"};
+    th0.join();
+    th1.join();
+    auto track = recorder.track_id("pseudo");
+    ASSERT_EQ(track, recorder.track_id("pseudo"));
+    recorder.add_span(track, "test", "pseudo_span", 1, 2);
+    recorder.add_instant("test", "instant");
+    recorder.stop();
+    ASSERT_FALSE(TraceEventRecorder::enabled());
+
+    // not recorded
+    recorder.add_instant("test", "instant");
+
+    auto str = read_file(fpath);
+    ASSERT_EQ(0u, str.find("{\"traceEvents\":["));
+    ASSERT_EQ("}\n]}\n", str.substr(str.size() - 5));
+    ASSERT_EQ(200u, count_substr(str, "span\\\"quoted\\\""));
+    ASSERT_EQ(200u, count_substr(str, "\"ph\":\"C\""));
+    ASSERT_NE(std::string::npos, str.find("\"value\":200}"));
+    ASSERT_EQ(1u, count_substr(str, "pseudo_span"));
+    ASSERT_EQ(1u, count_substr(str, "\"ph\":\"i\""));
+    ASSERT_NE(std::string::npos, str.find("trace_worker0"));
+    ASSERT_NE(std::string::npos, str.find("trace_worker1"));
+    ASSERT_NE(std::string::npos, str.find("\"name\":\"pseudo\""));
+}
+
+TEST(TestTraceEvent, Restart) {
+    auto&& recorder = TraceEventRecorder::inst();
+    auto run = [&](const std::string& fpath) {
+        recorder.start(fpath);
+        // the buffer of the exited thread is dropped at stop()
+        std::thread th{[&]() {
+            recorder.update_counter("restart_counter", "value", 1);
+        }};
+        th.join();
+        recorder.stop();
+        return read_file(fpath);
+    };
+    run(output_file("trace_event_restart0.json"));
+    // counters are reset by start()
+    auto str = run(output_file("trace_event_restart1.json"));
+    ASSERT_NE(std::string::npos, str.find("\"value\":1}"));
+    ASSERT_EQ(std::string::npos, str.find("\"value\":2}"));
+}
+
+#if MGB_HAVE_THREAD
+TEST(TestTraceEvent, CpuCompNode) {
+    auto fpath = output_file("trace_event_cpu_comp_node.json");
+    auto&& recorder = TraceEventRecorder::inst();
+    recorder.start(fpath);
+
+    HostTensorGenerator<> gen;
+    auto cn = CompNode::load("multithread2:0");
+    auto host_x = gen({64, 64}, cn);
+    auto graph = ComputingGraph::make();
+    graph->options().graph_opt_level = 0;
+    auto x = opr::Host2DeviceCopy::make(*graph, host_x), y = x * 2 + 1;
+    HostTensorND host_y;
+    auto func = graph->compile({make_callback_copy(y, host_y)});
+    func->execute().wait();
+    CompNodeEnv::from_comp_node(cn).cpu_env().dispatch(
+            [](size_t, size_t) {}, 8);
+    cn.sync();
+    recorder.stop();
+
+    auto str = read_file(fpath);
+    ASSERT_NE(std::string::npos, str.find("\"cat\":\"cpu_queue\""));
+    ASSERT_NE(std::string::npos, str.find("\"name\":\"queue_wait\""));
+    ASSERT_NE(std::string::npos, str.find("\"cat\":\"thread_pool\""));
+    ASSERT_NE(std::string::npos, str.find("\"name\":\"memory " +
+                                          cn.to_string() + "\""));
+}
+#endif
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
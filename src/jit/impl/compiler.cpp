@@ -12,6 +12,7 @@
 #include "./halide/compiler_cuda.h"
 #include "./nvrtc/compiler_cuda.h"
 #include "./mlir/compiler.h"
+#include "./cpu/compiler_cpu.h"
 
 #include "megbrain/jit/compiler.h"
 #include "megbrain/utils/hash.h"
@@ -112,6 +113,10 @@ Compiler* Compiler::get(ComputingGraph& graph, CompNode comp_node) {
                     break;
                 }
 #endif
+                if (!backend || !strcmp(backend, "CPU")) {
+                    compiler = std::make_unique<CPUCompiler>();
+                    break;
+                }
                 mgb_throw(InternalError, "No compiler support for cpu");
                 break;
             default:
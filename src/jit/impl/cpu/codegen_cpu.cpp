@@ -0,0 +1,211 @@
+/**
+ * \file src/jit/impl/cpu/codegen_cpu.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "./codegen_cpu.h"
+
+#include "megbrain/common.h"
+#include "megbrain/jit/ast_c.h"
+#include "megbrain/jit/placeholder_opr.h"
+#include "megbrain/jit/utils.h"
+#include "megbrain/opr/tensor_manip.h"
+
+#include <cinttypes>
+
+#if MGB_JIT
+
+using namespace mgb;
+using namespace jit;
+using namespace ast_c;
+
+namespace {
+
+using VarNode2AST = ThinHashMap<VarNode*, ASTPtr>;
+
+bool is_value_input(const JITExecutor::Args::Data& inp) {
+    // HOST_VALUE_FOR_SHAPE inputs only carry a shape
+    return inp.layout.dtype.valid();
+}
+
+void check_dtype(DType dtype) {
+    mgb_throw_if(dtype != dtype::Float32(), GraphError,
+                 "unsupported dtype %s in CPU JIT fusion", dtype.name());
+}
+
+//! code to compute the offsets of the inputs for the first element of a row
+std::string gen_offset_code(const JITExecutor::Args& args, size_t ndim) {
+    std::string res;
+    res += ssprintf(
+            "size_t inner = idx %% shape[%zu], rest = idx / shape[%zu];\n",
+            ndim - 1, ndim - 1);
+    for (size_t i = 0; i < args.inputs.size(); ++i) {
+        if (is_value_input(args.inputs[i])) {
+            res += ssprintf("ptrdiff_t off%zu = inner * strides[%zu];\n", i,
+                            i * ndim + ndim - 1);
+        }
+    }
+    for (size_t d = ndim - 1; d-- > 0;) {
+        res += ssprintf(
+                "{\nsize_t c = rest %% shape[%zu];\nrest /= shape[%zu];\n", d,
+                d);
+        for (size_t i = 0; i < args.inputs.size(); ++i) {
+            if (is_value_input(args.inputs[i])) {
+                res += ssprintf("off%zu += c * strides[%zu];\n", i,
+                                i * ndim + d);
+            }
+        }
+        res += "}\n";
+    }
+    return res;
+}
+
+//! generate code to access input values in the kernel
+void gen_input_code(str_util::StrReplaceMap& replace_map, VarNode2AST& var2ast,
+                    const JITExecutor::Args& args,
+                    const PlaceholderArray& placeholders, size_t ndim) {
+    std::string row_ptrs_str, load_exps_str;
+    for (size_t i = 0; i < args.inputs.size(); i++) {
+        auto&& inp = args.inputs[i];
+        auto var = placeholders[inp.idx]->output(0);
+        if (!is_value_input(inp)) {
+            var2ast[var] = 0.f;
+            continue;
+        }
+        check_dtype(inp.layout.dtype);
+        ASTPtr elem_var = ASTPtr::make<VariableAST>("x" + std::to_string(i));
+        ASTPtr elem_val = ASTPtr::make<VariableAST>(
+                ssprintf("p%zu[j * s%zu]", i, i));
+        var2ast[var] = elem_var;
+        row_ptrs_str += ssprintf(
+                "const float* __restrict p%zu = inputs[%zu] + off%zu;\n"
+                "const ptrdiff_t s%zu = strides[%zu];\n",
+                i, i, i, i, i * ndim + ndim - 1);
+        load_exps_str += ASTPtr::make<DeclFloatAST>(elem_var)->code_gen();
+        load_exps_str +=
+                ASTPtr::make<AssignAST>(elem_var, elem_val)->code_gen();
+    }
+    str_util::append_replace_map(
+            replace_map, {{"{{OFFSETS}}", gen_offset_code(args, ndim)},
+                          {"{{ROW_PTRS}}", row_ptrs_str},
+                          {"{{LOAD_EXPRS}}", load_exps_str}});
+}
+
+ASTPtr gen_opr_ast(cg::OperatorNodeBase* opr, const VarNode2AST& var2ast) {
+    ASTPtrArray cur_inputs;
+    for (auto inp_node : opr->input()) {
+        cur_inputs.push_back(var2ast.at(inp_node));
+    }
+    if (opr->same_type<opr::Reduce>() || opr->same_type<opr::GetVarShape>() ||
+        opr->same_type<opr::Dimshuffle>()) {
+        // Reduce and GetVarShape occur in grad and would be ignored
+        return {cur_inputs[0]};
+    }
+
+    return opr2AST(opr, cur_inputs).at(0);
+}
+}  // anonymous namespace
+
+std::pair<std::string, std::string> mgb::jit::codegen_cpu(
+        const InternalGraph& internal_graph, const JITExecutor::Args& args) {
+    std::string source = R"(
+#include <cmath>
+#include <cstddef>
+
+using std::copysign;
+
+namespace {
+template <typename T>
+inline T mgb_log_sum_exp(T x, T y) {
+    T a, b;
+    a = x < y ? x : y;
+    b = x < y ? y : x;
+    return T(b + log1pf(expf(a - b)));
+}
+
+inline float rsqrtf(float x) {
+    return 1.f / sqrtf(x);
+}
+
+inline float rcbrtf(float x) {
+    return 1.f / cbrtf(x);
+}
+}  // anonymous namespace
+
+extern "C" void {{KERNEL_NAME}}(const float* const* inputs, float* output,
+                                const ptrdiff_t* shape,
+                                const ptrdiff_t* strides, size_t begin,
+                                size_t end) {
+    size_t idx = begin;
+    while (idx < end) {
+        {{OFFSETS}}
+        size_t n = shape[{{NDIM}} - 1] - inner;
+        if (n > end - idx) {
+            n = end - idx;
+        }
+        {{ROW_PTRS}}
+        float* __restrict out = output + idx;
+        for (size_t j = 0; j < n; ++j) {
+            {{LOAD_EXPRS}}
+            {{INTERNAL_EXPRS}}
+            out[j] = {{EXP}};
+        }
+        idx += n;
+    }
+}
+)";
+
+    check_dtype(args.outputs[0].layout.dtype);
+    size_t ndim = args.outputs[0].layout.ndim;
+
+    VarNode2AST var2ast;
+    str_util::StrReplaceMap source_replace_map;
+
+    // add inputs to the replace map
+    gen_input_code(source_replace_map, var2ast, args,
+                   internal_graph.placeholders(), ndim);
+
+    // add other oprs
+    std::string internal_exps_str;
+    size_t cur_opr_cnt = 0;
+    cg::DepOprIter{[&](cg::OperatorNodeBase* opr) {
+        ++cur_opr_cnt;
+        if (opr->same_type<JITPlaceholder>()) {
+            return;
+        }
+        ASTPtr elem_var =
+                ASTPtr::make<VariableAST>("y" + std::to_string(cur_opr_cnt));
+        ASTPtr elem_val = gen_opr_ast(opr, var2ast);
+        var2ast[opr->output(0)] = elem_var;
+        internal_exps_str += ASTPtr::make<DeclFloatAST>(elem_var)->code_gen();
+        internal_exps_str +=
+                ASTPtr::make<AssignAST>(elem_var, elem_val)->code_gen();
+    }}
+            .add(internal_graph.output());
+
+    str_util::append_replace_map(
+            source_replace_map,
+            {{"{{NDIM}}", std::to_string(ndim)},
+             {"{{INTERNAL_EXPRS}}", internal_exps_str},
+             {"{{EXP}}", var2ast.at(internal_graph.output())->code_gen()}});
+
+    str_util::replace_all_pairs_inplace(source, source_replace_map);
+
+    auto kernel_name = ssprintf(
+            "jit_cpu_%" PRIx64,
+            XXHash{}.update(source.data(), source.size()).digest());
+    str_util::replace_all_pairs_inplace(source,
+                                        {{"{{KERNEL_NAME}}", kernel_name}});
+
+    return {kernel_name, source};
+}
+
+#endif  // MGB_JIT
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
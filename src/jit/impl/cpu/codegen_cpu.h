@@ -0,0 +1,46 @@
+/**
+ * \file src/jit/impl/cpu/codegen_cpu.h
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+#include "megbrain_build_config.h"
+
+#if MGB_JIT
+
+#include "megbrain/jit/executor_opr.h"
+
+namespace mgb {
+namespace jit {
+
+/*!
+ * \brief generate C++ source of a fused elemwise kernel for the host
+ *
+ * The kernel computes the output elements in [begin, end) of the flattened
+ * output, and has the signature:
+ *
+ *      extern "C" void name(const float* const* inputs, float* output,
+ *                           const ptrdiff_t* shape, const ptrdiff_t* strides,
+ *                           size_t begin, size_t end);
+ *
+ * where \p shape is the output shape and \p strides contains the strides of
+ * each input broadcasted to the output shape (nr_inputs * ndim values).
+ *
+ * \return (kernel name, source code)
+ */
+std::pair<std::string, std::string> codegen_cpu(
+        const InternalGraph& internal_graph, const JITExecutor::Args& args);
+
+}  // namespace jit
+}  // namespace mgb
+
+#endif  // MGB_JIT
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
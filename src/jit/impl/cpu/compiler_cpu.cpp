@@ -0,0 +1,206 @@
+/**
+ * \file src/jit/impl/cpu/compiler_cpu.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "./compiler_cpu.h"
+#include "./codegen_cpu.h"
+
+#include "megbrain/comp_node_env.h"
+#include "megbrain/jit/utils.h"
+#include "megbrain/utils/hash.h"
+#include "megbrain/utils/timer.h"
+
+#include <cctype>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+
+#include <unistd.h>
+
+#if MGB_JIT
+
+using namespace mgb;
+using namespace jit;
+
+struct CPUExecutable::Library : public NonCopyableObj {
+    void* handle = nullptr;
+
+    ~Library() { ExecutableHelper::get().unload_lib(handle); }
+};
+
+namespace {
+
+//! minimal number of output elements in a task dispatched to the workers
+constexpr size_t MIN_ELEMS_PER_TASK = 16384;
+
+/*!
+ * \brief optimization flags for the generated source
+ *
+ * The flags are passed to the compiler through the shell, so only options
+ * made of a restricted set of characters are accepted.
+ */
+const char* cxx_flags() {
+    static const char* flags = []() {
+        const char* flags = MGB_GETENV("MGB_JIT_CPU_FLAGS");
+        if (!flags) {
+            return "-O3 -march=native -fno-math-errno -fno-trapping-math";
+        }
+        bool new_word = true;
+        for (const char* p = flags; *p; ++p) {
+            char c = *p;
+            if (c == ' ') {
+                new_word = true;
+                continue;
+            }
+            mgb_throw_if((new_word && c != '-') ||
+                                 !(isalnum(c) || strchr("-_=+,.", c)),
+                         MegBrainError,
+                         "bad MGB_JIT_CPU_FLAGS: %s; it should only contain "
+                         "space-separated options made of letters, digits "
+                         "and -_=+,.",
+                         flags);
+            new_word = false;
+        }
+        return flags;
+    }();
+    return flags;
+}
+
+/*!
+ * \brief process-wide cache of loaded libraries, keyed by the kernel name
+ *      which is the hash of the source
+ */
+class LibraryCache {
+    std::mutex m_mtx;
+    std::unordered_map<std::string, std::weak_ptr<CPUExecutable::Library>>
+            m_libs;
+
+public:
+    static LibraryCache& inst() {
+        static LibraryCache cache;
+        return cache;
+    }
+
+    std::shared_ptr<CPUExecutable::Library> get(const std::string& name,
+                                                const std::string& source) {
+        MGB_LOCK_GUARD(m_mtx);
+        auto&& cached = m_libs[name];
+        if (auto lib = cached.lock()) {
+            return lib;
+        }
+        auto&& helper = ExecutableHelper::get();
+        auto flags = cxx_flags();
+        auto so_name = ssprintf(
+                "%s-%" PRIx64 ".so", name.c_str(),
+                XXHash{}.update(flags, strlen(flags)).digest());
+        if (!helper.exists(so_name)) {
+            RealTimer timer;
+            auto obj_name = helper.compile_cpp_source_secondary(
+                    source.c_str(), name.c_str(), flags);
+            // link to a temp file and rename it, so other processes sharing
+            // the workdir never load a partially written library
+            auto tmp_name = ssprintf("%s.tmp%d", so_name.c_str(),
+                                     static_cast<int>(getpid()));
+            helper.link({obj_name}, tmp_name);
+            helper.remove_interm(obj_name);
+            auto tmp_path = helper.realpath(tmp_name),
+                 so_path = helper.realpath(so_name);
+            if (::rename(tmp_path.c_str(), so_path.c_str())) {
+                auto err = errno;
+                ::unlink(tmp_path.c_str());
+                mgb_throw(SystemError, "failed to rename %s to %s: %s",
+                          tmp_path.c_str(), so_path.c_str(), strerror(err));
+            }
+            mgb_log_debug("CPU JIT: compile %s: time=%.3fms", name.c_str(),
+                          timer.get_msecs());
+        } else {
+            mgb_log_debug("CPU JIT: reuse %s", so_name.c_str());
+        }
+        auto lib = std::make_shared<CPUExecutable::Library>();
+        lib->handle = helper.load_lib(so_name);
+        cached = lib;
+        return lib;
+    }
+};
+
+}  // anonymous namespace
+
+/* =================== CPUExecutable ==================== */
+
+void CPUExecutable::execute(JITExecutor* fusion_opr) {
+    auto&& args = fusion_opr->args();
+    auto&& out = args.outputs[0];
+    size_t ndim = out.layout.ndim, nr_inps = args.inputs.size();
+    mgb_assert(out.layout.is_contiguous());
+
+    std::vector<const float*> inputs(nr_inps, nullptr);
+    std::vector<ptrdiff_t> shape(ndim), strides(nr_inps * ndim, 0);
+    for (size_t i = 0; i < ndim; ++i) {
+        shape[i] = out.layout.shape[i];
+    }
+    for (size_t i = 0; i < nr_inps; ++i) {
+        auto&& inp = args.inputs[i];
+        if (!inp.layout.dtype.valid()) {
+            // HOST_VALUE_FOR_SHAPE input whose value is not used
+            continue;
+        }
+        mgb_assert(inp.layout.ndim == ndim);
+        inputs[i] = inp.from->dev_tensor().ptr<float>();
+        for (size_t j = 0; j < ndim; ++j) {
+            strides[i * ndim + j] = inp.layout.stride[j];
+        }
+    }
+    auto output = out.from->dev_tensor().ptr<float>();
+
+    auto&& env =
+            CompNodeEnv::from_comp_node(fusion_opr->comp_node()).cpu_env();
+    size_t nr_elems = out.layout.total_nr_elems();
+    size_t nr_threads = env.dispatcher->nr_threads();
+    size_t nr_tasks = 1;
+    if (nr_threads > 1) {
+        nr_tasks = std::min(nr_threads * 4,
+                            (nr_elems + MIN_ELEMS_PER_TASK - 1) /
+                                    MIN_ELEMS_PER_TASK);
+        nr_tasks = std::max<size_t>(nr_tasks, 1);
+    }
+    size_t chunk = (nr_elems + nr_tasks - 1) / nr_tasks;
+    auto task = [lib = m_lib, func = m_func, inputs = std::move(inputs),
+                 shape = std::move(shape), strides = std::move(strides), output,
+                 nr_elems, chunk](size_t index, size_t) {
+        size_t begin = index * chunk,
+               end = std::min(begin + chunk, nr_elems);
+        if (begin < end) {
+            func(inputs.data(), output, shape.data(), strides.data(), begin,
+                 end);
+        }
+    };
+    env.dispatch(std::move(task), nr_tasks);
+}
+
+/* ==================== CPUCompiler ===================== */
+
+std::unique_ptr<Executable> CPUCompiler::do_compile(
+        const InternalGraph& graph, const JITExecutor::Args& args) {
+    std::string source, kernel_name;
+    std::tie(kernel_name, source) = codegen_cpu(graph, args);
+    if (ExecutableHelper::keep_interm()) {
+        ExecutableHelper::get().write_file(
+                kernel_name + ".cpp",
+                "// " + graph.output()->owner_opr()->name() + "\n" + source);
+    }
+    auto lib = LibraryCache::inst().get(kernel_name, source);
+    CPUExecutable::Func func;
+    ExecutableHelper::get().resolve_func(func, lib->handle, kernel_name);
+    return std::make_unique<CPUExecutable>(std::move(lib), func);
+}
+
+#endif  // MGB_JIT
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
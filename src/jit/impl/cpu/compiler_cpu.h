@@ -0,0 +1,83 @@
+/**
+ * \file src/jit/impl/cpu/compiler_cpu.h
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+#include "megbrain_build_config.h"
+
+#if MGB_JIT
+
+#include "megbrain/jit/compiler.h"
+
+namespace mgb {
+namespace jit {
+
+/*!
+ * \brief Executable class for CPU, which calls a function in a shared library
+ *      built by the host compiler
+ */
+class CPUExecutable final : public Executable {
+public:
+    //! see codegen_cpu() for the meaning of the params
+    using Func = void (*)(const float* const* inputs, float* output,
+                          const ptrdiff_t* shape, const ptrdiff_t* strides,
+                          size_t begin, size_t end);
+
+    //! a loaded library, shared by executables with the same source
+    struct Library;
+
+    CPUExecutable(std::shared_ptr<Library> lib, Func func)
+            : m_lib{std::move(lib)}, m_func{func} {}
+
+    /*!
+     * \brief dispatch the kernel to the comp node, split into chunks of the
+     *      output that are run by the worker threads
+     */
+    void execute(JITExecutor* fusion_opr) override final;
+
+private:
+    std::shared_ptr<Library> m_lib;
+    Func m_func;
+};
+
+/*!
+ * \brief CPU compiler that generates C++ source from the AST and compiles it
+ *      with the host compiler
+ *
+ * The shared libraries are named by the hash of the generated source, so a
+ * library found in the JIT workdir (see MGB_JIT_WORKDIR) would be reused
+ * without compiling again. The compiler can be chosen by setting
+ * MGB_JIT_BACKEND to CPU, and MGB_JIT_CPU_FLAGS overrides the default
+ * optimization flags.
+ */
+class CPUCompiler final : public Compiler {
+    std::unique_ptr<Executable> do_compile(
+            const InternalGraph& graph, const JITExecutor::Args& args) override;
+
+public:
+    Property property() const override {
+        using F = Property::Flag;
+        return Property{
+                F::NEED_INPUT_COLLAPSE | F::BIND_NDIM | F::ONLY_FLOAT32,
+                JITFeatureBits::NONE, 64};
+    }
+
+    size_t get_nr_workspace_outputs(JITExecutor*) const override { return 0; }
+
+    void init_workspace_size_infer(JITExecutor*) override {}
+};
+
+}  // namespace jit
+}  // namespace mgb
+
+#endif  // MGB_JIT
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
@@ -367,6 +367,21 @@ bool JITFusionPass::Impl::can_be_fused(cg::OperatorNodeBase* opr) const {
     if (!backend) {
         backend = "DEFAULT";
     }
+
+    //! check the compiler actually chosen for the comp node, since the
+    //! default one depends on the backends built in
+    auto compiler = Compiler::get(*m_opt_state.graph().comp_graph(),
+                                  opr->output(0)->comp_node());
+    if (compiler->property().contain_flag(
+                Compiler::Property::Flag::ONLY_FLOAT32)) {
+        for (auto var : opr->input()) {
+            if (var->dtype() != dtype::Float32())
+                return false;
+        }
+        if (opr->output(0)->dtype() != dtype::Float32())
+            return false;
+    }
+
     // float elemwise
     if (auto elem = gopt::try_cast_as_op<opr::Elemwise>(opr)) {
         bool ret = true;
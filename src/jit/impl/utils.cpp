@@ -183,15 +183,19 @@ public:
     }
 
     std::string compile_cpp_source_secondary(const char* source,
-                                             const char* out_name) override {
+                                             const char* out_name,
+                                             const char* cxx_flags) override {
+        if (!cxx_flags) {
+            cxx_flags = "-O2";
+        }
         std::string uniq_name{out_name};
         uniq_name.append("-");
         uniq_name.append(std::to_string(
                 XXHash{}.update(source, strlen(source)).digest()));
         auto src_name = uniq_name + ".cpp", obj_name = uniq_name + ".o";
         write_file(src_name, source);
-        check_exec(ssprintf("g++ -O2 -fPIC -std=c++11 '%s' -o '%s' -c",
-                            realpath(src_name).c_str(),
+        check_exec(ssprintf("g++ %s -fPIC -std=c++11 '%s' -o '%s' -c",
+                            cxx_flags, realpath(src_name).c_str(),
                             realpath(obj_name).c_str()));
         return obj_name;
     }
@@ -214,6 +218,11 @@ public:
         return m_workdir + name;
     }
 
+    bool exists(const std::string& name) override {
+        struct stat sb;
+        return stat(realpath(name).c_str(), &sb) == 0 && S_ISREG(sb.st_mode);
+    }
+
     void remove(const std::string& name) override {
         int err = unlink(realpath(name).c_str());
         mgb_throw_if(err, SystemError, "failed to unlink %s: %s", name.c_str(),
@@ -61,7 +61,10 @@ public:
 
             //! if true, input would be contiguous; otherwise it is only
             //! monotone contiguous
-            NEED_INPUT_CONTIG = 1u << 3
+            NEED_INPUT_CONTIG = 1u << 3,
+
+            //! whether only float32 inputs and outputs are supported
+            ONLY_FLOAT32 = 1u << 4
         };
 
         //! flags that indicate requirements of this Compiler for the
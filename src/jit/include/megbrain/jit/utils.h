@@ -86,11 +86,14 @@ public:
      *
      * \param out_name output filename template; it should not include the .cpp
      *      suffix
+     * \param cxx_flags optimization flags passed to the compiler; -O2 is
+     *      used if it is null
      *
      * \return object file name (without dir path)
      */
-    virtual std::string compile_cpp_source_secondary(const char* source,
-                                                     const char* out_name) = 0;
+    virtual std::string compile_cpp_source_secondary(
+            const char* source, const char* out_name,
+            const char* cxx_flags = nullptr) = 0;
 
     //! link object files to shared library
     virtual void link(const SmallVector<std::string>& inp_names,
@@ -102,6 +105,9 @@ public:
     //! get real path of a file in the working dir
     virtual std::string realpath(const std::string& name) = 0;
 
+    //! whether a file exists in the working dir
+    virtual bool exists(const std::string& name) = 0;
+
     //! remove file if MGB_JIT_KEEP_INTERM is not set
     void remove_interm(const std::string& name) {
         if (!keep_interm()) {
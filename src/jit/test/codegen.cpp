@@ -124,6 +124,40 @@ void run<grad>(Backend backend, CompNode cn) {
 template <>
 void run<void>(Backend, CompNode) {}
 
+void run_cpu(CompNode cn, const TensorShape& shape) {
+    set_backend(Backend::CPU);
+    auto graph = ComputingGraph::make();
+    HostTensorGenerator<dtype::Float32> gen;
+    auto host_x0 = gen(shape, cn), host_x1 = gen({shape[0], 1}, cn),
+         host_x2 = gen({1, shape[1]}, cn);
+
+    auto a = opr::Host2DeviceCopy::make(*graph, host_x0),
+         b = opr::Host2DeviceCopy::make(*graph, host_x1),
+         c = opr::Host2DeviceCopy::make(*graph, host_x2);
+
+    auto y = opr::tanh(a) * opr::exp(b) + opr::sin(c) / (opr::abs(b) + 0.1f) +
+             a * c;
+
+    auto ig_gen =
+            std::make_unique<InternalGraphGenerator>(y.node()->owner_opr());
+
+    for (auto i : get_rev_topo_order(y)) {
+        if (!i->same_type<opr::Host2DeviceCopy>()) {
+            ig_gen->add_opr(i);
+        }
+    }
+
+    auto igraph = ig_gen->generate();
+    auto y_jit = JITExecutor::make(igraph, ig_gen->orig_inps());
+
+    HostTensorND host_y, host_y_jit;
+    auto func = graph->compile({make_callback_copy(y, host_y),
+                                make_callback_copy(y_jit, host_y_jit)});
+    func->execute();
+
+    MGB_ASSERT_TENSOR_NEAR(host_y, host_y_jit, 1e-4);
+}
+
 #if MGB_JIT_MLIR
 void run_mlir(CompNode cn) {
     set_backend(Backend::MLIR);
@@ -248,6 +282,15 @@ TYPED_TEST(TestJITNvrtcCodeGen, run) {
     run<TypeParam>(Backend::NVRTC, CompNode::load("gpu0"));
 }
 
+TEST(TestJITCPUCodeGen, Basic) {
+    run_cpu(CompNode::load("cpu0"), {23, 42});
+}
+
+TEST(TestJITCPUCodeGen, MultiThread) {
+    // large enough to be split into tasks that start inside a row
+    run_cpu(CompNode::load("multithread2:0"), {130, 513});
+}
+
 #if MGB_JIT_MLIR
 TEST(TestJITMlirCodeGen, Basic) {
     auto cn = CompNode::load("cpu0");
@@ -38,6 +38,9 @@ void jit::set_backend(Backend backend) {
         case Backend::MLIR:
             setenv("MGB_JIT_BACKEND", "MLIR", 1);
             return;
+        case Backend::CPU:
+            setenv("MGB_JIT_BACKEND", "CPU", 1);
+            return;
         default:
             mgb_assert(0);
     }
@@ -50,6 +50,23 @@ const char* get_param_name(CollectiveComm::Param param) {
 cudaStream_t get_stream(VarNode* var) {
     return CompNodeEnv::from_comp_node(var->comp_node()).cuda_env().stream;
 }
+
+ShmCommunicator::ReduceOp get_shm_reduce_op(MegRay::ReduceOp op) {
+    switch (op) {
+        case MegRay::ReduceOp::MEGRAY_SUM:
+            return ShmCommunicator::ReduceOp::SUM;
+        case MegRay::ReduceOp::MEGRAY_MAX:
+            return ShmCommunicator::ReduceOp::MAX;
+        case MegRay::ReduceOp::MEGRAY_MIN:
+            return ShmCommunicator::ReduceOp::MIN;
+        default:
+            mgb_throw(MegBrainError, "bad CollectiveComm reduce op");
+    }
+}
+
+bool is_shm_backend(const std::string& backend) {
+    return backend == "shm";
+}
 }  // anonymous namespace
 
 /* ================= ModeTrait ================= */
@@ -80,6 +97,18 @@ protected:
         }
     }
 
+    /*!
+     * \brief run \p func with the shm communicator on the cpu dispatcher,
+     *      so that it is ordered after the kernels producing the inputs
+     */
+    template <typename Func>
+    static void exec_shm(CollectiveComm* opr, Func&& func) {
+        auto comm = opr->m_shm_comm;
+        CompNodeEnv::from_comp_node(opr->output(0)->comp_node())
+                .cpu_env()
+                .dispatch([comm, func]() { func(*comm); });
+    }
+
 public:
     virtual ~ModeTrait() = default;
 
@@ -158,6 +187,15 @@ class CollectiveComm::ModeTrait::ALL_GATHER : public ModeTrait {
         auto &&iv = ivar->dev_tensor(), &&ov = ovar->dev_tensor();
         mgb_assert(ivar->comp_node().mem_node() ==
                    ovar->comp_node().mem_node());
+        if (opr->m_shm_comm) {
+            auto sendbuf = iv.raw_ptr(), recvbuf = ov.raw_ptr();
+            auto len = iv.shape().total_nr_elems();
+            auto dtype = iv.dtype();
+            exec_shm(opr, [=](ShmCommunicator& comm) {
+                comm.all_gather(sendbuf, recvbuf, len, dtype);
+            });
+            return;
+        }
         auto status = opr->m_megray_comm->all_gather(
                 (void*)iv.raw_ptr(), (void*)ov.raw_ptr(),
                 iv.shape().total_nr_elems(),
@@ -202,6 +240,15 @@ class CollectiveComm::ModeTrait::REDUCE_SCATTER_SUM : public ModeTrait {
                    ovar->comp_node().mem_node());
 
         size_t buff_len = ov.shape().total_nr_elems();// * opr->m_nr_devices;
+        if (opr->m_shm_comm) {
+            auto sendbuf = iv.raw_ptr(), recvbuf = ov.raw_ptr();
+            auto dtype = ov.dtype();
+            exec_shm(opr, [=](ShmCommunicator& comm) {
+                comm.reduce_scatter(sendbuf, recvbuf, buff_len, dtype,
+                                    ShmCommunicator::ReduceOp::SUM);
+            });
+            return;
+        }
         auto status = opr->m_megray_comm->reduce_scatter(
                 (void*)iv.raw_ptr(), (void*)ov.raw_ptr(), buff_len,
                 get_megray_dtype(ov.dtype()), MegRay::ReduceOp::MEGRAY_SUM,
@@ -249,6 +296,16 @@ class CollectiveComm::ModeTrait::AllReduceBase : public ReducedBasedTrait,
         auto &&iv = ivar->dev_tensor(), &&ov = ovar->dev_tensor();
         mgb_assert(ivar->comp_node().mem_node() ==
                    ovar->comp_node().mem_node());
+        if (opr->m_shm_comm) {
+            auto sendbuf = iv.raw_ptr(), recvbuf = ov.raw_ptr();
+            auto len = iv.shape().total_nr_elems();
+            auto dtype = iv.dtype();
+            auto shm_op = get_shm_reduce_op(op());
+            exec_shm(opr, [=](ShmCommunicator& comm) {
+                comm.all_reduce(sendbuf, recvbuf, len, dtype, shm_op);
+            });
+            return;
+        }
         auto status = opr->m_megray_comm->all_reduce(
                 (void*)iv.raw_ptr(), (void*)ov.raw_ptr(),
                 iv.shape().total_nr_elems(),
@@ -327,6 +384,17 @@ class CollectiveComm::ModeTrait::ReduceBase : public ReducedBasedTrait,
         if (opr->is_root()) {
             recvbuf = ovar->dev_tensor().raw_ptr();
         }
+        if (opr->m_shm_comm) {
+            auto sendbuf = iv.raw_ptr();
+            auto len = iv.shape().total_nr_elems();
+            auto dtype = iv.dtype();
+            auto shm_op = get_shm_reduce_op(op());
+            uint32_t root = opr->m_root;
+            exec_shm(opr, [=](ShmCommunicator& comm) {
+                comm.reduce(sendbuf, recvbuf, len, dtype, shm_op, root);
+            });
+            return;
+        }
         auto status = opr->m_megray_comm->reduce(
                 (void*)iv.raw_ptr(), recvbuf,
                 iv.shape().total_nr_elems(),
@@ -373,6 +441,14 @@ class CollectiveComm::ModeTrait::BROADCAST : public ModeTrait {
             datatype = ov.dtype();
             length = ov.shape().total_nr_elems();
         }
+        if (opr->m_shm_comm) {
+            auto recvbuf = ov.raw_ptr();
+            uint32_t root = opr->m_root;
+            exec_shm(opr, [=](ShmCommunicator& comm) {
+                comm.broadcast(buff, recvbuf, length, datatype, root);
+            });
+            return;
+        }
         auto status = opr->m_megray_comm->broadcast(
                 buff, (void*)ov.raw_ptr(), length,
                 get_megray_dtype(datatype), opr->m_root,
@@ -518,9 +594,24 @@ CollectiveComm::CollectiveComm(
           m_disable{disable} {
     // add input
     mgb_assert(inputs.size() <= 1, "one or zero input expected, got %zu", inputs.size());
+    auto chk_comp_node = [&](CompNode cn) {
+        if (is_shm_backend(backend)) {
+            mgb_assert(cn.device_type() == CompNode::DeviceType::CPU,
+                       "shm backend of CollectiveComm only supports CPU");
+        } else {
+            mgb_assert(cn.device_type() == CompNode::DeviceType::CUDA,
+                       "CollectiveComm currectly only supports CUDA");
+        }
+    };
+    if (is_shm_backend(backend)) {
+        using Mode = Param::Mode;
+        mgb_assert(param.mode != Mode::GATHER && param.mode != Mode::SCATTER &&
+                           param.mode != Mode::ALL_TO_ALL,
+                   "%s is not supported by shm backend of CollectiveComm",
+                   get_param_name(param));
+    }
     if (inputs.size() > 0) {
-        mgb_assert(inputs[0]->comp_node().device_type() == CompNode::DeviceType::CUDA,
-                   "CollectiveComm currectly only supports CUDA");
+        chk_comp_node(inputs[0]->comp_node());
         add_input({inputs[0]});
     }
 
@@ -531,8 +622,7 @@ CollectiveComm::CollectiveComm(
     const auto& cns = config.comp_node();
     mgb_assert(cns.size() <= 1, "one or zero comp node expected, got %zu", cns.size());
     if (cns.size() > 0) {
-        mgb_assert(cns[0].device_type() == CompNode::DeviceType::CUDA,
-                   "CollectiveComm currectly only supports CUDA");
+        chk_comp_node(cns[0]);
         output(0)->comp_node(cns[0]);
     } else {
         output(0)->comp_node(inputs[0]->comp_node());
@@ -605,11 +695,17 @@ void CollectiveComm::opr_register() {
     m_rank = reg_info.rank;
     m_root = reg_info.root_rank;
 
-    m_megray_comm = MegRayCommBuilder::get_megray_comm(
-            reg_info.hash, m_key, m_nr_devices, m_rank,
-            get_megray_backend(m_backend), m_group_client);
+    if (is_shm_backend(m_backend)) {
+        m_shm_comm = ShmCommBuilder::get_shm_comm(reg_info.hash, m_key,
+                                                  m_nr_devices, m_rank,
+                                                  m_group_client);
+    } else {
+        m_megray_comm = MegRayCommBuilder::get_megray_comm(
+                reg_info.hash, m_key, m_nr_devices, m_rank,
+                get_megray_backend(m_backend), m_group_client);
 
-    m_megray_ctx = MegRay::CudaContext::make(get_stream(output(0)));
+        m_megray_ctx = MegRay::CudaContext::make(get_stream(output(0)));
+    }
 
     m_init = true;
 }
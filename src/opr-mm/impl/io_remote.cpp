@@ -67,10 +67,16 @@ void RemoteSend::scn_do_execute() {
             }
         }
 
-        m_megray_comm = MegRayCommBuilder::get_megray_comm(
-                reg_info.hash, m_key, 2, 0, MegRay::MEGRAY_NCCL, m_group_client);
+        if (comp_node.device_type() == CompNode::DeviceType::CPU) {
+            m_shm_comm = ShmCommBuilder::get_shm_comm(reg_info.hash, m_key, 2,
+                                                      0, m_group_client);
+        } else {
+            m_megray_comm = MegRayCommBuilder::get_megray_comm(
+                    reg_info.hash, m_key, 2, 0, MegRay::MEGRAY_NCCL,
+                    m_group_client);
 
-        m_megray_ctx = MegRay::CudaContext::make(get_stream(output(0)));
+            m_megray_ctx = MegRay::CudaContext::make(get_stream(output(0)));
+        }
 
         m_init = true;
     }
@@ -82,10 +88,18 @@ void RemoteSend::scn_do_execute() {
     for (size_t i = 0; i < ishp.ndim; i++) {
         data_size *= ishp[i];
     }
-    auto status = m_megray_comm->send(tensor.raw_ptr(), data_size,
-                                      get_megray_dtype(tensor.dtype()),
-                                      1, m_megray_ctx);
-    mgb_assert(status == MegRay::MEGRAY_OK, "MegRay send failed");
+    if (m_shm_comm) {
+        auto comm = m_shm_comm;
+        auto ptr = tensor.raw_ptr();
+        auto dtype = tensor.dtype();
+        CompNodeEnv::from_comp_node(comp_node()).cpu_env().dispatch(
+                [=]() { comm->send(ptr, data_size, dtype, 1); });
+    } else {
+        auto status = m_megray_comm->send(tensor.raw_ptr(), data_size,
+                                          get_megray_dtype(tensor.dtype()),
+                                          1, m_megray_ctx);
+        mgb_assert(status == MegRay::MEGRAY_OK, "MegRay send failed");
+    }
 
     if (m_is_grad) {
         auto&& dest = output(0)->dev_tensor();
@@ -178,10 +192,16 @@ void RemoteRecv::scn_do_execute() {
             }
         }
 
-        m_megray_comm = MegRayCommBuilder::get_megray_comm(
-                reg_info.hash, m_key, 2, 1, MegRay::MEGRAY_NCCL, m_group_client);
+        if (comp_node.device_type() == CompNode::DeviceType::CPU) {
+            m_shm_comm = ShmCommBuilder::get_shm_comm(reg_info.hash, m_key, 2,
+                                                      1, m_group_client);
+        } else {
+            m_megray_comm = MegRayCommBuilder::get_megray_comm(
+                    reg_info.hash, m_key, 2, 1, MegRay::MEGRAY_NCCL,
+                    m_group_client);
 
-        m_megray_ctx = MegRay::CudaContext::make(get_stream(output(0)));
+            m_megray_ctx = MegRay::CudaContext::make(get_stream(output(0)));
+        }
 
         m_init = true;
     }
@@ -193,10 +213,18 @@ void RemoteRecv::scn_do_execute() {
     for (size_t i = 0; i < ishp.ndim; i++) {
         data_size *= ishp[i];
     }
-    auto status = m_megray_comm->recv(tensor.raw_ptr(), data_size,
-                                      get_megray_dtype(tensor.dtype()),
-                                      0, m_megray_ctx);
-    mgb_assert(status == MegRay::MEGRAY_OK, "MegRay recv failed");
+    if (m_shm_comm) {
+        auto comm = m_shm_comm;
+        auto ptr = tensor.raw_ptr();
+        auto dtype = tensor.dtype();
+        CompNodeEnv::from_comp_node(comp_node()).cpu_env().dispatch(
+                [=]() { comm->recv(ptr, data_size, dtype, 0); });
+    } else {
+        auto status = m_megray_comm->recv(tensor.raw_ptr(), data_size,
+                                          get_megray_dtype(tensor.dtype()),
+                                          0, m_megray_ctx);
+        mgb_assert(status == MegRay::MEGRAY_OK, "MegRay recv failed");
+    }
 }
 
 void RemoteRecv::init_output_static_infer_desc() {
@@ -0,0 +1,723 @@
+/**
+ * \file src/opr-mm/impl/shm_comm.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "megbrain/opr/shm_comm.h"
+#include "megbrain/utils/hash.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace mgb;
+using namespace opr;
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2,
+              "atomics in shared memory must be lock free");
+
+namespace {
+
+using ReduceOp = ShmCommunicator::ReduceOp;
+
+constexpr uint64_t SEGMENT_MAGIC = 0x314d4d4f43424d47;  // "GMBCOMM1"
+constexpr size_t CACHE_LINE = 64;
+//! number of slots owned by each rank
+constexpr size_t NR_SLOTS = 4;
+
+struct alignas(CACHE_LINE) Flag {
+    std::atomic<uint64_t> val;
+};
+
+struct alignas(CACHE_LINE) SegmentHeader {
+    uint64_t magic;
+    uint64_t chunk_bytes;
+    uint32_t size;
+    std::atomic<uint32_t> nr_attached;
+};
+
+enum class Algo { AUTO, RING, TREE };
+
+size_t get_env_size(const char* name, size_t def) {
+    auto env = MGB_GETENV(name);
+    if (!env) {
+        return def;
+    }
+    auto val = std::stoull(env);
+    mgb_throw_if(!val, MegBrainError, "invalid %s: %s", name, env);
+    return val;
+}
+
+Algo get_env_algo() {
+    auto env = MGB_GETENV("MGB_SHM_COMM_ALGO");
+    if (!env) {
+        return Algo::AUTO;
+    }
+    if (!strcmp(env, "RING")) {
+        return Algo::RING;
+    }
+    if (!strcmp(env, "TREE")) {
+        return Algo::TREE;
+    }
+    mgb_throw(MegBrainError, "invalid MGB_SHM_COMM_ALGO: %s", env);
+}
+
+/* ================= reduce kernels ================= */
+
+template <typename T>
+struct ReduceSum {
+    static T apply(T a, T b) { return static_cast<T>(a + b); }
+};
+
+template <typename T>
+struct ReduceMax {
+    static T apply(T a, T b) { return std::max(a, b); }
+};
+
+template <typename T>
+struct ReduceMin {
+    static T apply(T a, T b) { return std::min(a, b); }
+};
+
+using ReduceKern = void (*)(void* dst, const void* a, const void* b,
+                            size_t len);
+
+//! dst = a op b, where dst may alias a or b; written as a plain loop to be
+//! vectorized by the compiler
+template <typename T, class Op>
+void reduce_kern(void* dst, const void* a, const void* b, size_t len) {
+    auto pd = static_cast<T*>(dst);
+    auto pa = static_cast<const T*>(a), pb = static_cast<const T*>(b);
+    for (size_t i = 0; i < len; ++i) {
+        pd[i] = Op::apply(pa[i], pb[i]);
+    }
+}
+
+ReduceKern get_reduce_kern(DType dtype, ReduceOp op) {
+    switch (dtype.enumv()) {
+#define cb(_dt)                                                 \
+    case DTypeTrait<_dt>::enumv: {                              \
+        using ctype = DTypeTrait<_dt>::ctype;                   \
+        switch (op) {                                           \
+            case ReduceOp::SUM:                                 \
+                return reduce_kern<ctype, ReduceSum<ctype>>;    \
+            case ReduceOp::MAX:                                 \
+                return reduce_kern<ctype, ReduceMax<ctype>>;    \
+            case ReduceOp::MIN:                                 \
+                return reduce_kern<ctype, ReduceMin<ctype>>;    \
+        }                                                       \
+        break;                                                  \
+    }
+        cb(dtype::Float32) cb(dtype::Int32) cb(dtype::Int8)
+        MEGDNN_INC_FLOAT16(cb(dtype::Float16))
+#undef cb
+        default:
+            break;
+    }
+    mgb_throw(MegBrainError, "bad shared memory comm dtype or op: %s %d",
+              dtype.name(), static_cast<int>(op));
+}
+
+void copy_if_differ(void* dst, const void* src, size_t size) {
+    if (dst != src) {
+        memcpy(dst, src, size);
+    }
+}
+
+size_t div_ceil(size_t a, size_t b) {
+    return (a + b - 1) / b;
+}
+
+}  // anonymous namespace
+
+/* ================= ShmCommunicator::Impl ================= */
+
+struct ShmCommunicator::Impl {
+    using Readers = SmallVector<uint32_t, 2>;
+
+    const uint32_t size, rank;
+    size_t chunk_bytes, map_size;
+    void* map_ptr = nullptr;
+    SegmentHeader* header;
+    //! posted tag of each slot, indexed by (writer, slot)
+    Flag* posted;
+    //! acknowledged tag, indexed by (writer, reader)
+    Flag* acks;
+    //! pid of each rank, or 0 if it has not attached
+    Flag* pids;
+    uint8_t* slots;
+
+    //! max seconds to wait for another rank
+    size_t timeout;
+
+    //! index of current collective op, which is the higher part of tags
+    uint64_t op = 0;
+
+    //! states of the slots owned by this rank
+    size_t next_slot = 0;
+    uint64_t slot_tag[NR_SLOTS] = {};
+    Readers slot_readers[NR_SLOTS];
+
+    Impl(const std::string& key, uint32_t size, uint32_t rank,
+         GroupClient& group_client);
+
+    ~Impl() {
+        if (map_ptr) {
+            munmap(map_ptr, map_size);
+        }
+    }
+
+    //! throw if the process of rank \p peer is known to have exited
+    void check_alive(uint32_t peer) const {
+        if (peer >= size) {
+            return;
+        }
+        auto pid = static_cast<pid_t>(
+                pids[peer].val.load(std::memory_order_relaxed));
+        mgb_throw_if(pid && kill(pid, 0) && errno == ESRCH, SystemError,
+                     "shm comm: process %d of rank %u has exited",
+                     static_cast<int>(pid), peer);
+    }
+
+    /*!
+     * \brief busy wait until \p pred returns true
+     *
+     * \param peer the rank to wait for, or size if it is unknown; an
+     *      exception is thrown if it exits, or if the wait takes longer than
+     *      timeout
+     */
+    template <typename Pred>
+    void spin_wait(Pred&& pred, uint32_t peer) const {
+        size_t nr_spin = 0;
+        auto start = std::chrono::steady_clock::now();
+        while (!pred()) {
+            if (++nr_spin < 4096) {
+#if defined(__x86_64__) || defined(__i386__)
+                __builtin_ia32_pause();
+#endif
+                continue;
+            }
+            std::this_thread::yield();
+            if (nr_spin % 4096) {
+                continue;
+            }
+            check_alive(peer);
+            auto elapsed = std::chrono::duration<double>(
+                                   std::chrono::steady_clock::now() - start)
+                                   .count();
+            mgb_throw_if(elapsed > timeout, TimeoutError,
+                         "shm comm: rank %u waited for %s for %.1f seconds; "
+                         "set MGB_SHM_COMM_TIMEOUT to wait longer",
+                         rank,
+                         peer < size ? ssprintf("rank %u", peer).c_str()
+                                     : "other ranks",
+                         elapsed);
+        }
+    }
+
+    uint64_t tag(size_t idx) const {
+        mgb_assert(idx < (1ull << 32));
+        return (op << 32) | idx;
+    }
+
+    uint8_t* slot_ptr(uint32_t writer, size_t slot) const {
+        return slots + (writer * NR_SLOTS + slot) * chunk_bytes;
+    }
+
+    //! get a slot of this rank that is no longer read by anyone
+    size_t acquire_slot() {
+        size_t slot = next_slot;
+        next_slot = (slot + 1) % NR_SLOTS;
+        for (auto reader : slot_readers[slot]) {
+            auto&& flag = acks[rank * size + reader].val;
+            auto prev = slot_tag[slot];
+            spin_wait(
+                    [&]() {
+                        return flag.load(std::memory_order_acquire) >= prev;
+                    },
+                    reader);
+        }
+        return slot;
+    }
+
+    //! publish the data in \p slot to \p readers
+    void post(size_t slot, size_t idx, const Readers& readers) {
+        slot_tag[slot] = tag(idx);
+        slot_readers[slot] = readers;
+        posted[rank * NR_SLOTS + slot].val.store(slot_tag[slot],
+                                                 std::memory_order_release);
+    }
+
+    //! wait for the data posted by \p writer with index \p idx
+    const uint8_t* wait(uint32_t writer, size_t idx) {
+        auto expect = tag(idx);
+        const uint8_t* ret = nullptr;
+        auto find_slot = [&]() {
+            for (size_t i = 0; i < NR_SLOTS; ++i) {
+                if (posted[writer * NR_SLOTS + i].val.load(
+                            std::memory_order_acquire) == expect) {
+                    ret = slot_ptr(writer, i);
+                    return true;
+                }
+            }
+            return false;
+        };
+        spin_wait(find_slot, writer);
+        return ret;
+    }
+
+    //! tell \p writer that its data with index \p idx has been consumed
+    void ack(uint32_t writer, size_t idx) {
+        acks[writer * size + rank].val.store(tag(idx),
+                                             std::memory_order_release);
+    }
+
+    /* ------------------- ring ------------------- */
+
+    /*!
+     * \brief pipelined ring reduce-scatter on a chunk of each segment
+     *
+     * \param seg_chunk get (offset, length) in bytes of the chunk in a segment
+     * \param dst destination of the chunk of the segment owned by this rank
+     */
+    template <typename SegChunk>
+    void ring_reduce_scatter_chunk(const uint8_t* sendbuf, uint8_t* dst,
+                                   size_t idx_base, size_t elem_size,
+                                   ReduceKern kern, SegChunk&& seg_chunk) {
+        uint32_t next = (rank + 1) % size, prev = (rank + size - 1) % size;
+        size_t off, len;
+        for (uint32_t k = 0; k + 1 < size; ++k) {
+            std::tie(off, len) = seg_chunk((rank + size - k - 1) % size);
+            auto slot = acquire_slot();
+            if (!k) {
+                memcpy(slot_ptr(rank, slot), sendbuf + off, len);
+            } else {
+                auto src = wait(prev, idx_base + k - 1);
+                kern(slot_ptr(rank, slot), src, sendbuf + off,
+                     len / elem_size);
+                ack(prev, idx_base + k - 1);
+            }
+            post(slot, idx_base + k, {next});
+        }
+        std::tie(off, len) = seg_chunk(rank);
+        auto src = wait(prev, idx_base + size - 2);
+        kern(dst, src, sendbuf + off, len / elem_size);
+        ack(prev, idx_base + size - 2);
+    }
+
+    /*!
+     * \brief pipelined ring all-gather on a chunk of each segment, where the
+     *      chunk owned by this rank has been in \p recvbuf
+     */
+    template <typename SegChunk>
+    void ring_all_gather_chunk(uint8_t* recvbuf, size_t idx_base,
+                               SegChunk&& seg_chunk) {
+        uint32_t next = (rank + 1) % size, prev = (rank + size - 1) % size;
+        size_t off, len;
+        std::tie(off, len) = seg_chunk(rank);
+        auto slot = acquire_slot();
+        memcpy(slot_ptr(rank, slot), recvbuf + off, len);
+        post(slot, idx_base, {next});
+        for (uint32_t k = 0; k + 1 < size; ++k) {
+            std::tie(off, len) = seg_chunk((rank + size - k - 1) % size);
+            auto src = wait(prev, idx_base + k);
+            memcpy(recvbuf + off, src, len);
+            if (k + 2 < size) {
+                slot = acquire_slot();
+                memcpy(slot_ptr(rank, slot), src, len);
+                post(slot, idx_base + k + 1, {next});
+            }
+            ack(prev, idx_base + k);
+        }
+    }
+
+    /* ------------------- tree ------------------- */
+
+    uint32_t real_rank(uint32_t vrank, uint32_t root) const {
+        return (vrank + root) % size;
+    }
+
+    Readers tree_children(uint32_t root) const {
+        Readers ret;
+        uint32_t vrank = (rank + size - root) % size;
+        for (uint32_t i = vrank * 2 + 1; i <= vrank * 2 + 2 && i < size; ++i) {
+            ret.push_back(real_rank(i, root));
+        }
+        return ret;
+    }
+
+    uint32_t tree_parent(uint32_t root) const {
+        uint32_t vrank = (rank + size - root) % size;
+        mgb_assert(vrank);
+        return real_rank((vrank - 1) / 2, root);
+    }
+
+    //! reduce a chunk to \p dst on root along a binary tree
+    void tree_reduce_chunk(const uint8_t* src, uint8_t* dst, size_t len,
+                           size_t idx, uint32_t root, size_t elem_size,
+                           ReduceKern kern) {
+        auto children = tree_children(root);
+        size_t slot = 0;
+        if (rank != root) {
+            slot = acquire_slot();
+            dst = slot_ptr(rank, slot);
+        }
+        if (children.empty()) {
+            copy_if_differ(dst, src, len);
+        }
+        for (auto child : children) {
+            kern(dst, src, wait(child, idx), len / elem_size);
+            ack(child, idx);
+            src = dst;
+        }
+        if (rank != root) {
+            post(slot, idx, {tree_parent(root)});
+        }
+    }
+
+    //! broadcast a chunk from \p src on root along a binary tree
+    void tree_broadcast_chunk(const uint8_t* src, uint8_t* dst, size_t len,
+                              size_t idx, uint32_t root) {
+        auto children = tree_children(root);
+        if (rank != root) {
+            src = wait(tree_parent(root), idx);
+        }
+        if (!children.empty()) {
+            auto slot = acquire_slot();
+            memcpy(slot_ptr(rank, slot), src, len);
+            post(slot, idx, children);
+        }
+        copy_if_differ(dst, src, len);
+        if (rank != root) {
+            ack(tree_parent(root), idx);
+        }
+    }
+};
+
+ShmCommunicator::Impl::Impl(const std::string& key, uint32_t size,
+                            uint32_t rank, GroupClient& group_client)
+        : size{size}, rank{rank} {
+    chunk_bytes = get_env_size("MGB_SHM_COMM_CHUNK", 128 * 1024);
+    chunk_bytes = div_ceil(chunk_bytes, CACHE_LINE) * CACHE_LINE;
+    timeout = get_env_size("MGB_SHM_COMM_TIMEOUT", 600);
+    size_t posted_off = sizeof(SegmentHeader),
+           acks_off = posted_off + sizeof(Flag) * size * NR_SLOTS,
+           pids_off = acks_off + sizeof(Flag) * size * size,
+           slots_off = div_ceil(pids_off + sizeof(Flag) * size, 4096) * 4096;
+    map_size = slots_off + chunk_bytes * size * NR_SLOTS;
+
+    std::string name;
+    int port = 0;
+    auto do_map = [&](int fd) {
+        map_ptr = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                       fd, 0);
+        close(fd);
+        if (map_ptr == MAP_FAILED) {
+            map_ptr = nullptr;
+            mgb_throw(SystemError, "failed to map shm %s: %s", name.c_str(),
+                      strerror(errno));
+        }
+        auto base = static_cast<uint8_t*>(map_ptr);
+        header = reinterpret_cast<SegmentHeader*>(base);
+        posted = reinterpret_cast<Flag*>(base + posted_off);
+        acks = reinterpret_cast<Flag*>(base + acks_off);
+        pids = reinterpret_cast<Flag*>(base + pids_off);
+        slots = base + slots_off;
+    };
+    // the destructor is not called if the constructor throws
+    auto unmap = [&]() {
+        if (map_ptr) {
+            munmap(map_ptr, map_size);
+            map_ptr = nullptr;
+        }
+    };
+
+    if (rank == 0) {
+        static std::atomic_size_t cnt{0};
+        name = ssprintf("/mgb_shm_comm_%d_%zu", static_cast<int>(getpid()),
+                        cnt++);
+        int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0 && errno == EEXIST) {
+            // left by a crashed process whose pid is reused
+            shm_unlink(name.c_str());
+            fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        }
+        mgb_throw_if(fd < 0, SystemError, "failed to create shm %s: %s",
+                     name.c_str(), strerror(errno));
+        // the name must be removed on failure, since it is otherwise only
+        // unlinked after all the ranks have attached
+        MGB_TRY {
+            if (ftruncate(fd, map_size)) {
+                auto err = errno;
+                close(fd);
+                mgb_throw(SystemError, "failed to resize shm %s: %s",
+                          name.c_str(), strerror(err));
+            }
+            do_map(fd);
+            // ftruncate fills zeros, which are the initial values of the flags
+            header->magic = SEGMENT_MAGIC;
+            header->chunk_bytes = chunk_bytes;
+            header->size = size;
+            header->nr_attached.store(0);
+            pids[rank].val.store(getpid());
+
+            group_client.bcast_addr(name, port, key, size, rank, 0);
+
+            if (size > 1) {
+                spin_wait(
+                        [&]() {
+                            return header->nr_attached.load() + 1 == size;
+                        },
+                        size);
+            }
+        }
+        MGB_CATCH(..., {
+            shm_unlink(name.c_str());
+            unmap();
+            throw;
+        });
+        // the segment is kept alive by the mappings
+        shm_unlink(name.c_str());
+    } else {
+        group_client.bcast_addr(name, port, key, size, rank, 0);
+        int fd = shm_open(name.c_str(), O_RDWR, 0);
+        mgb_throw_if(fd < 0, SystemError, "failed to open shm %s: %s",
+                     name.c_str(), strerror(errno));
+        do_map(fd);
+        if (header->magic != SEGMENT_MAGIC ||
+            header->chunk_bytes != chunk_bytes || header->size != size) {
+            size_t other_chunk_bytes = header->chunk_bytes;
+            uint32_t other_size = header->size;
+            unmap();
+            mgb_throw(MegBrainError,
+                      "inconsistent shm comm settings between ranks: "
+                      "chunk=%zu/%zu size=%u/%u",
+                      other_chunk_bytes, chunk_bytes, other_size, size);
+        }
+        pids[rank].val.store(getpid());
+        header->nr_attached.fetch_add(1);
+    }
+}
+
+/* ================= ShmCommunicator ================= */
+
+ShmCommunicator::ShmCommunicator(const std::string& key, uint32_t size,
+                                 uint32_t rank, GroupClient& group_client)
+        : m_size{size},
+          m_rank{rank},
+          m_impl{std::make_unique<Impl>(key, size, rank, group_client)} {
+    mgb_assert(rank < size);
+}
+
+ShmCommunicator::~ShmCommunicator() = default;
+
+void ShmCommunicator::all_reduce(const void* sendbuf, void* recvbuf,
+                                 size_t len, DType dtype, ReduceOp op) {
+    MGB_LOCK_GUARD(m_mtx);
+    auto&& impl = *m_impl;
+    ++impl.op;
+    auto kern = get_reduce_kern(dtype, op);
+    size_t elem_size = dtype.size(), bytes = len * elem_size;
+    auto src = static_cast<const uint8_t*>(sendbuf);
+    auto dst = static_cast<uint8_t*>(recvbuf);
+    if (m_size == 1 || !len) {
+        copy_if_differ(dst, src, bytes);
+        return;
+    }
+
+    size_t chunk = impl.chunk_bytes / elem_size * elem_size;
+    auto algo = get_env_algo();
+    if (algo == Algo::AUTO) {
+        algo = bytes <= get_env_size("MGB_SHM_COMM_TREE_THRESHOLD", 64 * 1024)
+                       ? Algo::TREE
+                       : Algo::RING;
+    }
+    if (algo == Algo::TREE) {
+        size_t nr_chunks = div_ceil(bytes, chunk);
+        for (size_t i = 0; i < nr_chunks; ++i) {
+            size_t off = i * chunk, cur = std::min(chunk, bytes - off);
+            impl.tree_reduce_chunk(src + off, dst + off, cur, i * 2, 0,
+                                   elem_size, kern);
+            impl.tree_broadcast_chunk(dst + off, dst + off, cur, i * 2 + 1, 0);
+        }
+        return;
+    }
+
+    size_t seg_bytes = div_ceil(len, m_size) * elem_size,
+           nr_chunks = div_ceil(seg_bytes, chunk);
+    for (size_t i = 0; i < nr_chunks; ++i) {
+        // (offset, length) of the i-th chunk of a segment
+        auto seg_chunk = [&](uint32_t seg) {
+            size_t begin = std::min(bytes, seg * seg_bytes),
+                   end = std::min(bytes, begin + seg_bytes),
+                   off = std::min(end, begin + i * chunk);
+            return std::make_pair(off, std::min(chunk, end - off));
+        };
+        size_t idx_base = i * (m_size - 1) * 2;
+        impl.ring_reduce_scatter_chunk(src, dst + seg_chunk(m_rank).first,
+                                       idx_base, elem_size, kern, seg_chunk);
+        impl.ring_all_gather_chunk(dst, idx_base + m_size - 1, seg_chunk);
+    }
+}
+
+void ShmCommunicator::reduce_scatter(const void* sendbuf, void* recvbuf,
+                                     size_t recvlen, DType dtype,
+                                     ReduceOp op) {
+    MGB_LOCK_GUARD(m_mtx);
+    auto&& impl = *m_impl;
+    ++impl.op;
+    auto kern = get_reduce_kern(dtype, op);
+    size_t elem_size = dtype.size(), seg_bytes = recvlen * elem_size;
+    auto src = static_cast<const uint8_t*>(sendbuf);
+    auto dst = static_cast<uint8_t*>(recvbuf);
+    if (m_size == 1 || !recvlen) {
+        copy_if_differ(dst, src, seg_bytes);
+        return;
+    }
+
+    size_t chunk = impl.chunk_bytes / elem_size * elem_size,
+           nr_chunks = div_ceil(seg_bytes, chunk);
+    for (size_t i = 0; i < nr_chunks; ++i) {
+        auto seg_chunk = [&](uint32_t seg) {
+            size_t off = i * chunk;
+            return std::make_pair(seg * seg_bytes + off,
+                                  std::min(chunk, seg_bytes - off));
+        };
+        impl.ring_reduce_scatter_chunk(src, dst + i * chunk,
+                                       i * (m_size - 1), elem_size, kern,
+                                       seg_chunk);
+    }
+}
+
+void ShmCommunicator::all_gather(const void* sendbuf, void* recvbuf,
+                                 size_t sendlen, DType dtype) {
+    MGB_LOCK_GUARD(m_mtx);
+    auto&& impl = *m_impl;
+    ++impl.op;
+    size_t elem_size = dtype.size(), seg_bytes = sendlen * elem_size;
+    auto dst = static_cast<uint8_t*>(recvbuf);
+    copy_if_differ(dst + m_rank * seg_bytes, sendbuf, seg_bytes);
+    if (m_size == 1 || !sendlen) {
+        return;
+    }
+
+    size_t chunk = impl.chunk_bytes / elem_size * elem_size,
+           nr_chunks = div_ceil(seg_bytes, chunk);
+    for (size_t i = 0; i < nr_chunks; ++i) {
+        auto seg_chunk = [&](uint32_t seg) {
+            size_t off = i * chunk;
+            return std::make_pair(seg * seg_bytes + off,
+                                  std::min(chunk, seg_bytes - off));
+        };
+        impl.ring_all_gather_chunk(dst, i * (m_size - 1), seg_chunk);
+    }
+}
+
+void ShmCommunicator::broadcast(const void* sendbuf, void* recvbuf,
+                                size_t len, DType dtype, uint32_t root) {
+    MGB_LOCK_GUARD(m_mtx);
+    auto&& impl = *m_impl;
+    ++impl.op;
+    mgb_assert(root < m_size);
+    size_t bytes = len * dtype.size(), chunk = impl.chunk_bytes,
+           nr_chunks = div_ceil(bytes, chunk);
+    auto src = static_cast<const uint8_t*>(sendbuf);
+    auto dst = static_cast<uint8_t*>(recvbuf);
+    for (size_t i = 0; i < nr_chunks; ++i) {
+        size_t off = i * chunk;
+        impl.tree_broadcast_chunk(m_rank == root ? src + off : nullptr,
+                                  dst + off, std::min(chunk, bytes - off), i,
+                                  root);
+    }
+}
+
+void ShmCommunicator::reduce(const void* sendbuf, void* recvbuf, size_t len,
+                             DType dtype, ReduceOp op, uint32_t root) {
+    MGB_LOCK_GUARD(m_mtx);
+    auto&& impl = *m_impl;
+    ++impl.op;
+    mgb_assert(root < m_size);
+    auto kern = get_reduce_kern(dtype, op);
+    size_t elem_size = dtype.size(), bytes = len * elem_size,
+           chunk = impl.chunk_bytes / elem_size * elem_size,
+           nr_chunks = div_ceil(bytes, chunk);
+    auto src = static_cast<const uint8_t*>(sendbuf);
+    auto dst = static_cast<uint8_t*>(recvbuf);
+    for (size_t i = 0; i < nr_chunks; ++i) {
+        size_t off = i * chunk;
+        impl.tree_reduce_chunk(src + off, m_rank == root ? dst + off : nullptr,
+                               std::min(chunk, bytes - off), i, root,
+                               elem_size, kern);
+    }
+}
+
+void ShmCommunicator::send(const void* sendbuf, size_t len, DType dtype,
+                           uint32_t peer) {
+    MGB_LOCK_GUARD(m_mtx);
+    auto&& impl = *m_impl;
+    ++impl.op;
+    mgb_assert(peer < m_size && peer != m_rank);
+    size_t bytes = len * dtype.size(), chunk = impl.chunk_bytes,
+           nr_chunks = div_ceil(bytes, chunk);
+    auto src = static_cast<const uint8_t*>(sendbuf);
+    for (size_t i = 0; i < nr_chunks; ++i) {
+        size_t off = i * chunk;
+        auto slot = impl.acquire_slot();
+        memcpy(impl.slot_ptr(m_rank, slot), src + off,
+               std::min(chunk, bytes - off));
+        impl.post(slot, i, {peer});
+    }
+}
+
+void ShmCommunicator::recv(void* recvbuf, size_t len, DType dtype,
+                           uint32_t peer) {
+    MGB_LOCK_GUARD(m_mtx);
+    auto&& impl = *m_impl;
+    ++impl.op;
+    mgb_assert(peer < m_size && peer != m_rank);
+    size_t bytes = len * dtype.size(), chunk = impl.chunk_bytes,
+           nr_chunks = div_ceil(bytes, chunk);
+    auto dst = static_cast<uint8_t*>(recvbuf);
+    for (size_t i = 0; i < nr_chunks; ++i) {
+        size_t off = i * chunk;
+        memcpy(dst + off, impl.wait(peer, i), std::min(chunk, bytes - off));
+        impl.ack(peer, i);
+    }
+}
+
+/* ================= ShmCommBuilder ================= */
+
+ShmCommBuilder::Entry& ShmCommBuilder::get_entry(uint64_t hash) {
+    MGB_LOCK_GUARD(m_map_mtx);
+    return m_comms[hash];
+}
+
+std::shared_ptr<ShmCommunicator> ShmCommBuilder::get_shm_comm(
+        uint64_t hash, const std::string& key, uint32_t size, uint32_t rank,
+        std::shared_ptr<GroupClient> group_client) {
+    static ShmCommBuilder inst;
+    auto&& entry = inst.get_entry(hash);
+    // only lock the entry while building, since ranks in the same process
+    // wait for each other
+    MGB_LOCK_GUARD(entry.mtx);
+    if (!entry.comm) {
+        entry.comm = std::make_shared<ShmCommunicator>(key, size, rank,
+                                                       *group_client);
+    }
+    return entry.comm;
+}
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
@@ -14,6 +14,7 @@
 #include "megbrain/graph.h"
 #include "megbrain/opr/internal/mixin_base.h"
 #include "megbrain/opr/group_manager.h"
+#include "megbrain/opr/shm_comm.h"
 
 #include "megray.h"
 
@@ -36,6 +37,8 @@ MGB_DEFINE_CLS_WITH_SUPER(RemoteIOBase, cg::SingleCNOperatorNodeBase) // {
         std::shared_ptr<GroupClient> m_group_client;
         std::shared_ptr<MegRay::Communicator> m_megray_comm;
         std::shared_ptr<MegRay::Context> m_megray_ctx;
+        //! used instead of m_megray_comm on CPU comp nodes
+        std::shared_ptr<ShmCommunicator> m_shm_comm;
         bool m_init = false;
         using Super::Super;
 };
@@ -0,0 +1,119 @@
+/**
+ * \file src/opr-mm/include/megbrain/opr/shm_comm.h
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+#include <mutex>
+#include <unordered_map>
+
+#include "megbrain/opr/group_manager.h"
+#include "megbrain/utils/metahelper.h"
+
+namespace mgb {
+namespace opr {
+
+/*!
+ * \brief collective communication between processes (or threads) on the same
+ *      host through POSIX shared memory, used for CPU comp nodes
+ *
+ * Each rank owns a few slots in a shared segment, and data is moved in chunks
+ * of one slot, so that transfers are pipelined among the ranks. A slot is
+ * published by storing a tag into its flag, and is reused only after all of
+ * its readers have acknowledged the tag.
+ *
+ * ALL_REDUCE uses a ring (reduce-scatter followed by all-gather) for large
+ * messages and a binary tree (reduce followed by broadcast) for messages not
+ * larger than MGB_SHM_COMM_TREE_THRESHOLD bytes. REDUCE_SCATTER and
+ * ALL_GATHER always use the ring, while BROADCAST and REDUCE use the tree.
+ * Setting MGB_SHM_COMM_ALGO to RING or TREE forces the algorithm of
+ * ALL_REDUCE, and MGB_SHM_COMM_CHUNK sets the slot size in bytes. All ranks
+ * must use the same settings.
+ *
+ * A rank waiting for another one throws TimeoutError after
+ * MGB_SHM_COMM_TIMEOUT seconds (600 by default), or SystemError once the
+ * process of the other rank has exited.
+ */
+class ShmCommunicator final : public NonCopyableObj {
+public:
+    enum class ReduceOp : uint32_t { SUM, MAX, MIN };
+
+    /*!
+     * \brief create the communicator; the segment is created by rank 0 and
+     *      its name is broadcast through \p group_client under \p key
+     */
+    ShmCommunicator(const std::string& key, uint32_t size, uint32_t rank,
+                    GroupClient& group_client);
+
+    ~ShmCommunicator();
+
+    uint32_t size() const { return m_size; }
+    uint32_t rank() const { return m_rank; }
+
+    //! \p len is the number of elements in each buffer
+    void all_reduce(const void* sendbuf, void* recvbuf, size_t len,
+                    DType dtype, ReduceOp op);
+
+    //! rank i receives the i-th part, which contains \p recvlen elements
+    void reduce_scatter(const void* sendbuf, void* recvbuf, size_t recvlen,
+                        DType dtype, ReduceOp op);
+
+    void all_gather(const void* sendbuf, void* recvbuf, size_t sendlen,
+                    DType dtype);
+
+    //! \p sendbuf is only used on \p root
+    void broadcast(const void* sendbuf, void* recvbuf, size_t len,
+                   DType dtype, uint32_t root);
+
+    //! \p recvbuf is only used on \p root
+    void reduce(const void* sendbuf, void* recvbuf, size_t len, DType dtype,
+                ReduceOp op, uint32_t root);
+
+    /*!
+     * \brief point-to-point transfer; every call counts as a collective op,
+     *      so it should only be used by communicators of two ranks
+     */
+    void send(const void* sendbuf, size_t len, DType dtype, uint32_t peer);
+
+    void recv(void* recvbuf, size_t len, DType dtype, uint32_t peer);
+
+private:
+    struct Impl;
+
+    const uint32_t m_size, m_rank;
+    std::unique_ptr<Impl> m_impl;
+    std::mutex m_mtx;
+};
+
+/*!
+ * build shared memory communicators, use hash for deduplication
+ */
+class ShmCommBuilder {
+    struct Entry {
+        std::mutex mtx;
+        std::shared_ptr<ShmCommunicator> comm;
+    };
+
+    //! find or insert the entry of given hash
+    Entry& get_entry(uint64_t hash);
+
+    std::unordered_map<uint64_t, Entry> m_comms;
+    std::mutex m_map_mtx;
+
+public:
+    static std::shared_ptr<ShmCommunicator> get_shm_comm(
+            uint64_t hash, const std::string& key, uint32_t size, uint32_t rank,
+            std::shared_ptr<GroupClient> group_client);
+};
+
+}  // namespace opr
+}  // namespace mgb
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
@@ -1800,3 +1800,156 @@ TEST(TestOprCollectiveComm, AllToAllWithGradThisNodeOnly) {
     MGB_ASSERT_TENSOR_EQ(host_expect_grad0, host_grad0);
     MGB_ASSERT_TENSOR_EQ(host_expect_grad1, host_grad1);
 }
+
+TEST(TestOprCollectiveComm, AllReduceShm) {
+    auto cn0 = CompNode::load("cpu0");
+    auto cn1 = CompNode::load("cpu1");
+
+    // the small shape is reduced along a tree and the large one along a ring
+    auto run_mode = [&](const Mode mode, const TensorShape& shape) {
+        HostTensorGenerator<> gen;
+        auto host_x0 = gen(shape);
+        auto host_x1 = gen(shape);
+        HostTensorND host_y0, host_y1, host_y_expect;
+
+        auto client = std::make_shared<test::MockGroupClient>();
+        auto graph = ComputingGraph::make();
+
+        auto x0 = opr::Host2DeviceCopy::make(*graph, host_x0, cn0);
+        auto x1 = opr::Host2DeviceCopy::make(*graph, host_x1, cn1);
+
+        auto y0 = opr::CollectiveComm::make({x0}, graph.get(), "all_reduce", 2,
+                                            false, 0, false, client, {mode},
+                                            dtype::Float32(), "shm")[0];
+        auto y1 = opr::CollectiveComm::make({x1}, graph.get(), "all_reduce", 2,
+                                            false, 1, false, client, {mode},
+                                            dtype::Float32(), "shm")[0];
+        auto y_expect = make_all_reduce_output(
+                mode, {x0, opr::Copy::make(x1, cn0)});
+
+        auto func =
+                graph->compile({make_callback_copy(y0, host_y0),
+                                make_callback_copy(y1, host_y1),
+                                make_callback_copy(y_expect, host_y_expect)});
+        func->execute();
+
+        MGB_ASSERT_TENSOR_EQ(host_y_expect, host_y0);
+        MGB_ASSERT_TENSOR_EQ(host_y_expect, host_y1);
+    };
+
+    for (auto&& shape : {TensorShape{28, 28}, TensorShape{257, 1023}}) {
+        run_mode(Mode::ALL_REDUCE_MAX, shape);
+        run_mode(Mode::ALL_REDUCE_MIN, shape);
+        run_mode(Mode::ALL_REDUCE_SUM, shape);
+    }
+}
+
+TEST(TestOprCollectiveComm, AllGatherShm) {
+    auto cn0 = CompNode::load("cpu0");
+    auto cn1 = CompNode::load("cpu1");
+
+    HostTensorGenerator<> gen;
+    auto host_x0 = gen({256, 513});
+    auto host_x1 = gen({256, 513});
+    HostTensorND host_y0, host_y1, host_y_expect;
+
+    auto client = std::make_shared<test::MockGroupClient>();
+    auto graph = ComputingGraph::make();
+
+    auto x0 = opr::Host2DeviceCopy::make(*graph, host_x0, cn0);
+    auto x1 = opr::Host2DeviceCopy::make(*graph, host_x1, cn1);
+
+    auto y0 = opr::CollectiveComm::make(
+            {x0}, graph.get(), "all_gather", 2, false, 0, false, client,
+            {Mode::ALL_GATHER}, dtype::Float32(), "shm")[0];
+    auto y1 = opr::CollectiveComm::make(
+            {x1}, graph.get(), "all_gather", 2, false, 1, false, client,
+            {Mode::ALL_GATHER}, dtype::Float32(), "shm")[0];
+    auto y_expect = opr::Concat::make({x0, opr::Copy::make(x1, cn0)}, 0);
+
+    auto func = graph->compile({make_callback_copy(y0, host_y0),
+                                make_callback_copy(y1, host_y1),
+                                make_callback_copy(y_expect, host_y_expect)});
+    func->execute();
+
+    MGB_ASSERT_TENSOR_EQ(host_y_expect, host_y0);
+    MGB_ASSERT_TENSOR_EQ(host_y_expect, host_y1);
+}
+
+TEST(TestOprCollectiveComm, ReduceScatterSumShm) {
+    auto cn0 = CompNode::load("cpu0");
+    auto cn1 = CompNode::load("cpu1");
+
+    HostTensorGenerator<> gen;
+    auto host_x0 = gen({256, 513});
+    auto host_x1 = gen({256, 513});
+    HostTensorND host_y0, host_y1, host_y0_expect, host_y1_expect;
+
+    auto client = std::make_shared<test::MockGroupClient>();
+    auto graph = ComputingGraph::make();
+
+    auto x0 = opr::Host2DeviceCopy::make(*graph, host_x0, cn0);
+    auto x1 = opr::Host2DeviceCopy::make(*graph, host_x1, cn1);
+
+    auto y0 = opr::CollectiveComm::make(
+            {x0}, graph.get(), "reduce_scatter_sum", 2, false, 0, false,
+            client, {Mode::REDUCE_SCATTER_SUM}, dtype::Float32(), "shm")[0];
+    auto y1 = opr::CollectiveComm::make(
+            {x1}, graph.get(), "reduce_scatter_sum", 2, false, 1, false,
+            client, {Mode::REDUCE_SCATTER_SUM}, dtype::Float32(), "shm")[0];
+    auto y_expect = make_reduce_scatter_sum_output(
+            {x0, opr::Copy::make(x1, cn0)});
+
+    auto func = graph->compile(
+            {make_callback_copy(y0, host_y0), make_callback_copy(y1, host_y1),
+             make_callback_copy(y_expect[0], host_y0_expect),
+             make_callback_copy(y_expect[1], host_y1_expect)});
+    func->execute();
+
+    MGB_ASSERT_TENSOR_EQ(host_y0_expect, host_y0);
+    MGB_ASSERT_TENSOR_EQ(host_y1_expect, host_y1);
+}
+
+TEST(TestOprCollectiveComm, BroadcastShmMultiThread) {
+    auto cn0 = CompNode::load("cpu0");
+    auto cn1 = CompNode::load("cpu1");
+
+    HostTensorGenerator<> gen;
+    auto host_x0 = gen({28, 28});
+    HostTensorND host_y0, host_y1;
+
+    auto client = std::make_shared<test::MockGroupClient>();
+
+    auto run_0 = [&]() {  // rank 0
+        auto graph0 = ComputingGraph::make();
+        auto x0 = opr::Host2DeviceCopy::make(*graph0, host_x0, cn0);
+        auto y0 = opr::CollectiveComm::make(
+                {x0}, graph0.get(), "broadcast", 2, true, 0, false, client,
+                {Mode::BROADCAST}, dtype::Float32(), "shm")[0];
+        auto func0 = graph0->compile({make_callback_copy(y0, host_y0)});
+        func0->execute();
+    };
+
+    auto run_1 = [&]() {  // rank 1
+        auto graph1 = ComputingGraph::make();
+        auto y_dev = std::make_shared<DeviceTensorND>(
+                DeviceTensorND()
+                        .comp_node(cn1)
+                        .dtype(dtype::Float32())
+                        .resize(host_x0->shape()));
+        auto y1 = opr::CollectiveComm::make(
+                {}, graph1.get(), "broadcast", 2, false, 1, false, client,
+                {y_dev}, {Mode::BROADCAST}, dtype::Float32(), "shm", {cn1})[0];
+        auto func1 = graph1->compile({make_callback_copy(y1, host_y1)});
+        func1->execute();
+    };
+
+    std::thread t0(run_0);
+    std::thread t1(run_1);
+
+    t0.join();
+    t1.join();
+
+    MGB_ASSERT_TENSOR_EQ(*host_x0, host_y0);
+    MGB_ASSERT_TENSOR_EQ(*host_x0, host_y1);
+}
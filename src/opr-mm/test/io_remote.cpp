@@ -215,3 +215,27 @@ TEST(TestOprIORemote, SendGrad) {
         MGB_ASSERT_FLOAT_EQ(px[i] + 1.f, pgx[i]);
     }
 }
+
+TEST(TestOprIORemote, IdentityShm) {
+    auto cn0 = CompNode::load("cpu0");
+    auto cn1 = CompNode::load("cpu1");
+
+    HostTensorGenerator<> gen;
+    auto host_x = gen({256, 513});
+    HostTensorND host_y;
+
+    auto client = std::make_shared<test::MockGroupClient>();
+    auto graph = ComputingGraph::make();
+
+    auto x = opr::Host2DeviceCopy::make(*graph, host_x, cn0);
+    auto xr = opr::RemoteSend::make("x", x, client, false);
+    auto y = opr::RemoteRecv::make("x", *graph.get(),
+                                   client, {cn1}, host_x->shape(),
+                                   host_x->dtype());
+
+    auto func = graph->compile({{xr, {}}, make_callback_copy(y, host_y)});
+
+    func->execute();
+
+    MGB_ASSERT_TENSOR_EQ(*host_x, host_y);
+}
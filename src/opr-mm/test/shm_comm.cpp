@@ -0,0 +1,162 @@
+/**
+ * \file src/opr-mm/test/shm_comm.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "megbrain/opr/shm_comm.h"
+#include "megbrain/test/helper.h"
+#include "mock_client.h"
+
+#include <dirent.h>
+#include <unistd.h>
+#include <thread>
+
+using namespace mgb;
+using ReduceOp = opr::ShmCommunicator::ReduceOp;
+
+namespace {
+
+//! run \p func(comm) on \p size ranks, each in its own thread
+template <typename Func>
+void run_ranks(uint32_t size, Func&& func) {
+    auto client = std::make_shared<test::MockGroupClient>();
+    std::vector<std::thread> workers;
+    for (uint32_t rank = 0; rank < size; ++rank) {
+        workers.emplace_back([&, rank]() {
+            opr::ShmCommunicator comm{"shm_comm_test", size, rank, *client};
+            func(comm);
+        });
+    }
+    for (auto&& i : workers) {
+        i.join();
+    }
+}
+
+std::vector<std::vector<float>> gen_inputs(uint32_t size, size_t len) {
+    std::vector<std::vector<float>> ret(size);
+    for (uint32_t i = 0; i < size; ++i) {
+        ret[i].resize(len);
+        for (size_t j = 0; j < len; ++j) {
+            ret[i][j] = static_cast<float>((i * 7 + j * 3) % 17) - 8;
+        }
+    }
+    return ret;
+}
+
+//! number of shm segments created by this process that are not unlinked
+size_t nr_shm_segments() {
+    auto prefix = ssprintf("mgb_shm_comm_%d_", static_cast<int>(getpid()));
+    size_t ret = 0;
+    if (auto dir = opendir("/dev/shm")) {
+        while (auto ent = readdir(dir)) {
+            ret += !strncmp(ent->d_name, prefix.c_str(), prefix.size());
+        }
+        closedir(dir);
+    }
+    return ret;
+}
+
+}  // anonymous namespace
+
+TEST(TestShmComm, AllReduce) {
+    constexpr uint32_t SIZE = 3;
+    // the small message is reduced along a tree and the large one along a
+    // ring, split into multiple chunks
+    for (size_t len : {100, 100003}) {
+        auto inputs = gen_inputs(SIZE, len);
+        std::vector<std::vector<float>> outputs(SIZE,
+                                                std::vector<float>(len));
+        run_ranks(SIZE, [&](opr::ShmCommunicator& comm) {
+            auto rank = comm.rank();
+            comm.all_reduce(inputs[rank].data(), outputs[rank].data(), len,
+                            dtype::Float32(), ReduceOp::SUM);
+        });
+        for (size_t j = 0; j < len; ++j) {
+            float expect = 0;
+            for (uint32_t i = 0; i < SIZE; ++i) {
+                expect += inputs[i][j];
+            }
+            for (uint32_t i = 0; i < SIZE; ++i) {
+                ASSERT_EQ(expect, outputs[i][j])
+                        << "len=" << len << " j=" << j;
+            }
+        }
+    }
+}
+
+TEST(TestShmComm, ReduceScatterAllGather) {
+    constexpr uint32_t SIZE = 4;
+    constexpr size_t LEN = 50001;
+    auto inputs = gen_inputs(SIZE, LEN * SIZE);
+    std::vector<std::vector<float>> scattered(SIZE, std::vector<float>(LEN)),
+            gathered(SIZE, std::vector<float>(LEN * SIZE));
+    run_ranks(SIZE, [&](opr::ShmCommunicator& comm) {
+        auto rank = comm.rank();
+        comm.reduce_scatter(inputs[rank].data(), scattered[rank].data(), LEN,
+                            dtype::Float32(), ReduceOp::MAX);
+        comm.all_gather(scattered[rank].data(), gathered[rank].data(), LEN,
+                        dtype::Float32());
+    });
+    for (size_t j = 0; j < LEN * SIZE; ++j) {
+        float expect = inputs[0][j];
+        for (uint32_t i = 1; i < SIZE; ++i) {
+            expect = std::max(expect, inputs[i][j]);
+        }
+        ASSERT_EQ(expect, scattered[j / LEN][j % LEN]);
+        for (uint32_t i = 0; i < SIZE; ++i) {
+            ASSERT_EQ(expect, gathered[i][j]);
+        }
+    }
+}
+
+TEST(TestShmComm, BroadcastReduceSendRecv) {
+    constexpr uint32_t SIZE = 2;
+    constexpr size_t LEN = 70001;
+    auto inputs = gen_inputs(SIZE, LEN);
+    std::vector<std::vector<float>> bcast(SIZE, std::vector<float>(LEN)),
+            reduced(SIZE, std::vector<float>(LEN)),
+            received(SIZE, std::vector<float>(LEN));
+    run_ranks(SIZE, [&](opr::ShmCommunicator& comm) {
+        auto rank = comm.rank();
+        comm.broadcast(inputs[rank].data(), bcast[rank].data(), LEN,
+                       dtype::Float32(), 1);
+        comm.reduce(inputs[rank].data(), reduced[rank].data(), LEN,
+                    dtype::Float32(), ReduceOp::MIN, 0);
+        if (rank == 0) {
+            comm.send(inputs[0].data(), LEN, dtype::Float32(), 1);
+        } else {
+            comm.recv(received[1].data(), LEN, dtype::Float32(), 0);
+        }
+    });
+    for (size_t j = 0; j < LEN; ++j) {
+        ASSERT_EQ(inputs[1][j], bcast[0][j]);
+        ASSERT_EQ(inputs[1][j], bcast[1][j]);
+        ASSERT_EQ(std::min(inputs[0][j], inputs[1][j]), reduced[0][j]);
+        ASSERT_EQ(inputs[0][j], received[1][j]);
+    }
+}
+
+TEST(TestShmComm, Timeout) {
+    setenv("MGB_SHM_COMM_TIMEOUT", "1", 1);
+    auto client = std::make_shared<test::MockGroupClient>();
+    // rank 1 never attaches
+    std::thread rank1{[&]() {
+        std::string name;
+        int port = 0;
+        client->bcast_addr(name, port, "shm_comm_timeout", 2, 1, 0);
+    }};
+    ASSERT_THROW(opr::ShmCommunicator("shm_comm_timeout", 2, 0, *client),
+                 TimeoutError);
+    rank1.join();
+    unsetenv("MGB_SHM_COMM_TIMEOUT");
+    // the segment is removed on failure
+    ASSERT_EQ(0u, nr_shm_segments());
+}
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
@@ -0,0 +1,439 @@
+/**
+ * \file src/plugin/impl/perf_counter.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "megbrain/plugin/perf_counter.h"
+#include "megbrain/comp_node_env.h"
+#include "megbrain/graph/event.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <unordered_set>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define MGB_HAVE_PERF_EVENT 1
+#else
+#define MGB_HAVE_PERF_EVENT 0
+#endif
+
+using namespace mgb;
+
+namespace {
+//! size of a cache line, used to estimate DRAM traffic from LLC misses
+constexpr double CACHE_LINE_SIZE = 64;
+}  // anonymous namespace
+
+/* ===================== ThreadCounters ===================== */
+
+/*!
+ * \brief a group of perf events for each thread in the process
+ *
+ * Threads are discovered from /proc/self/task by refresh(); counts of exited
+ * threads are kept so that the sum never decreases.
+ */
+class PerfCounterProfiler::ThreadCounters {
+    bool m_available = MGB_HAVE_PERF_EVENT;
+    std::mutex m_mtx;
+#if MGB_HAVE_PERF_EVENT
+    static constexpr size_t NR_EVENT = 4;
+
+    //! tid => fds of the events, the first one is the group leader
+    std::unordered_map<pid_t, std::vector<int>> m_tid2fds;
+    Counters m_exited;
+
+    static int perf_event_open(perf_event_attr* attr, pid_t tid, int group_fd) {
+        return syscall(__NR_perf_event_open, attr, tid, -1, group_fd, 0);
+    }
+
+    static std::vector<int> open_group(pid_t tid) {
+        static const uint64_t configs[NR_EVENT] = {
+                PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                PERF_COUNT_HW_CACHE_REFERENCES, PERF_COUNT_HW_CACHE_MISSES};
+        std::vector<int> fds;
+        for (auto config : configs) {
+            perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = config;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP |
+                               PERF_FORMAT_TOTAL_TIME_ENABLED |
+                               PERF_FORMAT_TOTAL_TIME_RUNNING;
+            int fd = perf_event_open(&attr, tid, fds.empty() ? -1 : fds[0]);
+            if (fd < 0) {
+                for (auto i : fds) {
+                    close(i);
+                }
+                return {};
+            }
+            fds.push_back(fd);
+        }
+        return fds;
+    }
+
+    static bool read_group(int leader, Counters& dest) {
+        struct {
+            uint64_t nr, time_enabled, time_running, values[NR_EVENT];
+        } buf;
+        if (::read(leader, &buf, sizeof(buf)) !=
+                    static_cast<ssize_t>(sizeof(buf)) ||
+            buf.nr != NR_EVENT) {
+            return false;
+        }
+        // scale the counts if the events have been multiplexed
+        double scale = buf.time_running
+                               ? static_cast<double>(buf.time_enabled) /
+                                         buf.time_running
+                               : 0;
+        dest.cycles = buf.values[0] * scale;
+        dest.instructions = buf.values[1] * scale;
+        dest.cache_refs = buf.values[2] * scale;
+        dest.cache_misses = buf.values[3] * scale;
+        return true;
+    }
+
+    static void close_group(const std::vector<int>& fds) {
+        for (auto i : fds) {
+            close(i);
+        }
+    }
+#endif
+
+public:
+    ~ThreadCounters() {
+#if MGB_HAVE_PERF_EVENT
+        for (auto&& i : m_tid2fds) {
+            close_group(i.second);
+        }
+#endif
+    }
+
+    bool available() const { return m_available; }
+
+    //! open counters for new threads and close those of exited threads
+    void refresh() {
+#if MGB_HAVE_PERF_EVENT
+        MGB_LOCK_GUARD(m_mtx);
+        if (!m_available) {
+            return;
+        }
+        auto dir = opendir("/proc/self/task");
+        if (!dir) {
+            return;
+        }
+        std::unordered_set<pid_t> alive;
+        while (auto ent = readdir(dir)) {
+            if (ent->d_name[0] == '.') {
+                continue;
+            }
+            auto tid = static_cast<pid_t>(std::atoi(ent->d_name));
+            alive.insert(tid);
+            if (m_tid2fds.count(tid)) {
+                continue;
+            }
+            auto fds = open_group(tid);
+            if (fds.empty()) {
+                if (m_tid2fds.empty()) {
+                    mgb_log_warn(
+                            "failed to open perf events: %s; only timing "
+                            "based metrics would be reported",
+                            strerror(errno));
+                    m_available = false;
+                    break;
+                }
+                // the thread may have just exited
+                continue;
+            }
+            m_tid2fds[tid] = std::move(fds);
+        }
+        closedir(dir);
+        for (auto iter = m_tid2fds.begin(); iter != m_tid2fds.end();) {
+            if (!alive.count(iter->first)) {
+                Counters cnt;
+                if (read_group(iter->second[0], cnt)) {
+                    m_exited += cnt;
+                }
+                close_group(iter->second);
+                iter = m_tid2fds.erase(iter);
+            } else {
+                ++iter;
+            }
+        }
+#endif
+    }
+
+    //! sum of the counters of all threads
+    Counters read() {
+        Counters ret;
+#if MGB_HAVE_PERF_EVENT
+        MGB_LOCK_GUARD(m_mtx);
+        ret = m_exited;
+        for (auto&& i : m_tid2fds) {
+            Counters cnt;
+            if (read_group(i.second[0], cnt)) {
+                ret += cnt;
+            }
+        }
+#endif
+        return ret;
+    }
+};
+
+/* ===================== Roofline ===================== */
+
+PerfCounterProfiler::Roofline PerfCounterProfiler::Roofline::measure(
+        CompNode cn) {
+    Roofline ret;
+    if (auto env = MGB_GETENV("MGB_ROOFLINE")) {
+        auto nr = sscanf(env, "%lf:%lf", &ret.gflops, &ret.gbps);
+        mgb_assert(nr == 2, "bad MGB_ROOFLINE: %s", env);
+        return ret;
+    }
+    mgb_assert(cn.device_type() == CompNode::DeviceType::CPU);
+    auto&& env = CompNodeEnv::from_comp_node(cn).cpu_env();
+    // sub tasks are distributed to all the threads of the comp node
+    constexpr size_t NR_TASK = 64, NR_REPEAT = 3;
+    auto run = [&](MultiThreadingTask task) {
+        double best = std::numeric_limits<double>::infinity();
+        for (size_t i = 0; i < NR_REPEAT; ++i) {
+            RealTimer timer;
+            env.dispatch(MultiThreadingTask{task}, NR_TASK);
+            cn.sync();
+            best = std::min(best, timer.get_secs());
+        }
+        return best;
+    };
+
+    {
+        // a scaling copy much larger than the last level cache
+        constexpr size_t SIZE = 64 * 1024 * 1024 / sizeof(float);
+        std::unique_ptr<float[]> src{new float[SIZE]}, dst{new float[SIZE]};
+        std::fill_n(src.get(), SIZE, 1.f);
+        std::fill_n(dst.get(), SIZE, 0.f);
+        auto time = run([&](size_t id, size_t) {
+            auto sptr = src.get(), dptr = dst.get();
+            for (size_t i = SIZE * id / NR_TASK, it = SIZE * (id + 1) / NR_TASK;
+                 i < it; ++i) {
+                dptr[i] = sptr[i] * 1.5f;
+            }
+        });
+        ret.gbps = 2 * SIZE * sizeof(float) / time / 1e9;
+    }
+
+    {
+        // independent multiply-add chains which can be vectorized and
+        // pipelined
+        constexpr size_t NR_LANE = 64, NR_ITER = 1 << 15;
+        float sink[NR_TASK];
+        volatile float mul = 0.999f, add = 1e-3f;
+        float m = mul, a = add;
+        auto time = run([&](size_t id, size_t) {
+            float acc[NR_LANE];
+            for (size_t i = 0; i < NR_LANE; ++i) {
+                acc[i] = i + id;
+            }
+            for (size_t iter = 0; iter < NR_ITER; ++iter) {
+                for (size_t i = 0; i < NR_LANE; ++i) {
+                    acc[i] = acc[i] * m + a;
+                }
+            }
+            sink[id] = std::accumulate(acc, acc + NR_LANE, 0.f);
+        });
+        mgb_assert(std::isfinite(std::accumulate(sink, sink + NR_TASK, 0.f)));
+        ret.gflops = 2. * NR_TASK * NR_ITER * NR_LANE / time / 1e9;
+    }
+    return ret;
+}
+
+/* ===================== PerfCounterProfiler ===================== */
+
+PerfCounterProfiler::Counters& PerfCounterProfiler::Counters::operator+=(
+        const Counters& rhs) {
+    cycles += rhs.cycles;
+    instructions += rhs.instructions;
+    cache_refs += rhs.cache_refs;
+    cache_misses += rhs.cache_misses;
+    return *this;
+}
+
+PerfCounterProfiler::Counters PerfCounterProfiler::Counters::operator-(
+        const Counters& rhs) const {
+    Counters ret;
+    ret.cycles = cycles - rhs.cycles;
+    ret.instructions = instructions - rhs.instructions;
+    ret.cache_refs = cache_refs - rhs.cache_refs;
+    ret.cache_misses = cache_misses - rhs.cache_misses;
+    return ret;
+}
+
+PerfCounterProfiler::PerfCounterProfiler(cg::ComputingGraph* graph)
+        : PluginBase(graph), m_thread_counters{new ThreadCounters} {
+    using namespace cg::event;
+    auto is_cpu = [](CompNode cn) {
+        return cn.device_type() == CompNode::DeviceType::CPU;
+    };
+    auto on_seq_start = [this, is_cpu](const CompSeqExecBeforeStart& event) {
+        for (auto cn : *event.used_comp_node) {
+            if (is_cpu(cn) && !m_roofline.count(cn)) {
+                m_roofline[cn] = Roofline::measure(cn);
+            }
+        }
+        // the threads are only created before the execution
+        m_thread_counters->refresh();
+    };
+    auto on_kern_start = [this, is_cpu](const OprExecKernelStart& event) {
+        for (auto cn : cg::get_opr_comp_node_set(event.opr)) {
+            if (is_cpu(cn)) {
+                auto callback = [this, cn, opr = event.opr]() {
+                    this->on_kern_start(opr, cn);
+                };
+                event.env->dispatch_on_comp_node(cn, callback);
+            }
+        }
+    };
+    auto on_kern_end = [this, is_cpu](const OprExecKernelEnd& event) {
+        auto footprint = m_opr_footprint.calc_footprint(event.opr);
+        double computation = footprint.computation, memory = footprint.memory;
+        for (auto cn : cg::get_opr_comp_node_set(event.opr)) {
+            if (is_cpu(cn)) {
+                auto callback = [this, cn, opr = event.opr, computation,
+                                 memory]() {
+                    this->on_kern_end(opr, cn, computation, memory);
+                };
+                event.env->dispatch_on_comp_node(cn, callback);
+            }
+        }
+    };
+    auto on_graph_compile = [this](const CompSeqOrderDetermined&) {
+        MGB_LOCK_GUARD(m_mtx);
+        m_kern_start.clear();
+        m_opr_stats.clear();
+    };
+
+    auto&& ev = graph->event();
+    add_event_handler(
+            ev.register_receiver<CompSeqExecBeforeStart>(on_seq_start));
+    add_event_handler(ev.register_receiver<OprExecKernelStart>(on_kern_start));
+    add_event_handler(ev.register_receiver<OprExecKernelEnd>(on_kern_end));
+    add_event_handler(
+            ev.register_receiver<CompSeqOrderDetermined>(on_graph_compile));
+}
+
+PerfCounterProfiler::~PerfCounterProfiler() noexcept = default;
+
+bool PerfCounterProfiler::counters_available() const {
+    return m_thread_counters->available();
+}
+
+void PerfCounterProfiler::on_kern_start(cg::OperatorNodeBase* opr,
+                                        CompNode cn) {
+    KernStart start;
+    start.counters = m_thread_counters->read();
+    start.time = m_timer.get_secs();
+    MGB_LOCK_GUARD(m_mtx);
+    m_kern_start[{opr, cn}] = start;
+}
+
+void PerfCounterProfiler::on_kern_end(cg::OperatorNodeBase* opr, CompNode cn,
+                                      double computation, double memory) {
+    auto time = m_timer.get_secs();
+    auto counters = m_thread_counters->read();
+    MGB_LOCK_GUARD(m_mtx);
+    auto iter = m_kern_start.find({opr, cn});
+    if (iter == m_kern_start.end()) {
+        return;
+    }
+    auto&& stat = m_opr_stats[opr];
+    stat.comp_node = cn;
+    ++stat.nr_exec;
+    stat.time += time - iter->second.time;
+    stat.computation += computation;
+    stat.memory += memory;
+    stat.counters += counters - iter->second.counters;
+    m_kern_start.erase(iter);
+}
+
+#if MGB_ENABLE_JSON
+std::shared_ptr<json::Object> PerfCounterProfiler::to_json() const {
+    using namespace json;
+    auto roofline = Object::make();
+    for (auto&& i : m_roofline) {
+        (*roofline)[i.first.to_string()] =
+                Object::make({{"gflops", Number::make(i.second.gflops)},
+                              {"gbps", Number::make(i.second.gbps)},
+                              {"ridge", Number::make(i.second.ridge())}});
+    }
+
+    auto oprs = Object::make();
+    for (auto&& i : m_opr_stats) {
+        auto opr = i.first;
+        auto&& stat = i.second;
+        auto obj_ptr = Object::make();
+        auto&& obj = *obj_ptr;
+        obj["name"] = String::make(opr->name());
+        obj["type"] = String::make(opr->dyn_typeinfo()->name);
+        obj["comp_node"] = String::make(stat.comp_node.to_string());
+        obj["nr_exec"] = NumberInt::make(stat.nr_exec);
+        obj["time"] = Number::make(stat.time);
+        obj["computation"] = Number::make(stat.computation);
+        obj["memory"] = Number::make(stat.memory);
+        if (stat.time > 0) {
+            obj["gflops"] = Number::make(stat.computation / stat.time / 1e9);
+            obj["gbps"] = Number::make(stat.memory / stat.time / 1e9);
+        }
+        auto rl = m_roofline.find(stat.comp_node);
+        if (stat.memory > 0 && stat.computation > 0) {
+            double intensity = stat.computation / stat.memory;
+            obj["arith_intensity"] = Number::make(intensity);
+            if (rl != m_roofline.end() && stat.time > 0) {
+                auto&& peak = rl->second;
+                // fraction of the attainable throughput given by the roofline
+                double attainable =
+                        std::min(peak.gflops, intensity * peak.gbps);
+                obj["bound"] = String::make(
+                        intensity < peak.ridge() ? "memory" : "compute");
+                obj["roofline_ratio"] = Number::make(
+                        stat.computation / stat.time / 1e9 / attainable);
+            }
+        }
+        if (counters_available()) {
+            auto&& cnt = stat.counters;
+            obj["cycles"] = Number::make(cnt.cycles);
+            obj["instructions"] = Number::make(cnt.instructions);
+            obj["llc_refs"] = Number::make(cnt.cache_refs);
+            obj["llc_misses"] = Number::make(cnt.cache_misses);
+            if (cnt.cycles > 0) {
+                obj["ipc"] = Number::make(cnt.instructions / cnt.cycles);
+            }
+            if (stat.time > 0) {
+                // each LLC miss is assumed to move a cache line from DRAM
+                obj["dram_gbps"] = Number::make(
+                        cnt.cache_misses * CACHE_LINE_SIZE / stat.time / 1e9);
+            }
+        }
+        (*oprs)[opr->id_str()] = obj_ptr;
+    }
+    return Object::make({{"roofline", roofline},
+                         {"counters_available",
+                          Bool::make(counters_available())},
+                         {"opr", oprs}});
+}
+#endif
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
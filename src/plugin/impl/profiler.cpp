@@ -16,13 +16,17 @@
 #include "megbrain/graph/event.h"
 #include "megbrain/opr/io.h"
 #include "megbrain/system.h"
+#include "megbrain/utils/trace_event.h"
 
 using namespace mgb;
 using namespace cg;
 
 MGB_TYPEINFO_OBJ_IMPL(opr_profile::OprProfileHolder);
 
-GraphProfiler::GraphProfiler(cg::ComputingGraph* graph) : PluginBase(graph) {
+GraphProfiler::GraphProfiler(cg::ComputingGraph* graph)
+        : PluginBase(graph),
+          m_trace_timer_base{TraceEventRecorder::now() -
+                             m_timer.get_secs() * 1e6} {
     graph->options()
             .user_data.get_user_data_or_create<opr_profile::OprProfileHolder>();
 
@@ -58,8 +62,15 @@ GraphProfiler::GraphProfiler(cg::ComputingGraph* graph) : PluginBase(graph) {
         for (auto&& comp_node : get_opr_comp_node_set(event.opr)) {
             auto runner = [this, opr]() {
                 MGB_LOCK_GUARD(m_mtx);
-                m_host_time[{opr, std::this_thread::get_id()}].end =
-                        m_timer.get_secs();
+                auto&& hev = m_host_time[{opr, std::this_thread::get_id()}];
+                hev.end = m_timer.get_secs();
+                if (TraceEventRecorder::enabled()) {
+                    TraceEventRecorder::inst().add_span(
+                            "opr", opr->name(),
+                            m_trace_timer_base + hev.start * 1e6,
+                            m_trace_timer_base + hev.end * 1e6,
+                            {{"id", opr->id()}});
+                }
             };
             event.env->dispatch_on_comp_node(comp_node, runner);
         }
@@ -99,6 +110,7 @@ GraphProfiler::GraphProfiler(cg::ComputingGraph* graph) : PluginBase(graph) {
         m_kern_event.clear();
         m_opr_fp_rst.clear();
         m_start_of_time = None;
+        m_trace_start_of_time.clear();
     };
     auto&& ev = graph->event();
     add_event_handler(
@@ -137,6 +149,8 @@ void GraphProfiler::ensure_start_time() {
             auto&& event = m_start_of_time.val()[i];
             event = i.create_event(CompNode::Event::NEED_TIMER);
             event->record();
+            // the comp node is idle, so the event finishes immediately
+            m_trace_start_of_time[i] = TraceEventRecorder::now();
         }
     }
 }
@@ -219,6 +233,30 @@ std::shared_ptr<json::Object> GraphProfiler::to_json() const {
                          {"opr_internal_pf", opr_internal_pf}});
 }
 
+void GraphProfiler::record_trace_events() const {
+    auto&& recorder = TraceEventRecorder::inst();
+    if (!TraceEventRecorder::enabled()) {
+        return;
+    }
+    for (auto&& kern_ev : m_kern_event) {
+        auto opr = kern_ev.first.first;
+        auto comp_node = kern_ev.first.second;
+        auto&& event = kern_ev.second;
+        if (!event.kern || !event.end) {
+            continue;
+        }
+        auto&& start = m_start_of_time->at(comp_node);
+        auto base = m_trace_start_of_time.at(comp_node);
+        event.end->host_wait();
+        recorder.add_span(
+                recorder.track_id("device " + comp_node.to_string()), "kern",
+                opr->name(),
+                base + start->elapsed_time_until(*event.kern) * 1e6,
+                base + start->elapsed_time_until(*event.end) * 1e6,
+                {{"id", opr->id()}});
+    }
+}
+
 #endif  // MGB_ENABLE_JSON
 
 // vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
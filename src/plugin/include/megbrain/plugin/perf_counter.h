@@ -0,0 +1,117 @@
+/**
+ * \file src/plugin/include/megbrain/plugin/perf_counter.h
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+#include "megbrain/plugin/base.h"
+#include "megbrain/plugin/opr_footprint.h"
+#include "megbrain/utils/timer.h"
+
+#include <unordered_map>
+
+namespace mgb {
+
+/*!
+ * \brief collect hardware performance counters around the kernels of each
+ *      operator on cpu comp nodes, and compare the achieved throughput with
+ *      the roofline of the comp node
+ *
+ * Counters are read by perf_event_open(2) for all the threads in the process,
+ * so that the thread pool workers of multithread comp nodes are included;
+ * kernels running concurrently on other comp nodes are counted as well. If
+ * perf events are not available (e.g. restricted by perf_event_paranoid),
+ * only the time and footprint based metrics are reported.
+ *
+ * The roofline of each comp node is measured with all of its threads by a
+ * streaming kernel and an arithmetic kernel before the first execution. It
+ * can be overwritten by env var MGB_ROOFLINE in the format of
+ * "<GFLOP/s>:<GB/s>".
+ */
+class PerfCounterProfiler final : public PluginBase {
+public:
+    struct Roofline {
+        double gflops = 0;  //!< peak arithmetic throughput
+        double gbps = 0;    //!< peak memory bandwidth in GB/s
+
+        //! arithmetic intensity (flop per byte) where kernels become
+        //! compute bound
+        double ridge() const { return gbps > 0 ? gflops / gbps : 0; }
+
+        //! measure the roofline of a cpu comp node
+        static Roofline measure(CompNode cn);
+    };
+
+    struct Counters {
+        double cycles = 0, instructions = 0, cache_refs = 0, cache_misses = 0;
+
+        Counters& operator+=(const Counters& rhs);
+        Counters operator-(const Counters& rhs) const;
+    };
+
+    struct OprStat {
+        CompNode comp_node;
+        size_t nr_exec = 0;
+        //! total kernel time in seconds
+        double time = 0;
+        //! total computation and memory footprint given by OprFootprint
+        double computation = 0, memory = 0;
+        Counters counters;
+    };
+
+    PerfCounterProfiler(cg::ComputingGraph* graph);
+    ~PerfCounterProfiler() noexcept;
+
+    //! whether hardware counters could be opened
+    bool counters_available() const;
+
+    const CompNode::UnorderedMap<Roofline>& roofline() const {
+        return m_roofline;
+    }
+
+    const std::unordered_map<cg::OperatorNodeBase*, OprStat>& opr_stats()
+            const {
+        return m_opr_stats;
+    }
+
+#if MGB_ENABLE_JSON
+    /*!
+     * \brief achieved GFLOP/s, GB/s, arithmetic intensity and counters of
+     *      each operator, and the roofline of each comp node
+     */
+    std::shared_ptr<json::Object> to_json() const;
+#endif
+
+private:
+    class ThreadCounters;
+    struct KernStart {
+        double time;
+        Counters counters;
+    };
+
+    std::unique_ptr<ThreadCounters> m_thread_counters;
+    OprFootprint m_opr_footprint;
+    RealTimer m_timer;
+    CompNode::UnorderedMap<Roofline> m_roofline;
+
+    std::mutex m_mtx;
+    std::unordered_map<std::pair<cg::OperatorNodeBase*, CompNode>, KernStart,
+                       pairhash>
+            m_kern_start;
+    std::unordered_map<cg::OperatorNodeBase*, OprStat> m_opr_stats;
+
+    void on_kern_start(cg::OperatorNodeBase* opr, CompNode cn);
+    void on_kern_end(cg::OperatorNodeBase* opr, CompNode cn,
+                     double computation, double memory);
+};
+
+}  // namespace mgb
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
@@ -75,8 +75,12 @@ class GraphProfiler final : public PluginBase {
 
     //! first event on each comp node
     Maybe<CompNode::UnorderedMap<CompNodeEventPtr>> m_start_of_time;
+    //! TraceEventRecorder::now() when m_start_of_time is recorded
+    CompNode::UnorderedMap<double> m_trace_start_of_time;
     std::mutex m_mtx;
     RealTimer m_timer;
+    //! TraceEventRecorder::now() when m_timer starts
+    double m_trace_timer_base;
 
     //! return whether given opr should be profiled
     bool opr_filter(cg::OperatorNodeBase* opr);
@@ -93,6 +97,15 @@ public:
      */
     std::shared_ptr<json::Object> to_json() const;
 
+    /*!
+     * \brief add kernel spans of each comp node to TraceEventRecorder
+     *
+     * Host spans of the oprs are streamed while executing when the recorder
+     * is enabled; kernel spans have to wait for the events to finish, so this
+     * should be called after the function is executed.
+     */
+    void record_trace_events() const;
+
     /*!
      * \brief dump to visualizer format
      */
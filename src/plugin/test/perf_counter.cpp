@@ -0,0 +1,53 @@
+/**
+ * \file src/plugin/test/perf_counter.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "megbrain/opr/basic_arith_wrapper.h"
+#include "megbrain/opr/blas.h"
+#include "megbrain/opr/io.h"
+#include "megbrain/plugin/perf_counter.h"
+#include "megbrain/test/helper.h"
+
+using namespace mgb;
+
+TEST(TestPerfCounterProfiler, MatMulCPU) {
+    HostTensorGenerator<> gen;
+    auto cn = CompNode::load("cpu0");
+    auto host_x = gen({64, 128}, cn), host_y = gen({128, 32}, cn);
+    auto graph = ComputingGraph::make();
+    graph->options().graph_opt_level = 0;
+    auto x = opr::Host2DeviceCopy::make(*graph, host_x),
+         y = opr::Host2DeviceCopy::make(*graph, host_y),
+         mm = opr::MatrixMul::make(x, y), z = mm + 1;
+
+    PerfCounterProfiler profiler{graph.get()};
+    HostTensorND host_z;
+    auto func = graph->compile({make_callback_copy(z, host_z)});
+    func->execute().wait();
+    func->execute().wait();
+
+    auto&& roofline = profiler.roofline().at(cn);
+    ASSERT_GT(roofline.gflops, 0);
+    ASSERT_GT(roofline.gbps, 0);
+
+    auto&& stat = profiler.opr_stats().at(mm.node()->owner_opr());
+    ASSERT_EQ(cn, stat.comp_node);
+    ASSERT_EQ(2u, stat.nr_exec);
+    ASSERT_GT(stat.time, 0);
+    ASSERT_EQ(2. * 64 * 128 * 32 * 2, stat.computation);
+    if (profiler.counters_available()) {
+        ASSERT_GT(stat.counters.instructions, 0);
+    }
+#if MGB_ENABLE_JSON
+    profiler.to_json()->writeto_fpath(output_file("test_perf_counter.json"));
+#endif
+}
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
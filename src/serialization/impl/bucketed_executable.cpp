@@ -0,0 +1,268 @@
+/**
+ * \file src/serialization/impl/bucketed_executable.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "megbrain/serialization/bucketed_executable.h"
+#include "megbrain/graph/helper.h"
+#include "megbrain/opr/dnn/batch_norm.h"
+#include "megbrain/opr/io.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace mgb;
+using namespace serialization;
+
+struct BucketedExecutableCache::Entry {
+    std::map<std::string, TensorShape> shapes;
+    GraphLoader::LoadResult load_result;
+    std::unique_ptr<cg::AsyncExecutable> func;
+    std::vector<HostTensorND> outputs;
+    //! whether the first dim of each output follows the batch
+    std::vector<bool> output_is_batch;
+};
+
+namespace {
+/*!
+ * \brief find the vars whose first dim follows the batch, starting from the
+ *      batch inputs
+ *
+ * A var depends on the batch if its value is computed from a batch input;
+ * such a var must keep the batch as its first dim, so padded samples never
+ * affect other samples. Oprs that compute statistics over the batch, or move
+ * the batch to other dims, are rejected.
+ */
+ThinHashSet<VarNode*> get_batch_vars(
+        const GraphLoader::LoadResult& load_result,
+        const ThinHashSet<HostTensorND*>& batch_inputs, size_t bucket) {
+    ThinHashSet<VarNode*> batch_vars;
+    auto on_opr = [&](cg::OperatorNodeBase* opr) {
+        if (auto h2d = opr->try_cast_final<opr::Host2DeviceCopy>()) {
+            if (batch_inputs.count(h2d->host_data().get())) {
+                batch_vars.insert(h2d->output(0));
+            }
+            return;
+        }
+        bool depend_on_batch = false;
+        for (auto&& i : opr->node_prop().dep_map()) {
+            if (cg::OperatorNodeBase::NodeProp::is_device_value_dep(
+                        i.second) &&
+                batch_vars.count(i.first)) {
+                depend_on_batch = true;
+                break;
+            }
+        }
+        if (!depend_on_batch) {
+            return;
+        }
+        auto bn = opr->try_cast_final<opr::BatchNorm>();
+        mgb_throw_if(bn && bn->param().fwd_mode ==
+                                   opr::BatchNorm::Param::FwdMode::TRAINING,
+                     SerializationError,
+                     "BatchNorm %s in training mode can not be used with "
+                     "batch buckets",
+                     opr->cname());
+        for (auto i : opr->output()) {
+            if (i->contain_flag(VarNode::Flag::VOLATILE_CONTENT)) {
+                continue;
+            }
+            auto shape = opr->owner_graph()
+                                 ->static_infer_manager()
+                                 .infer_shape_fallible(i);
+            mgb_throw_if(!shape || !shape->ndim || shape->shape[0] != bucket,
+                         SerializationError,
+                         "var %s of opr %s{%s} does not keep the batch as its "
+                         "first dim (shape=%s); can not be used with batch "
+                         "buckets",
+                         i->cname(), opr->cname(), opr->dyn_typeinfo()->name,
+                         shape ? shape->to_string().c_str() : "<dynamic>");
+            batch_vars.insert(i);
+        }
+    };
+    cg::DepOprIter iter{on_opr};
+    for (auto&& i : load_result.output_var_list) {
+        iter.add(i);
+    }
+    return batch_vars;
+}
+}  // anonymous namespace
+
+BucketedExecutableCache::BucketedExecutableCache(
+        std::unique_ptr<GraphLoader> loader, Options options)
+        : m_loader{std::move(loader)}, m_options{std::move(options)} {
+    mgb_assert(m_loader);
+    mgb_assert(!m_options.load_config.comp_graph,
+               "each bucket must be loaded into a new graph");
+    mgb_assert(std::is_sorted(m_options.batch_buckets.begin(),
+                              m_options.batch_buckets.end()),
+               "batch buckets must be sorted");
+    mgb_assert(m_options.capacity >= 1);
+}
+
+BucketedExecutableCache::~BucketedExecutableCache() = default;
+
+bool BucketedExecutableCache::is_batch_input(const std::string& name) const {
+    auto&& names = m_options.batch_inputs;
+    return names.empty() ||
+           std::find(names.begin(), names.end(), name) != names.end();
+}
+
+BucketedExecutableCache::Entry& BucketedExecutableCache::get_entry(
+        const std::map<std::string, TensorShape>& shapes, size_t bucket) {
+    for (auto iter = m_entries.begin(); iter != m_entries.end(); ++iter) {
+        auto eq = [](const std::pair<const std::string, TensorShape>& a,
+                     const std::pair<const std::string, TensorShape>& b) {
+            return a.first == b.first && a.second.eq_shape(b.second);
+        };
+        if (iter->shapes.size() == shapes.size() &&
+            std::equal(shapes.begin(), shapes.end(), iter->shapes.begin(),
+                       eq)) {
+            m_entries.splice(m_entries.begin(), m_entries, iter);
+            return m_entries.front();
+        }
+    }
+
+    Entry entry;
+    entry.shapes = shapes;
+
+    auto config = m_options.load_config;
+    auto user_modifier = config.tensor_modifier;
+    // set the shapes before oprs are inserted, so it also works with
+    // const_var_shape
+    config.tensor_modifier = [&](const std::string& name, bool has_value,
+                                 HostTensorND& tensor) {
+        if (user_modifier) {
+            user_modifier(name, has_value, tensor);
+        }
+        auto iter = shapes.find(name);
+        if (iter == shapes.end()) {
+            return;
+        }
+        if (has_value) {
+            // the dumped default value is overwritten by run(); do not resize
+            // in place since the storage may be shared with the model buffer
+            tensor = HostTensorND{tensor.comp_node(), iter->second,
+                                  tensor.dtype()};
+        } else {
+            tensor.resize(iter->second);
+        }
+    };
+    config.comp_graph = ComputingGraph::make();
+    config.comp_graph->options().comp_node_seq_record_level =
+            m_options.comp_node_seq_record_level;
+    if (m_options.graph_setup) {
+        m_options.graph_setup(*config.comp_graph);
+    }
+    entry.load_result = m_loader->load(config, true);
+
+    auto&& tensor_map = entry.load_result.tensor_map;
+    ThinHashSet<HostTensorND*> batch_inputs;
+    for (auto&& i : shapes) {
+        auto iter = tensor_map.find(i.first);
+        mgb_assert(iter != tensor_map.end(), "unknown input: %s",
+                   i.first.c_str());
+        mgb_assert(iter->second->shape().eq_shape(i.second));
+        if (is_batch_input(i.first)) {
+            batch_inputs.insert(iter->second.get());
+        }
+    }
+
+    auto&& output_vars = entry.load_result.output_var_list;
+    entry.output_is_batch.resize(output_vars.size(), false);
+    if (bucket) {
+        auto batch_vars =
+                get_batch_vars(entry.load_result, batch_inputs, bucket);
+        for (size_t i = 0; i < output_vars.size(); ++i) {
+            entry.output_is_batch[i] = batch_vars.count(output_vars[i].node());
+        }
+    }
+
+    entry.outputs.resize(output_vars.size());
+    ComputingGraph::OutputSpec out_spec;
+    for (size_t i = 0; i < output_vars.size(); ++i) {
+        auto dest = &entry.outputs[i];
+        out_spec.emplace_back(output_vars[i], [dest](DeviceTensorND& dv) {
+            dest->copy_from(dv);
+        });
+    }
+    entry.func = entry.load_result.graph_compile(out_spec);
+    ++m_nr_compiled;
+
+    // evict only after the new executable is ready, so a failed compile keeps
+    // the cache intact
+    if (m_entries.size() >= m_options.capacity) {
+        m_entries.pop_back();
+    }
+    m_entries.push_front(std::move(entry));
+    return m_entries.front();
+}
+
+std::vector<HostTensorND> BucketedExecutableCache::run(
+        const InputMap& inputs) {
+    size_t batch = 0;
+    for (auto&& i : inputs) {
+        if (is_batch_input(i.first)) {
+            auto&& shape = i.second.shape();
+            mgb_assert(shape.ndim >= 1, "batch input %s is a scalar",
+                       i.first.c_str());
+            mgb_assert(!batch || batch == shape[0],
+                       "batch size mismatch: input %s has %zu, expect %zu",
+                       i.first.c_str(), shape[0], batch);
+            batch = shape[0];
+        }
+    }
+
+    size_t bucket = batch;
+    auto&& buckets = m_options.batch_buckets;
+    auto biter = std::lower_bound(buckets.begin(), buckets.end(), batch);
+    if (biter != buckets.end()) {
+        bucket = *biter;
+    }
+
+    std::map<std::string, TensorShape> shapes;
+    for (auto&& i : inputs) {
+        auto shape = i.second.shape();
+        if (is_batch_input(i.first)) {
+            shape[0] = bucket;
+        }
+        shapes[i.first] = shape;
+    }
+    // exact shapes are used if the batch is larger than all the buckets, and
+    // such executables never see padded inputs
+    auto&& entry = get_entry(shapes, biter != buckets.end() ? bucket : 0);
+
+    for (auto&& i : inputs) {
+        auto&& dest = *entry.load_result.tensor_map.at(i.first);
+        if (bucket == batch || !is_batch_input(i.first)) {
+            dest.copy_from_fixlayout(i.second);
+            continue;
+        }
+        dest.sub(Slice(0, batch).apply(dest.layout(), 0))
+                .copy_from_fixlayout(i.second);
+        auto pad = dest.sub(Slice(batch, bucket).apply(dest.layout(), 0));
+        memset(pad.raw_ptr(), 0, pad.layout().span().dist_byte());
+    }
+
+    entry.func->execute().wait();
+
+    std::vector<HostTensorND> ret;
+    ret.reserve(entry.outputs.size());
+    for (size_t idx = 0; idx < entry.outputs.size(); ++idx) {
+        auto&& i = entry.outputs[idx];
+        if (bucket != batch && entry.output_is_batch[idx]) {
+            ret.push_back(i.sub(Slice(0, batch).apply(i.layout(), 0)));
+        } else {
+            ret.push_back(i);
+        }
+    }
+    return ret;
+}
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
@@ -11,6 +11,16 @@
 
 #include "megbrain/serialization/file.h"
 
+#if defined(__unix__) || defined(__APPLE__)
+#define MGB_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define MGB_HAVE_MMAP 0
+#endif
+
 namespace mgb {
 namespace serialization {
 
@@ -245,6 +255,34 @@ std::unique_ptr<InputFile> InputFile::make_mem_proxy(std::shared_ptr<void> ptr,
     return std::make_unique<SharedMemProxyImpl>(std::move(ptr), size, writable);
 }
 
+/* ====================== mmap impl ====================== */
+#if MGB_HAVE_MMAP
+std::unique_ptr<InputFile> InputFile::make_mmap(const char* path) {
+    int fd = open(path, O_RDONLY);
+    mgb_assert(fd >= 0, "failed to open %s: %s", path, strerror(errno));
+    struct stat st;
+    auto err = fstat(fd, &st);
+    mgb_assert(!err, "failed to stat %s: %s", path, strerror(errno));
+    size_t size = st.st_size;
+    mgb_assert(size, "can not mmap empty file %s", path);
+    // private writable mapping: pages are shared between processes until they
+    // are written, e.g. when a graph input aliasing the file is overwritten
+    // in place, which then only copies the written pages
+    void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd,
+                     0);
+    close(fd);
+    mgb_assert(ptr != MAP_FAILED, "failed to mmap %s: %s", path,
+               strerror(errno));
+    std::shared_ptr<void> refhold{ptr, [size](void* p) { munmap(p, size); }};
+    // do not move tensor values for alignment, which would copy the pages
+    return make_mem_proxy(std::move(refhold), size, false);
+}
+#else
+std::unique_ptr<InputFile> InputFile::make_mmap(const char* path) {
+    return make_fs(path);
+}
+#endif
+
 class OutputFile::VectorProxyImpl final : public OutputFile {
     std::vector<uint8_t>* const m_buf;
     size_t m_offset;
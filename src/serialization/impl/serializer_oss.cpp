@@ -399,10 +399,16 @@ void GraphDumperOSS::dump_tensor(const std::string& name,
             break;
     }
 
-    size_t value_size = 0;
+    size_t value_size = 0, value_offset = 0;
     if (has_value) {
         check_tensor_value_valid(name, tensor);
         auto begin = m_file->tell();
+        if (auto align = m_config.tensor_value_align) {
+            // pad so that the value can be mapped without copy
+            value_offset = (align - begin % align) % align;
+            std::vector<uint8_t> padding(value_offset);
+            m_file->write(padding.data(), value_offset);
+        }
         auto&& dumper = m_config.tensor_value_dumper;
         if (dumper) {
             dumper(*m_file, *m_cur_opr, tensor);
@@ -420,8 +426,9 @@ void GraphDumperOSS::dump_tensor(const std::string& name,
             m_builder, m_builder.CreateSharedString(
                                tensor.comp_node().to_string_logical()));
     auto dtype = build_dtype(tensor.dtype());
-    auto serialized_tensor = fbs::CreateTensor(m_builder, fbname, shape,
-                                               comp_node, dtype, value_size);
+    auto serialized_tensor =
+            fbs::CreateTensor(m_builder, fbname, shape, comp_node, dtype,
+                              value_size, value_offset);
     m_cur_opr_tensor.emplace_back(serialized_tensor);
 }
 
@@ -555,6 +562,9 @@ public:
                    m_cur_opr_blob_cnt < m_current_opr->blobs()->size());
         auto blob = m_current_opr->blobs()->Get(m_cur_opr_blob_cnt++);
         mgb_assert(blob && blob->data());
+        // copy into a private buffer: consumers such as TensorRT, Atlas,
+        // Cambricon and extern C oprs rely on its alignment, and it should
+        // not pin the whole graph buffer
         auto size = blob->data()->size();
         std::shared_ptr<uint8_t> shptr{new uint8_t[size],
                                        [](uint8_t* p) { delete[] p; }};
@@ -0,0 +1,113 @@
+/**
+ * \file src/serialization/include/megbrain/serialization/bucketed_executable.h
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#pragma once
+
+#include "megbrain/serialization/serializer.h"
+
+#include <list>
+#include <map>
+
+namespace mgb {
+namespace serialization {
+
+/*!
+ * \brief cache of executables compiled for input shape buckets, to serve a
+ *      loaded model with varying batch sizes
+ *
+ * Each distinct set of (padded) input shapes gets its own graph instance
+ * loaded by the GraphLoader (so params are shared) and its own compiled
+ * function, whose shapes never change. This allows the computing sequence to
+ * be recorded (see ComputingGraph::Options::comp_node_seq_record_level) even
+ * if the batch size of requests varies.
+ *
+ * At run time the batch size is rounded up to the nearest bucket; batch
+ * inputs are zero-padded, and outputs computed from batch inputs are sliced
+ * back to the request batch size. Requests larger than the largest bucket are
+ * run with their exact shapes.
+ *
+ * Padding is only correct if samples are computed independently. When an
+ * executable is compiled for a bucket, every var computed from batch inputs
+ * must keep the batch as its first dim, and BatchNorm must not be in training
+ * mode; otherwise SerializationError is thrown. Oprs that mix samples while
+ * keeping the shape (e.g. softmax along the batch dim) can not be detected and
+ * must not be used.
+ *
+ * This class is not thread safe.
+ */
+class BucketedExecutableCache : public NonCopyableObj {
+public:
+    using InputMap = std::map<std::string, HostTensorND>;
+
+    struct Options {
+        //! batch sizes of the buckets, in ascending order; empty to use
+        //! exact shapes
+        std::vector<size_t> batch_buckets;
+
+        //! names of inputs whose first dim is the batch; empty for all
+        //! inputs
+        std::vector<std::string> batch_inputs;
+
+        //! config passed to GraphLoader::load(); comp_graph must be empty
+        GraphLoadConfig load_config;
+
+        uint8_t comp_node_seq_record_level = 1;
+
+        //! callback to setup options of each new graph
+        thin_function<void(ComputingGraph&)> graph_setup;
+
+        //! max number of compiled executables kept in the cache
+        size_t capacity = 16;
+    };
+
+    BucketedExecutableCache(std::unique_ptr<GraphLoader> loader,
+                            Options options);
+    ~BucketedExecutableCache();
+
+    /*!
+     * \brief run the model on given inputs
+     *
+     * \return output values in the order of LoadResult::output_var_list;
+     *      they share storage with the cache and are only valid until next
+     *      run()
+     */
+    std::vector<HostTensorND> run(const InputMap& inputs);
+
+    //! number of executables compiled since construction
+    size_t nr_compiled() const { return m_nr_compiled; }
+
+    //! number of executables currently cached
+    size_t nr_cached() const { return m_entries.size(); }
+
+private:
+    struct Entry;
+
+    std::unique_ptr<GraphLoader> m_loader;
+    const Options m_options;
+    //! most recently used first
+    std::list<Entry> m_entries;
+    size_t m_nr_compiled = 0;
+
+    bool is_batch_input(const std::string& name) const;
+
+    /*!
+     * \brief find or compile the executable for given input shapes
+     * \param bucket batch size of the bucket if inputs might be padded, or 0
+     *      if exact shapes are used
+     */
+    Entry& get_entry(const std::map<std::string, TensorShape>& shapes,
+                     size_t bucket);
+};
+
+}  // namespace serialization
+}  // namespace mgb
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
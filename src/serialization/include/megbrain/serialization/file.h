@@ -91,6 +91,20 @@ public:
     static std::unique_ptr<InputFile> make_mem_proxy(std::shared_ptr<void> ptr,
                                                      size_t size,
                                                      bool writable = true);
+
+    /*!
+     * \brief create an InputFile that maps a file on local file system into
+     *      memory
+     *
+     * read_shared() returns views into the mapping, and tensor values whose
+     * file offsets are aligned (see GraphDumpConfig::tensor_value_align)
+     * directly alias the mapped pages, so the pages of the model file can be
+     * shared by multiple processes. The mapping is read-only, so writing to
+     * the tensors that alias it is a fault rather than a silent copy.
+     *
+     * It falls back to make_fs() on platforms without mmap.
+     */
+    static std::unique_ptr<InputFile> make_mmap(const char* path);
 };
 
 //! abstract output file interface
@@ -51,6 +51,11 @@ struct GraphDumpConfig {
     //! tensor value without layout; useful for compression or encryption
     TensorValueDumper tensor_value_dumper;
 
+    //! if nonzero, tensor values are padded to start at file offsets aligned
+    //! to this value, so they can be used in place when the model file is
+    //! loaded by InputFile::make_mmap(); only supported in FLATBUFFERS format
+    size_t tensor_value_align = 0;
+
     GraphDumpConfig(int keep_var_name_ = 1, bool keep_param_name_ = false,
                     bool keep_opr_priority_ = false,
                     const std::shared_ptr<UserDataContainer>& user_data_ =
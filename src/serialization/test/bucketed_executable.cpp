@@ -0,0 +1,185 @@
+/**
+ * \file src/serialization/test/bucketed_executable.cpp
+ * MegEngine is Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * Copyright (c) 2014-2020 Megvii Inc. All rights reserved.
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT ARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+#if MGB_ENABLE_FBS_SERIALIZATION
+
+#include "megbrain/serialization/bucketed_executable.h"
+#include "megbrain/opr/io.h"
+#include "megbrain/opr/basic_arith.h"
+#include "megbrain/opr/basic_arith_wrapper.h"
+#include "megbrain/test/helper.h"
+
+using namespace mgb;
+using namespace serialization;
+
+TEST(TestBucketedExecutableCache, Basic) {
+    auto fname = output_file("TestBucketedExecutableCache.Basic");
+    HostTensorGenerator<> gen;
+    auto host_w = gen({1, 3});
+    {
+        auto graph = ComputingGraph::make();
+        auto host_x = gen({2, 3});
+        auto x = opr::Host2DeviceCopy::make(*graph, host_x, {"x"}),
+             w = opr::SharedDeviceTensor::make(*graph, *host_w, {"w"}),
+             y = x * w + 1;
+        auto dumper = GraphDumper::make(OutputFile::make_fs(fname.c_str()),
+                                        GraphDumpFormat::FLATBUFFERS);
+        dumper->dump({y});
+    }
+
+    BucketedExecutableCache::Options options;
+    options.batch_buckets = {2, 4, 8};
+    options.capacity = 3;
+    BucketedExecutableCache cache{
+            GraphLoader::make(InputFile::make_fs(fname.c_str()),
+                              GraphDumpFormat::FLATBUFFERS),
+            options};
+
+    auto pw = host_w->ptr<float>();
+    auto run = [&](size_t batch) {
+        auto host_x = gen({batch, 3});
+        auto outputs = cache.run({{"x", *host_x}});
+        ASSERT_EQ(1u, outputs.size());
+        auto&& y = outputs[0];
+        ASSERT_EQ(TensorShape({batch, 3}), y.shape());
+        auto px = host_x->ptr<float>(), py = y.ptr<float>();
+        for (size_t i = 0; i < batch * 3; ++i) {
+            MGB_ASSERT_FLOAT_EQ(px[i] * pw[i % 3] + 1, py[i]);
+        }
+    };
+
+    run(1);
+    run(2);
+    ASSERT_EQ(1u, cache.nr_compiled());
+    run(3);
+    run(4);
+    ASSERT_EQ(2u, cache.nr_compiled());
+    run(7);
+    ASSERT_EQ(3u, cache.nr_compiled());
+    run(1);
+    run(6);
+    ASSERT_EQ(3u, cache.nr_compiled());
+
+    // larger than all the buckets: exact shape, evicting bucket 4 (the least
+    // recently used one)
+    run(9);
+    ASSERT_EQ(4u, cache.nr_compiled());
+    ASSERT_EQ(3u, cache.nr_cached());
+    run(9);
+    run(8);
+    run(2);
+    ASSERT_EQ(4u, cache.nr_compiled());
+    run(3);
+    ASSERT_EQ(5u, cache.nr_compiled());
+    ASSERT_EQ(3u, cache.nr_cached());
+}
+
+TEST(TestBucketedExecutableCache, DefaultValueInput) {
+    auto fname = output_file("TestBucketedExecutableCache.DefaultValueInput");
+    HostTensorGenerator<> gen;
+    {
+        auto graph = ComputingGraph::make();
+        auto host_x = gen({2, 3});
+        opr::Host2DeviceCopy::Param param;
+        param.dump_default_value = true;
+        auto x = opr::Host2DeviceCopy::make(*graph, host_x, param, {"x"});
+        auto dumper = GraphDumper::make(OutputFile::make_fs(fname.c_str()),
+                                        GraphDumpFormat::FLATBUFFERS);
+        dumper->dump({x * 2});
+    }
+
+    BucketedExecutableCache::Options options;
+    options.batch_buckets = {4, 8};
+    BucketedExecutableCache cache{
+            GraphLoader::make(InputFile::make_fs(fname.c_str()),
+                              GraphDumpFormat::FLATBUFFERS),
+            options};
+    // the dumped batch is 2, which is not a bucket
+    for (size_t batch : {3, 6, 9}) {
+        auto host_x = gen({batch, 3});
+        auto outputs = cache.run({{"x", *host_x}});
+        ASSERT_EQ(TensorShape({batch, 3}), outputs[0].shape());
+        auto px = host_x->ptr<float>(), py = outputs[0].ptr<float>();
+        for (size_t i = 0; i < batch * 3; ++i) {
+            MGB_ASSERT_FLOAT_EQ(px[i] * 2, py[i]);
+        }
+    }
+    ASSERT_EQ(3u, cache.nr_compiled());
+}
+
+TEST(TestBucketedExecutableCache, NonBatchOutput) {
+    auto fname = output_file("TestBucketedExecutableCache.NonBatchOutput");
+    HostTensorGenerator<> gen;
+    // the first dim of w equals a bucket, but it does not follow the batch
+    auto host_w = gen({4, 3});
+    {
+        auto graph = ComputingGraph::make();
+        auto host_x = gen({2, 3});
+        auto x = opr::Host2DeviceCopy::make(*graph, host_x, {"x"}),
+             w = opr::SharedDeviceTensor::make(*graph, *host_w, {"w"});
+        auto dumper = GraphDumper::make(OutputFile::make_fs(fname.c_str()),
+                                        GraphDumpFormat::FLATBUFFERS);
+        dumper->dump({x + 1, w * 2});
+    }
+
+    BucketedExecutableCache::Options options;
+    options.batch_buckets = {4};
+    BucketedExecutableCache cache{
+            GraphLoader::make(InputFile::make_fs(fname.c_str()),
+                              GraphDumpFormat::FLATBUFFERS),
+            options};
+    auto host_x = gen({3, 3});
+    auto outputs = cache.run({{"x", *host_x}});
+    ASSERT_EQ(2u, outputs.size());
+    ASSERT_EQ(TensorShape({3, 3}), outputs[0].shape());
+    ASSERT_EQ(TensorShape({4, 3}), outputs[1].shape());
+    auto pw = host_w->ptr<float>(), py = outputs[1].ptr<float>();
+    for (size_t i = 0; i < 12; ++i) {
+        MGB_ASSERT_FLOAT_EQ(pw[i] * 2, py[i]);
+    }
+}
+
+TEST(TestBucketedExecutableCache, RejectBatchMixing) {
+    auto fname = output_file("TestBucketedExecutableCache.RejectBatchMixing");
+    HostTensorGenerator<> gen;
+    {
+        auto graph = ComputingGraph::make();
+        auto host_x = gen({2, 3});
+        auto x = opr::Host2DeviceCopy::make(*graph, host_x, {"x"}),
+             y = opr::Reduce::make(x, {opr::Reduce::Mode::SUM, 0});
+        auto dumper = GraphDumper::make(OutputFile::make_fs(fname.c_str()),
+                                        GraphDumpFormat::FLATBUFFERS);
+        dumper->dump({y});
+    }
+
+    BucketedExecutableCache::Options options;
+    options.batch_buckets = {4};
+    options.capacity = 1;
+    BucketedExecutableCache cache{
+            GraphLoader::make(InputFile::make_fs(fname.c_str()),
+                              GraphDumpFormat::FLATBUFFERS),
+            options};
+
+    // exact shapes are never padded, so reduction over the batch is allowed
+    auto host_x = gen({5, 3});
+    auto outputs = cache.run({{"x", *host_x}});
+    ASSERT_EQ(TensorShape({1, 3}), outputs[0].shape());
+    ASSERT_EQ(1u, cache.nr_compiled());
+
+    // the executable in the cache is kept if compiling a new one fails
+    ASSERT_THROW(cache.run({{"x", *gen({3, 3})}}), SerializationError);
+    ASSERT_EQ(1u, cache.nr_cached());
+    cache.run({{"x", *host_x}});
+    ASSERT_EQ(1u, cache.nr_compiled());
+}
+
+#endif
+
+// vim: syntax=cpp.doxygen foldmethod=marker foldmarker=f{{{,f}}}
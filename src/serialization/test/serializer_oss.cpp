@@ -679,6 +679,134 @@ TEST(TestSerializer2, MultipleParams) {
     load();
 }
 
+TEST(TestSerializer2, MmapAlignedParams) {
+    auto fname = GET_OUTPUT_FILE();
+    auto cn = CompNode::load("cpu0");
+    HostTensorGenerator<> gen;
+    std::vector<std::shared_ptr<HostTensorND>> tensors{
+            gen({2, 3}, cn), gen({1}, cn), gen({33, 5}, cn), gen({64, 3}, cn)};
+
+    {
+        auto graph = ComputingGraph::make();
+        SymbolVarArray outputs;
+        for (auto&& i : tensors) {
+            outputs.push_back(opr::SharedDeviceTensor::make(*graph, *i));
+        }
+        GraphDumper::DumpConfig config;
+        config.tensor_value_align = cn.get_mem_addr_alignment();
+        GraphDumper::make(OutputFile::make_fs(fname.c_str()),
+                          GraphDumpFormat::FLATBUFFERS)
+                ->dump(outputs, config);
+    }
+
+    auto check = [&](std::unique_ptr<InputFile> file,
+                     const void* shared_begin, size_t shared_size) {
+        auto loader =
+                GraphLoader::make(std::move(file), GraphDumpFormat::FLATBUFFERS);
+        auto rst = loader->load();
+        ASSERT_EQ(tensors.size(), rst.output_var_list.size());
+        for (size_t i = 0; i < tensors.size(); ++i) {
+            auto&& dev = rst.output_var_list[i]
+                                 .node()
+                                 ->owner_opr()
+                                 ->cast_final_safe<opr::SharedDeviceTensor>()
+                                 .get_dev_tensor();
+            HostTensorND got;
+            got.copy_from(dev).sync();
+            MGB_ASSERT_TENSOR_EQ(*tensors[i], got);
+            if (shared_begin) {
+                auto ptr = dev.raw_ptr();
+                auto begin = static_cast<const dt_byte*>(shared_begin);
+                ASSERT_TRUE(ptr >= begin && ptr < begin + shared_size);
+            }
+        }
+    };
+
+    check(InputFile::make_mmap(fname.c_str()), nullptr, 0);
+
+    // a read-only memory proxy shares the code path with mmap, so we can
+    // check that the param values are not copied
+    FILE* fin = fopen(fname.c_str(), "rb");
+    ASSERT_TRUE(fin);
+    fseek(fin, 0, SEEK_END);
+    size_t size = ftell(fin);
+    fseek(fin, 0, SEEK_SET);
+    std::shared_ptr<void> buf{cn.alloc_host(size),
+                              [cn](void* ptr) { cn.free_host(ptr); }};
+    ASSERT_EQ(size, fread(buf.get(), 1, size, fin));
+    fclose(fin);
+    check(InputFile::make_mem_proxy(buf, size, false), buf.get(), size);
+}
+
+TEST(TestSerializer2, MmapWriteInput) {
+    auto fname = GET_OUTPUT_FILE();
+    auto cn = CompNode::load("cpu0");
+    HostTensorGenerator<> gen;
+    TensorShape shape{64, 3};
+    auto host_x = gen(shape, cn), host_w = gen(shape, cn);
+
+    {
+        auto graph = ComputingGraph::make();
+        opr::Host2DeviceCopy::Param param;
+        param.dump_default_value = true;
+        auto x = opr::Host2DeviceCopy::make(*graph, host_x, param, {"x"}),
+             w = opr::SharedDeviceTensor::make(*graph, *host_w);
+        GraphDumper::DumpConfig config;
+        config.tensor_value_align = cn.get_mem_addr_alignment();
+        GraphDumper::make(OutputFile::make_fs(fname.c_str()),
+                          GraphDumpFormat::FLATBUFFERS)
+                ->dump({(x + w).rename("y")}, config);
+    }
+
+    std::shared_ptr<HostTensorND> xv;
+    auto run = [&](std::unique_ptr<InputFile> file, bool modify_inplace) {
+        auto rst = GraphLoader::make(std::move(file),
+                                     GraphDumpFormat::FLATBUFFERS)
+                           ->load();
+        xv = rst.tensor_map.at("x");
+        MGB_ASSERT_TENSOR_EQ(*host_x, *xv);
+        HostTensorND host_y, host_y_expect;
+        auto func = rst.graph_compile(
+                {make_callback_copy(rst.output_var_map.at("y"), host_y)});
+        if (modify_inplace) {
+            // write into the storage loaded from the file, like load-and-run
+            // does for its inputs
+            auto new_x = gen(shape, cn);
+            auto ptr = xv->raw_ptr();
+            xv->copy_from(*new_x);
+            ASSERT_EQ(ptr, xv->raw_ptr());
+            for (size_t i = 0; i < shape.total_nr_elems(); ++i) {
+                xv->ptr<float>()[i] += 1;
+            }
+        }
+        host_y_expect.copy_from(*xv);
+        for (size_t i = 0; i < shape.total_nr_elems(); ++i) {
+            host_y_expect.ptr<float>()[i] += host_w->ptr<float>()[i];
+        }
+        func->execute();
+        MGB_ASSERT_TENSOR_EQ(host_y_expect, host_y);
+    };
+
+    run(InputFile::make_mmap(fname.c_str()), true);
+    // the written pages are private to the mapping and the file is unchanged
+    run(InputFile::make_mmap(fname.c_str()), false);
+
+    // check that the input value aliases the buffer, so the writes above go
+    // to the mapped pages
+    FILE* fin = fopen(fname.c_str(), "rb");
+    ASSERT_TRUE(fin);
+    fseek(fin, 0, SEEK_END);
+    size_t size = ftell(fin);
+    fseek(fin, 0, SEEK_SET);
+    std::shared_ptr<void> buf{cn.alloc_host(size),
+                              [cn](void* ptr) { cn.free_host(ptr); }};
+    ASSERT_EQ(size, fread(buf.get(), 1, size, fin));
+    fclose(fin);
+    run(InputFile::make_mem_proxy(buf, size, false), false);
+    auto begin = static_cast<const dt_byte*>(buf.get());
+    ASSERT_TRUE(xv->raw_ptr() >= begin && xv->raw_ptr() < begin + size);
+}
+
 TEST(TestSerializer2, ParamerizedDType) {
     auto fname = GET_OUTPUT_FILE();
     TensorShape shape{2, 3, 3};